@@ -10,6 +10,7 @@ apt-get -y install \
 	libgmp-dev \
 	nettle-dev \
 	libudev-dev \
+	libfuse3-dev \
 	\
 	qtbase5-dev \
 	qttools5-dev \
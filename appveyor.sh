@@ -9,4 +9,8 @@ cmake .. -G Ninja \
 	-DCMAKE_INSTALL_PREFIX=/usr \
 	-DCMAKE_BUILD_TYPE=Release \
 	-DENABLE_NLS=OFF \
+	-DENABLE_FUSE=ON \
 	-DBUILD_TESTING=ON
+
+# Make sure the 'mount' command is built against libfuse3.
+grep -q 'HAVE_FUSE 1' src/rvthtool/config.rvthtool.h
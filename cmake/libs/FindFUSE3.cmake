@@ -0,0 +1,17 @@
+# Try to find libfuse3
+#  FUSE3_FOUND - system has libfuse3
+#  FUSE3_INCLUDE_DIR - the libfuse3 include directory
+#  FUSE3_LIBRARIES - Libraries needed to use libfuse3
+
+if (FUSE3_INCLUDE_DIR AND FUSE3_LIBRARIES)
+# Already in cache, be silent
+	set(FUSE3_FIND_QUIETLY TRUE)
+endif (FUSE3_INCLUDE_DIR AND FUSE3_LIBRARIES)
+
+find_path(FUSE3_INCLUDE_DIR NAMES fuse.h PATH_SUFFIXES fuse3)
+find_library(FUSE3_LIBRARIES NAMES fuse3 libfuse3)
+
+include(FindPackageHandleStandardArgs)
+FIND_PACKAGE_HANDLE_STANDARD_ARGS(FUSE3 DEFAULT_MSG FUSE3_INCLUDE_DIR FUSE3_LIBRARIES)
+
+mark_as_advanced(FUSE3_INCLUDE_DIR FUSE3_LIBRARIES)
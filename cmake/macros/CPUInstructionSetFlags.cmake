@@ -91,10 +91,16 @@ IF(CPU_i386 OR CPU_amd64)
 			SET(SSE2_FLAG "/arch:SSE2")
 			SET(SSSE3_FLAG "/arch:SSE2")
 			SET(SSE41_FLAG "/arch:SSE2")
+			SET(AESNI_FLAG "/arch:SSE2")
+			SET(SHA_FLAG "/arch:SSE2")
 		ENDIF(CPU_i386)
+		SET(AVX2_FLAG "/arch:AVX2")
 		IF(CMAKE_CXX_COMPILER_ID STREQUAL "Clang")
 			SET(SSSE3_FLAG "-mssse3")
 			SET(SSE41_FLAG "-msse4.1")
+			SET(AESNI_FLAG "-maes")
+			SET(SHA_FLAG "-msse4.1 -msha")
+			SET(AVX2_FLAG "-mavx2")
 		ENDIF(CMAKE_CXX_COMPILER_ID STREQUAL "Clang")
 	ELSE()
 		IF(CPU_i386)
@@ -103,5 +109,16 @@ IF(CPU_i386 OR CPU_amd64)
 		ENDIF(CPU_i386)
 		SET(SSSE3_FLAG "-mssse3")
 		SET(SSE41_FLAG "-msse4.1")
+		SET(AESNI_FLAG "-msse2 -maes")
+		SET(SHA_FLAG "-msse4.1 -msha")
+		SET(AVX2_FLAG "-mavx2")
 	ENDIF()
 ENDIF(CPU_i386 OR CPU_amd64)
+
+# arm64: Flags for the ARMv8 Crypto Extensions.
+IF(CPU_arm64)
+	# MSVC does not require any flags for ARMv8 CE.
+	IF(NOT MSVC)
+		SET(ARMCE_FLAG "-march=armv8-a+crypto")
+	ENDIF(NOT MSVC)
+ENDIF(CPU_arm64)
@@ -9,6 +9,20 @@ ELSE()
 	SET(ENABLE_UDEV OFF CACHE INTERNAL "Enable UDEV for the 'query' command." FORCE)
 ENDIF()
 
+# Enable io_uring on Linux
+IF(UNIX AND NOT APPLE)
+	OPTION(ENABLE_IO_URING "Enable io_uring for queued reads, if supported by the kernel headers." ON)
+ELSE()
+	SET(ENABLE_IO_URING OFF CACHE INTERNAL "Enable io_uring for queued reads, if supported by the kernel headers." FORCE)
+ENDIF()
+
+# Enable FUSE on Linux
+IF(UNIX AND NOT APPLE)
+	OPTION(ENABLE_FUSE "Enable FUSE for the 'mount' command." ON)
+ELSE()
+	SET(ENABLE_FUSE OFF CACHE INTERNAL "Enable FUSE for the 'mount' command." FORCE)
+ENDIF()
+
 # Enable D-Bus for DockManager / Unity API
 IF(UNIX AND NOT APPLE)
 	OPTION(ENABLE_DBUS "Enable D-Bus support for DockManager / Unity API." 1)
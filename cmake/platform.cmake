@@ -55,6 +55,9 @@ IF(WIN32)
 	INCLUDE(cmake/platform/win32.cmake)
 ENDIF(WIN32)
 
+# Determine the CPU architecture and instruction set flags.
+INCLUDE(CPUInstructionSetFlags)
+
 # Check what flag is needed for stack smashing protection.
 INCLUDE(CheckStackProtectorCompilerFlag)
 CHECK_STACK_PROTECTOR_COMPILER_FLAG(RP_STACK_CFLAG)
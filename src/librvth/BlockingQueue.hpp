@@ -0,0 +1,93 @@
+/***************************************************************************
+ * RVT-H Tool (librvth)                                                    *
+ * BlockingQueue.hpp: Simple thread-safe FIFO queue.                       *
+ *                                                                         *
+ * Copyright (c) 2026 by David Korth.                                      *
+ * SPDX-License-Identifier: GPL-2.0-or-later                               *
+ ***************************************************************************/
+
+#pragma once
+
+#include "libwiicrypto/common.h"
+
+// C++ includes
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+
+/**
+ * Thread-safe FIFO queue for producer/consumer pipelines.
+ *
+ * pop() blocks until an item is available or the queue is closed.
+ * Once closed, push() is rejected, and pop() drains the remaining
+ * items before returning false.
+ *
+ * The queue itself is unbounded. Pipelines bound their memory usage
+ * by cycling a fixed set of work buffers through a "free" queue.
+ */
+template<typename T>
+class BlockingQueue
+{
+public:
+	BlockingQueue() : m_closed(false) { }
+
+private:
+	DISABLE_COPY(BlockingQueue)
+
+public:
+	/**
+	 * Push an item onto the queue.
+	 * @param item Item
+	 * @return True on success; false if the queue is closed.
+	 */
+	bool push(const T &item)
+	{
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			if (m_closed) {
+				return false;
+			}
+			m_queue.push_back(item);
+		}
+		m_cond.notify_one();
+		return true;
+	}
+
+	/**
+	 * Pop an item from the queue.
+	 * This will block until an item is available or the queue is closed.
+	 * @param item [out] Item
+	 * @return True if an item was retrieved; false if the queue is closed and empty.
+	 */
+	bool pop(T &item)
+	{
+		std::unique_lock<std::mutex> lock(m_mutex);
+		m_cond.wait(lock, [this]() { return !m_queue.empty() || m_closed; });
+		if (m_queue.empty()) {
+			// Queue is closed.
+			return false;
+		}
+		item = m_queue.front();
+		m_queue.pop_front();
+		return true;
+	}
+
+	/**
+	 * Close the queue.
+	 * All waiting consumers will be woken up.
+	 */
+	void close(void)
+	{
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_closed = true;
+		}
+		m_cond.notify_all();
+	}
+
+private:
+	std::mutex m_mutex;
+	std::condition_variable m_cond;
+	std::deque<T> m_queue;
+	bool m_closed;
+};
@@ -0,0 +1,191 @@
+/***************************************************************************
+ * RVT-H Tool (librvth)                                                    *
+ * DeltaCompare.cpp: Find changed groups for incremental imports.          *
+ *                                                                         *
+ * Copyright (c) 2026 by David Korth.                                      *
+ * SPDX-License-Identifier: GPL-2.0-or-later                               *
+ ***************************************************************************/
+
+#include "DeltaCompare.hpp"
+#include "RefFile.hpp"
+#include "reader/Reader.hpp"
+
+#include "byteswap.h"
+#include "nhcd_structs.h"
+#include "libwiicrypto/wii_structs.h"
+#include "libwiicrypto/wii_sector.h"
+
+// C includes (C++ namespace)
+#include <cassert>
+#include <cerrno>
+#include <cstring>
+
+// C++ includes
+#include <memory>
+using std::unique_ptr;
+
+/**
+ * Create a DeltaCompare object.
+ * @param dst	[in] Destination Reader (existing image)
+ */
+DeltaCompare::DeltaCompare(Reader *dst)
+	: m_dst(dst)
+	, m_buf(aligned_uptr<uint8_t>(RefFile::DIRECT_IO_ALIGN, LBA_TO_BYTES(UNIT_SIZE_LBA)))
+	, m_bytesRead(0)
+{
+	assert(dst != nullptr);
+}
+
+/**
+ * Load an encrypted Wii partition's H3 table from both images.
+ *
+ * If the partition headers don't have the same layout,
+ * the partition is compared like the rest of the image.
+ *
+ * @param src		[in] Source Reader
+ * @param lba_start	[in] Starting LBA of the partition
+ * @param lba_len	[in] Length of the partition, in LBAs
+ * @return 0 on success; negative POSIX error code on error.
+ */
+int DeltaCompare::addPartition(Reader *src, uint32_t lba_start, uint32_t lba_len)
+{
+	// Read the partition headers.
+	unique_ptr<RVL_PartitionHeader> src_hdr(new RVL_PartitionHeader);
+	unique_ptr<RVL_PartitionHeader> dst_hdr(new RVL_PartitionHeader);
+	errno = 0;
+	if (src->read(src_hdr.get(), lba_start, BYTES_TO_LBA(sizeof(*src_hdr))) != BYTES_TO_LBA(sizeof(*src_hdr))) {
+		// Read error.
+		return (errno != 0 ? -errno : -EIO);
+	}
+	if (lba_start + BYTES_TO_LBA(sizeof(*dst_hdr)) > m_dst->lba_len() ||
+	    m_dst->read(dst_hdr.get(), lba_start, BYTES_TO_LBA(sizeof(*dst_hdr))) != BYTES_TO_LBA(sizeof(*dst_hdr)))
+	{
+		// Unable to read the destination partition header.
+		// Compare the partition like the rest of the image.
+		return 0;
+	}
+	m_bytesRead += sizeof(*dst_hdr);
+
+	// The H3 table and data offsets must match.
+	// NOTE: The data size may be different.
+	if (src_hdr->h3_table_offset != dst_hdr->h3_table_offset ||
+	    src_hdr->data_offset != dst_hdr->data_offset)
+	{
+		// Different layout.
+		return 0;
+	}
+	const uint32_t h3_lba = BYTES_TO_LBA(static_cast<uint64_t>(be32_to_cpu(src_hdr->h3_table_offset)) << 2);
+	const uint32_t data_lba = BYTES_TO_LBA(static_cast<uint64_t>(be32_to_cpu(src_hdr->data_offset)) << 2);
+	if (h3_lba == 0 || data_lba == 0 || data_lba >= lba_len ||
+	    h3_lba + BYTES_TO_LBA(sizeof(Wii_Disc_H3_t)) > lba_len)
+	{
+		// Invalid partition header.
+		return 0;
+	}
+
+	// Read the H3 tables.
+	unique_ptr<Wii_Disc_H3_t> src_h3(new Wii_Disc_H3_t);
+	unique_ptr<Wii_Disc_H3_t> dst_h3(new Wii_Disc_H3_t);
+	errno = 0;
+	if (src->read(src_h3.get(), lba_start + h3_lba, BYTES_TO_LBA(sizeof(*src_h3))) != BYTES_TO_LBA(sizeof(*src_h3))) {
+		// Read error.
+		return (errno != 0 ? -errno : -EIO);
+	}
+	if (m_dst->read(dst_h3.get(), lba_start + h3_lba, BYTES_TO_LBA(sizeof(*dst_h3))) != BYTES_TO_LBA(sizeof(*dst_h3))) {
+		// Unable to read the destination H3 table.
+		return 0;
+	}
+	m_bytesRead += sizeof(*dst_h3);
+
+	// Number of groups, based on the partition size.
+	// The H3 table can't describe more groups than it has entries.
+	Partition part;
+	part.lba_data = lba_start + data_lba;
+	part.group_count = (lba_len - data_lba + UNIT_SIZE_LBA - 1) / UNIT_SIZE_LBA;
+	if (part.group_count > ARRAY_SIZE(src_h3->h3)) {
+		part.group_count = ARRAY_SIZE(src_h3->h3);
+	}
+
+	// Compare the H3 entries.
+	part.h3_changed.resize(part.group_count);
+	for (uint32_t i = 0; i < part.group_count; i++) {
+		part.h3_changed[i] = (memcmp(src_h3->h3[i], dst_h3->h3[i], sizeof(src_h3->h3[i])) != 0);
+	}
+
+	m_partitions.push_back(std::move(part));
+	return 0;
+}
+
+/**
+ * Find the partition whose group data contains an LBA.
+ * @param lba	[in] LBA
+ * @return Partition, or nullptr if none.
+ */
+const DeltaCompare::Partition *DeltaCompare::findPartition(uint32_t lba) const
+{
+	for (const Partition &part : m_partitions) {
+		if (lba >= part.lba_data &&
+		    lba - part.lba_data < part.group_count * UNIT_SIZE_LBA)
+		{
+			return &part;
+		}
+	}
+	return nullptr;
+}
+
+/**
+ * Get the end of the unit that contains an LBA.
+ * @param lba	[in] LBA
+ * @return First LBA after the unit.
+ */
+uint32_t DeltaCompare::unitEnd(uint32_t lba) const
+{
+	const Partition *const part = findPartition(lba);
+	if (part) {
+		// End of the group.
+		return part->lba_data + ((lba - part->lba_data) / UNIT_SIZE_LBA + 1) * UNIT_SIZE_LBA;
+	}
+
+	// Next 2 MB boundary, or the start of a partition's
+	// group data, whichever comes first.
+	uint32_t end = (lba / UNIT_SIZE_LBA + 1) * UNIT_SIZE_LBA;
+	for (const Partition &p : m_partitions) {
+		if (p.lba_data > lba && p.lba_data < end) {
+			end = p.lba_data;
+		}
+	}
+	return end;
+}
+
+/**
+ * Has part of a unit changed?
+ * @param buf		[in] Source data
+ * @param lba_start	[in] Starting LBA
+ * @param lba_len	[in] Length, in LBAs (must not cross a unit boundary)
+ * @return True if the destination has to be written; false if it's unchanged.
+ */
+bool DeltaCompare::isChanged(const uint8_t *buf, uint32_t lba_start, uint32_t lba_len)
+{
+	assert(lba_len > 0 && lba_len <= UNIT_SIZE_LBA);
+	assert(lba_start + lba_len <= unitEnd(lba_start));
+
+	// If the H3 entries are different, the group has changed.
+	const Partition *const part = findPartition(lba_start);
+	if (part && part->h3_changed[(lba_start - part->lba_data) / UNIT_SIZE_LBA]) {
+		return true;
+	}
+
+	// Compare with the destination.
+	// NOTE: The H3 entries may match even if the encrypted data doesn't,
+	// e.g. if the title key changed, so this is still needed for groups.
+	if (lba_start + lba_len > m_dst->lba_len()) {
+		// Past the end of the destination.
+		return true;
+	}
+	if (m_dst->read(m_buf.get(), lba_start, lba_len) != lba_len) {
+		// Read error. Write the data anyway.
+		return true;
+	}
+	m_bytesRead += LBA_TO_BYTES(lba_len);
+	return (memcmp(m_buf.get(), buf, LBA_TO_BYTES(lba_len)) != 0);
+}
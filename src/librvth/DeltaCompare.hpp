@@ -0,0 +1,107 @@
+/***************************************************************************
+ * RVT-H Tool (librvth)                                                    *
+ * DeltaCompare.hpp: Find changed groups for incremental imports.          *
+ *                                                                         *
+ * Copyright (c) 2026 by David Korth.                                      *
+ * SPDX-License-Identifier: GPL-2.0-or-later                               *
+ ***************************************************************************/
+
+#pragma once
+
+#include "libwiicrypto/common.h"
+#include "aligned_malloc.h"
+
+// C includes
+#include <stdint.h>
+
+// C++ includes
+#include <vector>
+
+class Reader;
+
+/**
+ * Finds the parts of a disc image that differ from an existing
+ * copy of the same title. Used for incremental imports.
+ *
+ * The image is compared in units: 2 MB groups in encrypted Wii
+ * partitions, and 2 MB blocks everywhere else. If a partition's
+ * H3 table was loaded from both images, groups with different
+ * H3 entries are known to have changed without reading the
+ * destination. Everything else is read from the destination
+ * and compared with the source data.
+ */
+class DeltaCompare
+{
+public:
+	/**
+	 * Create a DeltaCompare object.
+	 * @param dst	[in] Destination Reader (existing image)
+	 */
+	explicit DeltaCompare(Reader *dst);
+
+private:
+	DISABLE_COPY(DeltaCompare)
+
+public:
+	// Unit size, in LBAs. (2 MB; same as a Wii group)
+	static constexpr uint32_t UNIT_SIZE_LBA = 4096;
+
+	/**
+	 * Load an encrypted Wii partition's H3 table from both images.
+	 *
+	 * If the partition headers don't have the same layout,
+	 * the partition is compared like the rest of the image.
+	 *
+	 * @param src		[in] Source Reader
+	 * @param lba_start	[in] Starting LBA of the partition
+	 * @param lba_len	[in] Length of the partition, in LBAs
+	 * @return 0 on success; negative POSIX error code on error.
+	 */
+	int addPartition(Reader *src, uint32_t lba_start, uint32_t lba_len);
+
+	/**
+	 * Get the end of the unit that contains an LBA.
+	 * @param lba	[in] LBA
+	 * @return First LBA after the unit.
+	 */
+	uint32_t unitEnd(uint32_t lba) const;
+
+	/**
+	 * Has part of a unit changed?
+	 * @param buf		[in] Source data
+	 * @param lba_start	[in] Starting LBA
+	 * @param lba_len	[in] Length, in LBAs (must not cross a unit boundary)
+	 * @return True if the destination has to be written; false if it's unchanged.
+	 */
+	bool isChanged(const uint8_t *buf, uint32_t lba_start, uint32_t lba_len);
+
+	/**
+	 * Get the number of bytes read from the destination.
+	 * @return Bytes read
+	 */
+	inline uint64_t bytesRead(void) const
+	{
+		return m_bytesRead;
+	}
+
+private:
+	struct Partition {
+		uint32_t lba_data;		// Starting LBA of the group data
+		uint32_t group_count;		// Number of groups
+		std::vector<bool> h3_changed;	// True if a group's H3 entries differ
+	};
+
+	/**
+	 * Find the partition whose group data contains an LBA.
+	 * @param lba	[in] LBA
+	 * @return Partition, or nullptr if none.
+	 */
+	const Partition *findPartition(uint32_t lba) const;
+
+	Reader *m_dst;
+	std::vector<Partition> m_partitions;
+
+	// Destination read buffer. (one unit)
+	aligned_unique_ptr<uint8_t> m_buf;
+	uint64_t m_bytesRead;
+};
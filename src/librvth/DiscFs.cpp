@@ -0,0 +1,273 @@
+/***************************************************************************
+ * RVT-H Tool (librvth)                                                    *
+ * DiscFs.cpp: Wii partition filesystem tree.                              *
+ *                                                                         *
+ * Copyright (c) 2026 by David Korth.                                      *
+ * SPDX-License-Identifier: GPL-2.0-or-later                               *
+ ***************************************************************************/
+
+#include "DiscFs.hpp"
+#include "reader/PartitionReader.hpp"
+
+#include "byteswap.h"
+#include "libwiicrypto/gcn_structs.h"
+
+// C includes (C++ namespace)
+#include <cerrno>
+#include <cstring>
+
+// C++ includes
+#include <memory>
+#include <utility>
+using std::pair;
+using std::string;
+using std::unique_ptr;
+using std::vector;
+
+// Apploader header address and fields.
+// The apploader image is a 32-byte header, followed by the
+// apploader code and the trailer.
+#define APPLOADER_ADDRESS 0x2440
+#define APPLOADER_HEADER_SIZE 0x20
+#define APPLOADER_SIZE_OFFSET 0x14
+#define APPLOADER_TRAILER_SIZE_OFFSET 0x18
+
+// bi2.bin size
+#define BI2_SIZE 0x2000
+
+// Maximum FST size. Real FSTs are much smaller than this.
+#define FST_SIZE_MAX (64U*1024U*1024U)
+
+// FST entry. (All fields are big-endian.)
+typedef struct _FST_Entry {
+	uint32_t type_name_offset;	// High 8 bits: 1 == directory; Low 24 bits: name offset
+	uint32_t offset;		// File: offset (RSH2 on Wii); Directory: parent index
+	uint32_t size;			// File: size; Directory: index of the next entry after it
+} FST_Entry;
+ASSERT_STRUCT(FST_Entry, 12);
+
+DiscFs::DiscFs()
+{
+	// Root directory
+	m_entries.resize(1);
+	m_entries[ROOT].is_dir = true;
+	m_entries[ROOT].offset = 0;
+	m_entries[ROOT].size = 0;
+}
+
+/**
+ * Add a directory.
+ * If an entry with the same name already exists, it's returned instead.
+ * @param parent	[in] Parent directory
+ * @param name		[in] Name
+ * @return Entry index
+ */
+unsigned int DiscFs::addDir(unsigned int parent, const string &name)
+{
+	auto iter = m_entries[parent].children.find(name);
+	if (iter != m_entries[parent].children.end()) {
+		return iter->second;
+	}
+
+	const unsigned int idx = static_cast<unsigned int>(m_entries.size());
+	m_entries.resize(m_entries.size() + 1);
+	Entry &entry = m_entries[idx];
+	entry.name = name;
+	entry.is_dir = true;
+	entry.offset = 0;
+	entry.size = 0;
+	m_entries[parent].children.emplace(name, idx);
+	return idx;
+}
+
+/**
+ * Add a file.
+ * If an entry with the same name already exists, it's kept.
+ * @param parent	[in] Parent directory
+ * @param name		[in] Name
+ * @param offset	[in] Offset in the partition
+ * @param size		[in] Size, in bytes
+ */
+void DiscFs::addFile(unsigned int parent, const string &name, uint64_t offset, uint64_t size)
+{
+	if (m_entries[parent].children.find(name) != m_entries[parent].children.end()) {
+		return;
+	}
+
+	const unsigned int idx = static_cast<unsigned int>(m_entries.size());
+	m_entries.resize(m_entries.size() + 1);
+	Entry &entry = m_entries[idx];
+	entry.name = name;
+	entry.is_dir = false;
+	entry.offset = offset;
+	entry.size = size;
+	m_entries[parent].children.emplace(name, idx);
+}
+
+/**
+ * Add the contents of an FST to a directory.
+ * @param dir		[in] Directory
+ * @param fst		[in] FST
+ * @param fst_size	[in] Size of the FST, in bytes
+ * @param shift		[in] File offset shift (2 for Wii; 0 for GameCube)
+ * @return 0 on success; negative POSIX error code on error.
+ */
+int DiscFs::addFst(unsigned int dir, const uint8_t *fst, size_t fst_size, unsigned int shift)
+{
+	if (fst_size < sizeof(FST_Entry)) {
+		return -EIO;
+	}
+
+	// The root entry's size is the total number of entries.
+	// The string table is located immediately after the entries.
+	const FST_Entry *const entries = reinterpret_cast<const FST_Entry*>(fst);
+	const uint32_t count = be32_to_cpu(entries[0].size);
+	if (count == 0 || count > fst_size / sizeof(FST_Entry)) {
+		return -EIO;
+	}
+	const char *const strtbl = reinterpret_cast<const char*>(&entries[count]);
+	const size_t strtbl_size = fst_size - (count * sizeof(FST_Entry));
+
+	// Directory stack: (index of the next entry after the directory, DiscFs directory)
+	vector<pair<uint32_t, unsigned int> > stack;
+	stack.emplace_back(count, dir);
+
+	for (uint32_t i = 1; i < count; i++) {
+		while (i >= stack.back().first) {
+			stack.pop_back();
+		}
+
+		const uint32_t type_name_offset = be32_to_cpu(entries[i].type_name_offset);
+		const uint32_t name_offset = type_name_offset & 0xFFFFFF;
+		if (name_offset >= strtbl_size) {
+			return -EIO;
+		}
+		const char *const name = &strtbl[name_offset];
+		const size_t name_len = strnlen(name, strtbl_size - name_offset);
+		if (name_len == 0 || name_len == strtbl_size - name_offset ||
+		    strchr(name, '/') != nullptr ||
+		    !strcmp(name, ".") || !strcmp(name, ".."))
+		{
+			// Empty, unterminated, or invalid name.
+			return -EIO;
+		}
+
+		const uint32_t offset = be32_to_cpu(entries[i].offset);
+		const uint32_t size = be32_to_cpu(entries[i].size);
+		if ((type_name_offset >> 24) != 0) {
+			// Directory. It must end within its parent directory.
+			if (size <= i || size > stack.back().first) {
+				return -EIO;
+			}
+			const unsigned int subdir = addDir(stack.back().second, string(name, name_len));
+			stack.emplace_back(size, subdir);
+		} else {
+			// File
+			addFile(stack.back().second, string(name, name_len),
+				static_cast<uint64_t>(offset) << shift, size);
+		}
+	}
+
+	return 0;
+}
+
+/**
+ * Load the filesystem from a Wii partition.
+ * @param ptReader	[in] PartitionReader
+ * @return 0 on success; negative POSIX error code on error.
+ */
+int DiscFs::load(PartitionReader *ptReader)
+{
+	// Read everything up to the end of the apploader header.
+	uint8_t hdr[APPLOADER_ADDRESS + APPLOADER_HEADER_SIZE];
+	errno = 0;
+	if (ptReader->read(hdr, 0, sizeof(hdr)) != sizeof(hdr)) {
+		return (errno != 0 ? -errno : -EIO);
+	}
+
+	const unsigned int sys = addDir(ROOT, "sys");
+	const unsigned int files = addDir(ROOT, "files");
+	addFile(sys, "boot.bin", 0, GCN_Boot_Info_ADDRESS);
+	addFile(sys, "bi2.bin", GCN_Boot_Info_ADDRESS, BI2_SIZE);
+
+	// Apploader
+	uint32_t u32;
+	memcpy(&u32, &hdr[APPLOADER_ADDRESS + APPLOADER_SIZE_OFFSET], sizeof(u32));
+	uint64_t apploader_size = APPLOADER_HEADER_SIZE + static_cast<uint64_t>(be32_to_cpu(u32));
+	memcpy(&u32, &hdr[APPLOADER_ADDRESS + APPLOADER_TRAILER_SIZE_OFFSET], sizeof(u32));
+	apploader_size += be32_to_cpu(u32);
+	addFile(sys, "apploader.img", APPLOADER_ADDRESS, apploader_size);
+
+	// Boot block offsets are RSH2 on Wii.
+	GCN_Boot_Block bb;
+	memcpy(&bb, &hdr[GCN_Boot_Block_ADDRESS], sizeof(bb));
+	const uint64_t dol_offset = static_cast<uint64_t>(be32_to_cpu(bb.bootFilePosition)) << 2;
+	const uint64_t fst_offset = static_cast<uint64_t>(be32_to_cpu(bb.FSTPosition)) << 2;
+	const uint64_t fst_size = static_cast<uint64_t>(be32_to_cpu(bb.FSTLength)) << 2;
+
+	// main.dol: The size is the end of the last section.
+	DOL_Header dol;
+	if (dol_offset != 0 && ptReader->read(&dol, dol_offset, sizeof(dol)) == sizeof(dol)) {
+		uint64_t dol_size = sizeof(dol);
+		for (unsigned int i = 0; i < ARRAY_SIZE(dol.textData); i++) {
+			const uint64_t end = static_cast<uint64_t>(be32_to_cpu(dol.textData[i])) + be32_to_cpu(dol.textLen[i]);
+			if (end > dol_size) {
+				dol_size = end;
+			}
+		}
+		for (unsigned int i = 0; i < ARRAY_SIZE(dol.dataData); i++) {
+			const uint64_t end = static_cast<uint64_t>(be32_to_cpu(dol.dataData[i])) + be32_to_cpu(dol.dataLen[i]);
+			if (end > dol_size) {
+				dol_size = end;
+			}
+		}
+		addFile(sys, "main.dol", dol_offset, dol_size);
+	}
+
+	// FST
+	if (fst_offset == 0 || fst_size == 0) {
+		// No FST.
+		return 0;
+	} else if (fst_size > FST_SIZE_MAX || fst_offset + fst_size > ptReader->size()) {
+		return -EIO;
+	}
+	addFile(sys, "fst.bin", fst_offset, fst_size);
+
+	unique_ptr<uint8_t[]> fst(new uint8_t[static_cast<size_t>(fst_size)]);
+	errno = 0;
+	if (ptReader->read(fst.get(), fst_offset, static_cast<size_t>(fst_size)) != fst_size) {
+		return (errno != 0 ? -errno : -EIO);
+	}
+	return addFst(files, fst.get(), static_cast<size_t>(fst_size), 2);
+}
+
+/**
+ * Look up an entry by path.
+ * @param path	[in] Path, relative to the root. ("/" is the root.)
+ * @return Entry index, or -1 if not found.
+ */
+int DiscFs::lookup(const char *path) const
+{
+	unsigned int idx = ROOT;
+	while (*path != '\0') {
+		if (*path == '/') {
+			path++;
+			continue;
+		}
+
+		const char *const slash = strchr(path, '/');
+		const size_t len = (slash ? static_cast<size_t>(slash - path) : strlen(path));
+		const Entry &dir = m_entries[idx];
+		if (!dir.is_dir) {
+			return -1;
+		}
+		auto iter = dir.children.find(string(path, len));
+		if (iter == dir.children.end()) {
+			return -1;
+		}
+		idx = iter->second;
+		path += len;
+	}
+
+	return static_cast<int>(idx);
+}
@@ -0,0 +1,110 @@
+/***************************************************************************
+ * RVT-H Tool (librvth)                                                    *
+ * DiscFs.hpp: Wii partition filesystem tree.                              *
+ *                                                                         *
+ * Copyright (c) 2026 by David Korth.                                      *
+ * SPDX-License-Identifier: GPL-2.0-or-later                               *
+ ***************************************************************************/
+
+#pragma once
+
+#include "libwiicrypto/common.h"
+
+// C includes
+#include <stdint.h>
+#include <stddef.h>
+
+// C++ includes
+#include <map>
+#include <string>
+#include <vector>
+
+class PartitionReader;
+
+/**
+ * Filesystem tree of a Wii partition, in the same layout as
+ * Dolphin's "Extract Entire Disc":
+ * - sys/boot.bin, sys/bi2.bin, sys/apploader.img, sys/main.dol, sys/fst.bin
+ * - files/: Everything in the FST.
+ *
+ * Only the tree is stored. File data is read from the partition
+ * using each file's offset and size.
+ */
+class DiscFs
+{
+public:
+	DiscFs();
+
+private:
+	DISABLE_COPY(DiscFs)
+
+public:
+	// Index of the root directory.
+	static constexpr unsigned int ROOT = 0;
+
+	struct Entry {
+		std::string name;	// Name
+		bool is_dir;		// True if this is a directory.
+		uint64_t offset;	// Offset in the partition (files only)
+		uint64_t size;		// Size, in bytes (files only)
+
+		// Directory contents: name -> entry index (directories only)
+		std::map<std::string, unsigned int> children;
+	};
+
+	/**
+	 * Load the filesystem from a Wii partition.
+	 * @param ptReader	[in] PartitionReader
+	 * @return 0 on success; negative POSIX error code on error.
+	 */
+	int load(PartitionReader *ptReader);
+
+	/**
+	 * Add a directory.
+	 * If an entry with the same name already exists, it's returned instead.
+	 * @param parent	[in] Parent directory
+	 * @param name		[in] Name
+	 * @return Entry index
+	 */
+	unsigned int addDir(unsigned int parent, const std::string &name);
+
+	/**
+	 * Add a file.
+	 * If an entry with the same name already exists, it's kept.
+	 * @param parent	[in] Parent directory
+	 * @param name		[in] Name
+	 * @param offset	[in] Offset in the partition
+	 * @param size		[in] Size, in bytes
+	 */
+	void addFile(unsigned int parent, const std::string &name, uint64_t offset, uint64_t size);
+
+	/**
+	 * Add the contents of an FST to a directory.
+	 * @param dir		[in] Directory
+	 * @param fst		[in] FST
+	 * @param fst_size	[in] Size of the FST, in bytes
+	 * @param shift		[in] File offset shift (2 for Wii; 0 for GameCube)
+	 * @return 0 on success; negative POSIX error code on error.
+	 */
+	int addFst(unsigned int dir, const uint8_t *fst, size_t fst_size, unsigned int shift);
+
+	/**
+	 * Look up an entry by path.
+	 * @param path	[in] Path, relative to the root. ("/" is the root.)
+	 * @return Entry index, or -1 if not found.
+	 */
+	int lookup(const char *path) const;
+
+	/**
+	 * Get an entry.
+	 * @param idx	[in] Entry index
+	 * @return Entry
+	 */
+	inline const Entry &entry(unsigned int idx) const
+	{
+		return m_entries[idx];
+	}
+
+private:
+	std::vector<Entry> m_entries;
+};
@@ -0,0 +1,184 @@
+/***************************************************************************
+ * RVT-H Tool (librvth)                                                    *
+ * DiscHasher.cpp: CRC-32, MD5, and SHA-1 digests of a disc image.         *
+ *                                                                         *
+ * Copyright (c) 2026 by David Korth.                                      *
+ * SPDX-License-Identifier: GPL-2.0-or-later                               *
+ ***************************************************************************/
+
+#include "DiscHasher.hpp"
+#include "rvth.hpp"
+
+#include "libwiicrypto/crc32.h"
+
+// C includes (C++ namespace)
+#include <cassert>
+#include <cstring>
+
+// Nettle
+#include <nettle/md5.h>
+#include <nettle/sha1.h>
+
+DiscHasher::DiscHasher()
+	: m_cur(nullptr)
+	, m_size(0)
+	, m_crc32(0)
+{
+	memset(m_md5, 0, sizeof(m_md5));
+	memset(m_sha1, 0, sizeof(m_sha1));
+
+	m_jobs.reserve(BUF_COUNT);
+	for (unsigned int i = 0; i < BUF_COUNT; i++) {
+		Job *const job = new Job;
+		job->buf.reset(new uint8_t[BUF_SIZE]);
+		job->size = 0;
+		job->refs = 0;
+		m_jobs.emplace_back(job);
+		m_freeQueue.push(job);
+	}
+
+	for (unsigned int i = 0; i < ALGO_MAX; i++) {
+		m_threads[i] = std::thread(&DiscHasher::run, this, static_cast<Algo>(i));
+	}
+}
+
+DiscHasher::~DiscHasher()
+{
+	stop();
+}
+
+/**
+ * Stop the digest threads.
+ */
+void DiscHasher::stop(void)
+{
+	for (unsigned int i = 0; i < ALGO_MAX; i++) {
+		m_workQueue[i].close();
+	}
+	for (unsigned int i = 0; i < ALGO_MAX; i++) {
+		if (m_threads[i].joinable()) {
+			m_threads[i].join();
+		}
+	}
+}
+
+/**
+ * Add data to the stream.
+ * @param pData	[in] Data
+ * @param size	[in] Size of the data, in bytes
+ */
+void DiscHasher::update(const uint8_t *pData, size_t size)
+{
+	m_size += size;
+	while (size > 0) {
+		if (!m_cur) {
+			// Wait for a free buffer.
+			if (!m_freeQueue.pop(m_cur)) {
+				// Shouldn't happen...
+				assert(!"Free queue was closed.");
+				return;
+			}
+			m_cur->size = 0;
+		}
+
+		size_t chunk = BUF_SIZE - m_cur->size;
+		if (chunk > size) {
+			chunk = size;
+		}
+		memcpy(&m_cur->buf[m_cur->size], pData, chunk);
+		m_cur->size += chunk;
+		pData += chunk;
+		size -= chunk;
+
+		if (m_cur->size == BUF_SIZE) {
+			submit();
+		}
+	}
+}
+
+/**
+ * Submit the current buffer to the digest threads.
+ */
+void DiscHasher::submit(void)
+{
+	m_cur->refs = ALGO_MAX;
+	for (unsigned int i = 0; i < ALGO_MAX; i++) {
+		m_workQueue[i].push(m_cur);
+	}
+	m_cur = nullptr;
+}
+
+/**
+ * Finish the digests.
+ * @param pDigests	[out] Digests
+ */
+void DiscHasher::finish(RvtH_Digests *pDigests)
+{
+	if (m_cur && m_cur->size > 0) {
+		submit();
+	}
+	stop();
+
+	pDigests->size = m_size;
+	pDigests->crc32 = m_crc32;
+	memcpy(pDigests->md5, m_md5, sizeof(pDigests->md5));
+	memcpy(pDigests->sha1, m_sha1, sizeof(pDigests->sha1));
+}
+
+/**
+ * Digest thread.
+ * @param algo	[in] Digest algorithm
+ */
+void DiscHasher::run(Algo algo)
+{
+	uint32_t crc = 0;
+	struct md5_ctx md5;
+	struct sha1_ctx sha1;
+	switch (algo) {
+		case ALGO_MD5:
+			md5_init(&md5);
+			break;
+		case ALGO_SHA1:
+			sha1_init(&sha1);
+			break;
+		default:
+			break;
+	}
+
+	Job *job;
+	while (m_workQueue[algo].pop(job)) {
+		switch (algo) {
+			case ALGO_CRC32:
+				crc = crc32_update(crc, job->buf.get(), job->size);
+				break;
+			case ALGO_MD5:
+				md5_update(&md5, job->size, job->buf.get());
+				break;
+			case ALGO_SHA1:
+				sha1_update(&sha1, job->size, job->buf.get());
+				break;
+			default:
+				assert(!"Invalid digest algorithm.");
+				break;
+		}
+
+		// The last thread to finish with the buffer returns it.
+		if (--job->refs == 0) {
+			m_freeQueue.push(job);
+		}
+	}
+
+	switch (algo) {
+		case ALGO_CRC32:
+			m_crc32 = crc;
+			break;
+		case ALGO_MD5:
+			md5_digest(&md5, sizeof(m_md5), m_md5);
+			break;
+		case ALGO_SHA1:
+			sha1_digest(&sha1, sizeof(m_sha1), m_sha1);
+			break;
+		default:
+			break;
+	}
+}
@@ -0,0 +1,108 @@
+/***************************************************************************
+ * RVT-H Tool (librvth)                                                    *
+ * DiscHasher.hpp: CRC-32, MD5, and SHA-1 digests of a disc image.         *
+ *                                                                         *
+ * Copyright (c) 2026 by David Korth.                                      *
+ * SPDX-License-Identifier: GPL-2.0-or-later                               *
+ ***************************************************************************/
+
+#pragma once
+
+#include "libwiicrypto/common.h"
+#include "BlockingQueue.hpp"
+
+// C includes
+#include <stdint.h>
+
+// C++ includes
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <vector>
+
+struct _RvtH_Digests;
+
+/**
+ * Computes the CRC-32, MD5, and SHA-1 of a data stream, as listed
+ * in disc image catalogs, while the stream is being copied.
+ *
+ * Data passed to update() is copied into a small ring of buffers,
+ * and each digest is computed on its own thread, so the caller
+ * only waits if the digests fall behind by the whole ring.
+ *
+ * update() and finish() must be called from the same thread.
+ * Destroying the object without calling finish() discards the
+ * digests, so the caller can bail out at any time.
+ */
+class DiscHasher
+{
+public:
+	DiscHasher();
+	~DiscHasher();
+
+private:
+	DISABLE_COPY(DiscHasher)
+
+public:
+	// Buffer size and number of buffers.
+	static constexpr unsigned int BUF_SIZE = 1U * 1024U * 1024U;
+	static constexpr unsigned int BUF_COUNT = 8;
+
+	/**
+	 * Add data to the stream.
+	 * @param pData	[in] Data
+	 * @param size	[in] Size of the data, in bytes
+	 */
+	void update(const uint8_t *pData, size_t size);
+
+	/**
+	 * Finish the digests.
+	 * @param pDigests	[out] Digests
+	 */
+	void finish(struct _RvtH_Digests *pDigests);
+
+private:
+	enum Algo {
+		ALGO_CRC32,
+		ALGO_MD5,
+		ALGO_SHA1,
+
+		ALGO_MAX
+	};
+
+	struct Job {
+		std::unique_ptr<uint8_t[]> buf;
+		size_t size;			// Number of bytes used
+		std::atomic<unsigned int> refs;	// Number of digest threads using the buffer
+	};
+
+	/**
+	 * Submit the current buffer to the digest threads.
+	 */
+	void submit(void);
+
+	/**
+	 * Stop the digest threads.
+	 */
+	void stop(void);
+
+	/**
+	 * Digest thread.
+	 * @param algo	[in] Digest algorithm
+	 */
+	void run(Algo algo);
+
+private:
+	std::vector<std::unique_ptr<Job> > m_jobs;
+	Job *m_cur;			// Buffer being filled by update()
+	uint64_t m_size;		// Total number of bytes
+
+	BlockingQueue<Job*> m_freeQueue;
+	BlockingQueue<Job*> m_workQueue[ALGO_MAX];
+	std::thread m_threads[ALGO_MAX];
+
+	// Results, written by the digest threads.
+	uint32_t m_crc32;
+	uint8_t m_md5[16];
+	uint8_t m_sha1[20];
+};
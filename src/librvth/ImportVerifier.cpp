@@ -0,0 +1,324 @@
+/***************************************************************************
+ * RVT-H Tool (librvth)                                                    *
+ * ImportVerifier.cpp: Verify Wii partition hashes during an import.       *
+ *                                                                         *
+ * Copyright (c) 2026 by David Korth.                                      *
+ * SPDX-License-Identifier: GPL-2.0-or-later                               *
+ ***************************************************************************/
+
+#include "ImportVerifier.hpp"
+#include "rvth.hpp"
+#include "RefFile.hpp"
+
+// Reader class
+#include "reader/Reader.hpp"
+
+// Encryption
+#include "aesw.h"
+
+// C includes (C++ namespace)
+#include <cassert>
+#include <cerrno>
+#include <cstring>
+
+// C++ includes
+#include <algorithm>
+using std::thread;
+using std::unique_ptr;
+using std::vector;
+
+/**
+ * Create an ImportVerifier.
+ * @param threads	[in] Number of worker threads (0 for default)
+ */
+ImportVerifier::ImportVerifier(unsigned int threads)
+	: m_threadCount(threads)
+	, m_part_idx(0)
+	, m_group(0)
+	, m_cur(nullptr)
+	, m_cur_filled(0)
+	, m_reader_dest(nullptr)
+	, m_reread_errs(0)
+	, m_err(0)
+{
+	if (m_threadCount == 0) {
+		// The import is usually limited by the write speed,
+		// so there's no point in using more than a few threads.
+		m_threadCount = std::min(thread::hardware_concurrency(), 4U);
+		if (m_threadCount == 0) {
+			m_threadCount = 1;
+		}
+	}
+
+	for (std::atomic<unsigned int> &errs : m_errs) {
+		errs = 0;
+	}
+}
+
+ImportVerifier::~ImportVerifier()
+{
+	stop();
+}
+
+/**
+ * Stop the worker threads.
+ */
+void ImportVerifier::stop(void)
+{
+	m_workQueue.close();
+	for (thread &t : m_threads) {
+		if (t.joinable()) {
+			t.join();
+		}
+	}
+	m_threads.clear();
+}
+
+/**
+ * Load an encrypted Wii partition's header and H3 table.
+ * Partitions must be added before calling start().
+ * @param reader	[in] Source Reader
+ * @param pte		[in] Partition table entry (must be valid until finish())
+ * @return 0 on success; negative POSIX error code or RvtH_Errors on error.
+ */
+int ImportVerifier::addPartition(Reader *reader, const pt_entry_t *pte)
+{
+	assert(m_threads.empty());
+
+	unique_ptr<VerifyPartition> part(new VerifyPartition);
+	part->reader = reader;
+	part->pte = pte;
+	part->pt_idx = static_cast<unsigned int>(m_parts.size());
+
+	unique_ptr<RVL_PartitionHeader> pt_hdr(new RVL_PartitionHeader);
+	int ret = rvth_verify_load_partition(pt_hdr.get(), part.get());
+	if (ret != 0) {
+		return ret;
+	}
+
+	// The whole partition must be present.
+	const uint32_t lba_len = rvth_verify_groups_lba_len(pte, part->lba_data, part->group_count);
+	if ((lba_len + LBAS_PER_GROUP - 1) / LBAS_PER_GROUP < part->group_count) {
+		// Partition is truncated.
+		return -EIO;
+	}
+
+	if (part->h4_error) {
+		m_errs[4]++;
+	}
+
+	// Keep the partitions in LBA order.
+	auto iter = m_parts.begin();
+	auto iter_len = m_parts_lba_len.begin();
+	while (iter != m_parts.end() && (*iter)->lba_data < part->lba_data) {
+		++iter;
+		++iter_len;
+	}
+	m_parts_lba_len.insert(iter_len, lba_len);
+	m_parts.insert(iter, std::move(part));
+	return 0;
+}
+
+/**
+ * Start the worker threads.
+ * If the destination can't be dropped from the OS page cache,
+ * groups aren't re-read, and finish() reports that.
+ * @param reader_dest	[in,opt] Destination Reader, if written groups should be re-read.
+ */
+void ImportVerifier::start(Reader *reader_dest)
+{
+	assert(m_threads.empty());
+
+	m_reader_dest = reader_dest;
+	if (m_reader_dest && m_reader_dest->dropCache(0, 1) != 0) {
+		// Re-reading would return the data from the OS page cache
+		// instead of checking what was written to the device.
+		m_reader_dest = nullptr;
+	}
+	if (m_reader_dest) {
+		m_rbuf = aligned_uptr<uint8_t>(RefFile::DIRECT_IO_ALIGN, GROUP_SIZE_ENC);
+	}
+
+	// Two groups per thread, so one can be assembled
+	// while the other is being verified.
+	const unsigned int job_count = m_threadCount * 2;
+	m_jobs.reserve(job_count);
+	for (unsigned int i = 0; i < job_count; i++) {
+		Job *const job = new Job;
+		job->buf = aligned_uptr<uint8_t>(RefFile::DIRECT_IO_ALIGN, GROUP_SIZE_ENC);
+		job->gdata.reset(new Wii_Disc_Sector_t[64]);
+		job->part = nullptr;
+		job->H3_entry = nullptr;
+		job->max_sector = 64;
+		m_jobs.emplace_back(job);
+		m_freeQueue.push(job);
+	}
+
+	m_threads.reserve(m_threadCount);
+	for (unsigned int i = 0; i < m_threadCount; i++) {
+		m_threads.emplace_back(&ImportVerifier::run, this);
+	}
+}
+
+/**
+ * Process data that was written to the destination.
+ * Data must be passed in order, with no gaps.
+ * @param buf		[in] Source data
+ * @param lba_start	[in] Starting LBA
+ * @param lba_len	[in] Length, in LBAs
+ */
+void ImportVerifier::update(const uint8_t *buf, uint32_t lba_start, uint32_t lba_len)
+{
+	const uint32_t lba_end = lba_start + lba_len;
+	while (m_part_idx < m_parts.size()) {
+		const VerifyPartition *const part = m_parts[m_part_idx].get();
+		const uint32_t part_lba_len = m_parts_lba_len[m_part_idx];
+
+		// Current group.
+		const uint32_t group_offset = m_group * LBAS_PER_GROUP;
+		const uint32_t g_start = part->lba_data + group_offset;
+		const uint32_t g_len = std::min(part_lba_len - group_offset, static_cast<uint32_t>(LBAS_PER_GROUP));
+		const uint32_t g_end = g_start + g_len;
+		if (g_start >= lba_end) {
+			// Group starts in a later chunk.
+			break;
+		}
+
+		// Copy the part of the group that's in this chunk.
+		const uint32_t copy_start = std::max(g_start, lba_start);
+		const uint32_t copy_end = std::min(g_end, lba_end);
+		if (copy_start < copy_end) {
+			if (!m_cur) {
+				// Wait for a free group buffer.
+				if (!m_freeQueue.pop(m_cur)) {
+					// Shouldn't happen...
+					assert(!"Free queue was closed.");
+					return;
+				}
+				m_cur_filled = 0;
+			}
+			memcpy(&m_cur->buf[LBA_TO_BYTES(copy_start - g_start)],
+				&buf[LBA_TO_BYTES(copy_start - lba_start)],
+				LBA_TO_BYTES(copy_end - copy_start));
+			m_cur_filled += copy_end - copy_start;
+		}
+
+		if (g_end > lba_end) {
+			// Group continues in the next chunk.
+			break;
+		}
+
+		// Group is complete.
+		submit(part, m_group, g_start, g_len);
+		m_group++;
+		if (m_group >= part->group_count) {
+			// Next partition.
+			m_part_idx++;
+			m_group = 0;
+		}
+	}
+}
+
+/**
+ * Submit the current group to the worker threads.
+ * @param part		[in] Partition
+ * @param group		[in] Group number
+ * @param lba_start	[in] Starting LBA of the group
+ * @param lba_len	[in] Length of the group, in LBAs
+ */
+void ImportVerifier::submit(const VerifyPartition *part, unsigned int group, uint32_t lba_start, uint32_t lba_len)
+{
+	Job *const job = m_cur;
+	m_cur = nullptr;
+	if (!job || m_cur_filled != lba_len) {
+		// Part of the group is missing.
+		// This shouldn't happen, since chunks are passed in order.
+		setError(-EIO);
+		if (job) {
+			m_freeQueue.push(job);
+		}
+		return;
+	}
+
+	if (m_reader_dest) {
+		// Read the group back from the destination and compare it.
+		// The data was flushed by the import loop, so it can be
+		// dropped from the page cache first.
+		const int ret = m_reader_dest->dropCache(lba_start, lba_len);
+		if (ret != 0) {
+			setError(ret);
+		}
+		const size_t size = LBA_TO_BYTES(lba_len);
+		const size_t lba_size = m_reader_dest->read(m_rbuf.get(), lba_start, lba_len);
+		if (lba_size != lba_len || memcmp(m_rbuf.get(), job->buf.get(), size) != 0) {
+			m_reread_errs++;
+		}
+	}
+
+	// Incomplete last group. (See read_group() in verify.cpp.)
+	job->max_sector = std::min(part->groupSectors(group), lba_len / 64);
+	job->part = part;
+	job->H3_entry = part->H3_tbl->h3[group];
+	m_workQueue.push(job);
+}
+
+/**
+ * Worker thread.
+ */
+void ImportVerifier::run(void)
+{
+	// Each worker thread needs its own AES context.
+	AesCtx *const aesw = aesw_new();
+	if (!aesw) {
+		int err = errno;
+		if (err == 0) {
+			err = ENOMEM;
+		}
+		setError(-err);
+	}
+	const VerifyPartition *key_part = nullptr;
+
+	Job *job;
+	while (m_workQueue.pop(job)) {
+		if (aesw) {
+			if (job->part != key_part) {
+				key_part = job->part;
+				aesw_set_key(aesw, key_part->title_key, sizeof(key_part->title_key));
+			}
+			rvth_verify_group(aesw, reinterpret_cast<const Wii_Disc_Sector_t*>(job->buf.get()),
+				job->gdata.get(), job->H3_entry, job->max_sector, job->errors);
+			for (const VerifyError &error : job->errors) {
+				m_errs[error.hash_level]++;
+			}
+		}
+		m_freeQueue.push(job);
+	}
+
+	if (aesw) {
+		aesw_free(aesw);
+	}
+}
+
+/**
+ * Wait for the worker threads and get the results.
+ * @param pStats	[out,opt] Import statistics (verification fields only)
+ * @return 0 on success; negative POSIX error code on error.
+ */
+int ImportVerifier::finish(RvtH_Import_Stats *pStats)
+{
+	if (m_part_idx < m_parts.size()) {
+		// Not all of the groups were received.
+		setError(-EIO);
+	}
+	stop();
+
+	if (pStats) {
+		pStats->verified = true;
+		for (unsigned int i = 0; i < ARRAY_SIZE(pStats->verify_errs); i++) {
+			pStats->verify_errs[i] = m_errs[i];
+		}
+		pStats->reread = (m_reader_dest != nullptr);
+		pStats->reread_errs = m_reread_errs;
+	}
+	return m_err;
+}
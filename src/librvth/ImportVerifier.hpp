@@ -0,0 +1,160 @@
+/***************************************************************************
+ * RVT-H Tool (librvth)                                                    *
+ * ImportVerifier.hpp: Verify Wii partition hashes during an import.       *
+ *                                                                         *
+ * Copyright (c) 2026 by David Korth.                                      *
+ * SPDX-License-Identifier: GPL-2.0-or-later                               *
+ ***************************************************************************/
+
+#pragma once
+
+#include "libwiicrypto/common.h"
+#include "aligned_malloc.h"
+#include "BlockingQueue.hpp"
+#include "verify_group.hpp"
+#include "ptbl.h"
+
+// C includes
+#include <stdint.h>
+
+// C++ includes
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <vector>
+
+class Reader;
+struct _RvtH_Import_Stats;
+
+/**
+ * Checks the H0-H4 hash tree of the encrypted Wii partitions in a
+ * disc image while the image is being imported, so a separate
+ * verification pass isn't needed afterwards.
+ *
+ * The import loop passes each chunk to update() after writing it.
+ * Chunks are assembled into groups, and complete groups are checked
+ * by worker threads using the same kernel as RvtH::verifyWiiPartitions().
+ *
+ * Optionally, each group is read back from the destination bank
+ * as soon as it's complete and compared with the source data.
+ * The read is done on the calling thread, since Reader isn't
+ * thread-safe. The group is dropped from the OS page cache first,
+ * so it's read from the device instead of from memory.
+ *
+ * addPartition(), start(), update(), and finish() must be called
+ * from the same thread.
+ */
+class ImportVerifier
+{
+public:
+	/**
+	 * Create an ImportVerifier.
+	 * @param threads	[in] Number of worker threads (0 for default)
+	 */
+	explicit ImportVerifier(unsigned int threads = 0);
+	~ImportVerifier();
+
+private:
+	DISABLE_COPY(ImportVerifier)
+
+public:
+	/**
+	 * Load an encrypted Wii partition's header and H3 table.
+	 * Partitions must be added before calling start().
+	 * @param reader	[in] Source Reader
+	 * @param pte		[in] Partition table entry (must be valid until finish())
+	 * @return 0 on success; negative POSIX error code or RvtH_Errors on error.
+	 */
+	int addPartition(Reader *reader, const pt_entry_t *pte);
+
+	/**
+	 * Start the worker threads.
+	 * If the destination can't be dropped from the OS page cache,
+	 * groups aren't re-read, and finish() reports that.
+	 * @param reader_dest	[in,opt] Destination Reader, if written groups should be re-read.
+	 */
+	void start(Reader *reader_dest);
+
+	/**
+	 * Process data that was written to the destination.
+	 * Data must be passed in order, with no gaps.
+	 * @param buf		[in] Source data
+	 * @param lba_start	[in] Starting LBA
+	 * @param lba_len	[in] Length, in LBAs
+	 */
+	void update(const uint8_t *buf, uint32_t lba_start, uint32_t lba_len);
+
+	/**
+	 * Wait for the worker threads and get the results.
+	 * @param pStats	[out,opt] Import statistics (verification fields only)
+	 * @return 0 on success; negative POSIX error code on error.
+	 */
+	int finish(struct _RvtH_Import_Stats *pStats);
+
+private:
+	struct Job {
+		aligned_unique_ptr<uint8_t> buf;		// 2 MB, encrypted group
+		std::unique_ptr<Wii_Disc_Sector_t[]> gdata;	// 2 MB, decrypted group
+		std::vector<VerifyError> errors;		// Errors found in this group
+
+		const VerifyPartition *part;	// Partition
+		const uint8_t *H3_entry;	// H3 hash for this group
+		unsigned int max_sector;	// Number of sectors to check
+	};
+
+	/**
+	 * Stop the worker threads.
+	 */
+	void stop(void);
+
+	/**
+	 * Submit the current group to the worker threads.
+	 * @param part		[in] Partition
+	 * @param group		[in] Group number
+	 * @param lba_start	[in] Starting LBA of the group
+	 * @param lba_len	[in] Length of the group, in LBAs
+	 */
+	void submit(const VerifyPartition *part, unsigned int group, uint32_t lba_start, uint32_t lba_len);
+
+	/**
+	 * Worker thread.
+	 */
+	void run(void);
+
+	/**
+	 * Record an error, if no error has been recorded yet.
+	 * @param err	[in] Negative POSIX error code
+	 */
+	inline void setError(int err)
+	{
+		int expected = 0;
+		m_err.compare_exchange_strong(expected, err);
+	}
+
+private:
+	unsigned int m_threadCount;
+	std::vector<std::thread> m_threads;
+	std::vector<std::unique_ptr<Job> > m_jobs;
+	BlockingQueue<Job*> m_freeQueue;
+	BlockingQueue<Job*> m_workQueue;
+
+	// Partitions, in LBA order, and the number of LBAs in each
+	// partition's groups.
+	std::vector<std::unique_ptr<VerifyPartition> > m_parts;
+	std::vector<uint32_t> m_parts_lba_len;
+
+	// Group being assembled by update().
+	unsigned int m_part_idx;
+	unsigned int m_group;
+	Job *m_cur;
+	uint32_t m_cur_filled;		// Number of LBAs copied into m_cur
+
+	// Re-read buffer.
+	Reader *m_reader_dest;
+	aligned_unique_ptr<uint8_t> m_rbuf;
+
+	// Results
+	std::atomic<unsigned int> m_errs[5];	// Hash errors, by level (H0-H4)
+	unsigned int m_reread_errs;		// Groups that didn't match when re-read
+	std::atomic<int> m_err;			// First error (negative POSIX error code)
+};
@@ -0,0 +1,376 @@
+/***************************************************************************
+ * RVT-H Tool (librvth)                                                    *
+ * IoQueue.cpp: Queued positional I/O engine for RefFile.                  *
+ *                                                                         *
+ * Copyright (c) 2026 by David Korth.                                      *
+ * SPDX-License-Identifier: GPL-2.0-or-later                               *
+ ***************************************************************************/
+
+#include "config.librvth.h"
+
+#include "IoQueue.hpp"
+
+// C includes (C++ namespace)
+#include <cassert>
+#include <cerrno>
+#include <cstring>
+
+#ifdef HAVE_IO_URING
+// io_uring is used directly through its system calls,
+// so liburing isn't required.
+#  include <linux/io_uring.h>
+#  include <sys/mman.h>
+#  include <sys/syscall.h>
+#  include <unistd.h>
+
+/**
+ * io_uring submission and completion rings.
+ */
+struct IoQueue::Ring {
+	Ring()
+		: fd(-1)
+		, sq_ptr(MAP_FAILED), sq_size(0)
+		, cq_ptr(MAP_FAILED), cq_size(0)
+		, sqes(static_cast<struct io_uring_sqe*>(MAP_FAILED)), sqes_size(0)
+		, to_submit(0)
+	{ }
+
+	~Ring()
+	{
+		if (sqes != MAP_FAILED) {
+			munmap(sqes, sqes_size);
+		}
+		if (cq_ptr != MAP_FAILED && cq_ptr != sq_ptr) {
+			munmap(cq_ptr, cq_size);
+		}
+		if (sq_ptr != MAP_FAILED) {
+			munmap(sq_ptr, sq_size);
+		}
+		if (fd >= 0) {
+			close(fd);
+		}
+	}
+
+	/**
+	 * Set up the ring.
+	 * @param entries Number of submission queue entries
+	 * @return 0 on success; negative POSIX error code on error.
+	 */
+	int init(unsigned int entries)
+	{
+		struct io_uring_params p;
+		memset(&p, 0, sizeof(p));
+		fd = static_cast<int>(syscall(__NR_io_uring_setup, entries, &p));
+		if (fd < 0) {
+			return -errno;
+		}
+
+		sq_size = p.sq_off.array + p.sq_entries * sizeof(unsigned int);
+		cq_size = p.cq_off.cqes + p.cq_entries * sizeof(struct io_uring_cqe);
+		if (p.features & IORING_FEAT_SINGLE_MMAP) {
+			if (cq_size > sq_size) {
+				sq_size = cq_size;
+			}
+			cq_size = sq_size;
+		}
+
+		sq_ptr = mmap(nullptr, sq_size, PROT_READ | PROT_WRITE,
+			MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQ_RING);
+		if (sq_ptr == MAP_FAILED) {
+			return -errno;
+		}
+		if (p.features & IORING_FEAT_SINGLE_MMAP) {
+			cq_ptr = sq_ptr;
+		} else {
+			cq_ptr = mmap(nullptr, cq_size, PROT_READ | PROT_WRITE,
+				MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_CQ_RING);
+			if (cq_ptr == MAP_FAILED) {
+				return -errno;
+			}
+		}
+
+		sqes_size = p.sq_entries * sizeof(struct io_uring_sqe);
+		sqes = static_cast<struct io_uring_sqe*>(mmap(nullptr, sqes_size,
+			PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQES));
+		if (sqes == MAP_FAILED) {
+			return -errno;
+		}
+
+		uint8_t *const sq8 = static_cast<uint8_t*>(sq_ptr);
+		sq_head  = reinterpret_cast<unsigned int*>(sq8 + p.sq_off.head);
+		sq_tail  = reinterpret_cast<unsigned int*>(sq8 + p.sq_off.tail);
+		sq_mask  = *reinterpret_cast<unsigned int*>(sq8 + p.sq_off.ring_mask);
+		sq_array = reinterpret_cast<unsigned int*>(sq8 + p.sq_off.array);
+
+		uint8_t *const cq8 = static_cast<uint8_t*>(cq_ptr);
+		cq_head = reinterpret_cast<unsigned int*>(cq8 + p.cq_off.head);
+		cq_tail = reinterpret_cast<unsigned int*>(cq8 + p.cq_off.tail);
+		cq_mask = *reinterpret_cast<unsigned int*>(cq8 + p.cq_off.ring_mask);
+		cqes    = reinterpret_cast<struct io_uring_cqe*>(cq8 + p.cq_off.cqes);
+		return 0;
+	}
+
+	/**
+	 * Enter the kernel to submit SQEs and/or wait for CQEs.
+	 * @param min_complete Minimum number of completions to wait for
+	 * @return 0 on success; negative POSIX error code on error.
+	 */
+	int enter(unsigned int min_complete)
+	{
+		while (to_submit > 0 || min_complete > 0) {
+			const int ret = static_cast<int>(syscall(__NR_io_uring_enter, fd,
+				to_submit, min_complete,
+				(min_complete > 0 ? IORING_ENTER_GETEVENTS : 0), nullptr, 0));
+			if (ret < 0) {
+				if (errno == EINTR || errno == EAGAIN || errno == EBUSY)
+					continue;
+				return -errno;
+			}
+			to_submit -= static_cast<unsigned int>(ret);
+			if (min_complete > 0) {
+				// Completions are available now.
+				break;
+			}
+		}
+		return 0;
+	}
+
+	int fd;
+	void *sq_ptr;
+	size_t sq_size;
+	void *cq_ptr;
+	size_t cq_size;
+	struct io_uring_sqe *sqes;
+	size_t sqes_size;
+
+	unsigned int *sq_head;
+	unsigned int *sq_tail;
+	unsigned int sq_mask;
+	unsigned int *sq_array;
+	unsigned int *cq_head;
+	unsigned int *cq_tail;
+	unsigned int cq_mask;
+	struct io_uring_cqe *cqes;
+
+	unsigned int to_submit;	// SQEs queued but not submitted
+
+	// Requests, indexed by SQE user_data.
+	struct Request {
+		uint8_t *ptr;
+		size_t size;
+		off64_t offset;
+		uintptr_t tag;
+	};
+	std::vector<Request> requests;
+	std::vector<unsigned int> freeRequests;
+};
+#else /* !HAVE_IO_URING */
+struct IoQueue::Ring { };
+#endif /* HAVE_IO_URING */
+
+/**
+ * Create an I/O queue.
+ * @param file	[in] RefFile
+ * @param depth	[in] Maximum number of reads in flight
+ */
+IoQueue::IoQueue(const RefFilePtr &file, unsigned int depth)
+	: m_file(file)
+	, m_depth(depth > 0 ? depth : 1)
+	, m_inFlight(0)
+{
+#ifdef HAVE_IO_URING
+	// Set up io_uring. If it isn't available (old kernel,
+	// or disabled by seccomp or sysctl), reads will be synchronous.
+	std::unique_ptr<Ring> ring(new Ring);
+	if (ring->init(m_depth) == 0) {
+		ring->requests.resize(m_depth);
+		ring->freeRequests.reserve(m_depth);
+		for (unsigned int i = m_depth; i > 0; i--) {
+			ring->freeRequests.push_back(i - 1);
+		}
+		m_ring = std::move(ring);
+	}
+#endif /* HAVE_IO_URING */
+}
+
+IoQueue::~IoQueue()
+{
+	// Wait for all asynchronous reads to finish,
+	// since the kernel is writing to the caller's buffers.
+	Completion completion;
+	while (m_ring && m_inFlight > 0) {
+		if (!wait(completion))
+			break;
+	}
+}
+
+/**
+ * Is asynchronous I/O in use?
+ * @return True if reads are asynchronous; false if they're synchronous.
+ */
+bool IoQueue::isAsync(void) const
+{
+	return (bool)m_ring;
+}
+
+/**
+ * Queue a read.
+ * The read won't start until submit() or wait() is called.
+ * @param ptr		[out] Read buffer
+ * @param size		[in] Number of bytes to read
+ * @param offset	[in] File offset
+ * @param tag		[in] Caller-defined tag, returned by wait()
+ */
+void IoQueue::read(void *ptr, size_t size, off64_t offset, uintptr_t tag)
+{
+	assert(!isFull());
+	m_inFlight++;
+
+#ifdef HAVE_IO_URING
+	if (m_ring) {
+		Ring *const ring = m_ring.get();
+		const unsigned int req_idx = ring->freeRequests.back();
+		ring->freeRequests.pop_back();
+		Ring::Request &req = ring->requests[req_idx];
+		req.ptr = static_cast<uint8_t*>(ptr);
+		req.size = size;
+		req.offset = offset;
+		req.tag = tag;
+
+		const unsigned int tail = *ring->sq_tail;
+		const unsigned int sqe_idx = tail & ring->sq_mask;
+		struct io_uring_sqe *const sqe = &ring->sqes[sqe_idx];
+		memset(sqe, 0, sizeof(*sqe));
+		sqe->opcode = IORING_OP_READ;
+		sqe->fd = m_file->fdForRequest(ptr, size, offset);
+		sqe->off = static_cast<uint64_t>(offset);
+		sqe->addr = reinterpret_cast<uintptr_t>(ptr);
+		sqe->len = static_cast<uint32_t>(size);
+		sqe->user_data = req_idx;
+		ring->sq_array[sqe_idx] = sqe_idx;
+		__atomic_store_n(ring->sq_tail, tail + 1, __ATOMIC_RELEASE);
+		ring->to_submit++;
+		return;
+	}
+#endif /* HAVE_IO_URING */
+
+	// Synchronous read.
+	Completion completion;
+	completion.tag = tag;
+	completion.ptr = static_cast<uint8_t*>(ptr);
+	completion.size = size;
+	completion.done = 0;
+	completeSync(completion, offset);
+	m_syncDone.push_back(completion);
+}
+
+/**
+ * Finish a read synchronously using RefFile::pread().
+ * @param completion	[in,out] Completion (done is updated)
+ * @param offset	[in] File offset of the start of the read
+ */
+void IoQueue::completeSync(Completion &completion, off64_t offset)
+{
+	errno = 0;
+	completion.done += m_file->pread(completion.ptr + completion.done,
+		completion.size - completion.done, offset + completion.done);
+	completion.err = 0;
+	if (completion.done != completion.size) {
+		completion.err = (errno != 0 ? errno : EIO);
+	}
+}
+
+/**
+ * Submit all queued reads.
+ */
+void IoQueue::submit(void)
+{
+#ifdef HAVE_IO_URING
+	if (m_ring) {
+		// NOTE: If submission fails, wait() will complete
+		// the reads synchronously.
+		m_ring->enter(0);
+	}
+#endif /* HAVE_IO_URING */
+}
+
+/**
+ * Wait for a read to complete.
+ *
+ * Failed or short asynchronous reads are retried using
+ * RefFile::pread(), so the completion reflects the same
+ * result as a synchronous read.
+ *
+ * @param completion	[out] Completion
+ * @return True if a read completed; false if no reads are in flight.
+ */
+bool IoQueue::wait(Completion &completion)
+{
+	if (m_inFlight == 0) {
+		return false;
+	}
+
+#ifdef HAVE_IO_URING
+	if (m_ring) {
+		Ring *const ring = m_ring.get();
+		unsigned int head = *ring->cq_head;
+		if (head == __atomic_load_n(ring->cq_tail, __ATOMIC_ACQUIRE)) {
+			while (ring->enter(1) != 0) {
+				// io_uring_enter() failed. If the kernel hasn't
+				// consumed the most recent SQE yet, take it back
+				// and do the read synchronously.
+				const unsigned int tail = *ring->sq_tail;
+				if (__atomic_load_n(ring->sq_head, __ATOMIC_ACQUIRE) == tail) {
+					// All SQEs were consumed. Keep waiting.
+					ring->to_submit = 0;
+					continue;
+				}
+				const struct io_uring_sqe *const sqe = &ring->sqes[(tail - 1) & ring->sq_mask];
+				const unsigned int req_idx = static_cast<unsigned int>(sqe->user_data);
+				__atomic_store_n(ring->sq_tail, tail - 1, __ATOMIC_RELEASE);
+				if (ring->to_submit > 0) {
+					ring->to_submit--;
+				}
+
+				const Ring::Request &req = ring->requests[req_idx];
+				completion.tag = req.tag;
+				completion.ptr = req.ptr;
+				completion.size = req.size;
+				completion.done = 0;
+				completeSync(completion, req.offset);
+				ring->freeRequests.push_back(req_idx);
+				m_inFlight--;
+				return true;
+			}
+			head = *ring->cq_head;
+		}
+
+		const struct io_uring_cqe *const cqe = &ring->cqes[head & ring->cq_mask];
+		const unsigned int req_idx = static_cast<unsigned int>(cqe->user_data);
+		const int res = cqe->res;
+		__atomic_store_n(ring->cq_head, head + 1, __ATOMIC_RELEASE);
+
+		const Ring::Request &req = ring->requests[req_idx];
+		completion.tag = req.tag;
+		completion.ptr = req.ptr;
+		completion.size = req.size;
+		completion.done = (res > 0 ? static_cast<size_t>(res) : 0);
+		completion.err = 0;
+		if (completion.done != completion.size) {
+			// Error or short read. Retry the rest synchronously.
+			// This handles EOF and unsupported direct I/O requests
+			// the same way as RefFile::pread().
+			completeSync(completion, req.offset);
+		}
+		ring->freeRequests.push_back(req_idx);
+		m_inFlight--;
+		return true;
+	}
+#endif /* HAVE_IO_URING */
+
+	assert(!m_syncDone.empty());
+	completion = m_syncDone.front();
+	m_syncDone.pop_front();
+	m_inFlight--;
+	return true;
+}
@@ -0,0 +1,127 @@
+/***************************************************************************
+ * RVT-H Tool (librvth)                                                    *
+ * IoQueue.hpp: Queued positional I/O engine for RefFile.                  *
+ *                                                                         *
+ * Copyright (c) 2026 by David Korth.                                      *
+ * SPDX-License-Identifier: GPL-2.0-or-later                               *
+ ***************************************************************************/
+
+#pragma once
+
+#include "RefFile.hpp"
+
+// C includes
+#include <stdint.h>
+
+// C++ includes
+#include <deque>
+#include <memory>
+#include <vector>
+
+/**
+ * Queued read engine for a RefFile.
+ *
+ * On Linux, if io_uring is available, reads are submitted to the
+ * kernel in batches and several can be in flight at once, which is
+ * needed to reach full bandwidth on USB-attached RVT-H Readers.
+ *
+ * Otherwise, each read is done synchronously using RefFile::pread()
+ * when it's queued, and wait() returns the results in order.
+ *
+ * This class is not thread-safe.
+ */
+class IoQueue
+{
+public:
+	/**
+	 * Create an I/O queue.
+	 * @param file	[in] RefFile
+	 * @param depth	[in] Maximum number of reads in flight
+	 */
+	IoQueue(const RefFilePtr &file, unsigned int depth);
+	~IoQueue();
+
+private:
+	DISABLE_COPY(IoQueue)
+
+public:
+	/**
+	 * Is asynchronous I/O in use?
+	 * @return True if reads are asynchronous; false if they're synchronous.
+	 */
+	bool isAsync(void) const;
+
+	/**
+	 * Is the queue full?
+	 * If it is, wait() must be called before queueing another read.
+	 * @return True if full; false if not.
+	 */
+	inline bool isFull(void) const
+	{
+		return (m_inFlight >= m_depth);
+	}
+
+	/**
+	 * Get the number of reads in flight.
+	 * @return Number of reads in flight.
+	 */
+	inline unsigned int inFlight(void) const
+	{
+		return m_inFlight;
+	}
+
+	/**
+	 * Queue a read.
+	 * The read won't start until submit() or wait() is called.
+	 * @param ptr		[out] Read buffer
+	 * @param size		[in] Number of bytes to read
+	 * @param offset	[in] File offset
+	 * @param tag		[in] Caller-defined tag, returned by wait()
+	 */
+	void read(void *ptr, size_t size, off64_t offset, uintptr_t tag);
+
+	/**
+	 * Submit all queued reads.
+	 */
+	void submit(void);
+
+	struct Completion {
+		uintptr_t tag;	// Tag from read()
+		uint8_t *ptr;	// Read buffer
+		size_t size;	// Number of bytes requested
+		size_t done;	// Number of bytes read
+		int err;	// POSIX error code if done is less than size
+	};
+
+	/**
+	 * Wait for a read to complete.
+	 *
+	 * Failed or short asynchronous reads are retried using
+	 * RefFile::pread(), so the completion reflects the same
+	 * result as a synchronous read.
+	 *
+	 * @param completion	[out] Completion
+	 * @return True if a read completed; false if no reads are in flight.
+	 */
+	bool wait(Completion &completion);
+
+private:
+	/**
+	 * Finish a read synchronously using RefFile::pread().
+	 * @param completion	[in,out] Completion (done is updated)
+	 * @param offset	[in] File offset of the start of the read
+	 */
+	void completeSync(Completion &completion, off64_t offset);
+
+private:
+	RefFilePtr m_file;
+	unsigned int m_depth;
+	unsigned int m_inFlight;
+
+	// Synchronous completions
+	std::deque<Completion> m_syncDone;
+
+	// io_uring ring (Linux only)
+	struct Ring;
+	std::unique_ptr<Ring> m_ring;
+};
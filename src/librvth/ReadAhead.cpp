@@ -0,0 +1,334 @@
+/***************************************************************************
+ * RVT-H Tool (librvth)                                                    *
+ * ReadAhead.cpp: Double-buffered read-ahead pipeline for bulk copies.     *
+ *                                                                         *
+ * Copyright (c) 2026 by David Korth.                                      *
+ * SPDX-License-Identifier: GPL-2.0-or-later                               *
+ ***************************************************************************/
+
+#include "ReadAhead.hpp"
+#include "IoQueue.hpp"
+#include "RefFile.hpp"
+#include "nhcd_structs.h"
+#include "reader/Reader.hpp"
+
+// C includes (C++ namespace)
+#include <cassert>
+#include <cerrno>
+#include <cstring>
+
+// Number of queued reads per buffer in asynchronous mode.
+// Compressed images may need more than one read per buffer.
+static constexpr unsigned int IOQUEUE_READS_PER_BUF = 4;
+
+/**
+ * Start a read-ahead pipeline.
+ *
+ * buf_size is rounded up to a multiple of 4096 bytes so the
+ * buffers can be used for direct I/O. depth is the number of
+ * buffers in the ring.
+ *
+ * @param reader	[in] Source Reader
+ * @param lba_start	[in] Starting LBA
+ * @param lba_len	[in] Number of LBAs to read
+ * @param buf_size	[in] Buffer size, in bytes (0 for default)
+ * @param depth		[in] Number of buffers (0 for default)
+ */
+ReadAhead::ReadAhead(Reader *reader, uint32_t lba_start, uint32_t lba_len,
+	unsigned int buf_size, unsigned int depth)
+	: m_reader(reader)
+	, m_lba_start(lba_start)
+	, m_lba_len(lba_len)
+	, m_lba_next(lba_start)
+	, m_zeroCopy(false)
+{
+	assert(reader != nullptr);
+
+	if (buf_size == 0) {
+		buf_size = DEFAULT_BUF_SIZE;
+	} else if (buf_size > MAX_BUF_SIZE) {
+		buf_size = MAX_BUF_SIZE;
+	} else {
+		buf_size = (buf_size + (RefFile::DIRECT_IO_ALIGN - 1)) & ~(RefFile::DIRECT_IO_ALIGN - 1);
+	}
+	if (depth == 0) {
+		depth = DEFAULT_DEPTH;
+	} else if (depth > MAX_DEPTH) {
+		depth = MAX_DEPTH;
+	}
+	m_buf_size = buf_size;
+
+	// Use the mapped disc image directly if possible.
+	// NOTE: Checking the first and last LBAs, since the
+	// range may extend past the end of a truncated image.
+	if (lba_len > 0 &&
+	    reader->map(lba_start, 1, true) != nullptr &&
+	    reader->map(lba_start + lba_len - 1, 1, true) != nullptr)
+	{
+		m_zeroCopy = true;
+		return;
+	}
+
+	// Allocate the buffers.
+	// NOTE: Aligned for direct I/O.
+	m_bufs.reserve(depth);
+	for (unsigned int i = 0; i < depth; i++) {
+		m_bufs.emplace_back(aligned_uptr<uint8_t>(RefFile::DIRECT_IO_ALIGN, buf_size));
+	}
+
+	// Use asynchronous I/O if the Reader can map LBAs to file offsets.
+	off64_t physOffset;
+	if (lba_len > 0 && reader->mapRun(0, 1, &physOffset) != 0) {
+		m_ioQueue.reset(new IoQueue(reader->file(), depth * IOQUEUE_READS_PER_BUF));
+		if (!m_ioQueue->isAsync()) {
+			// Asynchronous I/O isn't available.
+			m_ioQueue.reset();
+		}
+	}
+
+	if (m_ioQueue) {
+		// Start reading into all of the buffers.
+		m_slots.resize(depth);
+		for (unsigned int i = 0; i < depth; i++) {
+			m_slots[i].chunk.buf = m_bufs[i].get();
+			m_slots[i].pending = 0;
+			issue(i);
+		}
+		return;
+	}
+
+	// Reader thread.
+	for (unsigned int i = 0; i < depth; i++) {
+		m_freeQueue.push(m_bufs[i].get());
+	}
+	m_thread = std::thread([this]() {
+		Chunk chunk;
+		while (m_freeQueue.pop(chunk.buf)) {
+			if (!nextRange(chunk)) {
+				// All chunks have been read.
+				break;
+			}
+
+			// NOTE: Compressed readers don't count empty blocks
+			// in the return value, so check errno for errors.
+			errno = 0;
+			const uint32_t lba_read = m_reader->read(chunk.buf, chunk.lba_start, chunk.lba_len);
+			if (lba_read < chunk.lba_len && errno != 0) {
+				// Read error. Zero out the rest of the buffer
+				// so stale data from a previous chunk isn't used.
+				chunk.err = errno;
+				memset(&chunk.buf[LBA_TO_BYTES(lba_read)], 0, LBA_TO_BYTES(chunk.lba_len - lba_read));
+			}
+
+			if (!m_fullQueue.push(chunk)) {
+				// Pipeline was shut down.
+				break;
+			}
+		}
+		m_fullQueue.close();
+	});
+}
+
+ReadAhead::~ReadAhead()
+{
+	if (m_thread.joinable()) {
+		// Shut down the pipeline.
+		m_freeQueue.close();
+		m_fullQueue.close();
+		m_thread.join();
+	}
+
+	// Wait for any asynchronous reads before freeing the buffers.
+	m_ioQueue.reset();
+}
+
+/**
+ * Assign the next LBA range to a chunk.
+ * @param chunk	[in,out] Chunk (buf must be set)
+ * @return True if a range was assigned; false if all chunks have been assigned.
+ */
+bool ReadAhead::nextRange(Chunk &chunk)
+{
+	const uint32_t lba_end = m_lba_start + m_lba_len;
+	if (m_lba_next >= lba_end) {
+		return false;
+	}
+
+	const uint32_t lba_count_buf = BYTES_TO_LBA(m_buf_size);
+	chunk.lba_start = m_lba_next;
+	chunk.lba_len = (lba_end - m_lba_next < lba_count_buf) ? (lba_end - m_lba_next) : lba_count_buf;
+	chunk.err = 0;
+	m_lba_next += chunk.lba_len;
+	return true;
+}
+
+/**
+ * Queue asynchronous reads for the next chunk into a slot.
+ * (Asynchronous mode only)
+ * @param slot_idx Slot index
+ */
+void ReadAhead::issue(unsigned int slot_idx)
+{
+	Slot &slot = m_slots[slot_idx];
+	if (!nextRange(slot.chunk)) {
+		// All chunks have been assigned.
+		return;
+	}
+
+	// Queue one read per physically contiguous run.
+	// Empty runs are zeroed here.
+	uint8_t *ptr8 = slot.chunk.buf;
+	const uint32_t lba_end = slot.chunk.lba_start + slot.chunk.lba_len;
+	for (uint32_t lba = slot.chunk.lba_start; lba < lba_end; ) {
+		off64_t physOffset;
+		const uint32_t run_len = m_reader->mapRun(lba, lba_end - lba, &physOffset);
+		if (run_len == 0) {
+			// Mapping failed. Read the rest synchronously.
+			errno = 0;
+			const uint32_t lba_read = m_reader->read(ptr8, lba, lba_end - lba);
+			if (lba_read < lba_end - lba && errno != 0) {
+				slot.chunk.err = errno;
+				memset(&ptr8[LBA_TO_BYTES(lba_read)], 0, LBA_TO_BYTES(lba_end - lba - lba_read));
+			}
+			break;
+		}
+
+		if (physOffset < 0) {
+			// Empty run.
+			memset(ptr8, 0, LBA_TO_BYTES(run_len));
+		} else {
+			while (m_ioQueue->isFull()) {
+				reapOne();
+			}
+			m_ioQueue->read(ptr8, LBA_TO_BYTES(run_len), physOffset, slot_idx);
+			slot.pending++;
+		}
+
+		ptr8 += LBA_TO_BYTES(run_len);
+		lba += run_len;
+	}
+
+	m_issued.push_back(slot_idx);
+	m_ioQueue->submit();
+}
+
+/**
+ * Wait for one asynchronous read to complete.
+ * (Asynchronous mode only)
+ */
+void ReadAhead::reapOne(void)
+{
+	IoQueue::Completion completion;
+	if (!m_ioQueue->wait(completion)) {
+		assert(!"No reads in flight.");
+		return;
+	}
+
+	Slot &slot = m_slots[completion.tag];
+	assert(slot.pending > 0);
+	slot.pending--;
+	if (completion.err != 0) {
+		// Read error. Zero out the unread part of the buffer
+		// so stale data from a previous chunk isn't used.
+		if (slot.chunk.err == 0) {
+			slot.chunk.err = completion.err;
+		}
+		memset(completion.ptr + completion.done, 0, completion.size - completion.done);
+	}
+}
+
+/**
+ * Get the next chunk.
+ * This will block until the chunk has been read.
+ * @param chunk	[out] Chunk
+ * @return True if a chunk was retrieved; false if all chunks have been read.
+ */
+bool ReadAhead::next(Chunk &chunk)
+{
+	if (m_zeroCopy) {
+		if (!nextRange(chunk)) {
+			// All chunks have been read.
+			return false;
+		}
+		chunk.buf = m_reader->map(chunk.lba_start, chunk.lba_len, true);
+		if (!chunk.buf) {
+			// Unable to map this chunk.
+			readFallback(chunk);
+		}
+		return true;
+	}
+
+	if (!m_ioQueue) {
+		return m_fullQueue.pop(chunk);
+	}
+
+	if (m_issued.empty()) {
+		// All chunks have been read.
+		return false;
+	}
+	const unsigned int slot_idx = m_issued.front();
+	m_issued.pop_front();
+	Slot &slot = m_slots[slot_idx];
+	while (slot.pending > 0) {
+		reapOne();
+	}
+	chunk = slot.chunk;
+	return true;
+}
+
+/**
+ * Release a chunk retrieved by next().
+ * The chunk's buffer will be reused for reading ahead.
+ * @param chunk	[in] Chunk
+ */
+void ReadAhead::release(const Chunk &chunk)
+{
+	if (m_zeroCopy) {
+		// Only fallback buffers need to be released.
+		for (const auto &buf : m_fallbackBufs) {
+			if (buf.get() == chunk.buf) {
+				m_fallbackFree.push_back(chunk.buf);
+				break;
+			}
+		}
+		return;
+	}
+
+	if (!m_ioQueue) {
+		m_freeQueue.push(chunk.buf);
+		return;
+	}
+
+	// Find the chunk's slot and start reading into it again.
+	for (unsigned int i = 0; i < static_cast<unsigned int>(m_slots.size()); i++) {
+		if (m_slots[i].chunk.buf == chunk.buf) {
+			issue(i);
+			return;
+		}
+	}
+	assert(!"Chunk is not from this ReadAhead.");
+}
+
+/**
+ * Read a chunk that couldn't be mapped into a fallback buffer.
+ * (Zero-copy mode only)
+ * @param chunk	[in,out] Chunk (buf is set)
+ */
+void ReadAhead::readFallback(Chunk &chunk)
+{
+	if (m_fallbackFree.empty()) {
+		m_fallbackBufs.emplace_back(aligned_uptr<uint8_t>(RefFile::DIRECT_IO_ALIGN, m_buf_size));
+		m_fallbackFree.push_back(m_fallbackBufs.back().get());
+	}
+	chunk.buf = m_fallbackFree.back();
+	m_fallbackFree.pop_back();
+
+	// NOTE: Compressed readers don't count empty blocks
+	// in the return value, so check errno for errors.
+	errno = 0;
+	const uint32_t lba_read = m_reader->read(chunk.buf, chunk.lba_start, chunk.lba_len);
+	if (lba_read < chunk.lba_len && errno != 0) {
+		chunk.err = errno;
+		memset(&chunk.buf[LBA_TO_BYTES(lba_read)], 0, LBA_TO_BYTES(chunk.lba_len - lba_read));
+	}
+}
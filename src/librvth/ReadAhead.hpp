@@ -0,0 +1,170 @@
+/***************************************************************************
+ * RVT-H Tool (librvth)                                                    *
+ * ReadAhead.hpp: Double-buffered read-ahead pipeline for bulk copies.     *
+ *                                                                         *
+ * Copyright (c) 2026 by David Korth.                                      *
+ * SPDX-License-Identifier: GPL-2.0-or-later                               *
+ ***************************************************************************/
+
+#pragma once
+
+#include "libwiicrypto/common.h"
+#include "BlockingQueue.hpp"
+#include "aligned_malloc.h"
+
+// C includes
+#include <stdint.h>
+
+// C++ includes
+#include <deque>
+#include <memory>
+#include <thread>
+#include <vector>
+
+class IoQueue;
+class Reader;
+
+/**
+ * Two-stage read/consume pipeline.
+ *
+ * A ring of buffers is filled from a Reader while the calling
+ * thread consumes them, so the source and destination devices
+ * are busy at the same time.
+ *
+ * If the Reader supports map(), chunks point directly into the
+ * mapped disc image, and the kernel's read-ahead is used instead
+ * of separate buffers.
+ *
+ * Otherwise, if the Reader supports mapRun() and io_uring is
+ * available, reads for all free buffers are queued to the kernel
+ * at once. If not, a reader thread fills the buffers one at a time.
+ *
+ * Usage:
+ * - next() returns the next chunk in LBA order.
+ * - release() returns the chunk's buffer so it can be refilled.
+ * - The destructor stops reading, so the consumer can bail out
+ *   at any time.
+ *
+ * next() and release() must be called from the same thread.
+ */
+class ReadAhead
+{
+public:
+	// Default buffer size and depth.
+	static constexpr unsigned int DEFAULT_BUF_SIZE = 1U * 1024U * 1024U;
+	static constexpr unsigned int DEFAULT_DEPTH = 4;
+
+	// Maximum buffer size and depth.
+	static constexpr unsigned int MAX_BUF_SIZE = 64U * 1024U * 1024U;
+	static constexpr unsigned int MAX_DEPTH = 64;
+
+	/**
+	 * Start a read-ahead pipeline.
+	 *
+	 * buf_size is rounded up to a multiple of 4096 bytes so the
+	 * buffers can be used for direct I/O. depth is the number of
+	 * buffers in the ring.
+	 *
+	 * @param reader	[in] Source Reader
+	 * @param lba_start	[in] Starting LBA
+	 * @param lba_len	[in] Number of LBAs to read
+	 * @param buf_size	[in] Buffer size, in bytes (0 for default)
+	 * @param depth		[in] Number of buffers (0 for default)
+	 */
+	ReadAhead(Reader *reader, uint32_t lba_start, uint32_t lba_len,
+		unsigned int buf_size = 0, unsigned int depth = 0);
+	~ReadAhead();
+
+private:
+	DISABLE_COPY(ReadAhead)
+
+public:
+	struct Chunk {
+		uint8_t *buf;		// Data
+		uint32_t lba_start;	// Starting LBA
+		uint32_t lba_len;	// Length, in LBAs
+		int err;		// POSIX error code on read error (unread LBAs are zeroed)
+	};
+
+	/**
+	 * Get the next chunk.
+	 * This will block until the reader thread has filled it.
+	 * @param chunk	[out] Chunk
+	 * @return True if a chunk was retrieved; false if all chunks have been read.
+	 */
+	bool next(Chunk &chunk);
+
+	/**
+	 * Release a chunk retrieved by next().
+	 * The chunk's buffer will be reused for reading ahead.
+	 * @param chunk	[in] Chunk
+	 */
+	void release(const Chunk &chunk);
+
+	/**
+	 * Get the actual buffer size.
+	 * @return Buffer size, in bytes
+	 */
+	inline unsigned int bufSize(void) const
+	{
+		return m_buf_size;
+	}
+
+private:
+	/**
+	 * Assign the next LBA range to a chunk.
+	 * @param chunk	[in,out] Chunk (buf must be set)
+	 * @return True if a range was assigned; false if all chunks have been assigned.
+	 */
+	bool nextRange(Chunk &chunk);
+
+	/**
+	 * Queue asynchronous reads for the next chunk into a slot.
+	 * (Asynchronous mode only)
+	 * @param slot_idx Slot index
+	 */
+	void issue(unsigned int slot_idx);
+
+	/**
+	 * Wait for one asynchronous read to complete.
+	 * (Asynchronous mode only)
+	 */
+	void reapOne(void);
+
+	/**
+	 * Read a chunk that couldn't be mapped into a fallback buffer.
+	 * (Zero-copy mode only)
+	 * @param chunk	[in,out] Chunk (buf is set)
+	 */
+	void readFallback(Chunk &chunk);
+
+private:
+	Reader *const m_reader;
+	const uint32_t m_lba_start;
+	const uint32_t m_lba_len;
+	uint32_t m_lba_next;		// Next LBA to assign to a chunk
+	unsigned int m_buf_size;
+
+	std::vector<aligned_unique_ptr<uint8_t> > m_bufs;
+
+	// Zero-copy mode
+	// If a chunk can't be mapped, it's read into a fallback buffer.
+	bool m_zeroCopy;
+	std::vector<aligned_unique_ptr<uint8_t> > m_fallbackBufs;
+	std::vector<uint8_t*> m_fallbackFree;
+
+	// Reader thread mode
+	BlockingQueue<uint8_t*> m_freeQueue;
+	BlockingQueue<Chunk> m_fullQueue;
+	std::thread m_thread;
+
+	// Asynchronous mode
+	// NOTE: m_ioQueue must be destroyed before m_bufs.
+	struct Slot {
+		Chunk chunk;
+		unsigned int pending;	// Number of reads in flight
+	};
+	std::vector<Slot> m_slots;
+	std::deque<unsigned int> m_issued;	// Slots in LBA order
+	std::unique_ptr<IoQueue> m_ioQueue;
+};
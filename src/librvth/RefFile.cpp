@@ -2,7 +2,7 @@
  * RVT-H Tool (librvth)                                                    *
  * RefFile.cpp: Reference-counted FILE*. (use std::shared_ptr<>)           *
  *                                                                         *
- * Copyright (c) 2018-2025 by David Korth.                                 *
+ * Copyright (c) 2018-2026 by David Korth.                                 *
  * SPDX-License-Identifier: GPL-2.0-or-later                               *
  ***************************************************************************/
 
@@ -57,6 +57,11 @@ RefFile::RefFile(const TCHAR *filename, bool create)
 	: m_file(nullptr)
 	, m_lastError(0)
 	, m_isWritable(false)
+#ifdef _WIN32
+	, m_hDirect(nullptr)
+#else /* !_WIN32 */
+	, m_fdDirect(-1)
+#endif /* _WIN32 */
 {
 	if (!filename) {
 		// No filename...
@@ -79,6 +84,10 @@ RefFile::RefFile(const TCHAR *filename, bool create)
 		return;
 	}
 
+	// Disable stdio buffering. Bulk I/O uses pread() and pwrite(),
+	// which bypass the stdio buffer, so buffered data could be stale.
+	setvbuf(m_file, nullptr, _IONBF, 0);
+
 	// If the file was opened with 'create',
 	// it should be considered writable.
 	m_isWritable = create;
@@ -86,6 +95,7 @@ RefFile::RefFile(const TCHAR *filename, bool create)
 
 RefFile::~RefFile()
 {
+	setDirectIO(false);
 	if (m_file) {
 		fclose(m_file);
 	}
@@ -131,9 +141,18 @@ int RefFile::makeWritable(void)
 		// FIXME: If it's NULL, something's wrong...
 	}
 
+	// Disable stdio buffering. (See the constructor.)
+	setvbuf(m_file, nullptr, _IONBF, 0);
+
 	// Seek to the original position.
 	// TODO: Check for errors.
 	fseeko(m_file, pos, SEEK_SET);
+
+	// If direct I/O is enabled, reopen the unbuffered file too.
+	if (ret == 0 && isDirectIO()) {
+		setDirectIO(false);
+		setDirectIO(true);
+	}
 	return ret;
 }
 
@@ -264,6 +283,8 @@ int RefFile::makeSparse(off64_t size)
 
 /**
  * Get the size of the file.
+ * For regular files and Linux/Windows devices, this doesn't
+ * use the stdio file position, so it's thread-safe.
  * @return Size of file, or -1 on error.
  */
 off64_t RefFile::size(void)
@@ -273,10 +294,26 @@ off64_t RefFile::size(void)
 		return -1;
 	}
 
-	// If this is a device, try OS-specific device size functions first.
-	// NOTE: _fseeki64(fp, 0, SEEK_END) isn't working on
-	// device files on Windows for some reason...
-	if (this->isDevice()) {
+	if (!this->isDevice()) {
+		// Regular file. Get the size from the file handle.
+		// This doesn't use the stdio file position, so multiple
+		// Readers can get the size of the same file at once.
+#ifdef _WIN32
+		HANDLE hFile = (HANDLE)_get_osfhandle(_fileno(m_file));
+		LARGE_INTEGER liSize;
+		if (hFile && hFile != INVALID_HANDLE_VALUE && GetFileSizeEx(hFile, &liSize)) {
+			return liSize.QuadPart;
+		}
+#else /* !_WIN32 */
+		struct stat sb;
+		if (fstat(fileno(m_file), &sb) == 0 && S_ISREG(sb.st_mode)) {
+			return sb.st_size;
+		}
+#endif /* _WIN32 */
+	} else {
+		// Device. Try OS-specific device size functions first.
+		// NOTE: _fseeki64(fp, 0, SEEK_END) isn't working on
+		// device files on Windows for some reason...
 #ifdef _WIN32
 		// Windows version.
 		HANDLE hDevice = (HANDLE)_get_osfhandle(_fileno(m_file));
@@ -308,8 +345,9 @@ off64_t RefFile::size(void)
 #endif
 	}
 
-	// Not a device, or the OS-specific device size function failed.
+	// The OS-specific size function failed.
 	// Use this->seeko() / this->tello().
+	// NOTE: This changes the stdio file position temporarily.
 	off64_t orig_pos = this->tello();
 	if (orig_pos < 0) {
 		// Error.
@@ -386,3 +424,417 @@ int RefFile::flush(void)
 	return ::fsync(fileno(m_file));
 #endif /* _WIN32 */
 }
+
+/**
+ * Drop a range of the file from the OS page cache, so the
+ * next read comes from the device. Written data must be
+ * flushed first.
+ * @param offset	[in] File offset.
+ * @param size		[in] Size, in bytes.
+ * @return 0 on success; negative POSIX error code on error.
+ */
+int RefFile::dropCache(off64_t offset, off64_t size)
+{
+	if (!m_file) {
+		// File is not open.
+		return -EBADF;
+	}
+
+#if !defined(_WIN32) && defined(POSIX_FADV_DONTNEED)
+	// NOTE: posix_fadvise() returns the error code instead of setting errno.
+	return -posix_fadvise(fileno(m_file), offset, size, POSIX_FADV_DONTNEED);
+#else
+	// Part of a file can't be dropped from the cache here,
+	// but aligned direct I/O reads bypass the cache.
+	UNUSED(offset);
+	UNUSED(size);
+	return (isDirectIO() ? 0 : -ENOTSUP);
+#endif
+}
+
+/**
+ * Enable or disable direct (unbuffered) I/O.
+ *
+ * When enabled, pread() and pwrite() bypass the OS page cache
+ * if the buffer, size, and offset are all aligned to
+ * DIRECT_IO_ALIGN. Other requests, as well as the stdio
+ * wrappers, continue to use buffered I/O.
+ *
+ * @param enable True to enable; false to disable.
+ * @return 0 on success; negative POSIX error code on error.
+ */
+int RefFile::setDirectIO(bool enable)
+{
+	if (!enable) {
+		// Close the unbuffered file.
+#ifdef _WIN32
+		if (m_hDirect) {
+			CloseHandle(m_hDirect);
+			m_hDirect = nullptr;
+		}
+#else /* !_WIN32 */
+		if (m_fdDirect >= 0) {
+			::close(m_fdDirect);
+			m_fdDirect = -1;
+		}
+#endif /* _WIN32 */
+		return 0;
+	}
+
+	if (!m_file) {
+		// File is not open.
+		return -EBADF;
+	} else if (isDirectIO()) {
+		// Direct I/O is already enabled.
+		return 0;
+	}
+
+	// Open the file a second time for unbuffered access.
+	// The original file is kept for buffered access.
+#if defined(_WIN32)
+	HANDLE hDirect = CreateFile(m_filename.c_str(),
+		GENERIC_READ | (m_isWritable ? GENERIC_WRITE : 0),
+		FILE_SHARE_READ | FILE_SHARE_WRITE, nullptr,
+		OPEN_EXISTING, FILE_FLAG_NO_BUFFERING, nullptr);
+	if (hDirect == INVALID_HANDLE_VALUE) {
+		return -EIO;
+	}
+	m_hDirect = hDirect;
+#elif defined(O_DIRECT)
+	const int fd = ::open(m_filename.c_str(), (m_isWritable ? O_RDWR : O_RDONLY) | O_DIRECT);
+	if (fd < 0) {
+		// NOTE: Some file systems, e.g. tmpfs, don't support O_DIRECT.
+		return -errno;
+	}
+	m_fdDirect = fd;
+#elif defined(F_NOCACHE)
+	// macOS: No O_DIRECT, but F_NOCACHE has the same effect.
+	const int fd = ::open(m_filename.c_str(), m_isWritable ? O_RDWR : O_RDONLY);
+	if (fd < 0) {
+		return -errno;
+	}
+	if (fcntl(fd, F_NOCACHE, 1) != 0) {
+		const int err = errno;
+		::close(fd);
+		return -err;
+	}
+	m_fdDirect = fd;
+#else
+	// Direct I/O is not supported on this system.
+	return -ENOTSUP;
+#endif
+
+	return 0;
+}
+
+/**
+ * Can a request use direct I/O?
+ * @param ptr		[in] Buffer.
+ * @param size		[in] Size.
+ * @param offset	[in] File offset.
+ * @return True if the request is aligned to RefFile::DIRECT_IO_ALIGN.
+ */
+static inline bool isDirectIOAligned(const void *ptr, size_t size, off64_t offset)
+{
+	return ((reinterpret_cast<uintptr_t>(ptr) | size | static_cast<uint64_t>(offset)) &
+		(RefFile::DIRECT_IO_ALIGN - 1)) == 0;
+}
+
+#ifndef _WIN32
+/**
+ * Get the file descriptor to use for a positional I/O request.
+ * The direct I/O descriptor is used if the request is aligned.
+ * @param ptr		[in] Buffer.
+ * @param size		[in] Size.
+ * @param offset	[in] File offset.
+ * @return File descriptor.
+ */
+int RefFile::fdForRequest(const void *ptr, size_t size, off64_t offset) const
+{
+	if (isDirectIO() && isDirectIOAligned(ptr, size, offset)) {
+		return m_fdDirect;
+	}
+	return fileno(m_file);
+}
+#endif /* !_WIN32 */
+
+/**
+ * Read data from the file at the specified offset.
+ * This doesn't use the stdio file position.
+ * NOTE: On Windows, this moves the file position.
+ * @param ptr		[out] Read buffer.
+ * @param size		[in] Number of bytes to read.
+ * @param offset	[in] File offset.
+ * @return Number of bytes read. (Less than size on error or EOF.)
+ */
+size_t RefFile::pread(void *ptr, size_t size, off64_t offset)
+{
+	uint8_t *ptr8 = static_cast<uint8_t*>(ptr);
+	size_t total = 0;
+	bool allowDirect = isDirectIO();
+
+#ifdef _WIN32
+	HANDLE hBuffered = (HANDLE)_get_osfhandle(_fileno(m_file));
+	while (total < size) {
+		const bool direct = (allowDirect && isDirectIOAligned(ptr8, size - total, offset));
+		HANDLE hFile = (direct ? static_cast<HANDLE>(m_hDirect) : hBuffered);
+
+		// ReadFile() takes a DWORD size, so read at most 1 GB at a time.
+		const DWORD dwToRead = static_cast<DWORD>(
+			(size - total) > 0x40000000U ? 0x40000000U : (size - total));
+		OVERLAPPED ov;
+		memset(&ov, 0, sizeof(ov));
+		ov.Offset = static_cast<DWORD>(offset);
+		ov.OffsetHigh = static_cast<DWORD>(offset >> 32);
+		DWORD dwRead = 0;
+		if (!ReadFile(hFile, ptr8, dwToRead, &dwRead, &ov)) {
+			if (direct) {
+				// Direct I/O failed. Retry with buffered I/O.
+				allowDirect = false;
+				continue;
+			}
+			// Read error.
+			// NOTE: ERROR_HANDLE_EOF is returned if the
+			// offset is past the end of the file.
+			if (GetLastError() != ERROR_HANDLE_EOF) {
+				errno = EIO;
+			}
+			break;
+		} else if (dwRead == 0) {
+			// End of file.
+			break;
+		}
+		ptr8 += dwRead;
+		total += dwRead;
+		offset += dwRead;
+	}
+#else /* !_WIN32 */
+	const int fdBuffered = fileno(m_file);
+	while (total < size) {
+		const bool direct = (allowDirect && isDirectIOAligned(ptr8, size - total, offset));
+		const ssize_t ret = ::pread(direct ? m_fdDirect : fdBuffered, ptr8, size - total, offset);
+		if (ret < 0) {
+			if (errno == EINTR)
+				continue;
+			if (direct && errno == EINVAL) {
+				// Direct I/O isn't supported here.
+				// Retry with buffered I/O.
+				allowDirect = false;
+				continue;
+			}
+			// Read error.
+			break;
+		} else if (ret == 0) {
+			// End of file.
+			break;
+		}
+		ptr8 += ret;
+		total += ret;
+		offset += ret;
+	}
+#endif /* _WIN32 */
+
+	return total;
+}
+
+/**
+ * Write data to the file at the specified offset.
+ * This doesn't use the stdio file position.
+ * NOTE: On Windows, this moves the file position.
+ * @param ptr		[in] Write buffer.
+ * @param size		[in] Number of bytes to write.
+ * @param offset	[in] File offset.
+ * @return Number of bytes written. (Less than size on error.)
+ */
+size_t RefFile::pwrite(const void *ptr, size_t size, off64_t offset)
+{
+	const uint8_t *ptr8 = static_cast<const uint8_t*>(ptr);
+	size_t total = 0;
+	bool allowDirect = isDirectIO();
+
+#ifdef _WIN32
+	HANDLE hBuffered = (HANDLE)_get_osfhandle(_fileno(m_file));
+	while (total < size) {
+		const bool direct = (allowDirect && isDirectIOAligned(ptr8, size - total, offset));
+		HANDLE hFile = (direct ? static_cast<HANDLE>(m_hDirect) : hBuffered);
+
+		// WriteFile() takes a DWORD size, so write at most 1 GB at a time.
+		const DWORD dwToWrite = static_cast<DWORD>(
+			(size - total) > 0x40000000U ? 0x40000000U : (size - total));
+		OVERLAPPED ov;
+		memset(&ov, 0, sizeof(ov));
+		ov.Offset = static_cast<DWORD>(offset);
+		ov.OffsetHigh = static_cast<DWORD>(offset >> 32);
+		DWORD dwWritten = 0;
+		if (!WriteFile(hFile, ptr8, dwToWrite, &dwWritten, &ov) || dwWritten == 0) {
+			if (direct) {
+				// Direct I/O failed. Retry with buffered I/O.
+				allowDirect = false;
+				continue;
+			}
+			// Write error.
+			errno = EIO;
+			break;
+		}
+		ptr8 += dwWritten;
+		total += dwWritten;
+		offset += dwWritten;
+	}
+#else /* !_WIN32 */
+	const int fdBuffered = fileno(m_file);
+	while (total < size) {
+		const bool direct = (allowDirect && isDirectIOAligned(ptr8, size - total, offset));
+		const ssize_t ret = ::pwrite(direct ? m_fdDirect : fdBuffered, ptr8, size - total, offset);
+		if (ret < 0) {
+			if (errno == EINTR)
+				continue;
+			if (direct && errno == EINVAL) {
+				// Direct I/O isn't supported here.
+				// Retry with buffered I/O.
+				allowDirect = false;
+				continue;
+			}
+			// Write error.
+			break;
+		} else if (ret == 0) {
+			// No progress. Treat this as an error.
+			errno = EIO;
+			break;
+		}
+		ptr8 += ret;
+		total += ret;
+		offset += ret;
+	}
+#endif /* _WIN32 */
+
+	return total;
+}
+
+/**
+ * Find the next region of data in the file. (SEEK_DATA)
+ * NOTE: This changes the file position.
+ * @param offset	[in] Starting offset.
+ * @return Offset of the data, or -1 on error.
+ *         (errno == ENXIO if there's no data after offset;
+ *          errno == ENOTSUP if this isn't supported.)
+ */
+off64_t RefFile::seekData(off64_t offset)
+{
+#if !defined(_WIN32) && defined(SEEK_DATA)
+	const off64_t ret = ::lseek(fileno(m_file), offset, SEEK_DATA);
+	if (ret < 0 && errno == EINVAL) {
+		// File system doesn't support SEEK_DATA.
+		errno = ENOTSUP;
+	}
+	return ret;
+#else /* _WIN32 || !SEEK_DATA */
+	// Not supported on Windows. seekHole() fails too, so
+	// canCopyExtents() never selects the extent-copy path,
+	// and banks are copied with the regular path instead.
+	UNUSED(offset);
+	errno = ENOTSUP;
+	return -1;
+#endif /* !_WIN32 && SEEK_DATA */
+}
+
+/**
+ * Find the next hole in the file. (SEEK_HOLE)
+ * The end of the file counts as a hole.
+ * NOTE: This changes the file position.
+ * @param offset	[in] Starting offset.
+ * @return Offset of the hole, or -1 on error.
+ *         (errno == ENOTSUP if this isn't supported.)
+ */
+off64_t RefFile::seekHole(off64_t offset)
+{
+#if !defined(_WIN32) && defined(SEEK_HOLE)
+	const off64_t ret = ::lseek(fileno(m_file), offset, SEEK_HOLE);
+	if (ret < 0 && errno == EINVAL) {
+		// File system doesn't support SEEK_HOLE.
+		errno = ENOTSUP;
+	}
+	return ret;
+#else /* _WIN32 || !SEEK_HOLE */
+	UNUSED(offset);
+	errno = ENOTSUP;
+	return -1;
+#endif /* !_WIN32 && SEEK_HOLE */
+}
+
+/**
+ * Copy data from another file into this file.
+ *
+ * If possible, the data is shared using a reflink (FICLONERANGE)
+ * or copied within the kernel using copy_file_range().
+ * Otherwise, it's copied using pread() and pwrite().
+ *
+ * @param src		[in] Source file.
+ * @param src_offset	[in] Source offset.
+ * @param dst_offset	[in] Destination offset.
+ * @param size		[in] Number of bytes to copy.
+ * @return Number of bytes copied. (Less than size on error or EOF.)
+ */
+size_t RefFile::copyRangeFrom(RefFile *src, off64_t src_offset, off64_t dst_offset, size_t size)
+{
+	size_t total = 0;
+
+#ifndef _WIN32
+	const int fdIn = fileno(src->m_file);
+	const int fdOut = fileno(m_file);
+
+#  ifdef FICLONERANGE
+	// Try a reflink first. This only works on some file systems
+	// (e.g. btrfs and XFS), and the offsets and size must be
+	// aligned to the file system block size.
+	if (isDirectIOAligned(nullptr, size, src_offset | dst_offset)) {
+		struct file_clone_range fcr;
+		fcr.src_fd = fdIn;
+		fcr.src_offset = static_cast<uint64_t>(src_offset);
+		fcr.src_length = static_cast<uint64_t>(size);
+		fcr.dest_offset = static_cast<uint64_t>(dst_offset);
+		if (ioctl(fdOut, FICLONERANGE, &fcr) == 0) {
+			return size;
+		}
+	}
+#  endif /* FICLONERANGE */
+
+#  ifdef HAVE_COPY_FILE_RANGE
+	// Copy the data within the kernel.
+	while (total < size) {
+		loff_t off_in = src_offset + total;
+		loff_t off_out = dst_offset + total;
+		const ssize_t ret = ::copy_file_range(fdIn, &off_in, fdOut, &off_out, size - total, 0);
+		if (ret < 0) {
+			if (errno == EINTR)
+				continue;
+			// Not supported for these files. (e.g. EXDEV on older kernels)
+			// Fall back to pread() and pwrite().
+			break;
+		} else if (ret == 0) {
+			// End of file.
+			return total;
+		}
+		total += ret;
+	}
+#  endif /* HAVE_COPY_FILE_RANGE */
+#endif /* !_WIN32 */
+
+	// Copy the rest using pread() and pwrite().
+	static constexpr size_t COPY_BUF_SIZE = 1U * 1024U * 1024U;
+	std::unique_ptr<uint8_t[]> buf;
+	while (total < size) {
+		if (!buf) {
+			buf.reset(new uint8_t[COPY_BUF_SIZE]);
+		}
+		const size_t chunk = ((size - total) < COPY_BUF_SIZE) ? (size - total) : COPY_BUF_SIZE;
+		const size_t szRead = src->pread(buf.get(), chunk, src_offset + total);
+		const size_t szWritten = this->pwrite(buf.get(), szRead, dst_offset + total);
+		total += szWritten;
+		if (szRead != chunk || szWritten != szRead) {
+			// Read or write error, or end of file.
+			break;
+		}
+	}
+
+	return total;
+}
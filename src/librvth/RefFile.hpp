@@ -2,7 +2,7 @@
  * RVT-H Tool (librvth)                                                    *
  * RefFile.hpp: Reference-counted FILE*. (use std::shared_ptr<>)           *
  *                                                                         *
- * Copyright (c) 2018-2025 by David Korth.                                 *
+ * Copyright (c) 2018-2026 by David Korth.                                 *
  * SPDX-License-Identifier: GPL-2.0-or-later                               *
  ***************************************************************************/
 
@@ -89,6 +89,8 @@ public:
 
 	/**
 	 * Get the size of the file.
+	 * For regular files and Linux/Windows devices, this doesn't
+	 * use the stdio file position, so it's thread-safe.
 	 * @return Size of file, or -1 on error.
 	 */
 	off64_t size(void);
@@ -99,6 +101,45 @@ public:
 	 */
 	time_t mtime(void);
 
+	/**
+	 * Enable or disable direct (unbuffered) I/O.
+	 *
+	 * When enabled, pread() and pwrite() bypass the OS page cache
+	 * if the buffer, size, and offset are all aligned to
+	 * DIRECT_IO_ALIGN. Other requests, as well as the stdio
+	 * wrappers, continue to use buffered I/O.
+	 *
+	 * @param enable True to enable; false to disable.
+	 * @return 0 on success; negative POSIX error code on error.
+	 */
+	int setDirectIO(bool enable);
+
+	/**
+	 * Is direct I/O enabled?
+	 * @return True if enabled; false if not.
+	 */
+	inline bool isDirectIO(void) const
+	{
+#ifdef _WIN32
+		return (m_hDirect != nullptr);
+#else /* !_WIN32 */
+		return (m_fdDirect >= 0);
+#endif /* _WIN32 */
+	}
+
+	// Buffer, size, and offset alignment required for direct I/O.
+	static constexpr size_t DIRECT_IO_ALIGN = 4096;
+
+	/**
+	 * Drop a range of the file from the OS page cache, so the
+	 * next read comes from the device. Written data must be
+	 * flushed first.
+	 * @param offset	[in] File offset.
+	 * @param size		[in] Size, in bytes.
+	 * @return 0 on success; negative POSIX error code on error.
+	 */
+	int dropCache(off64_t offset, off64_t size);
+
 public:
 	/** Convenience wrappers for stdio functions. **/
 	// NOTE: These functions set errno, **NOT** m_lastError!
@@ -130,6 +171,70 @@ public:
 		::rewind(m_file);
 	}
 
+public:
+	/** Positional I/O **/
+	// These functions don't use the stdio file position,
+	// so multiple threads can read from the same RefFile at once.
+	// NOTE: On Windows, ReadFile()/WriteFile() with an OVERLAPPED offset
+	// on a synchronous handle moves the file position to the end of the
+	// transfer. Call seeko() before using stdio functions afterwards.
+	// NOTE: These functions set errno, **NOT** m_lastError!
+
+	/**
+	 * Read data from the file at the specified offset.
+	 * @param ptr		[out] Read buffer.
+	 * @param size		[in] Number of bytes to read.
+	 * @param offset	[in] File offset.
+	 * @return Number of bytes read. (Less than size on error or EOF.)
+	 */
+	size_t pread(void *ptr, size_t size, off64_t offset);
+
+	/**
+	 * Write data to the file at the specified offset.
+	 * @param ptr		[in] Write buffer.
+	 * @param size		[in] Number of bytes to write.
+	 * @param offset	[in] File offset.
+	 * @return Number of bytes written. (Less than size on error.)
+	 */
+	size_t pwrite(const void *ptr, size_t size, off64_t offset);
+
+	/** Sparse file functions **/
+
+	/**
+	 * Find the next region of data in the file. (SEEK_DATA)
+	 * NOTE: This changes the file position.
+	 * @param offset	[in] Starting offset.
+	 * @return Offset of the data, or -1 on error.
+	 *         (errno == ENXIO if there's no data after offset;
+	 *          errno == ENOTSUP if this isn't supported.)
+	 */
+	off64_t seekData(off64_t offset);
+
+	/**
+	 * Find the next hole in the file. (SEEK_HOLE)
+	 * The end of the file counts as a hole.
+	 * NOTE: This changes the file position.
+	 * @param offset	[in] Starting offset.
+	 * @return Offset of the hole, or -1 on error.
+	 *         (errno == ENOTSUP if this isn't supported.)
+	 */
+	off64_t seekHole(off64_t offset);
+
+	/**
+	 * Copy data from another file into this file.
+	 *
+	 * If possible, the data is shared using a reflink (FICLONERANGE)
+	 * or copied within the kernel using copy_file_range().
+	 * Otherwise, it's copied using pread() and pwrite().
+	 *
+	 * @param src		[in] Source file.
+	 * @param src_offset	[in] Source offset.
+	 * @param dst_offset	[in] Destination offset.
+	 * @param size		[in] Number of bytes to copy.
+	 * @return Number of bytes copied. (Less than size on error or EOF.)
+	 */
+	size_t copyRangeFrom(RefFile *src, off64_t src_offset, off64_t dst_offset, size_t size);
+
 	/** Convenience wrappers **/
 
 	inline size_t seekoAndRead(off64_t offset, int whence, void *ptr, size_t size, size_t nmemb)
@@ -157,11 +262,31 @@ public:
 		return m_isWritable;
 	}
 
+private:
+	friend class IoQueue;
+	friend class MmapReader;
+#ifndef _WIN32
+	/**
+	 * Get the file descriptor to use for a positional I/O request.
+	 * The direct I/O descriptor is used if the request is aligned.
+	 * @param ptr		[in] Buffer.
+	 * @param size		[in] Size.
+	 * @param offset	[in] File offset.
+	 * @return File descriptor.
+	 */
+	int fdForRequest(const void *ptr, size_t size, off64_t offset) const;
+#endif /* !_WIN32 */
+
 private:
 	FILE *m_file;			// FILE pointer
 	std::tstring m_filename;	// Filename for reopening as writable
 	int m_lastError;		// Last error code
 	bool m_isWritable;		// Is the file writable?
+#ifdef _WIN32
+	void *m_hDirect;		// Unbuffered HANDLE for direct I/O, or nullptr
+#else /* !_WIN32 */
+	int m_fdDirect;			// Unbuffered fd for direct I/O, or -1
+#endif /* _WIN32 */
 };
 
 typedef std::shared_ptr<RefFile> RefFilePtr;
@@ -0,0 +1,257 @@
+/***************************************************************************
+ * RVT-H Tool (librvth)                                                    *
+ * VerifyCache.cpp: Persistent cache for verification results.             *
+ *                                                                         *
+ * Copyright (c) 2026 by David Korth.                                      *
+ * SPDX-License-Identifier: GPL-2.0-or-later                               *
+ ***************************************************************************/
+
+#include "VerifyCache.hpp"
+
+#ifdef _WIN32
+#  include <windows.h>
+#  include <direct.h>
+#else /* !_WIN32 */
+#  include <sys/stat.h>
+#  include <sys/types.h>
+#  include <unistd.h>
+#endif /* _WIN32 */
+
+// C includes
+#include <stdlib.h>
+
+// C includes (C++ namespace)
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+
+// C++ includes
+#include <string>
+#include <vector>
+using std::tstring;
+using std::vector;
+
+#ifdef _WIN32
+#  define DIR_SEP_CHR _T('\\')
+#else /* !_WIN32 */
+#  define DIR_SEP_CHR _T('/')
+#endif /* _WIN32 */
+
+// Cache file header.
+static const char VERIFY_CACHE_MAGIC[] = "rvthtool-verify";
+static const unsigned int VERIFY_CACHE_VERSION = 1;
+
+// Maximum number of errors in a cache file.
+// This is only used to reject corrupted files.
+static const unsigned int VERIFY_CACHE_MAX_ERRORS = 16U * 1024U * 1024U;
+
+/**
+ * Create a directory and its parents.
+ * @param path	[in] Directory
+ * @return 0 on success; negative POSIX error code on error.
+ */
+static int mkdir_recursive(const tstring &path)
+{
+	// Skip the first character so the root directory
+	// isn't created. (Drive letters are rejected by mkdir.)
+	for (size_t pos = path.find(DIR_SEP_CHR, 1); ; pos = path.find(DIR_SEP_CHR, pos + 1)) {
+		const tstring subdir = path.substr(0, pos);
+#ifdef _WIN32
+		int ret = _tmkdir(subdir.c_str());
+#else /* !_WIN32 */
+		int ret = mkdir(subdir.c_str(), 0777);
+#endif /* _WIN32 */
+		if (ret != 0 && errno != EEXIST) {
+			return -errno;
+		}
+		if (pos == tstring::npos) {
+			break;
+		}
+	}
+	return 0;
+}
+
+/**
+ * Open the verification cache.
+ * The directory is created when results are saved.
+ * @param dir	[in,opt] Cache directory (if nullptr, use the user's cache directory)
+ */
+VerifyCache::VerifyCache(const TCHAR *dir)
+{
+	if (dir) {
+		m_dir = dir;
+	} else {
+#ifdef _WIN32
+		const TCHAR *const localAppData = _tgetenv(_T("LOCALAPPDATA"));
+		if (localAppData && localAppData[0] != _T('\0')) {
+			m_dir = localAppData;
+		}
+#else /* !_WIN32 */
+		const char *const xdgCacheHome = getenv("XDG_CACHE_HOME");
+		if (xdgCacheHome && xdgCacheHome[0] == '/') {
+			m_dir = xdgCacheHome;
+		} else {
+			// XDG_CACHE_HOME is unset or invalid.
+			// Use the default, ~/.cache.
+			const char *const home = getenv("HOME");
+			if (home && home[0] == '/') {
+				m_dir = home;
+				m_dir += "/.cache";
+			}
+		}
+#endif /* _WIN32 */
+		if (m_dir.empty()) {
+			// Unable to determine the user's cache directory.
+			return;
+		}
+		m_dir += DIR_SEP_CHR;
+		m_dir += _T("rvthtool");
+		m_dir += DIR_SEP_CHR;
+		m_dir += _T("verify");
+	}
+
+	// Remove trailing slashes.
+	while (m_dir.size() > 1 && m_dir[m_dir.size() - 1] == DIR_SEP_CHR) {
+		m_dir.resize(m_dir.size() - 1);
+	}
+}
+
+/**
+ * Get the filename for a key.
+ * @param key	[in] Key
+ * @return Filename
+ */
+tstring VerifyCache::filename(const uint8_t key[KEY_SIZE]) const
+{
+	static const TCHAR hex_digits[] = _T("0123456789abcdef");
+
+	tstring filename(m_dir);
+	filename.reserve(m_dir.size() + 1 + (KEY_SIZE * 2) + 7);
+	filename += DIR_SEP_CHR;
+	for (unsigned int i = 0; i < KEY_SIZE; i++) {
+		filename += hex_digits[key[i] >> 4];
+		filename += hex_digits[key[i] & 0x0F];
+	}
+	filename += _T(".verify");
+	return filename;
+}
+
+/**
+ * Load cached results.
+ * @param key		[in] Key
+ * @param errors	[out] Errors, in the order they were reported
+ * @return True if cached results were found; false if not.
+ */
+bool VerifyCache::load(const uint8_t key[KEY_SIZE], vector<Error> &errors) const
+{
+	errors.clear();
+	if (m_dir.empty()) {
+		return false;
+	}
+
+	FILE *const f = _tfopen(filename(key).c_str(), _T("r"));
+	if (!f) {
+		return false;
+	}
+
+	// Check the header.
+	char magic[32];
+	unsigned int version = 0, count = 0;
+	if (fscanf(f, "%31s %u\nerrors %u\n", magic, &version, &count) != 3 ||
+	    strcmp(magic, VERIFY_CACHE_MAGIC) != 0 ||
+	    version != VERIFY_CACHE_VERSION ||
+	    count > VERIFY_CACHE_MAX_ERRORS)
+	{
+		// Not a valid cache file.
+		fclose(f);
+		return false;
+	}
+
+	errors.reserve(count < 65536U ? count : 65536U);
+	for (unsigned int i = 0; i < count; i++) {
+		unsigned int pt_idx, group, hash_level, sector, kb, err_type, is_zero;
+		if (fscanf(f, "%u %u %u %u %u %u %u\n", &pt_idx, &group,
+		           &hash_level, &sector, &kb, &err_type, &is_zero) != 7 ||
+		    pt_idx > 255 || hash_level > 3 || sector > 63 || kb > 31 ||
+		    err_type > 255 || is_zero > 1)
+		{
+			// Not a valid cache file.
+			fclose(f);
+			errors.clear();
+			return false;
+		}
+
+		Error error;
+		error.pt_idx = static_cast<uint8_t>(pt_idx);
+		error.hash_level = static_cast<uint8_t>(hash_level);
+		error.sector = static_cast<uint8_t>(sector);
+		error.kb = static_cast<uint8_t>(kb);
+		error.err_type = static_cast<uint8_t>(err_type);
+		error.is_zero = (is_zero != 0);
+		error.group = group;
+		errors.push_back(error);
+	}
+
+	fclose(f);
+	return true;
+}
+
+/**
+ * Save results to the cache.
+ * @param key		[in] Key
+ * @param errors	[in] Errors, in the order they were reported
+ * @return 0 on success; negative POSIX error code on error.
+ */
+int VerifyCache::save(const uint8_t key[KEY_SIZE], const vector<Error> &errors) const
+{
+	if (m_dir.empty()) {
+		return -ENOENT;
+	}
+
+	int ret = mkdir_recursive(m_dir);
+	if (ret != 0) {
+		return ret;
+	}
+
+	// Write to a temporary file, then rename it,
+	// so a partially-written file is never loaded.
+	const tstring final_filename = filename(key);
+	const tstring tmp_filename = final_filename + _T(".tmp");
+	FILE *const f = _tfopen(tmp_filename.c_str(), _T("w"));
+	if (!f) {
+		return -errno;
+	}
+
+	fprintf(f, "%s %u\nerrors %u\n", VERIFY_CACHE_MAGIC, VERIFY_CACHE_VERSION,
+		static_cast<unsigned int>(errors.size()));
+	for (const Error &error : errors) {
+		fprintf(f, "%u %u %u %u %u %u %u\n", error.pt_idx, error.group,
+			error.hash_level, error.sector, error.kb, error.err_type,
+			error.is_zero ? 1U : 0U);
+	}
+	if (ferror(f)) {
+		ret = -EIO;
+	}
+	if (fclose(f) != 0 && ret == 0) {
+		ret = -errno;
+	}
+	if (ret != 0) {
+		_tremove(tmp_filename.c_str());
+		return ret;
+	}
+
+#ifdef _WIN32
+	if (!MoveFileEx(tmp_filename.c_str(), final_filename.c_str(), MOVEFILE_REPLACE_EXISTING)) {
+		// TODO: Convert Win32 error code to POSIX.
+		ret = -EIO;
+	}
+#else /* !_WIN32 */
+	if (rename(tmp_filename.c_str(), final_filename.c_str()) != 0) {
+		ret = -errno;
+	}
+#endif /* _WIN32 */
+	if (ret != 0) {
+		_tremove(tmp_filename.c_str());
+	}
+	return ret;
+}
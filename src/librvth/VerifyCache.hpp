@@ -0,0 +1,110 @@
+/***************************************************************************
+ * RVT-H Tool (librvth)                                                    *
+ * VerifyCache.hpp: Persistent cache for verification results.             *
+ *                                                                         *
+ * Copyright (c) 2026 by David Korth.                                      *
+ * SPDX-License-Identifier: GPL-2.0-or-later                               *
+ ***************************************************************************/
+
+#pragma once
+
+#include "libwiicrypto/common.h"
+#include "tcharx.h"
+
+// C includes
+#include <stdint.h>
+
+// C++ includes
+#include <string>
+#include <vector>
+
+/**
+ * Persistent cache for verification results.
+ *
+ * Each bank's results are stored in a separate file, named after
+ * a SHA-1 key that identifies the bank's contents. Since the key
+ * is only derived from the bank's metadata, corruption that doesn't
+ * change the metadata won't be detected until the cache is rebuilt.
+ *
+ * Cache directory:
+ * - Windows: %LOCALAPPDATA%\rvthtool\verify
+ * - Other: $XDG_CACHE_HOME/rvthtool/verify (default: ~/.cache)
+ *
+ * The cache is best-effort: if a file can't be read or written,
+ * the bank is verified as usual.
+ */
+class VerifyCache
+{
+public:
+	/**
+	 * Open the verification cache.
+	 * The directory is created when results are saved.
+	 * @param dir	[in,opt] Cache directory (if nullptr, use the user's cache directory)
+	 */
+	explicit VerifyCache(const TCHAR *dir = nullptr);
+
+private:
+	DISABLE_COPY(VerifyCache)
+
+public:
+	// Key size (SHA-1)
+	static constexpr unsigned int KEY_SIZE = 20;
+
+	/**
+	 * Cached hash verification error.
+	 */
+	struct Error {
+		uint8_t pt_idx;		// Partition index
+		uint8_t hash_level;	// Hash level (0-3)
+		uint8_t sector;		// Sector number (0-63)
+		uint8_t kb;		// KB number (1-31; H0 only)
+		uint8_t err_type;	// Error type (see RvtH_Verify_Error_Type)
+		bool is_zero;		// If true, the encrypted sector is all zeroes.
+		uint32_t group;		// Group number
+	};
+
+	/**
+	 * Is the cache directory known?
+	 * @return True if the cache can be used; false if not.
+	 */
+	inline bool isValid(void) const
+	{
+		return !m_dir.empty();
+	}
+
+	/**
+	 * Get the cache directory.
+	 * @return Cache directory (empty if unknown)
+	 */
+	inline const std::tstring &dir(void) const
+	{
+		return m_dir;
+	}
+
+	/**
+	 * Load cached results.
+	 * @param key		[in] Key
+	 * @param errors	[out] Errors, in the order they were reported
+	 * @return True if cached results were found; false if not.
+	 */
+	bool load(const uint8_t key[KEY_SIZE], std::vector<Error> &errors) const;
+
+	/**
+	 * Save results to the cache.
+	 * @param key		[in] Key
+	 * @param errors	[in] Errors, in the order they were reported
+	 * @return 0 on success; negative POSIX error code on error.
+	 */
+	int save(const uint8_t key[KEY_SIZE], const std::vector<Error> &errors) const;
+
+private:
+	/**
+	 * Get the filename for a key.
+	 * @param key	[in] Key
+	 * @return Filename
+	 */
+	std::tstring filename(const uint8_t key[KEY_SIZE]) const;
+
+private:
+	std::tstring m_dir;
+};
@@ -0,0 +1,95 @@
+/***************************************************************************
+ * RVT-H Tool (librvth)                                                    *
+ * aligned_malloc.h: Aligned memory allocation functions.                  *
+ *                                                                         *
+ * Copyright (c) 2026 by David Korth.                                      *
+ * SPDX-License-Identifier: GPL-2.0-or-later                               *
+ ***************************************************************************/
+
+#pragma once
+
+// C includes
+#include <stdlib.h>
+#ifdef _WIN32
+#  include <malloc.h>
+#endif /* _WIN32 */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Allocate aligned memory.
+ * Memory must be freed using aligned_free().
+ * @param alignment	[in] Alignment. (Must be a power of two and a multiple of sizeof(void*).)
+ * @param size		[in] Size.
+ * @return Pointer to allocated memory, or NULL on error.
+ */
+static inline void *aligned_malloc(size_t alignment, size_t size)
+{
+#ifdef _WIN32
+	return _aligned_malloc(size, alignment);
+#else /* !_WIN32 */
+	void *ptr;
+	return (posix_memalign(&ptr, alignment, size) == 0 ? ptr : NULL);
+#endif /* _WIN32 */
+}
+
+/**
+ * Free memory allocated with aligned_malloc().
+ * @param ptr	[in] Pointer to allocated memory.
+ */
+static inline void aligned_free(void *ptr)
+{
+#ifdef _WIN32
+	_aligned_free(ptr);
+#else /* !_WIN32 */
+	free(ptr);
+#endif /* _WIN32 */
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#ifdef __cplusplus
+
+// C++ includes
+#include <memory>
+#include <new>
+
+/**
+ * Deleter for std::unique_ptr<> with aligned_malloc().
+ */
+struct aligned_deleter {
+	inline void operator()(void *ptr) const
+	{
+		aligned_free(ptr);
+	}
+};
+
+/**
+ * std::unique_ptr<> for an array allocated with aligned_malloc().
+ */
+template<typename T>
+using aligned_unique_ptr = std::unique_ptr<T[], aligned_deleter>;
+
+/**
+ * Allocate an aligned array.
+ * Like operator new[], this throws std::bad_alloc on error.
+ * @tparam T Element type. (Must be trivially constructible.)
+ * @param alignment	[in] Alignment.
+ * @param count		[in] Number of elements.
+ * @return aligned_unique_ptr<T>
+ */
+template<typename T>
+static inline aligned_unique_ptr<T> aligned_uptr(size_t alignment, size_t count)
+{
+	T *const ptr = static_cast<T*>(aligned_malloc(alignment, count * sizeof(T)));
+	if (!ptr) {
+		throw std::bad_alloc();
+	}
+	return aligned_unique_ptr<T>(ptr);
+}
+
+#endif /* __cplusplus */
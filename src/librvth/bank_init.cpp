@@ -2,7 +2,7 @@
  * RVT-H Tool (librvth)                                                    *
  * bank_init.cpp: RvtH_BankEntry initialization functions.                 *
  *                                                                         *
- * Copyright (c) 2018-2025 by David Korth.                                 *
+ * Copyright (c) 2018-2026 by David Korth.                                 *
  * SPDX-License-Identifier: GPL-2.0-or-later                               *
  ***************************************************************************/
 
@@ -603,7 +603,7 @@ int rvth_init_BankEntry_AppLoader(RvtH_BankEntry *entry)
  * @param lba_start		[in] Starting LBA.
  * @param lba_len		[in] Length, in LBAs.
  * @param nhcd_timestamp	[in] Timestamp string pointer from the bank table.
- * @return 0 on success; negative POSIX error code on error.
+ * @return 1 if rvth_init_BankEntry_lazy() is needed; 0 if not; negative POSIX error code on error.
  */
 int rvth_init_BankEntry(RvtH_BankEntry *entry, const RefFilePtr &f_img,
 	uint8_t type, uint32_t lba_start, uint32_t lba_len,
@@ -704,6 +704,23 @@ int rvth_init_BankEntry(RvtH_BankEntry *entry, const RefFilePtr &f_img,
 		entry->timestamp = rvth_timestamp_parse(nhcd_timestamp);
 	}
 
+	// NOTE: The region code, encryption status, and AppLoader
+	// error status are initialized by rvth_init_BankEntry_lazy().
+	// We're done here.
+	return 1;
+}
+
+/**
+ * Initialize the RVT-H bank entry fields that require reading
+ * from the bank: region code, encryption status, and AppLoader
+ * error status.
+ *
+ * This should only be called if rvth_init_BankEntry() returned 1.
+ *
+ * @param entry		[in,out] RvtH_BankEntry
+ */
+void rvth_init_BankEntry_lazy(RvtH_BankEntry *entry)
+{
 	// TODO: Error handling.
 	// Initialize the region code.
 	rvth_init_BankEntry_region(entry);
@@ -711,7 +728,4 @@ int rvth_init_BankEntry(RvtH_BankEntry *entry, const RefFilePtr &f_img,
 	rvth_init_BankEntry_crypto(entry);
 	// Initialize the AppLoader error status.
 	rvth_init_BankEntry_AppLoader(entry);
-
-	// We're done here.
-	return 0;
 }
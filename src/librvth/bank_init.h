@@ -2,7 +2,7 @@
  * RVT-H Tool (librvth)                                                    *
  * bank_init.h: RvtH_BankEntry initialization functions.                   *
  *                                                                         *
- * Copyright (c) 2018-2025 by David Korth.                                 *
+ * Copyright (c) 2018-2026 by David Korth.                                 *
  * SPDX-License-Identifier: GPL-2.0-or-later                               *
  ***************************************************************************/
 
@@ -51,16 +51,32 @@ int rvth_init_BankEntry_AppLoader(RvtH_BankEntry *entry);
 
 /**
  * Initialize an RVT-H bank entry from an opened HDD image.
+ *
+ * Only the bank table entry and disc header are read here.
+ * Fields that require more reads from the bank are initialized
+ * by rvth_init_BankEntry_lazy().
+ *
  * @param entry			[out] RvtH_BankEntry
  * @param f_img			[in] RefFile*
  * @param type			[in] Bank type. (See RvtH_BankType_e.)
  * @param lba_start		[in] Starting LBA.
  * @param lba_len		[in] Length, in LBAs.
  * @param nhcd_timestamp	[in] Timestamp string pointer from the bank table.
- * @return 0 on success; negative POSIX error code on error.
+ * @return 1 if rvth_init_BankEntry_lazy() is needed; 0 if not; negative POSIX error code on error.
  */
 int rvth_init_BankEntry(RvtH_BankEntry *entry, const RefFilePtr &f_img,
 	uint8_t type, uint32_t lba_start, uint32_t lba_len,
 	const char *nhcd_timestamp);
 
+/**
+ * Initialize the RVT-H bank entry fields that require reading
+ * from the bank: region code, encryption status, and AppLoader
+ * error status.
+ *
+ * This should only be called if rvth_init_BankEntry() returned 1.
+ *
+ * @param entry		[in,out] RvtH_BankEntry
+ */
+void rvth_init_BankEntry_lazy(RvtH_BankEntry *entry);
+
 #endif
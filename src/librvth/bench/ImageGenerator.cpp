@@ -0,0 +1,520 @@
+/***************************************************************************
+ * RVT-H Tool (librvth/bench)                                              *
+ * ImageGenerator.cpp: Synthetic disc and RVT-H HDD image generator.       *
+ *                                                                         *
+ * Copyright (c) 2026 by David Korth.                                      *
+ * SPDX-License-Identifier: GPL-2.0-or-later                               *
+ ***************************************************************************/
+
+#include "ImageGenerator.hpp"
+
+#include "RefFile.hpp"
+#include "nhcd_structs.h"
+#include "reader/CisoReader.hpp"
+#include "reader/libwbfs.h"
+
+// libwiicrypto
+#include "libwiicrypto/byteswap.h"
+#include "libwiicrypto/cert.h"
+#include "libwiicrypto/cert_store.h"
+#include "libwiicrypto/gcn_structs.h"
+#include "libwiicrypto/priv_key_store.h"
+#include "libwiicrypto/wii_sector.h"
+#include "libwiicrypto/wii_structs.h"
+
+// Encryption
+#include "libwiicrypto/aesw.h"
+#include "libwiicrypto/sha1w.h"
+
+// C includes (C++ namespace)
+#include <cassert>
+#include <cerrno>
+#include <cstring>
+
+// C++ includes
+#include <memory>
+#include <random>
+using std::unique_ptr;
+using std::vector;
+
+// Disc layout.
+// The game partition is placed at the usual address,
+// and uses the usual layout for encrypted partitions.
+static const uint32_t PARTITION_ADDRESS = 0x50000;
+static const uint32_t PT_TMD_OFFSET = 0x2C0;
+static const uint32_t PT_H3_OFFSET = 0x8000;
+static const uint32_t PT_DATA_OFFSET_ENC = 0x20000;
+static const uint32_t PT_DATA_OFFSET_DEC = 0x8000;
+
+// Maximum number of groups. (limited by the H3 table)
+static const unsigned int H3_MAX_GROUPS = sizeof(Wii_Disc_H3_t) / RVL_SHA1_DIGEST_SIZE;
+
+// Disc and title IDs.
+static const char DISC_ID6[] = "RVTE01";
+static const char DISC_TITLE[] = "RVT-H Tool benchmark disc";
+static const uint32_t TITLE_ID_HI = 0x00010000;
+static const uint32_t TITLE_ID_LO = 0x52565445;	// "RVTE"
+static const uint32_t IOS_VERSION = 37;
+
+// Bank timestamp for HDD images.
+static const char BANK_TIMESTAMP[] = "20260101000000";
+
+/**
+ * Write data to a file.
+ * @param file		[in] RefFile
+ * @param offset	[in] Offset
+ * @param data		[in] Data
+ * @param size		[in] Size
+ * @return 0 on success; negative POSIX error code on error.
+ */
+static int writeAt(RefFile *file, off64_t offset, const void *data, size_t size)
+{
+	errno = 0;
+	if (file->pwrite(data, size, offset) != size) {
+		return (errno != 0 ? -errno : -EIO);
+	}
+	return 0;
+}
+
+/**
+ * Create a file for writing.
+ * @param filename	[in] Filename
+ * @param pErr		[out] Error code (negative POSIX error code)
+ * @return RefFile, or nullptr on error.
+ */
+static unique_ptr<RefFile> createFile(const TCHAR *filename, int *pErr)
+{
+	unique_ptr<RefFile> file(new RefFile(filename, true));
+	if (!file->isOpen()) {
+		*pErr = (file->lastError() != 0 ? -file->lastError() : -EIO);
+		return nullptr;
+	}
+	*pErr = 0;
+	return file;
+}
+
+/**
+ * Encrypt a group of Wii sectors.
+ * This is the same algorithm as rvth_encrypt_group() in extract_crypt.cpp.
+ * @param aesw		[in] AES context (key must be set to the title key)
+ * @param pInBuf	[in] User data (GROUP_SIZE_DEC bytes)
+ * @param pOutBuf	[out] Encrypted group (GROUP_SIZE_ENC bytes)
+ * @param pH3		[out] H3 hash (RVL_SHA1_DIGEST_SIZE bytes)
+ */
+static void encryptGroup(AesCtx *aesw, const uint8_t *pInBuf, uint8_t *pOutBuf, uint8_t *pH3)
+{
+	Wii_Disc_Sector_t *const sbuf = reinterpret_cast<Wii_Disc_Sector_t*>(pOutBuf);
+
+	// Copy the user data and calculate the H0 hashes.
+	for (unsigned int i = 0; i < 64; i++, pInBuf += SECTOR_SIZE_DEC) {
+		memcpy(sbuf[i].data, pInBuf, SECTOR_SIZE_DEC);
+		sha1w_hash_blocks(sbuf[i].hashes.H0[0], sbuf[i].data,
+			1024, 1024, ARRAY_SIZE(sbuf[i].hashes.H0));
+		memset(sbuf[i].hashes.pad_H0, 0, sizeof(sbuf[i].hashes.pad_H0));
+	}
+
+	// Calculate the H1 hashes for each subgroup of 8 sectors.
+	for (unsigned int i = 0; i < 64; i += 8) {
+		Wii_Disc_Sector_t *const sbuf0 = &sbuf[i];
+		sha1w_hash_blocks(sbuf0->hashes.H1[0], sbuf0->hashes.H0[0],
+			sizeof(sbuf0->hashes.H0), sizeof(*sbuf0), ARRAY_SIZE(sbuf0->hashes.H1));
+		memset(sbuf0->hashes.pad_H1, 0, sizeof(sbuf0->hashes.pad_H1));
+		for (unsigned int j = i+1; j < i+8; j++) {
+			memcpy(sbuf[j].hashes.H1, sbuf0->hashes.H1, sizeof(sbuf[j].hashes.H1));
+			memset(sbuf[j].hashes.pad_H1, 0, sizeof(sbuf[j].hashes.pad_H1));
+		}
+	}
+
+	// Calculate the H2 hashes. All sectors have the same H2 table.
+	sha1w_hash_blocks(sbuf[0].hashes.H2[0], sbuf[0].hashes.H1[0],
+		sizeof(sbuf[0].hashes.H1), sizeof(sbuf[0]) * 8, ARRAY_SIZE(sbuf[0].hashes.H2));
+	memset(sbuf[0].hashes.pad_H2, 0, sizeof(sbuf[0].hashes.pad_H2));
+	for (unsigned int i = 1; i < 64; i++) {
+		memcpy(sbuf[i].hashes.H2, sbuf[0].hashes.H2, sizeof(sbuf[i].hashes.H2));
+		memset(sbuf[i].hashes.pad_H2, 0, sizeof(sbuf[i].hashes.pad_H2));
+	}
+
+	// Calculate the H3 hash.
+	sha1w_hash_blocks(pH3, sbuf[0].hashes.H2[0],
+		sizeof(sbuf[0].hashes.H2), sizeof(sbuf[0].hashes.H2), 1);
+
+	// Encrypt the hashes first, then the user data.
+	// The user data IV is stored within the encrypted H2 table.
+	static const uint8_t iv_zero[16] = {0};
+	for (unsigned int i = 0; i < 64; i++) {
+		aesw_set_iv(aesw, iv_zero, sizeof(iv_zero));
+		aesw_encrypt(aesw, reinterpret_cast<uint8_t*>(&sbuf[i].hashes), sizeof(sbuf[i].hashes));
+		aesw_set_iv(aesw, &sbuf[i].hashes.H2[7][4], 16);
+		aesw_encrypt(aesw, sbuf[i].data, sizeof(sbuf[i].data));
+	}
+}
+
+/**
+ * Generate a synthetic Wii disc image.
+ * @param groups	[in] Number of 2 MB groups in the game partition
+ * @param seed		[in] Random number seed
+ */
+ImageGenerator::ImageGenerator(unsigned int groups, uint32_t seed)
+	: m_groups(groups)
+{
+	assert(groups > 0);
+	assert(groups <= H3_MAX_GROUPS);
+	if (m_groups == 0) {
+		m_groups = 1;
+	} else if (m_groups > H3_MAX_GROUPS) {
+		m_groups = H3_MAX_GROUPS;
+	}
+
+	std::mt19937 rng(seed);
+	for (uint8_t &b : m_title_key) {
+		b = static_cast<uint8_t>(rng());
+	}
+
+	// Encrypted image layout: disc header, partition, and
+	// a few empty blocks, rounded up to the block size.
+	const size_t pt_end = PARTITION_ADDRESS + PT_DATA_OFFSET_ENC +
+		(static_cast<size_t>(m_groups) * GROUP_SIZE_ENC);
+	const size_t image_size = ((pt_end + BLOCK_SIZE - 1) & ~(static_cast<size_t>(BLOCK_SIZE) - 1)) +
+		((m_groups / 4) + 1) * static_cast<size_t>(BLOCK_SIZE);
+	m_image.assign(image_size, 0);
+	buildDiscHeader(m_image.data(), true);
+
+	// Partition user data. The partition starts with
+	// a copy of the disc header, like a real disc.
+	m_userData.resize(static_cast<size_t>(m_groups) * GROUP_SIZE_DEC);
+	uint32_t *const p32 = reinterpret_cast<uint32_t*>(m_userData.data());
+	for (size_t i = 0; i < m_userData.size() / sizeof(uint32_t); i++) {
+		p32[i] = rng();
+	}
+	memcpy(m_userData.data(), m_image.data(), sizeof(GCN_DiscHeader));
+	GCN_DiscHeader *const pt_discHeader = reinterpret_cast<GCN_DiscHeader*>(m_userData.data());
+	pt_discHeader->hash_verify = 0;
+	pt_discHeader->disc_noCrypt = 0;
+
+	// Encrypt the groups and build the H3 table.
+	uint8_t *const pt = &m_image[PARTITION_ADDRESS];
+	uint8_t *const h3 = &pt[PT_H3_OFFSET];
+	AesCtx *const aesw = aesw_new();
+	aesw_set_key(aesw, m_title_key, sizeof(m_title_key));
+	for (unsigned int g = 0; g < m_groups; g++) {
+		encryptGroup(aesw,
+			&m_userData[static_cast<size_t>(g) * GROUP_SIZE_DEC],
+			&pt[PT_DATA_OFFSET_ENC + (static_cast<size_t>(g) * GROUP_SIZE_ENC)],
+			&h3[g * RVL_SHA1_DIGEST_SIZE]);
+	}
+	aesw_free(aesw);
+
+	// H4: SHA-1 of the H3 table, stored in the TMD.
+	uint8_t h4[RVL_SHA1_DIGEST_SIZE];
+	sha1w_hash_blocks(h4, h3, sizeof(Wii_Disc_H3_t), sizeof(Wii_Disc_H3_t), 1);
+	buildPartitionHeader(pt, true, h4);
+}
+
+/**
+ * Build the disc header, volume group table, and region setting.
+ * @param image		[out] Disc image (at least 0x50000 bytes)
+ * @param encrypted	[in] If true, the disc is encrypted.
+ */
+void ImageGenerator::buildDiscHeader(uint8_t *image, bool encrypted)
+{
+	GCN_DiscHeader *const discHeader = reinterpret_cast<GCN_DiscHeader*>(image);
+	memcpy(discHeader->id6, DISC_ID6, sizeof(discHeader->id6));
+	discHeader->magic_wii = cpu_to_be32(WII_MAGIC);
+	memcpy(discHeader->game_title, DISC_TITLE, sizeof(DISC_TITLE));
+	if (!encrypted) {
+		discHeader->hash_verify = 1;
+		discHeader->disc_noCrypt = 1;
+	}
+
+	// Volume group table: one volume group with the game partition.
+	static const uint32_t ptbl_address = RVL_VolumeGroupTable_ADDRESS + sizeof(RVL_VolumeGroupTable);
+	RVL_VolumeGroupTable *const vgtbl = reinterpret_cast<RVL_VolumeGroupTable*>(&image[RVL_VolumeGroupTable_ADDRESS]);
+	vgtbl->vg[0].count = cpu_to_be32(1);
+	vgtbl->vg[0].addr = cpu_to_be32(ptbl_address >> 2);
+	RVL_PartitionTableEntry *const ptbl = reinterpret_cast<RVL_PartitionTableEntry*>(&image[ptbl_address]);
+	ptbl->addr = cpu_to_be32(PARTITION_ADDRESS >> 2);
+	ptbl->type = cpu_to_be32(0);
+
+	RVL_RegionSetting *const region = reinterpret_cast<RVL_RegionSetting*>(&image[RVL_RegionSetting_ADDRESS]);
+	region->region_code = cpu_to_be32(GCN_REGION_USA);
+}
+
+/**
+ * Build the partition header.
+ * @param pthdr		[out] Partition header (RVL_PartitionHeader)
+ * @param encrypted	[in] If true, build the encrypted header; otherwise, unencrypted.
+ * @param h3_sha1	[in] SHA-1 of the H3 table (encrypted only)
+ */
+void ImageGenerator::buildPartitionHeader(uint8_t *pthdr, bool encrypted, const uint8_t *h3_sha1) const
+{
+	RVL_PartitionHeader *const hdr = reinterpret_cast<RVL_PartitionHeader*>(pthdr);
+	memset(hdr, 0, sizeof(*hdr));
+
+	// Ticket: debug issuer, with the fake title key
+	// encrypted using the debug common key.
+	RVL_Ticket *const ticket = &hdr->ticket;
+	ticket->signature_type = cpu_to_be32(RVL_SIGNATURE_TYPE_RSA2048_SHA1);
+	strncpy(ticket->issuer, RVL_Cert_Issuers[RVL_CERT_ISSUER_DPKI_TICKET], sizeof(ticket->issuer) - 1);
+	ticket->title_id.hi = cpu_to_be32(TITLE_ID_HI);
+	ticket->title_id.lo = cpu_to_be32(TITLE_ID_LO);
+	ticket->unknown2[0] = 0xFF;
+	ticket->unknown2[1] = 0xFF;
+	ticket->common_key_index = RVL_COMMON_KEY_INDEX_DEFAULT;
+
+	// The title key IV is the title ID, followed by zeroes.
+	uint8_t iv[16];
+	memcpy(iv, ticket->title_id.u8, sizeof(ticket->title_id.u8));
+	memset(&iv[8], 0, 8);
+	memcpy(ticket->enc_title_key, m_title_key, sizeof(ticket->enc_title_key));
+	AesCtx *const aesw = aesw_new();
+	aesw_set_key(aesw, RVL_AES_Keys[RVL_KEY_DEBUG], sizeof(RVL_AES_Keys[RVL_KEY_DEBUG]));
+	aesw_set_iv(aesw, iv, sizeof(iv));
+	aesw_encrypt(aesw, ticket->enc_title_key, sizeof(ticket->enc_title_key));
+	aesw_free(aesw);
+	cert_realsign_ticketOrTMD(reinterpret_cast<uint8_t*>(ticket), sizeof(*ticket), &rvth_privkey_RVL_dpki_ticket);
+
+	// TMD: one content entry, with the H3 table's SHA-1.
+	uint8_t *const tmd = &hdr->u8[PT_TMD_OFFSET];
+	RVL_TMD_Header *const tmdHeader = reinterpret_cast<RVL_TMD_Header*>(tmd);
+	tmdHeader->signature_type = cpu_to_be32(RVL_SIGNATURE_TYPE_RSA2048_SHA1);
+	strncpy(tmdHeader->issuer, RVL_Cert_Issuers[RVL_CERT_ISSUER_DPKI_TMD], sizeof(tmdHeader->issuer) - 1);
+	tmdHeader->sys_version.hi = cpu_to_be32(0x00000001);
+	tmdHeader->sys_version.lo = cpu_to_be32(IOS_VERSION);
+	tmdHeader->title_id = ticket->title_id;
+	tmdHeader->title_type = cpu_to_be32(1);
+	tmdHeader->nbr_cont = cpu_to_be16(1);
+
+	RVL_Content_Entry *const content = reinterpret_cast<RVL_Content_Entry*>(&tmd[sizeof(RVL_TMD_Header)]);
+	content->type = cpu_to_be16(RVL_CONTENT_TYPE_DEFAULT);
+	content->size = cpu_to_be64(static_cast<uint64_t>(m_groups) * GROUP_SIZE_DEC);
+	if (encrypted) {
+		memcpy(content->sha1_hash, h3_sha1, sizeof(content->sha1_hash));
+	}
+
+	const uint32_t tmd_size = sizeof(RVL_TMD_Header) + sizeof(RVL_Content_Entry);
+	cert_realsign_ticketOrTMD(tmd, tmd_size, &rvth_privkey_RVL_dpki_tmd);
+	hdr->tmd_size = cpu_to_be32(tmd_size);
+	hdr->tmd_offset = cpu_to_be32(PT_TMD_OFFSET >> 2);
+
+	// Certificate chain: Ticket, CA, TMD.
+	static const RVL_Cert_Issuer cert_issuers[] = {
+		RVL_CERT_ISSUER_DPKI_TICKET,
+		RVL_CERT_ISSUER_DPKI_CA,
+		RVL_CERT_ISSUER_DPKI_TMD,
+	};
+	const uint32_t cert_chain_offset = (PT_TMD_OFFSET + tmd_size + 63) & ~63U;
+	uint32_t cert_chain_size = 0;
+	for (RVL_Cert_Issuer issuer : cert_issuers) {
+		const unsigned int cert_size = cert_get_size(issuer);
+		memcpy(&hdr->u8[cert_chain_offset + cert_chain_size], cert_get(issuer), cert_size);
+		cert_chain_size += cert_size;
+	}
+	hdr->cert_chain_size = cpu_to_be32(cert_chain_size);
+	hdr->cert_chain_offset = cpu_to_be32(cert_chain_offset >> 2);
+
+	if (encrypted) {
+		hdr->h3_table_offset = cpu_to_be32(PT_H3_OFFSET >> 2);
+		hdr->data_offset = cpu_to_be32(PT_DATA_OFFSET_ENC >> 2);
+		hdr->data_size = cpu_to_be32(static_cast<uint32_t>(
+			(static_cast<uint64_t>(m_groups) * GROUP_SIZE_ENC) >> 2));
+	} else {
+		// Unencrypted RVT-H images don't have an H3 table,
+		// and the data size is left as 0.
+		hdr->data_offset = cpu_to_be32(PT_DATA_OFFSET_DEC >> 2);
+	}
+}
+
+/**
+ * Is a 2 MB block of the plain image empty?
+ * @param block	[in] Block number
+ * @return True if the block is all zeroes; false if not.
+ */
+bool ImageGenerator::isBlockEmpty(unsigned int block) const
+{
+	// Only the blocks after the partition are empty.
+	const size_t pt_end = PARTITION_ADDRESS + PT_DATA_OFFSET_ENC +
+		(static_cast<size_t>(m_groups) * GROUP_SIZE_ENC);
+	return (static_cast<size_t>(block) * BLOCK_SIZE >= pt_end);
+}
+
+/**
+ * Write a plain, encrypted disc image.
+ * @param filename	[in] Filename
+ * @return 0 on success; negative POSIX error code on error.
+ */
+int ImageGenerator::writeGcm(const TCHAR *filename) const
+{
+	int ret;
+	unique_ptr<RefFile> file = createFile(filename, &ret);
+	if (!file) {
+		return ret;
+	}
+	return writeAt(file.get(), 0, m_image.data(), m_image.size());
+}
+
+/**
+ * Write an unencrypted RVT-H disc image.
+ * The game partition has the same user data as the encrypted
+ * image, but without hashes or encryption.
+ * @param filename	[in] Filename
+ * @return 0 on success; negative POSIX error code on error.
+ */
+int ImageGenerator::writeUnencrypted(const TCHAR *filename) const
+{
+	int ret;
+	unique_ptr<RefFile> file = createFile(filename, &ret);
+	if (!file) {
+		return ret;
+	}
+
+	vector<uint8_t> header(PARTITION_ADDRESS + PT_DATA_OFFSET_DEC);
+	buildDiscHeader(header.data(), false);
+	buildPartitionHeader(&header[PARTITION_ADDRESS], false, nullptr);
+	ret = writeAt(file.get(), 0, header.data(), header.size());
+	if (ret != 0) {
+		return ret;
+	}
+	// NOTE: GROUP_SIZE_DEC is a multiple of the LBA size.
+	return writeAt(file.get(), header.size(), m_userData.data(), m_userData.size());
+}
+
+/**
+ * Write a CISO disc image.
+ * Empty 2 MB blocks are not stored.
+ * @param filename	[in] Filename
+ * @return 0 on success; negative POSIX error code on error.
+ */
+int ImageGenerator::writeCiso(const TCHAR *filename) const
+{
+	const unsigned int block_count = static_cast<unsigned int>(m_image.size() / BLOCK_SIZE);
+	if (block_count > CisoReader::CISO_MAP_SIZE) {
+		return -EFBIG;
+	}
+
+	int ret;
+	unique_ptr<RefFile> file = createFile(filename, &ret);
+	if (!file) {
+		return ret;
+	}
+
+	// CISO header: magic, block size (little-endian), and block map.
+	vector<uint8_t> header(CisoReader::CISO_HEADER_SIZE);
+	memcpy(&header[0], "CISO", 4);
+	const uint32_t block_size_le = cpu_to_le32(BLOCK_SIZE);
+	memcpy(&header[4], &block_size_le, sizeof(block_size_le));
+
+	off64_t offset = CisoReader::CISO_HEADER_SIZE;
+	for (unsigned int block = 0; block < block_count; block++) {
+		if (isBlockEmpty(block))
+			continue;
+		header[8 + block] = 1;
+		ret = writeAt(file.get(), offset, &m_image[static_cast<size_t>(block) * BLOCK_SIZE], BLOCK_SIZE);
+		if (ret != 0) {
+			return ret;
+		}
+		offset += BLOCK_SIZE;
+	}
+	return writeAt(file.get(), 0, header.data(), header.size());
+}
+
+/**
+ * Write a WBFS disc image.
+ * Empty 2 MB blocks are not stored.
+ * @param filename	[in] Filename
+ * @return 0 on success; negative POSIX error code on error.
+ */
+int ImageGenerator::writeWbfs(const TCHAR *filename) const
+{
+	// 512-byte HDD sectors, 2 MB WBFS sectors.
+	// The WBFS header and disc table use physical block 0.
+	static const uint8_t hd_sec_sz_s = 9;
+	static const uint8_t wbfs_sec_sz_s = 21;
+	static_assert((1U << wbfs_sec_sz_s) == BLOCK_SIZE, "WBFS sector size must match BLOCK_SIZE");
+	static const unsigned int n_wbfs_sec_per_disc = (143432*2) >> (wbfs_sec_sz_s - 15);
+
+	const unsigned int block_count = static_cast<unsigned int>(m_image.size() / BLOCK_SIZE);
+	if (block_count > n_wbfs_sec_per_disc) {
+		return -EFBIG;
+	}
+
+	int ret;
+	unique_ptr<RefFile> file = createFile(filename, &ret);
+	if (!file) {
+		return ret;
+	}
+
+	vector<uint8_t> header(LBA_SIZE + sizeof(wbfs_disc_info_t) + n_wbfs_sec_per_disc * sizeof(be16_t));
+	wbfs_head_t *const head = reinterpret_cast<wbfs_head_t*>(header.data());
+	memcpy(&head->magic, "WBFS", 4);
+	head->hd_sec_sz_s = hd_sec_sz_s;
+	head->wbfs_sec_sz_s = wbfs_sec_sz_s;
+	head->disc_table[0] = 1;
+	wbfs_disc_info_t *const disc_info = reinterpret_cast<wbfs_disc_info_t*>(&header[LBA_SIZE]);
+	memcpy(disc_info->disc_header_copy, m_image.data(), sizeof(GCN_DiscHeader));
+
+	unsigned int phys = 1;
+	for (unsigned int block = 0; block < block_count; block++) {
+		if (isBlockEmpty(block))
+			continue;
+		disc_info->wlba_table[block] = cpu_to_be16(phys);
+		ret = writeAt(file.get(), static_cast<off64_t>(phys) * BLOCK_SIZE,
+			&m_image[static_cast<size_t>(block) * BLOCK_SIZE], BLOCK_SIZE);
+		if (ret != 0) {
+			return ret;
+		}
+		phys++;
+	}
+	head->n_hd_sec = cpu_to_be32(BYTES_TO_LBA(static_cast<off64_t>(phys) * BLOCK_SIZE));
+	return writeAt(file.get(), 0, header.data(), header.size());
+}
+
+/**
+ * Write an RVT-H HDD image with an 8-bank NHCD bank table.
+ * The first `banks` banks contain the disc image, and the
+ * rest are empty. The HDD image is created as a sparse file.
+ * @param filename	[in] Filename
+ * @param banks		[in] Number of banks to fill (1-8)
+ * @return 0 on success; negative POSIX error code on error.
+ */
+int ImageGenerator::writeHdd(const TCHAR *filename, unsigned int banks) const
+{
+	assert(banks >= 1 && banks <= NHCD_BANK_COUNT);
+	if (banks < 1 || banks > NHCD_BANK_COUNT) {
+		return -EINVAL;
+	}
+
+	int ret;
+	unique_ptr<RefFile> file = createFile(filename, &ret);
+	if (!file) {
+		return ret;
+	}
+	ret = file->makeSparse(LBA_TO_BYTES(NHCD_BANK_START_LBA(NHCD_BANK_COUNT, NHCD_BANK_COUNT)));
+	if (ret != 0) {
+		return ret;
+	}
+
+	unique_ptr<NHCD_BankTable> bankTable(new NHCD_BankTable);
+	memset(bankTable.get(), 0, sizeof(*bankTable));
+	bankTable->header.magic = cpu_to_be32(NHCD_BANKTABLE_MAGIC);
+	bankTable->header.x004 = cpu_to_be32(0x00000001);
+	bankTable->header.bank_count = cpu_to_be32(NHCD_BANK_COUNT);
+	bankTable->header.x010 = cpu_to_be32(0x002FF000);
+
+	for (unsigned int bank = 0; bank < banks; bank++) {
+		const uint32_t lba_start = NHCD_BANK_START_LBA(bank, NHCD_BANK_COUNT);
+		NHCD_BankEntry *const entry = &bankTable->entries[bank];
+		entry->type = cpu_to_be32(NHCD_BankType_Wii_SL);
+		memset(entry->all_zero, '0', sizeof(entry->all_zero));
+		memcpy(entry->timestamp, BANK_TIMESTAMP, sizeof(entry->timestamp));
+		entry->lba_start = cpu_to_be32(lba_start);
+		entry->lba_len = cpu_to_be32(BYTES_TO_LBA(m_image.size()));
+
+		ret = writeAt(file.get(), LBA_TO_BYTES(lba_start), m_image.data(), m_image.size());
+		if (ret != 0) {
+			return ret;
+		}
+	}
+
+	return writeAt(file.get(), LBA_TO_BYTES(NHCD_BANKTABLE_ADDRESS_LBA),
+		bankTable.get(), sizeof(*bankTable));
+}
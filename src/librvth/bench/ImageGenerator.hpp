@@ -0,0 +1,162 @@
+/***************************************************************************
+ * RVT-H Tool (librvth/bench)                                              *
+ * ImageGenerator.hpp: Synthetic disc and RVT-H HDD image generator.       *
+ *                                                                         *
+ * Copyright (c) 2026 by David Korth.                                      *
+ * SPDX-License-Identifier: GPL-2.0-or-later                               *
+ ***************************************************************************/
+
+#pragma once
+
+#include "libwiicrypto/common.h"
+#include "tcharx.h"
+
+// C includes
+#include <stdint.h>
+
+// C++ includes
+#include <vector>
+
+/**
+ * Synthetic Wii disc image generator.
+ *
+ * The generated disc has a single game partition filled with
+ * pseudo-random data. The partition is encrypted with a fake
+ * title key, and the H0-H4 hashes are generated so the image
+ * verifies without errors. The ticket and TMD are signed with
+ * the debug keys, so the image can be imported as-is.
+ *
+ * A few empty 2 MB blocks are appended after the partition,
+ * so CISO and WBFS images are smaller than the plain image.
+ *
+ * The whole image is kept in memory, so the group count
+ * should be kept reasonably small.
+ */
+class ImageGenerator
+{
+public:
+	/**
+	 * Generate a synthetic Wii disc image.
+	 * @param groups	[in] Number of 2 MB groups in the game partition
+	 * @param seed		[in] Random number seed
+	 */
+	explicit ImageGenerator(unsigned int groups, uint32_t seed = 0x52565448);
+
+private:
+	DISABLE_COPY(ImageGenerator)
+
+public:
+	// CISO and WBFS block size.
+	static constexpr uint32_t BLOCK_SIZE = 2U*1024U*1024U;
+
+	/**
+	 * Get the number of groups in the game partition.
+	 * @return Number of groups
+	 */
+	inline unsigned int groups(void) const
+	{
+		return m_groups;
+	}
+
+	/**
+	 * Get the size of the plain, encrypted disc image.
+	 * @return Image size, in bytes
+	 */
+	inline uint64_t imageSize(void) const
+	{
+		return m_image.size();
+	}
+
+	/**
+	 * Get the size of the game partition's encrypted data.
+	 * This is the amount of data hashed by verification.
+	 * @return Data size, in bytes
+	 */
+	inline uint64_t dataSize(void) const
+	{
+		return static_cast<uint64_t>(m_groups) * BLOCK_SIZE;
+	}
+
+	/**
+	 * Get the game partition's decrypted user data.
+	 * @return User data (groups() * GROUP_SIZE_DEC bytes)
+	 */
+	inline const uint8_t *userData(void) const
+	{
+		return m_userData.data();
+	}
+
+	/**
+	 * Write a plain, encrypted disc image.
+	 * @param filename	[in] Filename
+	 * @return 0 on success; negative POSIX error code on error.
+	 */
+	int writeGcm(const TCHAR *filename) const;
+
+	/**
+	 * Write an unencrypted RVT-H disc image.
+	 * The game partition has the same user data as the encrypted
+	 * image, but without hashes or encryption.
+	 * @param filename	[in] Filename
+	 * @return 0 on success; negative POSIX error code on error.
+	 */
+	int writeUnencrypted(const TCHAR *filename) const;
+
+	/**
+	 * Write a CISO disc image.
+	 * Empty 2 MB blocks are not stored.
+	 * @param filename	[in] Filename
+	 * @return 0 on success; negative POSIX error code on error.
+	 */
+	int writeCiso(const TCHAR *filename) const;
+
+	/**
+	 * Write a WBFS disc image.
+	 * Empty 2 MB blocks are not stored.
+	 * @param filename	[in] Filename
+	 * @return 0 on success; negative POSIX error code on error.
+	 */
+	int writeWbfs(const TCHAR *filename) const;
+
+	/**
+	 * Write an RVT-H HDD image with an 8-bank NHCD bank table.
+	 * The first `banks` banks contain the disc image, and the
+	 * rest are empty. The HDD image is created as a sparse file.
+	 * @param filename	[in] Filename
+	 * @param banks		[in] Number of banks to fill (1-8)
+	 * @return 0 on success; negative POSIX error code on error.
+	 */
+	int writeHdd(const TCHAR *filename, unsigned int banks) const;
+
+private:
+	/**
+	 * Build the partition header.
+	 * @param pthdr		[out] Partition header (RVL_PartitionHeader)
+	 * @param encrypted	[in] If true, build the encrypted header; otherwise, unencrypted.
+	 * @param h3_sha1	[in] SHA-1 of the H3 table (encrypted only)
+	 */
+	void buildPartitionHeader(uint8_t *pthdr, bool encrypted, const uint8_t *h3_sha1) const;
+
+	/**
+	 * Build the disc header, volume group table, and region setting.
+	 * @param image		[out] Disc image (at least 0x50000 bytes)
+	 * @param encrypted	[in] If true, the disc is encrypted.
+	 */
+	static void buildDiscHeader(uint8_t *image, bool encrypted);
+
+	/**
+	 * Is a 2 MB block of the plain image empty?
+	 * @param block	[in] Block number
+	 * @return True if the block is all zeroes; false if not.
+	 */
+	bool isBlockEmpty(unsigned int block) const;
+
+private:
+	unsigned int m_groups;
+	uint8_t m_title_key[16];
+
+	// Encrypted disc image
+	std::vector<uint8_t> m_image;
+	// Unencrypted user data for the game partition
+	std::vector<uint8_t> m_userData;
+};
@@ -0,0 +1,573 @@
+/***************************************************************************
+ * RVT-H Tool (librvth/bench)                                              *
+ * bench.cpp: librvth benchmark suite.                                     *
+ *                                                                         *
+ * Copyright (c) 2026 by David Korth.                                      *
+ * SPDX-License-Identifier: GPL-2.0-or-later                               *
+ ***************************************************************************/
+
+#include "ImageGenerator.hpp"
+
+#include "rvth.hpp"
+#include "rvth_error.h"
+#include "RefFile.hpp"
+#include "nhcd_structs.h"
+#include "aligned_malloc.h"
+#include "reader/Reader.hpp"
+#include "libwiicrypto/sig_tools.h"
+#include "libwiicrypto/wii_sector.h"
+
+#include "git.h"
+
+// C includes (C++ namespace)
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+// C++ includes
+#include <chrono>
+#include <memory>
+#include <string>
+#include <vector>
+using std::string;
+using std::unique_ptr;
+using std::vector;
+
+// JSON report version.
+// Increment this if existing fields are changed or removed.
+static const unsigned int BENCH_REPORT_VERSION = 1;
+
+// Image filenames. (created in the current directory)
+static const TCHAR GCM_FILENAME[] = _T("librvth_bench.gcm");
+static const TCHAR UNENC_FILENAME[] = _T("librvth_bench.unenc.gcm");
+static const TCHAR CISO_FILENAME[] = _T("librvth_bench.ciso");
+static const TCHAR WBFS_FILENAME[] = _T("librvth_bench.wbfs");
+static const TCHAR HDD_FILENAME[] = _T("librvth_bench.hdd.img");
+static const TCHAR EXTRACT_FILENAME[] = _T("librvth_bench.extract.gcm");
+
+/**
+ * Benchmark options.
+ */
+struct BenchOptions {
+	unsigned int groups = 64;	// Groups per disc image
+	unsigned int banks = 4;		// Banks to fill in the HDD image
+	unsigned int iterations = 3;	// Iterations per benchmark
+	unsigned int threads = 0;	// Worker threads (0 for auto)
+	bool keep = false;		// Keep the generated images
+	const TCHAR *output = nullptr;	// JSON output file (nullptr for stdout)
+	const TCHAR *import_device = nullptr;	// RVT-H Reader device for the import benchmark
+	unsigned int import_bank = 0;	// Bank number for the import benchmark
+};
+
+/**
+ * Benchmark result.
+ */
+struct BenchResult {
+	string name;		// Benchmark name
+	string format;		// Image format
+	unsigned int iterations = 0;	// Iterations completed
+	uint64_t bytes = 0;	// Bytes processed per iteration
+	double best_s = 0;	// Best time, in seconds
+	double mean_s = 0;	// Mean time, in seconds
+	int err = 0;		// Error code (0 on success)
+	string skipped;		// If not empty, reason the benchmark was skipped
+};
+
+/**
+ * Convert an error code to a string.
+ * @param err Error code (If negative, POSIX error; otherwise, see RvtH_Errors.)
+ * @return Error string
+ */
+static const char *errorString(int err)
+{
+	return (err < 0 ? strerror(-err) : rvth_error(err));
+}
+
+/**
+ * Run a benchmark.
+ * Iterations stop at the first error.
+ * @param name		[in] Benchmark name
+ * @param format	[in] Image format
+ * @param bytes		[in] Bytes processed per iteration
+ * @param iterations	[in] Number of iterations
+ * @param func		[in] Benchmark function (returns an error code)
+ * @return Benchmark result
+ */
+template<typename Func>
+static BenchResult runBench(const char *name, const char *format,
+	uint64_t bytes, unsigned int iterations, Func func)
+{
+	BenchResult result;
+	result.name = name;
+	result.format = format;
+	result.bytes = bytes;
+
+	double total = 0;
+	for (unsigned int i = 0; i < iterations; i++) {
+		const auto t_start = std::chrono::steady_clock::now();
+		const int err = func();
+		const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - t_start;
+		if (err != 0) {
+			result.err = err;
+			break;
+		}
+
+		const double s = elapsed.count();
+		if (result.iterations == 0 || s < result.best_s) {
+			result.best_s = s;
+		}
+		total += s;
+		result.iterations++;
+	}
+	if (result.iterations > 0) {
+		result.mean_s = total / result.iterations;
+	}
+
+	if (result.err != 0) {
+		fprintf(stderr, "%-16s %-6s FAILED: %s\n", name, format, errorString(result.err));
+	} else {
+		const double mib_s = (result.best_s > 0)
+			? (static_cast<double>(bytes) / (1024.0 * 1024.0) / result.best_s)
+			: 0;
+		fprintf(stderr, "%-16s %-6s best %9.4f s, mean %9.4f s, %9.1f MiB/s\n",
+			name, format, result.best_s, result.mean_s, mib_s);
+	}
+	return result;
+}
+
+/**
+ * Record a skipped benchmark.
+ * @param name		[in] Benchmark name
+ * @param format	[in] Image format
+ * @param reason	[in] Reason
+ * @return Benchmark result
+ */
+static BenchResult skipBench(const char *name, const char *format, const char *reason)
+{
+	BenchResult result;
+	result.name = name;
+	result.format = format;
+	result.skipped = reason;
+	fprintf(stderr, "%-16s %-6s skipped: %s\n", name, format, reason);
+	return result;
+}
+
+/**
+ * Escape a string for JSON.
+ * @param str String
+ * @return Escaped string, including quotes
+ */
+static string jsonString(const string &str)
+{
+	string ret;
+	ret.reserve(str.size() + 2);
+	ret += '"';
+	for (const char chr : str) {
+		switch (chr) {
+			case '"':	ret += "\\\""; break;
+			case '\\':	ret += "\\\\"; break;
+			case '\n':	ret += "\\n"; break;
+			case '\r':	ret += "\\r"; break;
+			case '\t':	ret += "\\t"; break;
+			default:
+				if (static_cast<unsigned char>(chr) < 0x20) {
+					char buf[8];
+					snprintf(buf, sizeof(buf), "\\u%04x", static_cast<unsigned char>(chr));
+					ret += buf;
+				} else {
+					ret += chr;
+				}
+				break;
+		}
+	}
+	ret += '"';
+	return ret;
+}
+
+/**
+ * Write the JSON report.
+ * @param f		[in] Output file
+ * @param opts		[in] Benchmark options
+ * @param gen		[in] Image generator
+ * @param results	[in] Benchmark results
+ */
+static void writeReport(FILE *f, const BenchOptions &opts,
+	const ImageGenerator &gen, const vector<BenchResult> &results)
+{
+#ifdef RP_GIT_VERSION
+	// Skip the "git: " prefix.
+	const string git_version(&RP_GIT_VERSION[5]);
+#else /* !RP_GIT_VERSION */
+	const string git_version;
+#endif /* RP_GIT_VERSION */
+#ifdef RP_GIT_DESCRIBE
+	const string git_describe(RP_GIT_DESCRIBE);
+#else /* !RP_GIT_DESCRIBE */
+	const string git_describe;
+#endif /* RP_GIT_DESCRIBE */
+
+	fprintf(f, "{\n");
+	fprintf(f, "  \"version\": %u,\n", BENCH_REPORT_VERSION);
+	fprintf(f, "  \"git\": %s,\n", jsonString(git_version).c_str());
+	fprintf(f, "  \"git_describe\": %s,\n", jsonString(git_describe).c_str());
+	fprintf(f, "  \"config\": {\n");
+	fprintf(f, "    \"groups\": %u,\n", gen.groups());
+	fprintf(f, "    \"banks\": %u,\n", opts.banks);
+	fprintf(f, "    \"iterations\": %u,\n", opts.iterations);
+	fprintf(f, "    \"threads\": %u,\n", opts.threads);
+	fprintf(f, "    \"image_size\": %llu,\n", static_cast<unsigned long long>(gen.imageSize()));
+	fprintf(f, "    \"data_size\": %llu\n", static_cast<unsigned long long>(gen.dataSize()));
+	fprintf(f, "  },\n");
+	fprintf(f, "  \"results\": [");
+	bool first = true;
+	for (const BenchResult &result : results) {
+		fprintf(f, "%s\n    {", first ? "" : ",");
+		first = false;
+		fprintf(f, "\"name\": %s, \"format\": %s, ",
+			jsonString(result.name).c_str(), jsonString(result.format).c_str());
+		if (!result.skipped.empty()) {
+			fprintf(f, "\"skipped\": %s}", jsonString(result.skipped).c_str());
+			continue;
+		}
+
+		const double mib_s = (result.err == 0 && result.best_s > 0)
+			? (static_cast<double>(result.bytes) / (1024.0 * 1024.0) / result.best_s)
+			: 0;
+		fprintf(f, "\"iterations\": %u, \"bytes\": %llu, "
+			"\"best_s\": %.6f, \"mean_s\": %.6f, \"mib_per_s\": %.2f, \"err\": %d",
+			result.iterations, static_cast<unsigned long long>(result.bytes),
+			result.best_s, result.mean_s, mib_s, result.err);
+		if (result.err != 0) {
+			fprintf(f, ", \"error\": %s", jsonString(errorString(result.err)).c_str());
+		}
+		fprintf(f, "}");
+	}
+	fprintf(f, "\n  ]\n}\n");
+}
+
+/**
+ * Read an entire disc image using Reader::read().
+ * @param filename	[in] Filename
+ * @param lba_start	[in] Starting LBA (0 for the entire file)
+ * @param lba_len	[in] Length, in LBAs (0 for the entire file)
+ * @return 0 on success; negative POSIX error code on error.
+ */
+static int readImage(const TCHAR *filename, uint32_t lba_start, uint32_t lba_len)
+{
+	RefFilePtr file = std::make_shared<RefFile>(filename);
+	if (!file->isOpen()) {
+		return (file->lastError() != 0 ? -file->lastError() : -EIO);
+	}
+	unique_ptr<Reader> reader(Reader::open(file, lba_start, lba_len));
+	if (!reader) {
+		return (errno != 0 ? -errno : -EIO);
+	}
+
+	// Read in 2 MB chunks.
+	static const uint32_t chunk_lba = BYTES_TO_LBA(ImageGenerator::BLOCK_SIZE);
+	uint8_t *const buf = static_cast<uint8_t*>(aligned_malloc(4096, ImageGenerator::BLOCK_SIZE));
+	if (!buf) {
+		return -ENOMEM;
+	}
+	int ret = 0;
+	const uint32_t total_lba = reader->lba_len();
+	for (uint32_t lba = 0; lba < total_lba; lba += chunk_lba) {
+		const uint32_t count = (total_lba - lba < chunk_lba) ? (total_lba - lba) : chunk_lba;
+		if (reader->read(buf, lba, count) != count) {
+			ret = -EIO;
+			break;
+		}
+	}
+	aligned_free(buf);
+	return ret;
+}
+
+/**
+ * Verify a bank and check that there are no errors.
+ * @param rvth		[in] RvtH object
+ * @param bank		[in] Bank number
+ * @param threads	[in] Number of worker threads
+ * @return 0 on success; non-zero on error.
+ */
+static int verifyBank(RvtH *rvth, unsigned int bank, unsigned int threads)
+{
+	RvtH::WiiErrorCount_t errorCount;
+	memset(&errorCount, 0, sizeof(errorCount));
+	int ret = rvth->verifyWiiPartitions(bank, &errorCount, nullptr, nullptr, threads);
+	if (ret != 0) {
+		return ret;
+	}
+	for (unsigned int errs : errorCount.errs) {
+		if (errs != 0) {
+			// The generated images should never have hash errors.
+			return -EBADMSG;
+		}
+	}
+	return 0;
+}
+
+/**
+ * Print usage information.
+ */
+static void printUsage(void)
+{
+	fputs("Usage: librvth_bench [options]\n"
+		"\n"
+		"Generates synthetic Wii disc images and RVT-H HDD images in the\n"
+		"current directory, benchmarks librvth operations on them, and\n"
+		"writes a JSON report. All images are read from the page cache\n"
+		"after the first iteration, so results reflect CPU throughput.\n"
+		"\n"
+		"Options:\n"
+		"  --groups N         2 MB groups per disc image (default 64)\n"
+		"  --banks N          Banks to fill in the HDD image, 1-8 (default 4)\n"
+		"  --iterations N     Iterations per benchmark (default 3)\n"
+		"  --threads N        Worker threads; 0 for auto (default 0)\n"
+		"  --quick            Small smoke test: 8 groups, 2 banks, 1 iteration\n"
+		"  --output FILE      Write the JSON report to FILE (default: stdout)\n"
+		"  --keep             Keep the generated images\n"
+		"  --import-device DEV  Benchmark importing into an RVT-H Reader.\n"
+		"                     The import bank must be empty, and will be\n"
+		"                     deleted after each iteration.\n"
+		"  --import-bank N    Bank number for --import-device, 1-8 (default 1)\n",
+		stderr);
+}
+
+/**
+ * Parse an unsigned integer option.
+ * @param arg	[in] Argument
+ * @param pVal	[out] Value
+ * @return True on success; false on error.
+ */
+static bool parseUInt(const TCHAR *arg, unsigned int *pVal)
+{
+	if (!arg || arg[0] == _T('\0')) {
+		return false;
+	}
+	TCHAR *endptr = nullptr;
+	const unsigned long val = _tcstoul(arg, &endptr, 10);
+	if (*endptr != _T('\0') || val > 0xFFFFFFFFUL) {
+		return false;
+	}
+	*pVal = static_cast<unsigned int>(val);
+	return true;
+}
+
+int RVTH_CDECL _tmain(int argc, TCHAR *argv[])
+{
+	BenchOptions opts;
+	for (int i = 1; i < argc; i++) {
+		const TCHAR *const arg = argv[i];
+		const TCHAR *const val = (i + 1 < argc) ? argv[i + 1] : nullptr;
+		bool ok = true;
+		if (!_tcscmp(arg, _T("--groups"))) {
+			ok = parseUInt(val, &opts.groups) && opts.groups > 0; i++;
+		} else if (!_tcscmp(arg, _T("--banks"))) {
+			ok = parseUInt(val, &opts.banks) && opts.banks >= 1 && opts.banks <= NHCD_BANK_COUNT; i++;
+		} else if (!_tcscmp(arg, _T("--iterations"))) {
+			ok = parseUInt(val, &opts.iterations) && opts.iterations > 0; i++;
+		} else if (!_tcscmp(arg, _T("--threads"))) {
+			ok = parseUInt(val, &opts.threads); i++;
+		} else if (!_tcscmp(arg, _T("--quick"))) {
+			opts.groups = 8;
+			opts.banks = 2;
+			opts.iterations = 1;
+		} else if (!_tcscmp(arg, _T("--output"))) {
+			ok = (val != nullptr); opts.output = val; i++;
+		} else if (!_tcscmp(arg, _T("--keep"))) {
+			opts.keep = true;
+		} else if (!_tcscmp(arg, _T("--import-device"))) {
+			ok = (val != nullptr); opts.import_device = val; i++;
+		} else if (!_tcscmp(arg, _T("--import-bank"))) {
+			ok = parseUInt(val, &opts.import_bank) && opts.import_bank >= 1 && opts.import_bank <= NHCD_BANK_COUNT; i++;
+			opts.import_bank--;
+		} else if (!_tcscmp(arg, _T("--help"))) {
+			printUsage();
+			return EXIT_SUCCESS;
+		} else {
+			ok = false;
+		}
+		if (!ok) {
+			printUsage();
+			return EXIT_FAILURE;
+		}
+	}
+
+	fprintf(stderr, "librvth benchmark suite: %u groups, %u banks, %u iterations\n",
+		opts.groups, opts.banks, opts.iterations);
+	vector<BenchResult> results;
+
+	// Generate the images.
+	unique_ptr<ImageGenerator> gen;
+	results.push_back(runBench("generate", "memory",
+		static_cast<uint64_t>(opts.groups) * GROUP_SIZE_ENC, 1, [&]() {
+			gen.reset(new ImageGenerator(opts.groups));
+			return 0;
+		}));
+	const uint64_t image_size = gen->imageSize();
+	const uint64_t data_size = gen->dataSize();
+	const uint64_t user_size = static_cast<uint64_t>(gen->groups()) * GROUP_SIZE_DEC;
+
+	results.push_back(runBench("write", "gcm", image_size, 1,
+		[&]() { return gen->writeGcm(GCM_FILENAME); }));
+	results.push_back(runBench("write", "unenc", user_size, 1,
+		[&]() { return gen->writeUnencrypted(UNENC_FILENAME); }));
+	results.push_back(runBench("write", "ciso", image_size, 1,
+		[&]() { return gen->writeCiso(CISO_FILENAME); }));
+	results.push_back(runBench("write", "wbfs", image_size, 1,
+		[&]() { return gen->writeWbfs(WBFS_FILENAME); }));
+	results.push_back(runBench("write", "hdd", image_size * opts.banks, 1,
+		[&]() { return gen->writeHdd(HDD_FILENAME, opts.banks); }));
+
+	// Open the HDD image and load all bank entries.
+	results.push_back(runBench("open_list", "hdd", 0, opts.iterations, [&]() {
+		int err = 0;
+		RvtH rvth(HDD_FILENAME, &err);
+		if (!rvth.isOpen()) {
+			return (err != 0 ? err : -EIO);
+		}
+		rvth.prefetchBankEntries();
+		for (unsigned int bank = 0; bank < rvth.bankCount(); bank++) {
+			if (!rvth.bankEntry(bank, &err)) {
+				return (err != 0 ? err : -EIO);
+			}
+		}
+		return 0;
+	}));
+
+	// Reader::read() throughput.
+	static const struct {
+		const char *format;
+		const TCHAR *filename;
+	} read_formats[] = {
+		{"gcm", GCM_FILENAME},
+		{"ciso", CISO_FILENAME},
+		{"wbfs", WBFS_FILENAME},
+	};
+	for (const auto &fmt : read_formats) {
+		results.push_back(runBench("reader_read", fmt.format, image_size, opts.iterations,
+			[&]() { return readImage(fmt.filename, 0, 0); }));
+	}
+	results.push_back(runBench("reader_read", "hdd", image_size, opts.iterations, [&]() {
+		return readImage(HDD_FILENAME, NHCD_BANK_START_LBA(0, NHCD_BANK_COUNT),
+			BYTES_TO_LBA(image_size));
+	}));
+
+	// Verification.
+	static const struct {
+		const char *format;
+		const TCHAR *filename;
+	} verify_formats[] = {
+		{"gcm", GCM_FILENAME},
+		{"ciso", CISO_FILENAME},
+		{"wbfs", WBFS_FILENAME},
+		{"hdd", HDD_FILENAME},
+	};
+	for (const auto &fmt : verify_formats) {
+		results.push_back(runBench("verify", fmt.format, data_size, opts.iterations, [&]() {
+			int err = 0;
+			RvtH rvth(fmt.filename, &err);
+			if (!rvth.isOpen()) {
+				return (err != 0 ? err : -EIO);
+			}
+			return verifyBank(&rvth, 0, opts.threads);
+		}));
+	}
+	results.push_back(runBench("verify_all", "hdd", data_size * opts.banks, opts.iterations, [&]() {
+		int err = 0;
+		RvtH rvth(HDD_FILENAME, &err);
+		if (!rvth.isOpen()) {
+			return (err != 0 ? err : -EIO);
+		}
+		vector<RvtH::WiiErrorCount_t> errorCounts(rvth.bankCount());
+		vector<int> bankErrs(rvth.bankCount());
+		err = rvth.verifyAllWiiPartitions(errorCounts.data(), bankErrs.data(),
+			nullptr, nullptr, opts.threads);
+		if (err != 0) {
+			return err;
+		}
+		for (unsigned int bank = 0; bank < opts.banks; bank++) {
+			if (bankErrs[bank] != 0) {
+				return bankErrs[bank];
+			}
+			for (unsigned int errs : errorCounts[bank].errs) {
+				if (errs != 0) {
+					return -EBADMSG;
+				}
+			}
+		}
+		return 0;
+	}));
+
+	// Extraction: HDD bank to a plain image.
+	results.push_back(runBench("extract_plain", "hdd", image_size, opts.iterations, [&]() {
+		int err = 0;
+		RvtH rvth(HDD_FILENAME, &err);
+		if (!rvth.isOpen()) {
+			return (err != 0 ? err : -EIO);
+		}
+		err = rvth.extract(0, EXTRACT_FILENAME, -1, 0, nullptr, nullptr, opts.threads);
+		_tremove(EXTRACT_FILENAME);
+		return err;
+	}));
+
+	// Extraction with encryption: unencrypted image to a debug-encrypted image.
+	results.push_back(runBench("extract_encrypt", "unenc", data_size, opts.iterations, [&]() {
+		int err = 0;
+		RvtH rvth(UNENC_FILENAME, &err);
+		if (!rvth.isOpen()) {
+			return (err != 0 ? err : -EIO);
+		}
+		err = rvth.extract(0, EXTRACT_FILENAME, RVL_CryptoType_Debug, 0, nullptr, nullptr, opts.threads);
+		_tremove(EXTRACT_FILENAME);
+		return err;
+	}));
+
+	// Import requires a writable RVT-H Reader device.
+	if (opts.import_device) {
+		results.push_back(runBench("import", "gcm", image_size, opts.iterations, [&]() {
+			int err = 0;
+			RvtH rvth(opts.import_device, &err);
+			if (!rvth.isOpen()) {
+				return (err != 0 ? err : -EIO);
+			}
+			err = rvth.import(opts.import_bank, GCM_FILENAME);
+			if (err == 0) {
+				err = rvth.deleteBank(opts.import_bank);
+			}
+			return err;
+		}));
+	} else {
+		results.push_back(skipBench("import", "gcm", "requires --import-device"));
+	}
+
+	if (!opts.keep) {
+		_tremove(GCM_FILENAME);
+		_tremove(UNENC_FILENAME);
+		_tremove(CISO_FILENAME);
+		_tremove(WBFS_FILENAME);
+		_tremove(HDD_FILENAME);
+	}
+
+	// Write the report.
+	FILE *f = stdout;
+	if (opts.output) {
+		f = _tfopen(opts.output, _T("w"));
+		if (!f) {
+			fprintf(stderr, "*** ERROR: Unable to open the output file: %s\n", strerror(errno));
+			return EXIT_FAILURE;
+		}
+	}
+	writeReport(f, opts, *gen, results);
+	if (f != stdout) {
+		fclose(f);
+	}
+
+	for (const BenchResult &result : results) {
+		if (result.err != 0) {
+			return EXIT_FAILURE;
+		}
+	}
+	return EXIT_SUCCESS;
+}
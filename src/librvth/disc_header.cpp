@@ -2,7 +2,7 @@
  * RVT-H Tool (librvth)                                                    *
  * disc_header.cpp: Read a GCN/Wii disc header and determine its type.     *
  *                                                                         *
- * Copyright (c) 2018-2025 by David Korth.                                 *
+ * Copyright (c) 2018-2026 by David Korth.                                 *
  * SPDX-License-Identifier: GPL-2.0-or-later                               *
  ***************************************************************************/
 
@@ -185,13 +185,9 @@ int rvth_disc_header_get(RefFile *f_img, uint32_t lba_start,
 	memset(discHeader, 0, sizeof(*discHeader));
 
 	// Read the disc header.
-	ret = f_img->seeko(LBA_TO_BYTES(lba_start), SEEK_SET);
-	if (ret != 0) {
-		// Seek error.
-		goto end;
-	}
+	// NOTE: Using pread() so multiple banks can be read in parallel.
 	errno = 0;
-	size = f_img->read(sbuf.u8, 1, sizeof(sbuf.u8));
+	size = f_img->pread(sbuf.u8, sizeof(sbuf.u8), LBA_TO_BYTES(lba_start));
 	if (size != sizeof(sbuf.u8)) {
 		// Read error.
 		ret = -errno;
@@ -235,17 +231,9 @@ int rvth_disc_header_get(RefFile *f_img, uint32_t lba_start,
 	bankType = ret;
 
 	// Get the volume group table.
-	ret = f_img->seeko(LBA_TO_BYTES(lba_start) + RVL_VolumeGroupTable_ADDRESS, SEEK_SET);
-	if (ret != 0) {
-		// Seek error.
-		ret = -errno;
-		if (ret == 0) {
-			ret = -EIO;
-		}
-		goto end;
-	}
 	errno = 0;
-	size = f_img->read(sbuf.u8, 1, sizeof(sbuf.u8));
+	size = f_img->pread(sbuf.u8, sizeof(sbuf.u8),
+		LBA_TO_BYTES(lba_start) + RVL_VolumeGroupTable_ADDRESS);
 	if (size != sizeof(sbuf.u8)) {
 		// Read error.
 		ret = -errno;
@@ -275,17 +263,8 @@ int rvth_disc_header_get(RefFile *f_img, uint32_t lba_start,
 		}
 		goto end;
 	}
-	ret = f_img->seeko(LBA_TO_BYTES(lba_start + game_lba), SEEK_SET);
-	if (ret != 0) {
-		// Seek error.
-		ret = -errno;
-		if (ret == 0) {
-			ret = -EIO;
-		}
-		goto end;
-	}
 	errno = 0;
-	size = f_img->read(pthdr, 1, sizeof(*pthdr));
+	size = f_img->pread(pthdr, sizeof(*pthdr), LBA_TO_BYTES(lba_start + game_lba));
 	if (size != sizeof(*pthdr)) {
 		// Read error.
 		ret = -errno;
@@ -304,17 +283,9 @@ int rvth_disc_header_get(RefFile *f_img, uint32_t lba_start,
 	}
 
 	// Read the first LBA of the partition.
-	ret = f_img->seeko(LBA_TO_BYTES(lba_start + game_lba) + data_offset, SEEK_SET);
-	if (ret != 0) {
-		// Seek error.
-		ret = -errno;
-		if (ret == 0) {
-			ret = -EIO;
-		}
-		goto end;
-	}
+	data_offset += LBA_TO_BYTES(lba_start + game_lba);
 	errno = 0;
-	size = f_img->read(sbuf.u8, 1, sizeof(sbuf.u8));
+	size = f_img->pread(sbuf.u8, sizeof(sbuf.u8), data_offset);
 	if (size != sizeof(sbuf.u8)) {
 		// Read error.
 		ret = -errno;
@@ -396,8 +367,9 @@ int rvth_disc_header_get(RefFile *f_img, uint32_t lba_start,
 
 	// Read the next LBA. This contains encrypted hashes,
 	// including the IV for the user data.
+	data_offset += LBA_SIZE;
 	errno = 0;
-	size = f_img->read(sbuf.u8, 1, sizeof(sbuf.u8));
+	size = f_img->pread(sbuf.u8, sizeof(sbuf.u8), data_offset);
 	if (size != sizeof(sbuf.u8)) {
 		// Read error.
 		ret = -errno;
@@ -409,8 +381,9 @@ int rvth_disc_header_get(RefFile *f_img, uint32_t lba_start,
 	memcpy(iv, &sbuf.u8[0x3D0-0x200], sizeof(iv));
 
 	// Read the first LBA of user data.
+	data_offset += LBA_SIZE;
 	errno = 0;
-	size = f_img->read(sbuf.u8, 1, sizeof(sbuf.u8));
+	size = f_img->pread(sbuf.u8, sizeof(sbuf.u8), data_offset);
 	if (size != sizeof(sbuf.u8)) {
 		// Read error.
 		ret = -errno;
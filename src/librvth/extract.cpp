@@ -2,7 +2,7 @@
  * RVT-H Tool (librvth)                                                    *
  * extract.cpp: RVT-H extract and import functions.                        *
  *                                                                         *
- * Copyright (c) 2018-2025 by David Korth.                                 *
+ * Copyright (c) 2018-2026 by David Korth.                                 *
  * SPDX-License-Identifier: GPL-2.0-or-later                               *
  ***************************************************************************/
 
@@ -18,8 +18,15 @@
 // Disc image reader.
 #include "reader/Reader.hpp"
 
+// Read-ahead pipeline for bulk copies
+#include "ReadAhead.hpp"
+#include "DeltaCompare.hpp"
+#include "DiscHasher.hpp"
+#include "ImportVerifier.hpp"
+
 // libwiicrypto
 #include "libwiicrypto/sig_tools.h"
+#include "libwiicrypto/zero_scan.h"
 
 // C includes
 #include <stdlib.h>
@@ -45,10 +52,6 @@ using std::wstring;
 #  include <sys/statvfs.h>
 #endif /* _WIN32 */
 
-// Buffer size
-static constexpr unsigned int BUF_SIZE = 1U * 1024U * 1024U;
-static constexpr unsigned int LBA_COUNT_BUF = BYTES_TO_LBA(BUF_SIZE);
-
 /**
  * Get the free disk space on the volume containing `filename`.
  * @param filename Filename.
@@ -130,21 +133,226 @@ static int64_t getDiskFreeSpace_lba(const TCHAR *filename)
 	return freeSpace_lba;
 }
 
+/**
+ * Check if a bank can be copied by file extents.
+ *
+ * This is used for sparse image files. Holes in the source file can
+ * be skipped without reading them, and data extents can be copied
+ * within the kernel. Devices and fully-allocated image files use the
+ * regular path, which checks every 4 KB block for zeroes so the
+ * destination will still be sparse.
+ *
+ * @param src		[in] Source Reader
+ * @param dst		[in] Destination Reader
+ * @param lba_len	[in] Number of LBAs to copy
+ * @return True if the bank can be copied by extents; false if not.
+ */
+static bool canCopyExtents(const Reader *src, const Reader *dst, uint32_t lba_len)
+{
+	RefFile *const srcFile = src->file().get();
+	if (srcFile->isDevice() || dst->file()->isDevice()) {
+		// Devices don't have holes.
+		return false;
+	}
+
+	// Destination must be a plain image.
+	off64_t dstOffset;
+	if (dst->mapRun(0, lba_len, &dstOffset) != lba_len || dstOffset < 0) {
+		return false;
+	}
+
+	// Check if the source has any holes.
+	for (uint32_t lba = 0; lba < lba_len; ) {
+		off64_t physOffset;
+		const uint32_t run_len = src->mapRun(lba, lba_len - lba, &physOffset);
+		if (run_len == 0) {
+			// Source can't be mapped.
+			return false;
+		}
+		if (physOffset >= 0) {
+			const off64_t hole = srcFile->seekHole(physOffset);
+			if (hole < 0) {
+				// SEEK_HOLE isn't supported.
+				return false;
+			} else if (hole < physOffset + LBA_TO_BYTES(run_len)) {
+				// Found a hole.
+				return true;
+			}
+		}
+		lba += run_len;
+	}
+
+	// No holes.
+	return false;
+}
+
+/**
+ * Copy a bank by file extents.
+ * Holes in the source file are skipped, leaving holes in the destination.
+ * @param src		[in] Source Reader
+ * @param dst		[in] Destination Reader
+ * @param lba_len	[in] Number of LBAs to copy
+ * @param callback	[in,opt] Progress callback
+ * @param state		[in,out] Progress callback state
+ * @param userdata	[in,opt] User data for progress callback
+ * @param pLastByte	[out] End offset of the last data copied, relative to the bank
+ * @return 0 on success; negative POSIX error code on error.
+ */
+static int copyExtents(Reader *src, Reader *dst, uint32_t lba_len,
+	RvtH_Progress_Callback callback, RvtH_Progress_State *state, void *userdata,
+	off64_t *pLastByte)
+{
+	// Progress is reported at most once per COPY_CHUNK_SIZE.
+	static constexpr size_t COPY_CHUNK_SIZE = 4U * 1024U * 1024U;
+
+	RefFile *const srcFile = src->file().get();
+	RefFile *const dstFile = dst->file().get();
+	off64_t dstBase;
+	dst->mapRun(0, lba_len, &dstBase);
+
+	*pLastByte = 0;
+	off64_t nextReport = 0;
+	for (uint32_t lba = 0; lba < lba_len; ) {
+		off64_t physOffset;
+		const uint32_t run_len = src->mapRun(lba, lba_len - lba, &physOffset);
+		assert(run_len != 0);
+		if (physOffset < 0) {
+			// Empty run.
+			lba += run_len;
+			continue;
+		}
+
+		// Copy the data extents in this run.
+		const off64_t run_end = physOffset + LBA_TO_BYTES(run_len);
+		off64_t pos = physOffset;
+		while (pos < run_end) {
+			const off64_t data = srcFile->seekData(pos);
+			if (data < 0) {
+				if (errno == ENXIO) {
+					// No more data in the file.
+					break;
+				}
+				return -errno;
+			} else if (data >= run_end) {
+				// No more data in this run.
+				break;
+			}
+			off64_t hole = srcFile->seekHole(data);
+			if (hole < 0) {
+				return -errno;
+			} else if (hole > run_end) {
+				hole = run_end;
+			}
+
+			// Copy the extent.
+			const off64_t bankOffset = LBA_TO_BYTES(lba) + (data - physOffset);
+			for (off64_t done = 0; done < hole - data; ) {
+				if (callback && bankOffset + done >= nextReport) {
+					nextReport = bankOffset + done + COPY_CHUNK_SIZE;
+					state->lba_processed = BYTES_TO_LBA(bankOffset + done);
+					if (!callback(state, userdata)) {
+						// Stop processing.
+						return -ECANCELED;
+					}
+				}
+
+				const size_t size = ((hole - data - done) < (off64_t)COPY_CHUNK_SIZE)
+					? static_cast<size_t>(hole - data - done) : COPY_CHUNK_SIZE;
+				errno = 0;
+				const size_t copied = dstFile->copyRangeFrom(srcFile,
+					data + done, dstBase + bankOffset + done, size);
+				if (copied != size) {
+					// Read or write error.
+					return (errno != 0 ? -errno : -EIO);
+				}
+				done += size;
+			}
+
+			*pLastByte = bankOffset + (hole - data);
+			pos = hole;
+		}
+
+		lba += run_len;
+	}
+
+	return 0;
+}
+
+/**
+ * Read back a disc image and hash it.
+ * This is used if the image was modified after it was copied.
+ * @param reader	[in] Reader
+ * @param buf_size	[in] Read-ahead buffer size, in bytes (0 for default)
+ * @param depth		[in] Read-ahead depth (0 for default)
+ * @param callback	[in,opt] Progress callback
+ * @param state		[in,out] Progress callback state
+ * @param userdata	[in,opt] User data for progress callback
+ * @param pDigests	[out] Digests
+ * @return 0 on success; negative POSIX error code on error.
+ */
+static int hashImage(Reader *reader, unsigned int buf_size, unsigned int depth,
+	RvtH_Progress_Callback callback, RvtH_Progress_State *state, void *userdata,
+	RvtH_Digests *pDigests)
+{
+	const uint32_t lba_len = reader->lba_len();
+	state->type = RVTH_PROGRESS_HASH;
+	state->lba_processed = 0;
+	state->lba_total = lba_len;
+
+	DiscHasher hasher;
+	ReadAhead readAhead(reader, 0, lba_len, buf_size, depth);
+	ReadAhead::Chunk chunk;
+	while (readAhead.next(chunk)) {
+		if (callback) {
+			state->lba_processed = chunk.lba_start;
+			if (!callback(state, userdata)) {
+				// Stop processing.
+				return -ECANCELED;
+			}
+		}
+		if (chunk.err != 0) {
+			// Read error.
+			return -chunk.err;
+		}
+
+		hasher.update(chunk.buf, LBA_TO_BYTES(chunk.lba_len));
+		readAhead.release(chunk);
+	}
+
+	if (callback) {
+		state->lba_processed = lba_len;
+		if (!callback(state, userdata)) {
+			// Stop processing.
+			return -ECANCELED;
+		}
+	}
+
+	hasher.finish(pDigests);
+	return 0;
+}
+
 /**
  * Copy a bank from this RVT-H HDD or standalone disc image to a writable standalone disc image.
+ *
+ * If pDigests is specified, the digests of the data written to the
+ * destination are computed on separate threads while copying.
+ *
  * @param rvth_dest	[out] Destination RvtH object.
  * @param bank_src	[in] Source bank number. (0-7)
  * @param callback	[in,opt] Progress callback.
  * @param userdata	[in,opt] User data for progress callback.
+ * @param pDigests	[out,opt] Digests of the destination image.
  * @return Error code. (If negative, POSIX error; otherwise, see RvtH_Errors.)
  */
-int RvtH::copyToGcm(RvtH *rvth_dest, unsigned int bank_src, RvtH_Progress_Callback callback, void *userdata)
+int RvtH::copyToGcm(RvtH *rvth_dest, unsigned int bank_src, RvtH_Progress_Callback callback, void *userdata,
+	RvtH_Digests *pDigests)
 {
 	uint32_t lba_copy_len;	// Total number of LBAs to copy. (entry_src->lba_len)
-	uint32_t lba_count;
-	uint32_t lba_buf_max;	// Highest LBA that can be written using the buffer.
 	uint32_t lba_nonsparse;	// Last LBA written that wasn't sparse.
 
+	// Digests of the destination image.
+	unique_ptr<DiscHasher> hasher;
+
 	// Callback state.
 	RvtH_Progress_State state;
 
@@ -168,7 +376,7 @@ int RvtH::copyToGcm(RvtH *rvth_dest, unsigned int bank_src, RvtH_Progress_Callba
 	}
 
 	// Check if the source bank can be extracted.
-	const RvtH_BankEntry *const entry_src = &d_ptr->entries[bank_src];
+	const RvtH_BankEntry *const entry_src = d_ptr->bankEntry(bank_src);
 	switch (entry_src->type) {
 		case RVTH_BankType_GCN:
 		case RVTH_BankType_Wii_SL:
@@ -194,24 +402,16 @@ int RvtH::copyToGcm(RvtH *rvth_dest, unsigned int bank_src, RvtH_Progress_Callba
 			return RVTH_ERROR_BANK_DL_2;
 	}
 
-	// Allocate the memory buffer.
-	uint8_t *const buf = (uint8_t*)malloc(BUF_SIZE);
-	if (!buf) {
-		// Error allocating memory.
-		err = errno;
-		if (err == 0) {
-			err = ENOMEM;
-		}
-		ret = -err;
-		goto end;
-	}
-
 	// FIXME: If the file existed and wasn't 0 bytes,
 	// either truncate it or don't do sparse writes.
 
 	// Make this a sparse file.
-	entry_dest = &rvth_dest->d_ptr->entries[0];
-	ret = rvth_dest->d_ptr->file->makeSparse(LBA_TO_BYTES(entry_dest->lba_len));
+	// NOTE: Compact formats allocate blocks as they're written.
+	entry_dest = rvth_dest->d_ptr->bankEntry(0);
+	ret = 0;
+	if (!entry_dest->reader->isCompact()) {
+		ret = rvth_dest->d_ptr->file->makeSparse(LBA_TO_BYTES(entry_dest->lba_len));
+	}
 	if (ret != 0) {
 		// Error managing the sparse file.
 		// TODO: Delete the file?
@@ -256,77 +456,136 @@ int RvtH::copyToGcm(RvtH *rvth_dest, unsigned int bank_src, RvtH_Progress_Callba
 		state.lba_total = lba_copy_len;
 	}
 
-	// TODO: Optimize seeking? (Reader::write() seeks every time.)
-	lba_buf_max = entry_dest->lba_len & ~(LBA_COUNT_BUF-1);
 	lba_nonsparse = 0;
-	for (lba_count = 0; lba_count < lba_buf_max; lba_count += LBA_COUNT_BUF) {
-		if (callback) {
-			bool bRet;
-			state.lba_processed = lba_count;
-			bRet = callback(&state, userdata);
-			if (!bRet) {
-				// Stop processing.
-				err = ECANCELED;
-				ret = -ECANCELED;
-				goto end;
-			}
+	if (pDigests) {
+		hasher.reset(new DiscHasher);
+	}
+	if (!hasher && canCopyExtents(entry_src->reader, entry_dest->reader, lba_copy_len)) {
+		// NOTE: Extents are copied without reading the data,
+		// so this can't be used if the image is being hashed.
+		// Sparse image file. Copy the data extents directly.
+		// Save the first LBA in case the disc header needs to be restored.
+		uint8_t lba0[LBA_SIZE];
+		errno = 0;
+		if (entry_src->reader->read(lba0, 0, 1) != 1 && errno != 0) {
+			err = errno;
+			ret = -err;
+			goto end;
 		}
 
-		// TODO: Error handling.
-		entry_src->reader->read(buf, lba_count, LBA_COUNT_BUF);
-
-		if (lba_count == 0) {
-			// Make sure we copy the disc header in if the
-			// header was zeroed by the RVT-H's "Flush" function.
-			// TODO: Move this outside of the `for` loop.
-			// TODO: Also check for NDDEMO?
-			const GCN_DiscHeader *const origHdr = (const GCN_DiscHeader*)buf;
-			if (origHdr->magic_wii != be32_to_cpu(WII_MAGIC) &&
-			    origHdr->magic_gcn != be32_to_cpu(GCN_MAGIC))
-			{
-				// Missing magic number. Need to restore the disc header.
-				memcpy(buf, &entry_src->discHeader, sizeof(entry_src->discHeader));
-			}
+		off64_t lastByte;
+		ret = copyExtents(entry_src->reader, entry_dest->reader, lba_copy_len,
+			callback, &state, userdata, &lastByte);
+		if (ret != 0) {
+			err = -ret;
+			goto end;
 		}
-
-		// Check for empty 4 KB blocks.
-		for (unsigned int sprs = 0; sprs < BUF_SIZE; sprs += 4096) {
-			if (!d_ptr->isBlockEmpty(&buf[sprs], 4096)) {
-				// 4 KB block is not empty.
-				lba_nonsparse = lba_count + (sprs / 512);
-				entry_dest->reader->write(&buf[sprs], lba_nonsparse, 8);
-				//entry_dest->reader->flush();
-				lba_nonsparse += 7;
-			}
+		if (lastByte > 0) {
+			lba_nonsparse = BYTES_TO_LBA(lastByte - 1);
 		}
-	}
 
-	// Process any remaining LBAs.
-	if (lba_count < lba_copy_len) {
-		const unsigned int lba_left = lba_copy_len - lba_count;
-		const unsigned int sz_left = static_cast<unsigned int>(LBA_TO_BYTES(lba_left));
+		// Make sure we copy the disc header in if the
+		// header was zeroed by the RVT-H's "Flush" function.
+		const GCN_DiscHeader *const origHdr = (const GCN_DiscHeader*)lba0;
+		if (origHdr->magic_wii != be32_to_cpu(WII_MAGIC) &&
+		    origHdr->magic_gcn != be32_to_cpu(GCN_MAGIC))
+		{
+			// Missing magic number. Need to restore the disc header.
+			memcpy(lba0, &entry_src->discHeader, sizeof(entry_src->discHeader));
+			entry_dest->reader->write(lba0, 0, 1);
+		}
+	} else {
+		// Read the source bank on a separate thread while
+		// the previous buffer is being written.
+		ReadAhead readAhead(entry_src->reader, 0, lba_copy_len,
+			d_ptr->readAheadBufSize, d_ptr->readAheadDepth);
+		ReadAhead::Chunk chunk;
+		while (readAhead.next(chunk)) {
+			if (callback) {
+				bool bRet;
+				state.lba_processed = chunk.lba_start;
+				bRet = callback(&state, userdata);
+				if (!bRet) {
+					// Stop processing.
+					err = ECANCELED;
+					ret = -ECANCELED;
+					goto end;
+				}
+			}
 
-		if (callback) {
-			bool bRet;
-			state.lba_processed = lba_count;
-			bRet = callback(&state, userdata);
-			if (!bRet) {
-				// Stop processing.
-				err = ECANCELED;
-				ret = -ECANCELED;
+			if (chunk.err != 0) {
+				// Read error.
+				err = chunk.err;
+				ret = -chunk.err;
 				goto end;
 			}
-		}
-		entry_src->reader->read(buf, lba_count, lba_left);
 
-		// Check for empty 512-byte blocks.
-		for (unsigned int sprs = 0; sprs < sz_left; sprs += 512) {
-			if (!d_ptr->isBlockEmpty(&buf[sprs], 512)) {
-				// 512-byte block is not empty.
-				lba_nonsparse = lba_count + (sprs / 512);
-				entry_dest->reader->write(&buf[sprs], lba_nonsparse, 1);
-				//entry_dest->reader->flush();
+			uint8_t *const buf = chunk.buf;
+			if (chunk.lba_start == 0) {
+				// Make sure we copy the disc header in if the
+				// header was zeroed by the RVT-H's "Flush" function.
+				// TODO: Also check for NDDEMO?
+				const GCN_DiscHeader *const origHdr = (const GCN_DiscHeader*)buf;
+				if (origHdr->magic_wii != be32_to_cpu(WII_MAGIC) &&
+				    origHdr->magic_gcn != be32_to_cpu(GCN_MAGIC))
+				{
+					// Missing magic number. Need to restore the disc header.
+					memcpy(buf, &entry_src->discHeader, sizeof(entry_src->discHeader));
+				}
+			}
+
+			if (hasher) {
+				// Empty blocks are hashed too, since they're
+				// part of the destination image.
+				hasher->update(buf, LBA_TO_BYTES(chunk.lba_len));
+			}
+
+			// Check for empty 4 KB blocks.
+			// Runs of empty blocks are skipped with a single zero scan,
+			// and runs of non-empty blocks are written at once.
+			const unsigned int sz_chunk = static_cast<unsigned int>(LBA_TO_BYTES(chunk.lba_len));
+			const unsigned int sz_chunk_4k = sz_chunk & ~4095U;
+			unsigned int sprs = 0;
+			while (sprs < sz_chunk_4k) {
+				// Skip the empty 4 KB blocks.
+				sprs += static_cast<unsigned int>(zero_scan(&buf[sprs], sz_chunk_4k - sprs)) & ~4095U;
+				if (sprs >= sz_chunk_4k)
+					break;
+
+				// Find the end of the non-empty 4 KB blocks.
+				const unsigned int sprs_start = sprs;
+				do {
+					sprs += 4096;
+				} while (sprs < sz_chunk_4k && !d_ptr->isBlockEmpty(&buf[sprs], 4096));
+
+				const uint32_t lba_count = (sprs - sprs_start) / 512;
+				lba_nonsparse = chunk.lba_start + (sprs_start / 512);
+				errno = 0;
+				if (entry_dest->reader->write(&buf[sprs_start], lba_nonsparse, lba_count) != lba_count) {
+					// Write error.
+					err = (errno != 0 ? errno : EIO);
+					ret = -err;
+					goto end;
+				}
+				lba_nonsparse += lba_count - 1;
+			}
+
+			// Check for empty 512-byte blocks at the end of the bank.
+			for (; sprs < sz_chunk; sprs += 512) {
+				if (!d_ptr->isBlockEmpty(&buf[sprs], 512)) {
+					// 512-byte block is not empty.
+					lba_nonsparse = chunk.lba_start + (sprs / 512);
+					errno = 0;
+					if (entry_dest->reader->write(&buf[sprs], lba_nonsparse, 1) != 1) {
+						// Write error.
+						err = (errno != 0 ? errno : EIO);
+						ret = -err;
+						goto end;
+					}
+				}
 			}
+
+			readAhead.release(chunk);
 		}
 	}
 
@@ -343,21 +602,26 @@ int RvtH::copyToGcm(RvtH *rvth_dest, unsigned int bank_src, RvtH_Progress_Callba
 	}
 
 	// lba_nonsparse should be equal to lba_copy_len-1.
-	if (lba_nonsparse != lba_copy_len-1) {
+	// NOTE: Not needed for compact formats, since their
+	// image size doesn't depend on the file size.
+	if (lba_nonsparse != lba_copy_len-1 && !entry_dest->reader->isCompact()) {
 		// Last LBA was sparse.
 		// We'll need to write an actual zero block.
 		// TODO: Maybe not needed if ftruncate() succeeded?
 		// TODO: Check for errors.
-		memset(buf, 0, 512);
-		entry_dest->reader->write(buf, lba_copy_len-1, 1);
+		static const uint8_t zero_lba[LBA_SIZE] = {0};
+		entry_dest->reader->write(zero_lba, lba_copy_len-1, 1);
 		//entry_dest->reader->flush();
 	}
 
 	// Flush the destination device.
 	entry_dest->reader->flush();
 
+	if (hasher) {
+		hasher->finish(pDigests);
+	}
+
 end:
-	free(buf);
 	if (err != 0) {
 		errno = err;
 	}
@@ -374,10 +638,13 @@ end:
  * @param flags		[in] Flags. (See RvtH_Extract_Flags.)
  * @param callback	[in,opt] Progress callback.
  * @param userdata	[in,opt] User data for progress callback.
+ * @param threads	[in,opt] Number of worker threads for encryption (0 for auto; 1 to disable threading)
+ * @param pDigests	[out,opt] Digests of the extracted disc image.
  * @return Error code. (If negative, POSIX error; otherwise, see RvtH_Errors.)
  */
 int RvtH::extract(unsigned int bank, const TCHAR *filename,
-	int recrypt_key, unsigned int flags, RvtH_Progress_Callback callback, void *userdata)
+	int recrypt_key, unsigned int flags, RvtH_Progress_Callback callback, void *userdata,
+	unsigned int threads, RvtH_Digests *pDigests)
 {
 	if (!filename || filename[0] == 0) {
 		errno = EINVAL;
@@ -395,7 +662,7 @@ int RvtH::extract(unsigned int bank, const TCHAR *filename,
 	// handle it as -1.
 
 	// Create a standalone disc image.
-	RvtH_BankEntry *const entry = &d_ptr->entries[bank];
+	RvtH_BankEntry *const entry = d_ptr->bankEntry(bank);
 	const bool unenc_to_enc = (entry->type >= RVTH_BankType_Wii_SL &&
 				   entry->crypto_type == RVL_CryptoType_None &&
 				   recrypt_key > RVL_CryptoType_Unknown);
@@ -425,6 +692,29 @@ int RvtH::extract(unsigned int bank, const TCHAR *filename,
 		gcm_lba_len = entry->lba_len;
 	}
 
+	// Output format.
+	// NOTE: SDK headers can't be used with compact formats.
+	RvtH_ImageFormat_e format;
+	switch (flags & (RVTH_EXTRACT_FORMAT_CISO | RVTH_EXTRACT_FORMAT_WBFS)) {
+		case 0:
+			format = RVTH_ImageFormat_GCM;
+			break;
+		case RVTH_EXTRACT_FORMAT_CISO:
+			format = RVTH_ImageFormat_CISO;
+			break;
+		case RVTH_EXTRACT_FORMAT_WBFS:
+			format = RVTH_ImageFormat_WBFS;
+			break;
+		default:
+			// Multiple formats specified.
+			errno = EINVAL;
+			return -EINVAL;
+	}
+	if (format != RVTH_ImageFormat_GCM && (flags & RVTH_EXTRACT_PREPEND_SDK_HEADER)) {
+		errno = EINVAL;
+		return -EINVAL;
+	}
+
 	if (flags & RVTH_EXTRACT_PREPEND_SDK_HEADER) {
 		if (entry->type == RVTH_BankType_GCN) {
 			// FIXME: Not supported.
@@ -450,7 +740,7 @@ int RvtH::extract(unsigned int bank, const TCHAR *filename,
 	}
 
 	int ret = 0;
-	unique_ptr<RvtH> rvth_dest(new RvtH(filename, gcm_lba_len, &ret));
+	unique_ptr<RvtH> rvth_dest(new RvtH(filename, gcm_lba_len, format, &ret));
 	if (!rvth_dest->isOpen()) {
 		// Error creating the standalone disc image.
 		errno = EIO;
@@ -463,7 +753,7 @@ int RvtH::extract(unsigned int bank, const TCHAR *filename,
 	if (flags & RVTH_EXTRACT_PREPEND_SDK_HEADER) {
 		// Prepend 32k to the GCM.
 		size_t size;
-		Reader *const reader = rvth_dest->d_ptr->entries[0].reader;
+		Reader *const reader = rvth_dest->d_ptr->bankEntry(0)->reader;
 		uint8_t *const sdk_header = static_cast<uint8_t*>(calloc(1, SDK_HEADER_SIZE_BYTES));
 		if (!sdk_header) {
 			int ret = -errno;
@@ -518,18 +808,35 @@ int RvtH::extract(unsigned int bank, const TCHAR *filename,
 		reader->lba_adjust(SDK_HEADER_SIZE_LBA);
 	}
 
+	// If the image is encrypted or recrypted, the partition headers
+	// are written after the rest of the image, so it can't be hashed
+	// while copying. It will be read back and hashed afterwards.
+	const bool recrypt = (recrypt_key > RVL_CryptoType_Unknown &&
+			      entry->crypto_type != recrypt_key);
+	const bool hash_after = (pDigests && (unenc_to_enc || recrypt));
+
 	// Copy the bank from the source image to the destination GCM.
 	if (unenc_to_enc) {
-		ret = copyToGcm_doCrypt(rvth_dest.get(), bank, callback, userdata);
+		ret = copyToGcm_doCrypt(rvth_dest.get(), bank, callback, userdata, threads);
 	} else {
-		ret = copyToGcm(rvth_dest.get(), bank, callback, userdata);
+		ret = copyToGcm(rvth_dest.get(), bank, callback, userdata,
+			(hash_after ? nullptr : pDigests));
 	}
-	if (ret == 0 && recrypt_key > RVL_CryptoType_Unknown) {
+	if (ret == 0 && recrypt) {
 		// Recrypt the disc image.
-		if (entry->crypto_type != recrypt_key) {
-			ret = rvth_dest->recryptWiiPartitions(0,
-				static_cast<RVL_CryptoType_e>(recrypt_key), callback, userdata);
-		}
+		ret = rvth_dest->recryptWiiPartitions(0,
+			static_cast<RVL_CryptoType_e>(recrypt_key), callback, userdata);
+	}
+	if (ret == 0 && hash_after) {
+		// Hash the finished disc image.
+		RvtH_Progress_State state;
+		state.rvth = this;
+		state.rvth_gcm = rvth_dest.get();
+		state.bank_rvth = bank;
+		state.bank_gcm = 0;
+		ret = hashImage(rvth_dest->d_ptr->bankEntry(0)->reader,
+			d_ptr->readAheadBufSize, d_ptr->readAheadDepth,
+			callback, &state, userdata, pDigests);
 	}
 
 	return ret;
@@ -542,14 +849,17 @@ int RvtH::extract(unsigned int bank, const TCHAR *filename,
  * @param bank_src	[in] Source bank number. (0-7)
  * @param callback	[in,opt] Progress callback.
  * @param userdata	[in,opt] User data for progress callback.
+ * @param flags		[in,opt] Flags. (See RvtH_Import_Flags.)
+ * @param pStats	[out,opt] Import statistics.
+ * @param pDigests	[out,opt] Digests of the copied disc image.
  * @return Error code. (If negative, POSIX error; otherwise, see RvtH_Errors.)
  */
 int RvtH::copyToHDD(RvtH *rvth_dest, unsigned int bank_dest,
-	unsigned int bank_src, RvtH_Progress_Callback callback, void *userdata)
+	unsigned int bank_src, RvtH_Progress_Callback callback, void *userdata,
+	unsigned int flags, RvtH_Import_Stats *pStats, RvtH_Digests *pDigests)
 {
 	uint32_t lba_copy_len;	// Total number of LBAs to copy. (entry_src->lba_len)
-	uint32_t lba_count;
-	uint32_t lba_buf_max;	// Highest LBA that can be written using the buffer.
+	uint32_t lba_written = 0;	// Number of LBAs written.
 
 	// Callback state
 	RvtH_Progress_State state;
@@ -571,7 +881,7 @@ int RvtH::copyToHDD(RvtH *rvth_dest, unsigned int bank_dest,
 	}
 
 	// Check if the source bank can be imported.
-	const RvtH_BankEntry *const entry_src = &d_ptr->entries[bank_src];
+	RvtH_BankEntry *const entry_src = d_ptr->bankEntry(bank_src);
 	switch (entry_src->type) {
 		case RVTH_BankType_GCN:
 		case RVTH_BankType_Wii_SL:
@@ -597,10 +907,54 @@ int RvtH::copyToHDD(RvtH *rvth_dest, unsigned int bank_dest,
 			return RVTH_ERROR_BANK_DL_2;
 	}
 
+	// Hash verification requires encrypted Wii partitions.
+	// The partitions are loaded before anything is written,
+	// so a bad partition header doesn't leave a partial import.
+	unique_ptr<ImportVerifier> verifier;
+	if (flags & RVTH_IMPORT_VERIFY) {
+		if (entry_src->type != RVTH_BankType_Wii_SL &&
+		    entry_src->type != RVTH_BankType_Wii_DL)
+		{
+			errno = EINVAL;
+			return RVTH_ERROR_NOT_WII_IMAGE;
+		} else if (entry_src->crypto_type == RVL_CryptoType_None) {
+			errno = EINVAL;
+			return RVTH_ERROR_IS_UNENCRYPTED;
+		}
+
+		ret = rvth_ptbl_load(entry_src);
+		if (ret != 0 || entry_src->pt_count == 0 || !entry_src->ptbl) {
+			// Unable to load the partition table.
+			if (ret == 0) {
+				ret = RVTH_ERROR_PARTITION_TABLE_CORRUPTED;
+			}
+			errno = EIO;
+			return ret;
+		}
+
+		verifier.reset(new ImportVerifier);
+		const pt_entry_t *pte = entry_src->ptbl;
+		for (unsigned int i = 0; i < entry_src->pt_count; i++, pte++) {
+			ret = verifier->addPartition(entry_src->reader, pte);
+			if (ret != 0) {
+				errno = (ret < 0 ? -ret : EIO);
+				return ret;
+			}
+		}
+	}
+
 	// Get the bank count of the destination RVT-H device.
 	const unsigned int bank_count_dest = rvth_dest->bankCount();
 	// Destination bank entry.
-	RvtH_BankEntry *const entry_dest = &rvth_dest->d_ptr->entries[bank_dest];
+	RvtH_BankEntry *const entry_dest = rvth_dest->d_ptr->bankEntry(bank_dest);
+
+	// For incremental imports, the destination bank must already
+	// have the same title, even if it's deleted. Otherwise, the
+	// usual checks apply.
+	const bool incremental = (flags & RVTH_IMPORT_INCREMENTAL) &&
+		entry_dest->type == entry_src->type &&
+		!memcmp(entry_dest->discHeader.id6, entry_src->discHeader.id6, sizeof(entry_src->discHeader.id6)) &&
+		entry_dest->discHeader.disc_number == entry_src->discHeader.disc_number;
 
 	// Source image length cannot be larger than a single bank.
 	RvtH_BankEntry *entry_dest2 = nullptr;
@@ -627,7 +981,8 @@ int RvtH::copyToHDD(RvtH *rvth_dest, unsigned int bank_dest,
 		// Check that the first bank is empty or deleted.
 		// NOTE: Checked below, but we should check this before
 		// checking the second bank.
-		if (entry_dest->type != RVTH_BankType_Empty &&
+		if (!incremental &&
+		    entry_dest->type != RVTH_BankType_Empty &&
 		    !entry_dest->is_deleted)
 		{
 			errno = EEXIST;
@@ -635,9 +990,10 @@ int RvtH::copyToHDD(RvtH *rvth_dest, unsigned int bank_dest,
 		}
 
 		// Check that the second bank is empty or deleted.
-		entry_dest2 = &rvth_dest->d_ptr->entries[bank_dest+1];
+		entry_dest2 = rvth_dest->d_ptr->bankEntry(bank_dest+1);
 		if (entry_dest2->type != RVTH_BankType_Empty &&
-		    !entry_dest2->is_deleted)
+		    !entry_dest2->is_deleted &&
+		    !(incremental && entry_dest2->type == RVTH_BankType_Wii_DL_Bank2))
 		{
 			errno = EEXIST;
 			return RVTH_ERROR_BANK2DL_NOT_EMPTY_OR_DELETED;
@@ -679,7 +1035,8 @@ int RvtH::copyToHDD(RvtH *rvth_dest, unsigned int bank_dest,
 	}
 
 	// Destination bank must be either empty or deleted.
-	if (entry_dest->type != RVTH_BankType_Empty &&
+	if (!incremental &&
+	    entry_dest->type != RVTH_BankType_Empty &&
 	    !entry_dest->is_deleted)
 	{
 		errno = EEXIST;
@@ -737,8 +1094,32 @@ int RvtH::copyToHDD(RvtH *rvth_dest, unsigned int bank_dest,
 		// It has to be updated in memory for qrvthtool, though.
 	}
 
-	// Allocate the memory buffer.
-	unique_ptr<uint8_t[]> buf(new uint8_t[BUF_SIZE]);
+	// For incremental imports, load the H3 tables of the encrypted
+	// Wii partitions so changed groups can be found without reading
+	// them from the destination.
+	unique_ptr<DeltaCompare> delta;
+	if (incremental) {
+		delta.reset(new DeltaCompare(entry_dest->reader));
+		if ((entry_src->type == RVTH_BankType_Wii_SL ||
+		     entry_src->type == RVTH_BankType_Wii_DL) &&
+		    entry_src->crypto_type != RVL_CryptoType_None &&
+		    rvth_ptbl_load(entry_src) == 0)
+		{
+			const pt_entry_t *pte = entry_src->ptbl;
+			for (unsigned int i = 0; i < entry_src->pt_count; i++, pte++) {
+				ret = delta->addPartition(entry_src->reader, pte->lba_start, pte->lba_len);
+				if (ret != 0) {
+					errno = -ret;
+					return ret;
+				}
+			}
+		}
+	}
+
+	// The destination's partition table will be reloaded if needed.
+	free(entry_dest->ptbl);
+	entry_dest->ptbl = nullptr;
+	entry_dest->pt_count = 0;
 
 	// Copy the bank table information.
 	entry_dest->lba_len	= entry_src->lba_len;
@@ -775,36 +1156,109 @@ int RvtH::copyToHDD(RvtH *rvth_dest, unsigned int bank_dest,
 		state.lba_total = lba_copy_len;
 	}
 
-	// TODO: Optimize seeking? (Reader::write() seeks every time.)
-	lba_buf_max = entry_dest->lba_len & ~(LBA_COUNT_BUF-1);
-	for (lba_count = 0; lba_count < lba_buf_max; lba_count += LBA_COUNT_BUF) {
-		if (callback) {
-			bool bRet;
-			state.lba_processed = lba_count;
-			bRet = callback(&state, userdata);
-			if (!bRet) {
-				// Stop processing.
-				errno = ECANCELED;
-				return -ECANCELED;
+	// Digests of the copied image.
+	unique_ptr<DiscHasher> hasher;
+	if (pDigests) {
+		hasher.reset(new DiscHasher);
+	}
+
+	// Start verifying the hashes.
+	if (verifier) {
+		verifier->start((flags & RVTH_IMPORT_VERIFY_REREAD) ? entry_dest->reader : nullptr);
+	}
+
+	// Read the source image on a separate thread while
+	// the previous buffer is being written.
+	// NOTE: Using the destination HDD's read-ahead settings.
+	{
+		ReadAhead readAhead(entry_src->reader, 0, lba_copy_len,
+			rvth_dest->d_ptr->readAheadBufSize, rvth_dest->d_ptr->readAheadDepth);
+		ReadAhead::Chunk chunk;
+		while (readAhead.next(chunk)) {
+			if (callback) {
+				bool bRet;
+				state.lba_processed = chunk.lba_start;
+				bRet = callback(&state, userdata);
+				if (!bRet) {
+					// Stop processing.
+					errno = ECANCELED;
+					return -ECANCELED;
+				}
 			}
-		}
 
-		// TODO: Restore the disc header here if necessary?
-		// GCMs being imported generally won't have the first
-		// 16 KB zeroed out...
+			// TODO: Restore the disc header here if necessary?
+			// GCMs being imported generally won't have the first
+			// 16 KB zeroed out...
 
-		// TODO: Error handling.
-		entry_src->reader->read(buf.get(), lba_count, LBA_COUNT_BUF);
-		entry_dest->reader->write(buf.get(), lba_count, LBA_COUNT_BUF);
-		entry_dest->reader->flush();
-	}
+			if (chunk.err != 0) {
+				// Read error.
+				errno = chunk.err;
+				return -chunk.err;
+			}
 
-	// Process any remaining LBAs.
-	if (lba_count < lba_copy_len) {
-		const unsigned int lba_left = lba_copy_len - lba_count;
-		entry_src->reader->read(buf.get(), lba_count, lba_left);
-		entry_dest->reader->write(buf.get(), lba_count, lba_left);
-		entry_dest->reader->flush();
+			if (hasher) {
+				hasher->update(chunk.buf, LBA_TO_BYTES(chunk.lba_len));
+			}
+			if (!delta) {
+				errno = 0;
+				if (entry_dest->reader->write(chunk.buf, chunk.lba_start, chunk.lba_len) != chunk.lba_len) {
+					// Write error.
+					ret = (errno != 0 ? -errno : -EIO);
+					errno = -ret;
+					return ret;
+				}
+				lba_written += chunk.lba_len;
+			} else {
+				// Only write the units that changed.
+				// Runs of changed units are written at once.
+				const uint32_t chunk_end = chunk.lba_start + chunk.lba_len;
+				uint32_t lba = chunk.lba_start;
+				uint32_t run_start = lba;
+				while (lba < chunk_end) {
+					uint32_t unit_end = delta->unitEnd(lba);
+					if (unit_end > chunk_end) {
+						unit_end = chunk_end;
+					}
+					const bool changed = delta->isChanged(
+						&chunk.buf[LBA_TO_BYTES(lba - chunk.lba_start)], lba, unit_end - lba);
+					if (!changed) {
+						// Write the pending run of changed units.
+						if (run_start < lba) {
+							errno = 0;
+							if (entry_dest->reader->write(&chunk.buf[LBA_TO_BYTES(run_start - chunk.lba_start)],
+								run_start, lba - run_start) != lba - run_start)
+							{
+								// Write error.
+								ret = (errno != 0 ? -errno : -EIO);
+								errno = -ret;
+								return ret;
+							}
+							lba_written += lba - run_start;
+						}
+						run_start = unit_end;
+					}
+					lba = unit_end;
+				}
+				if (run_start < chunk_end) {
+					errno = 0;
+					if (entry_dest->reader->write(&chunk.buf[LBA_TO_BYTES(run_start - chunk.lba_start)],
+						run_start, chunk_end - run_start) != chunk_end - run_start)
+					{
+						// Write error.
+						ret = (errno != 0 ? -errno : -EIO);
+						errno = -ret;
+						return ret;
+					}
+					lba_written += chunk_end - run_start;
+				}
+			}
+			entry_dest->reader->flush();
+			if (verifier) {
+				// NOTE: Called after writing so the group can be re-read.
+				verifier->update(chunk.buf, chunk.lba_start, chunk.lba_len);
+			}
+			readAhead.release(chunk);
+		}
 	}
 
 	if (callback) {
@@ -825,10 +1279,53 @@ int RvtH::copyToHDD(RvtH *rvth_dest, unsigned int bank_dest,
 	// TODO: Check for errors.
 	rvth_dest->d_ptr->writeBankEntry(bank_dest);
 
+	if (pStats) {
+		pStats->incremental = incremental;
+		pStats->bytes_written = LBA_TO_BYTES(static_cast<uint64_t>(lba_written));
+		pStats->bytes_skipped = LBA_TO_BYTES(static_cast<uint64_t>(lba_copy_len - lba_written));
+		pStats->bytes_read = (delta ? delta->bytesRead() : 0);
+		pStats->verified = false;
+		pStats->reread = false;
+		memset(pStats->verify_errs, 0, sizeof(pStats->verify_errs));
+		pStats->reread_errs = 0;
+	}
+	if (hasher) {
+		hasher->finish(pDigests);
+	}
+	if (verifier) {
+		ret = verifier->finish(pStats);
+		if (ret != 0) {
+			errno = -ret;
+			return ret;
+		}
+	}
+
 	// Finished importing the disc image.
 	return 0;
 }
 
+/**
+ * Will import() need to convert a bank to debug realsigned?
+ * @param entry		[in] Bank entry.
+ * @param ios_force	[in] IOS version to force. (-1 to use the existing IOS)
+ * @return True if the bank's Wii partitions will be recrypted.
+ */
+static bool importNeedsRecrypt(const RvtH_BankEntry *entry, int ios_force)
+{
+	// One of the following conditions:
+	// - Encryption: Retail, Korean, or vWii
+	// - Signature: Invalid
+	// - IOS requested does not match the TMD IOS
+	return (entry->type == RVTH_BankType_Wii_SL ||
+		entry->type == RVTH_BankType_Wii_DL) &&
+	       (entry->crypto_type == RVL_CryptoType_Retail ||
+		entry->crypto_type == RVL_CryptoType_Korean ||
+		entry->crypto_type == RVL_CryptoType_vWii ||
+		entry->ticket.sig_status != RVL_SigStatus_OK ||
+		entry->tmd.sig_status != RVL_SigStatus_OK ||
+		(ios_force >= 3 && entry->ios_version != ios_force));
+}
+
 /**
  * Import a disc image into this RVT-H disk image.
  * Compatibility wrapper; this function creates an RvtH object for the
@@ -838,11 +1335,15 @@ int RvtH::copyToHDD(RvtH *rvth_dest, unsigned int bank_dest,
  * @param callback	[in,opt] Progress callback.
  * @param userdata	[in,opt] User data for progress callback.
  * @param ios_force	[in,opt] IOS version to force. (-1 to use the existing IOS)
+ * @param flags		[in,opt] Flags. (See RvtH_Import_Flags.)
+ * @param pStats	[out,opt] Import statistics.
+ * @param pDigests	[out,opt] Digests of the disc image.
  * @return Error code. (If negative, POSIX error; otherwise, see RvtH_Errors.)
  */
 int RvtH::import(unsigned int bank, const TCHAR *filename,
 	RvtH_Progress_Callback callback, void *userdata,
-	int ios_force)
+	int ios_force, unsigned int flags, RvtH_Import_Stats *pStats,
+	RvtH_Digests *pDigests)
 {
 	if (!filename || filename[0] == 0) {
 		errno = EINVAL;
@@ -873,27 +1374,25 @@ int RvtH::import(unsigned int bank, const TCHAR *filename,
 		return RVTH_ERROR_NO_BANKS;
 	}
 
+	// If the image will be recrypted after it's copied, the bank
+	// won't match the source image, so an incremental import
+	// would read the whole bank and still write all of it.
+	if ((flags & RVTH_IMPORT_INCREMENTAL) &&
+	    importNeedsRecrypt(rvth_src->bankEntry(0), ios_force))
+	{
+		flags &= ~RVTH_IMPORT_INCREMENTAL;
+	}
+
 	// Copy the bank from the source GCM to the HDD.
 	// TODO: HDD to HDD?
 	// NOTE: `bank` parameter starts at 0, not 1.
-	ret = rvth_src->copyToHDD(this, bank, 0, callback, userdata);
+	// NOTE: The digests are computed while copying, so they
+	// don't include the recryption and import ID below.
+	ret = rvth_src->copyToHDD(this, bank, 0, callback, userdata, flags, pStats, pDigests);
 	if (ret == 0) {
 		// Must convert to debug realsigned for use on RVT-H.
 		const RvtH_BankEntry *const entry = this->bankEntry(bank);
-		if (entry &&
-			(entry->type == RVTH_BankType_Wii_SL ||
-			 entry->type == RVTH_BankType_Wii_DL) &&
-			(entry->crypto_type == RVL_CryptoType_Retail ||
-			 entry->crypto_type == RVL_CryptoType_Korean ||
-			 entry->crypto_type == RVL_CryptoType_vWii ||
-		         entry->ticket.sig_status != RVL_SigStatus_OK ||
-			 entry->tmd.sig_status != RVL_SigStatus_OK ||
-			 (ios_force >= 3 && entry->ios_version != ios_force)))
-		{
-			// One of the following conditions:
-			// - Encryption: Retail, Korean, or vWii
-			// - Signature: Invalid
-			// - IOS requested does not match the TMD IOS
+		if (entry && importNeedsRecrypt(entry, ios_force)) {
 			// Convert to Debug.
 			ret = recryptWiiPartitions(bank, RVL_CryptoType_Debug, callback, userdata, ios_force);
 		}
@@ -2,7 +2,7 @@
  * RVT-H Tool (librvth)                                                    *
  * extract_crypt.cpp: Extract and encrypt an unencrypted image.            *
  *                                                                         *
- * Copyright (c) 2018-2025 by David Korth.                                 *
+ * Copyright (c) 2018-2026 by David Korth.                                 *
  * SPDX-License-Identifier: GPL-2.0-or-later                               *
  ***************************************************************************/
 
@@ -35,8 +35,29 @@
 
 // Encryption
 #include "aesw.h"
+#include "sha1w.h"
 #include <nettle/sha1.h>
 
+// C++ includes
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+using std::thread;
+using std::unique_ptr;
+using std::vector;
+
+// Thread-safe queue
+#include "BlockingQueue.hpp"
+
+// Aligned memory allocation (for direct I/O)
+#include "aligned_malloc.h"
+
+// Group sizes, in LBAs.
+#define LBA_COUNT_DEC BYTES_TO_LBA(GROUP_SIZE_DEC)
+#define LBA_COUNT_ENC BYTES_TO_LBA(GROUP_SIZE_ENC)
+
 /**
  * Encrypt a group of Wii sectors.
  * @param aesw AES context. (Key must be set to the decrypted title key.)
@@ -52,9 +73,9 @@ static int rvth_encrypt_group(AesCtx *aesw, const uint8_t *pInBuf,
 	size_t inSize, uint8_t *pOutBuf, size_t outSize,
 	uint8_t *pH3, size_t H3_size)
 {
-	struct sha1_ctx sha1;
 	unsigned int i, j;
 	uint8_t iv[16];
+	AesBatchEntry batch[64*2];
 
 	// Disc sector pointers.
 	Wii_Disc_Sector_t *const sbuf = (Wii_Disc_Sector_t*)pOutBuf;
@@ -77,21 +98,14 @@ static int rvth_encrypt_group(AesCtx *aesw, const uint8_t *pInBuf,
 		return -EINVAL;
 	}
 
-	// Initialize the SHA-1 context.
-	sha1_init(&sha1);
-
 	// Copy the user data and calculate the H0 hashes.
 	for (i = 0; i < 64; i++, pInBuf += SECTOR_SIZE_DEC) {
 		// Copy user data.
-		uint8_t *pH0 = sbuf[i].hashes.H0[0];
-		uint8_t *pData = sbuf[i].data;
-		memcpy(pData, pInBuf, SECTOR_SIZE_DEC);
-
-		// Calculate the H0 hashes.
-		for (j = 0; j < 31; j++, pData += 1024, pH0 += SHA1_DIGEST_SIZE) {
-			sha1_update(&sha1, 1024, pData);
-			sha1_digest(&sha1, SHA1_DIGEST_SIZE, pH0);
-		}
+		memcpy(sbuf[i].data, pInBuf, SECTOR_SIZE_DEC);
+
+		// Calculate the H0 hashes. (31 blocks of 1 KB)
+		sha1w_hash_blocks(sbuf[i].hashes.H0[0], sbuf[i].data,
+			1024, 1024, ARRAY_SIZE(sbuf[i].hashes.H0));
 
 		// Zero out the post-H0 padding.
 		memset(sbuf[i].hashes.pad_H0, 0, sizeof(sbuf[i].hashes.pad_H0));
@@ -101,14 +115,11 @@ static int rvth_encrypt_group(AesCtx *aesw, const uint8_t *pInBuf,
 	for (i = 0; i < 64; i += 8) {
 		// First sector in the subgroup.
 		Wii_Disc_Sector_t *const sbuf0 = &sbuf[i];
-		uint8_t *pH1 = sbuf0->hashes.H1[0];
 
 		// Hash the H0 tables and store the results
 		// in the first sector's H1 table.
-		for (j = i; j < i+8; j++, pH1 += SHA1_DIGEST_SIZE) {
-			sha1_update(&sha1, sizeof(sbuf[j].hashes.H0), sbuf[j].hashes.H0[0]);
-			sha1_digest(&sha1, SHA1_DIGEST_SIZE, pH1);
-		}
+		sha1w_hash_blocks(sbuf0->hashes.H1[0], sbuf0->hashes.H0[0],
+			sizeof(sbuf0->hashes.H0), sizeof(*sbuf0), ARRAY_SIZE(sbuf0->hashes.H1));
 		memset(sbuf0->hashes.pad_H1, 0, sizeof(sbuf0->hashes.pad_H1));
 
 		// Copy the H1 hashes to each sector in the subgroup.
@@ -120,45 +131,320 @@ static int rvth_encrypt_group(AesCtx *aesw, const uint8_t *pInBuf,
 
 	// Calculate the H2 hashes for the subgroups.
 	// NOTE: All sectors in this group have the same H2 hashes.
-	sbuf_tmp = sbuf;
-	for (i = 0; i < 8; i += 1, sbuf_tmp += 8) {
-		sha1_update(&sha1, sizeof(sbuf_tmp->hashes.H1), sbuf_tmp->hashes.H1[0]);
-		sha1_digest(&sha1, SHA1_DIGEST_SIZE, sbuf[0].hashes.H2[i]);
-	}
+	// The H1 tables are taken from the first sector in each subgroup.
+	sha1w_hash_blocks(sbuf[0].hashes.H2[0], sbuf[0].hashes.H1[0],
+		sizeof(sbuf[0].hashes.H1), sizeof(sbuf[0]) * 8, ARRAY_SIZE(sbuf[0].hashes.H2));
 	memset(sbuf[0].hashes.pad_H2, 0, sizeof(sbuf[0].hashes.pad_H2));
 
-	// Copy the H2 hashes to all sectors and encrypt the hashes.
+	// Copy the H2 hashes to all sectors.
 	sbuf_tmp = &sbuf[1];
-	memset(iv, 0, sizeof(iv));
 	for (i = 1; i < 64; i++, sbuf_tmp++) {
 		memcpy(sbuf_tmp->hashes.H2, sbuf[0].hashes.H2, sizeof(sbuf[0].hashes.H2));
 		memset(sbuf_tmp->hashes.pad_H2, 0, sizeof(sbuf_tmp->hashes.pad_H2));
-
-		// TODO: Error checking.
-		aesw_set_iv(aesw, iv, sizeof(iv));
-		aesw_encrypt(aesw, (uint8_t*)&sbuf_tmp->hashes, sizeof(sbuf_tmp->hashes));
 	}
 
 	// Calculate the H3 hash.
-	sha1_update(&sha1, sizeof(sbuf[0].hashes.H2), sbuf[0].hashes.H2[0]);
-	sha1_digest(&sha1, SHA1_DIGEST_SIZE, pH3);
+	sha1w_hash_blocks(pH3, sbuf[0].hashes.H2[0],
+		sizeof(sbuf[0].hashes.H2), sizeof(sbuf[0].hashes.H2), 1);
 
-	// Encrypt sector 0's hashes.
-	aesw_set_iv(aesw, iv, sizeof(iv));
-	aesw_encrypt(aesw, (uint8_t*)&sbuf[0].hashes, sizeof(sbuf[0].hashes));
-
-	// Encrypt the user data.
-	sbuf_tmp = sbuf;
-	for (i = 0; i < 64; i++, sbuf_tmp++) {
-		// User data IV is stored within the encrypted H2 table.
-		aesw_set_iv(aesw, &sbuf[i].hashes.H2[7][4], 16);
-		aesw_encrypt(aesw, sbuf_tmp->data, sizeof(sbuf_tmp->data));
+	// Encrypt the hashes first, then the user data.
+	// User data IV is stored within the encrypted H2 table,
+	// and batch entries are processed in order.
+	memset(iv, 0, sizeof(iv));
+	for (i = 0; i < 64; i++) {
+		batch[i].iv = iv;
+		batch[i].data = (uint8_t*)&sbuf[i].hashes;
+		batch[i].size = sizeof(sbuf[i].hashes);
+
+		batch[64+i].iv = &sbuf[i].hashes.H2[7][4];
+		batch[64+i].data = sbuf[i].data;
+		batch[64+i].size = sizeof(sbuf[i].data);
+	}
+	if (aesw_encrypt_batch(aesw, batch, ARRAY_SIZE(batch)) != ARRAY_SIZE(batch)) {
+		// Encryption failed.
+		return -EIO;
 	}
 
 	// We're done here?
 	return 0;
 }
 
+/**
+ * Group encryption parameters for copyToGcm_doCrypt().
+ */
+struct EncryptParams {
+	Reader *reader_src;		// Source reader (unencrypted)
+	Reader *reader_dest;		// Destination reader (encrypted)
+	uint32_t data_lba_src;		// Game partition, data offset LBA. (source)
+	uint32_t data_lba_dest;		// Game partition, data offset LBA. (dest)
+	uint32_t lba_copy_len;		// Number of LBAs to copy.
+	unsigned int group_count;	// Number of groups to encrypt.
+	Wii_Disc_H3_t *H3_tbl;		// H3 table
+
+	RvtH_Progress_Callback callback;
+	void *userdata;
+	RvtH_Progress_State *state;
+};
+
+/**
+ * Group encryption job.
+ */
+struct EncryptJob {
+	aligned_unique_ptr<uint8_t> buf_dec;	// Unencrypted group (GROUP_SIZE_DEC; aligned for direct I/O)
+	unique_ptr<uint8_t[]> buf_enc;	// Encrypted group (GROUP_SIZE_ENC)
+	unsigned int group;		// Group number
+	int err;			// Error code from encrypt_read_group() or rvth_encrypt_group()
+
+	EncryptJob()
+		: buf_dec(aligned_uptr<uint8_t>(RefFile::DIRECT_IO_ALIGN, GROUP_SIZE_DEC))
+		, buf_enc(new uint8_t[GROUP_SIZE_ENC])
+		, group(0)
+		, err(0)
+	{ }
+};
+
+/**
+ * Run the progress callback for copyToGcm_doCrypt().
+ * @param p		[in] Group encryption parameters
+ * @param lba_processed	[in] Number of source LBAs processed
+ * @return True to continue; false to cancel.
+ */
+static bool encrypt_progress(const EncryptParams &p, uint32_t lba_processed)
+{
+	if (!p.callback) {
+		return true;
+	}
+	p.state->lba_processed = lba_processed;
+	return p.callback(p.state, p.userdata);
+}
+
+/**
+ * Read a group of unencrypted sectors.
+ * If the partition ends partway through the group,
+ * the rest of the group is zeroed.
+ * @param p		[in] Group encryption parameters
+ * @param group		[in] Group number
+ * @param buf_dec	[out] Buffer (GROUP_SIZE_DEC)
+ * @return 0 on success; negative POSIX error code on error.
+ */
+static int encrypt_read_group(const EncryptParams &p, unsigned int group, uint8_t *buf_dec)
+{
+	const uint32_t lba_count_dec = group * LBA_COUNT_DEC;
+	const uint32_t lba_left = p.lba_copy_len - lba_count_dec;
+	const uint32_t lba_read = (lba_left >= LBA_COUNT_DEC ? LBA_COUNT_DEC : lba_left);
+
+	errno = 0;
+	if (p.reader_src->read(buf_dec, p.data_lba_src + lba_count_dec, lba_read) != lba_read) {
+		// Read error.
+		return (errno != 0 ? -errno : -EIO);
+	}
+	if (lba_read < LBA_COUNT_DEC) {
+		// Pad the sectors.
+		memset(&buf_dec[LBA_TO_BYTES(lba_read)], 0, LBA_TO_BYTES(LBA_COUNT_DEC - lba_read));
+	}
+	return 0;
+}
+
+/**
+ * Write a group of encrypted sectors.
+ * @param p		[in] Group encryption parameters
+ * @param group		[in] Group number
+ * @param buf_enc	[in] Buffer (GROUP_SIZE_ENC)
+ * @return 0 on success; negative POSIX error code on error.
+ */
+static inline int encrypt_write_group(const EncryptParams &p, unsigned int group, const uint8_t *buf_enc)
+{
+	// TODO: Optimize seeking? (Reader::write() seeks every time.)
+	errno = 0;
+	if (p.reader_dest->write(buf_enc, p.data_lba_dest + (group * LBA_COUNT_ENC), LBA_COUNT_ENC) != LBA_COUNT_ENC) {
+		// Write error.
+		return (errno != 0 ? -errno : -EIO);
+	}
+	return 0;
+}
+
+/**
+ * Encrypt the groups in a partition using the calling thread.
+ * @param p	[in] Group encryption parameters
+ * @param aesw	[in] AES context, with the title key set
+ * @return 0 on success; negative POSIX error code on error.
+ */
+static int encrypt_groups_st(const EncryptParams &p, AesCtx *aesw)
+{
+	EncryptJob job;
+	for (unsigned int g = 0; g < p.group_count; g++) {
+		if (!encrypt_progress(p, g * LBA_COUNT_DEC)) {
+			// Stop processing.
+			return -ECANCELED;
+		}
+
+		// Read 64 decrypted sectors.
+		int ret = encrypt_read_group(p, g, job.buf_dec.get());
+		if (ret != 0) {
+			return ret;
+		}
+
+		// Encrypt the sectors. (64*31k -> 64*32k)
+		ret = rvth_encrypt_group(aesw, job.buf_dec.get(), GROUP_SIZE_DEC,
+			job.buf_enc.get(), GROUP_SIZE_ENC, p.H3_tbl->h3[g], SHA1_DIGEST_SIZE);
+		if (ret != 0) {
+			return ret;
+		}
+
+		// Write 64 encrypted sectors.
+		ret = encrypt_write_group(p, g, job.buf_enc.get());
+		if (ret != 0) {
+			return ret;
+		}
+	}
+
+	return 0;
+}
+
+/**
+ * Encrypt the groups in a partition using multiple threads.
+ *
+ * One thread reads groups from the source Reader, and the worker
+ * threads encrypt them. Groups are written by the calling thread
+ * in group order, and the progress callback is run on the calling
+ * thread with the same sequence as encrypt_groups_st().
+ *
+ * @param p		[in] Group encryption parameters
+ * @param title_key	[in] Decrypted title key
+ * @param threads	[in] Number of worker threads (must be at least 2)
+ * @return 0 on success; negative POSIX error code on error.
+ */
+static int encrypt_groups_mt(const EncryptParams &p, const uint8_t title_key[16], unsigned int threads)
+{
+	// Each worker thread needs its own AES context.
+	vector<AesCtx*> aesw_workers;
+	aesw_workers.reserve(threads);
+	for (unsigned int i = 0; i < threads; i++) {
+		errno = 0;
+		AesCtx *const aesw = aesw_new();
+		if (!aesw) {
+			int ret = -errno;
+			if (ret == 0) {
+				ret = -EIO;
+			}
+			for (AesCtx *p : aesw_workers) {
+				aesw_free(p);
+			}
+			return ret;
+		}
+		aesw_set_key(aesw, title_key, 16);
+		aesw_workers.push_back(aesw);
+	}
+
+	// Job slots. This limits the number of groups in flight,
+	// so each in-flight group has a unique (group % slot_count) index.
+	const unsigned int slot_count = threads + 2;
+	vector<unique_ptr<EncryptJob> > jobs;
+	jobs.reserve(slot_count);
+	BlockingQueue<EncryptJob*> freeQueue;
+	BlockingQueue<EncryptJob*> workQueue;
+	for (unsigned int i = 0; i < slot_count; i++) {
+		jobs.emplace_back(new EncryptJob);
+		freeQueue.push(jobs.back().get());
+	}
+
+	// Completed jobs, indexed by (group % slot_count).
+	std::mutex done_mutex;
+	std::condition_variable done_cond;
+	vector<EncryptJob*> done(slot_count, nullptr);
+
+	// Reader thread.
+	thread reader_thread([&]() {
+		for (unsigned int g = 0; g < p.group_count; g++) {
+			EncryptJob *job;
+			if (!freeQueue.pop(job)) {
+				// Encryption was aborted.
+				break;
+			}
+
+			// If the read fails, the job is still passed on
+			// so the error is returned in group order.
+			job->group = g;
+			const int err = encrypt_read_group(p, g, job->buf_dec.get());
+			job->err = err;
+			if (!workQueue.push(job) || err != 0) {
+				// Encryption was aborted, or a read error occurred.
+				break;
+			}
+		}
+		workQueue.close();
+	});
+
+	// Worker threads.
+	// NOTE: Each group has its own H3 entry, so the workers
+	// can write to the H3 table directly.
+	vector<thread> workers;
+	workers.reserve(threads);
+	for (unsigned int i = 0; i < threads; i++) {
+		AesCtx *const aesw = aesw_workers[i];
+		workers.emplace_back([&, aesw]() {
+			EncryptJob *job;
+			while (workQueue.pop(job)) {
+				if (job->err == 0) {
+					job->err = rvth_encrypt_group(aesw, job->buf_dec.get(), GROUP_SIZE_DEC,
+						job->buf_enc.get(), GROUP_SIZE_ENC,
+						p.H3_tbl->h3[job->group], SHA1_DIGEST_SIZE);
+				}
+				{
+					std::lock_guard<std::mutex> lock(done_mutex);
+					done[job->group % slot_count] = job;
+				}
+				done_cond.notify_all();
+			}
+		});
+	}
+
+	// Write the groups in order.
+	int ret = 0;
+	for (unsigned int g = 0; g < p.group_count; g++) {
+		if (!encrypt_progress(p, g * LBA_COUNT_DEC)) {
+			// Stop processing.
+			ret = -ECANCELED;
+			break;
+		}
+
+		EncryptJob *job;
+		{
+			std::unique_lock<std::mutex> lock(done_mutex);
+			EncryptJob *&slot = done[g % slot_count];
+			done_cond.wait(lock, [&slot]() { return slot != nullptr; });
+			job = slot;
+			slot = nullptr;
+		}
+		assert(job->group == g);
+		if (job->err != 0) {
+			// Read or encryption error.
+			ret = job->err;
+			break;
+		}
+
+		// Write 64 encrypted sectors.
+		ret = encrypt_write_group(p, g, job->buf_enc.get());
+		if (ret != 0) {
+			break;
+		}
+		freeQueue.push(job);
+	}
+
+	// Shut down the pipeline.
+	freeQueue.close();
+	workQueue.close();
+	reader_thread.join();
+	for (thread &worker : workers) {
+		worker.join();
+	}
+	for (AesCtx *aesw : aesw_workers) {
+		aesw_free(aesw);
+	}
+
+	return ret;
+}
+
 /**
  * Copy a bank from this RVT-H HDD or standalone disc image to a writable standalone disc image.
  *
@@ -166,14 +452,18 @@ static int rvth_encrypt_group(AesCtx *aesw, const uint8_t *pInBuf,
  * using the existing title key. It does *not* change the encryption
  * method or signature, so recryption will be needed afterwards.
  *
+ * Groups are encrypted by a pool of worker threads. The progress
+ * callback is always run on the calling thread.
+ *
  * @param rvth_dest	[out] Destination RvtH object.
  * @param bank_src	[in] Source bank number. (0-7)
  * @param callback	[in,opt] Progress callback.
  * @param userdata	[in,opt] User data for progress callback.
+ * @param threads	[in,opt] Number of worker threads (0 for auto; 1 to disable threading)
  * @return Error code. (If negative, POSIX error; otherwise, see RvtH_Errors.)
  */
 int RvtH::copyToGcm_doCrypt(RvtH *rvth_dest, unsigned int bank_src,
-	RvtH_Progress_Callback callback, void *userdata)
+	RvtH_Progress_Callback callback, void *userdata, unsigned int threads)
 {
 	uint32_t data_lba_src;	// Game partition, data offset LBA. (source, unencrypted)
 	uint32_t data_lba_dest;	// Game partition, data offset LBA. (dest, encrypted)
@@ -182,23 +472,17 @@ int RvtH::copyToGcm_doCrypt(RvtH *rvth_dest, unsigned int bank_src,
 	// Buffers.
 	RVL_PartitionHeader pthdr;
 	uint8_t *buf_dec = NULL;
-	uint8_t *buf_enc = NULL;
 
 	// H3 table.
 	Wii_Disc_H3_t *H3_tbl = NULL;	// H3 hash table.
-	uint8_t *pH3;			// Current H3 hash.
 	RVL_Content_Entry *content;
 	struct sha1_ctx sha1;
 
-	// Current LBA counters.
-	// Relative to the game partition.
-	uint32_t data_offset;	// Partition data offset.
-	uint32_t lba_count_dec;	// Decrypted (source)
-	uint32_t lba_count_enc;	// Encrypted (destination)
+	// Partition data offset.
+	uint32_t data_offset;
 
-	// Highest LBA that can be read from the source without
-	// padding the buffer.
-	uint32_t lba_max_dec;
+	// Group encryption parameters.
+	EncryptParams params;
 
 	// Callback state.
 	RvtH_Progress_State state;
@@ -227,7 +511,7 @@ int RvtH::copyToGcm_doCrypt(RvtH *rvth_dest, unsigned int bank_src,
 	}
 
 	// Check if the source bank can be extracted.
-	RvtH_BankEntry *const entry_src = &d_ptr->entries[bank_src];
+	RvtH_BankEntry *const entry_src = d_ptr->bankEntry(bank_src);
 	switch (entry_src->type) {
 		case RVTH_BankType_Wii_SL:
 		case RVTH_BankType_Wii_DL:
@@ -274,14 +558,13 @@ int RvtH::copyToGcm_doCrypt(RvtH *rvth_dest, unsigned int bank_src,
 	// If more than one partition, and the other partition
 	// isn't an update partition, fail.
 
-	// Process 64 sectors at a time.
+	// Buffer for the disc header and partition table.
+	// Groups are processed 64 sectors at a time using
+	// separate buffers. (See EncryptJob.)
 	// TODO: Use unique_ptr<>?
-	#define LBA_COUNT_DEC BYTES_TO_LBA(GROUP_SIZE_DEC)
-	#define LBA_COUNT_ENC BYTES_TO_LBA(GROUP_SIZE_ENC)
-	buf_dec = static_cast<uint8_t*>(malloc(GROUP_SIZE_DEC));
-	buf_enc = static_cast<uint8_t*>(malloc(GROUP_SIZE_ENC));
+	buf_dec = static_cast<uint8_t*>(malloc(LBA_SIZE));
 	H3_tbl = static_cast<Wii_Disc_H3_t*>(calloc(1, sizeof(*H3_tbl)));	// zero initialized
-	if (!buf_dec || !buf_enc || !H3_tbl) {
+	if (!buf_dec || !H3_tbl) {
 		// Error allocating memory.
 		err = errno;
 		if (err == 0) {
@@ -309,7 +592,7 @@ int RvtH::copyToGcm_doCrypt(RvtH *rvth_dest, unsigned int bank_src,
 	// tell the file system what the file's size will be.
 
 	// Copy the bank table information.
-	entry_dest = &rvth_dest->d_ptr->entries[0];
+	entry_dest = rvth_dest->d_ptr->bankEntry(0);
 	entry_dest->type	= entry_src->type;
 	entry_dest->region_code	= entry_src->region_code;
 	entry_dest->is_deleted	= false;
@@ -400,62 +683,31 @@ int RvtH::copyToGcm_doCrypt(RvtH *rvth_dest, unsigned int bank_src,
 	}
 	aesw_set_key(aesw, titleKey, sizeof(titleKey));
 
-	// TODO: Optimize seeking? (Reader::write() seeks every time.)
-	lba_max_dec = lba_copy_len - (lba_copy_len % LBA_COUNT_DEC);
-	pH3 = H3_tbl->h3[0];
-	for (lba_count_dec = 0, lba_count_enc = 0;
-	     lba_count_dec < lba_max_dec;
-	     lba_count_dec += LBA_COUNT_DEC, lba_count_enc += LBA_COUNT_ENC, pH3 += SHA1_DIGEST_SIZE)
-	{
-		if (callback) {
-			bool bRet;
-			state.lba_processed = lba_count_dec;
-			bRet = callback(&state, userdata);
-			if (!bRet) {
-				// Stop processing.
-				err = ECANCELED;
-				ret = -ECANCELED;
-				goto end;
-			}
-		}
-
-		// TODO: Error handling.
-
-		// Read 64 decrypted sectors.
-		entry_src->reader->read(buf_dec, data_lba_src + lba_count_dec, LBA_COUNT_DEC);
-
-		// Encrypt the sectors. (64*31k -> 64*32k)
-		rvth_encrypt_group(aesw, buf_dec, GROUP_SIZE_DEC, buf_enc, GROUP_SIZE_ENC, pH3, SHA1_DIGEST_SIZE);
-
-		// Write 64 encrypted sectors.
-		entry_dest->reader->write(buf_enc, data_lba_dest + lba_count_enc, LBA_COUNT_ENC);
-	}
-
-	// If we have leftover, write a padded group.
-	if (lba_count_dec < lba_copy_len) {
-		const unsigned int lba_left = lba_copy_len - lba_count_dec;
-
-		if (callback) {
-			bool bRet;
-			state.lba_processed = lba_count_dec;
-			bRet = callback(&state, userdata);
-			if (!bRet) {
-				// Stop processing.
-				err = ECANCELED;
-				ret = -ECANCELED;
-				goto end;
-			}
-		}
-
-		// Read and pad the sectors.
-		entry_src->reader->read(buf_dec, data_lba_src + lba_count_dec, lba_left);
-		memset(&buf_dec[LBA_TO_BYTES(LBA_COUNT_DEC - lba_left)], 0, LBA_TO_BYTES(lba_left));
-
-		// Encrypt the sectors. (64*31k -> 64*32k)
-		rvth_encrypt_group(aesw, buf_dec, GROUP_SIZE_DEC, buf_enc, GROUP_SIZE_ENC, pH3, SHA1_DIGEST_SIZE);
-
-		// Write 64 encrypted sectors.
-		entry_dest->reader->write(buf_enc, data_lba_dest + lba_count_enc, LBA_COUNT_ENC);
+	// Encrypt the groups.
+	// If we have leftover, the last group will be padded.
+	params.reader_src = entry_src->reader;
+	params.reader_dest = entry_dest->reader;
+	params.data_lba_src = data_lba_src;
+	params.data_lba_dest = data_lba_dest;
+	params.lba_copy_len = lba_copy_len;
+	params.group_count = (lba_copy_len + LBA_COUNT_DEC - 1) / LBA_COUNT_DEC;
+	params.H3_tbl = H3_tbl;
+	params.callback = callback;
+	params.userdata = userdata;
+	params.state = &state;
+
+	if (threads == 0) {
+		// Use one worker thread per CPU.
+		threads = thread::hardware_concurrency();
+	}
+	if (threads > 1 && params.group_count > 1) {
+		ret = encrypt_groups_mt(params, titleKey, threads);
+	} else {
+		ret = encrypt_groups_st(params, aesw);
+	}
+	if (ret != 0) {
+		err = -ret;
+		goto end;
 	}
 
 	/** Update the partition header. **/
@@ -506,7 +758,6 @@ int RvtH::copyToGcm_doCrypt(RvtH *rvth_dest, unsigned int bank_src,
 
 end:
 	free(buf_dec);
-	free(buf_enc);
 	free(H3_tbl);
 	aesw_free(aesw);
 	if (err != 0) {
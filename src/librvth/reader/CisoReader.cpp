@@ -2,7 +2,7 @@
  * RVT-H Tool (librvth)                                                    *
  * CisoReader.cpp: CISO disc image reader class.                           *
  *                                                                         *
- * Copyright (c) 2018-2025 by David Korth.                                 *
+ * Copyright (c) 2018-2026 by David Korth.                                 *
  * SPDX-License-Identifier: GPL-2.0-or-later                               *
  ***************************************************************************/
 
@@ -22,7 +22,9 @@
 
 // C++ includes
 #include <array>
+#include <memory>
 using std::array;
+using std::unique_ptr;
 
 // CISO magic
 static const array<char, 4> CISO_MAGIC = {{'C','I','S','O'}};
@@ -97,8 +99,11 @@ CisoReader::CisoReader(const RefFilePtr &file, uint32_t lba_start, uint32_t lba_
 	: super(file, lba_start, lba_len)
 	, m_real_lba_len(0)
 	, m_block_size_lba(0)
+	, m_physBlockCount(0)
+	, m_logicalBlockCount(0)
+	, m_writable(false)
+	, m_dirty(false)
 {
-	int ret;
 	int err = 0;
 	size_t size;
 	uint16_t physBlockIdx = 0;
@@ -134,16 +139,7 @@ CisoReader::CisoReader(const RefFilePtr &file, uint32_t lba_start, uint32_t lba_
 	m_real_lba_len = lba_len;
 
 	// Read the CISO header.
-	ret = m_file->seeko(lba_start * LBA_SIZE, SEEK_SET);
-	if (ret != 0) {
-		// Seek error.
-		err = errno;
-		if (err == 0) {
-			err = EIO;
-		}
-		goto fail;
-	}
-	size = m_file->read(cisoHeader, 1, sizeof(*cisoHeader));
+	size = m_file->pread(cisoHeader, sizeof(*cisoHeader), LBA_TO_BYTES(lba_start));
 	if (size != sizeof(*cisoHeader)) {
 		// Short read.
 		err = errno;
@@ -162,7 +158,7 @@ CisoReader::CisoReader(const RefFilePtr &file, uint32_t lba_start, uint32_t lba_
 	m_block_size_lba = BYTES_TO_LBA(le32_to_cpu(cisoHeader->block_size));
 
 	// Clear the CISO block map initially.
-	m_blockMap.fill(0xFF);
+	m_blockMap.fill(0xFFFF);
 
 	// Parse the CISO block map.
 	for (unsigned int i = 0; i < static_cast<unsigned int>(m_blockMap.size()); i++) {
@@ -184,6 +180,8 @@ CisoReader::CisoReader(const RefFilePtr &file, uint32_t lba_start, uint32_t lba_
 
 	// Calculate the image size based on the highest logical block index.
 	m_lba_len = static_cast<uint32_t>(maxLogicalBlockUsed + 1) * m_block_size_lba;
+	m_physBlockCount = physBlockIdx;
+	m_logicalBlockCount = (physBlockIdx > 0 ? maxLogicalBlockUsed + 1 : 0);
 
 	// Reader initialized.
 	delete cisoHeader;
@@ -197,6 +195,82 @@ fail:
 	errno = err;
 }
 
+CisoReader::~CisoReader()
+{
+	if (m_dirty && isOpen()) {
+		// Write the updated CISO header.
+		writeHeader();
+	}
+
+	// Superclass will unreference the file.
+}
+
+/**
+ * Create a new, writable CISO disc image.
+ *
+ * A blank CISO header is written to the file, and blocks
+ * are allocated as they're written. The header is updated
+ * by flush() and when the reader is deleted.
+ *
+ * NOTE: Writing is not thread-safe.
+ *
+ * @param file		RefFile (must be empty)
+ * @param lba_start	[in] Starting LBA
+ * @param lba_len	[in] Virtual image size, in LBAs
+ * @return CisoReader*, or NULL on error.
+ */
+CisoReader *CisoReader::create(const RefFilePtr &file, uint32_t lba_start, uint32_t lba_len)
+{
+	assert((bool)file);
+	assert(lba_len != 0);
+	if (!file || lba_len == 0) {
+		// Invalid parameters.
+		errno = EINVAL;
+		return nullptr;
+	}
+
+	// Using 2 MB blocks, which is the same as WBFS.
+	static const uint32_t block_size = 2U*1024U*1024U;
+	const uint32_t block_size_lba = BYTES_TO_LBA(block_size);
+	if ((lba_len + block_size_lba - 1) / block_size_lba > CISO_MAP_SIZE) {
+		// Image is too big for the CISO block map.
+		errno = EFBIG;
+		return nullptr;
+	}
+
+	// Write a blank CISO header.
+	CisoHeader *cisoHeader = new CisoHeader;
+	memset(cisoHeader, 0, sizeof(*cisoHeader));
+	memcpy(cisoHeader->magic, CISO_MAGIC.data(), CISO_MAGIC.size());
+	cisoHeader->block_size = cpu_to_le32(block_size);
+	errno = 0;
+	size_t size = file->pwrite(cisoHeader, sizeof(*cisoHeader), LBA_TO_BYTES(lba_start));
+	delete cisoHeader;
+	if (size != sizeof(*cisoHeader)) {
+		// Write error.
+		if (errno == 0) {
+			errno = EIO;
+		}
+		return nullptr;
+	}
+
+	// Open the blank image, then set the virtual image size.
+	CisoReader *const reader = new CisoReader(file, lba_start, BYTES_TO_LBA(sizeof(*cisoHeader)));
+	if (!reader->isOpen()) {
+		// Error opening the CISO image.
+		int err = errno;
+		if (err == 0) {
+			err = EIO;
+		}
+		delete reader;
+		errno = err;
+		return nullptr;
+	}
+	reader->m_lba_len = lba_len;
+	reader->m_writable = true;
+	return reader;
+}
+
 /**
  * Read data from the disc image.
  * @param ptr		[out] Read buffer.
@@ -221,39 +295,269 @@ uint32_t CisoReader::read(void *ptr, uint32_t lba_start, uint32_t lba_len)
 		return 0;
 	}
 
-	// TODO: Optimize reading multiple LBAs at once.
-	// For now, we're looking up a single LBA at a time.
+	// Process the request as runs of blocks that are either all empty
+	// or physically contiguous in the CISO image. Each run is handled
+	// with a single memset() or a single read.
 	uint8_t *ptr8 = static_cast<uint8_t*>(ptr);
-	uint32_t lba_end = lba_start + lba_len;
-	for (uint32_t lba = lba_start; lba < lba_end; lba++, ptr8 += LBA_SIZE) {
-		unsigned int physBlockIdx = m_blockMap[lba / m_block_size_lba];
-		if (physBlockIdx == 0xFFFF) {
-			// Empty block.
-			memset(ptr8, 0, LBA_SIZE);
-		} else {
-			// Determine the offset.
-			const unsigned int blockStart = physBlockIdx * m_block_size_lba;
-			const unsigned int offset = lba % m_block_size_lba;
+	const uint32_t lba_end = lba_start + lba_len;
+	uint32_t lba = lba_start;
+	while (lba < lba_end) {
+		off64_t physOffset;
+		const uint32_t run_len = mapRun(lba, lba_end - lba, &physOffset);
 
-			int ret = m_file->seeko(LBA_TO_BYTES(blockStart + offset + m_lba_start), SEEK_SET);
-			if (ret != 0) {
-				// Seek error.
+		if (physOffset < 0) {
+			// Empty blocks.
+			memset(ptr8, 0, LBA_TO_BYTES(run_len));
+		} else {
+			size_t size = m_file->pread(ptr8, LBA_TO_BYTES(run_len), physOffset);
+			if (size != LBA_TO_BYTES(run_len)) {
+				// Read error.
 				if (errno == 0) {
 					errno = EIO;
 				}
 				return 0;
 			}
-			size_t size = m_file->read(ptr8, LBA_SIZE, 1);
-			if (size != 1) {
-				// Read error.
+			lbas_read += run_len;
+		}
+
+		ptr8 += LBA_TO_BYTES(run_len);
+		lba += run_len;
+	}
+
+	return lbas_read;
+}
+
+/**
+ * Map a range of LBAs to a location in the underlying file.
+ * @param lba_start	[in] Starting LBA.
+ * @param lba_len	[in] Length, in LBAs.
+ * @param pPhysOffset	[out] Byte offset in the file, or -1 if the run is empty.
+ * @return Number of LBAs in the run (at most lba_len).
+ */
+uint32_t CisoReader::mapRun(uint32_t lba_start, uint32_t lba_len, off64_t *pPhysOffset) const
+{
+	assert(lba_start + lba_len <= m_lba_len);
+	const uint32_t lba_end = lba_start + lba_len;
+	const unsigned int firstBlockIdx = lba_start / m_block_size_lba;
+	const unsigned int firstPhysBlockIdx = m_blockMap[firstBlockIdx];
+
+	// Extend the run while the blocks are either all empty
+	// or physically contiguous.
+	unsigned int blockIdx = firstBlockIdx + 1;
+	uint32_t run_end = blockIdx * m_block_size_lba;
+	for (; run_end < lba_end; blockIdx++, run_end += m_block_size_lba) {
+		const unsigned int physBlockIdx = m_blockMap[blockIdx];
+		if (firstPhysBlockIdx == 0xFFFF) {
+			if (physBlockIdx != 0xFFFF)
+				break;
+		} else if (physBlockIdx == 0xFFFF ||
+		           physBlockIdx != firstPhysBlockIdx + (blockIdx - firstBlockIdx))
+		{
+			break;
+		}
+	}
+	if (run_end > lba_end) {
+		run_end = lba_end;
+	}
+
+	if (firstPhysBlockIdx == 0xFFFF) {
+		// Empty blocks.
+		*pPhysOffset = -1;
+	} else {
+		// Determine the offset.
+		const unsigned int blockStart = firstPhysBlockIdx * m_block_size_lba;
+		const unsigned int offset = lba_start % m_block_size_lba;
+		*pPhysOffset = LBA_TO_BYTES(blockStart + offset + m_lba_start);
+	}
+	return run_end - lba_start;
+}
+
+/**
+ * Write data to the disc image.
+ * Only supported for images opened with create().
+ * @param ptr		[in] Write buffer.
+ * @param lba_start	[in] Starting LBA.
+ * @param lba_len	[in] Length, in LBAs.
+ * @return Number of LBAs written, or 0 on error.
+ */
+uint32_t CisoReader::write(const void *ptr, uint32_t lba_start, uint32_t lba_len)
+{
+	if (!m_writable) {
+		// Existing CISO images are read-only.
+		errno = EROFS;
+		return 0;
+	}
+
+	// LBA bounds checking.
+	// TODO: Check for overflow?
+	assert(lba_start + lba_len <= m_lba_len);
+	if (lba_len == 0 || lba_start + lba_len > m_lba_len) {
+		// Out of range.
+		errno = EIO;
+		return 0;
+	}
+
+	// Allocate physical blocks for any empty blocks in the range.
+	const unsigned int lastBlockIdx = (lba_start + lba_len - 1) / m_block_size_lba;
+	for (unsigned int blockIdx = lba_start / m_block_size_lba; blockIdx <= lastBlockIdx; blockIdx++) {
+		if (m_blockMap[blockIdx] == 0xFFFF) {
+			if (allocBlock(blockIdx) != 0) {
+				// Unable to allocate the block.
+				return 0;
+			}
+		}
+	}
+
+	// Write the data as runs of physically contiguous blocks.
+	uint32_t lbas_written = 0;
+	const uint8_t *ptr8 = static_cast<const uint8_t*>(ptr);
+	const uint32_t lba_end = lba_start + lba_len;
+	uint32_t lba = lba_start;
+	while (lba < lba_end) {
+		off64_t physOffset;
+		const uint32_t run_len = mapRun(lba, lba_end - lba, &physOffset);
+		assert(physOffset >= 0);
+
+		errno = 0;
+		size_t size = m_file->pwrite(ptr8, LBA_TO_BYTES(run_len), physOffset);
+		if (size != LBA_TO_BYTES(run_len)) {
+			// Short write.
+			if (errno == 0) {
+				errno = EIO;
+			}
+			return lbas_written + static_cast<uint32_t>(size / LBA_SIZE);
+		}
+		lbas_written += run_len;
+
+		ptr8 += LBA_TO_BYTES(run_len);
+		lba += run_len;
+	}
+
+	return lbas_written;
+}
+
+/**
+ * Flush the file buffers.
+ * If the block map was modified, the CISO header is written.
+ */
+void CisoReader::flush(void)
+{
+	if (m_dirty) {
+		writeHeader();
+	}
+	super::flush();
+}
+
+/**
+ * Allocate a physical block for an empty logical block.
+ *
+ * CISO stores used blocks in logical order, so if a block
+ * is allocated before a block that's already been written,
+ * the following blocks are moved up by one block.
+ *
+ * @param blockIdx	[in] Logical block index.
+ * @return 0 on success; non-zero on error. (errno is set)
+ */
+int CisoReader::allocBlock(unsigned int blockIdx)
+{
+	assert(m_blockMap[blockIdx] == 0xFFFF);
+	if (m_physBlockCount >= 0xFFFF) {
+		// No more physical blocks.
+		errno = ENOSPC;
+		return -1;
+	}
+
+	const size_t block_size = LBA_TO_BYTES(m_block_size_lba);
+	unsigned int physBlockIdx;
+	if (blockIdx >= m_logicalBlockCount) {
+		// Appending a block. (usual case for sequential writes)
+		// Write the last LBA so the file covers the entire block,
+		// since the block might only be partially written.
+		static const uint8_t zero_lba[LBA_SIZE] = {0};
+		physBlockIdx = m_physBlockCount;
+		const off64_t lastLbaOffset = LBA_TO_BYTES(m_lba_start +
+			((physBlockIdx + 1) * m_block_size_lba) - 1);
+		errno = 0;
+		if (m_file->pwrite(zero_lba, sizeof(zero_lba), lastLbaOffset) != sizeof(zero_lba)) {
+			if (errno == 0) {
+				errno = EIO;
+			}
+			return -1;
+		}
+		m_logicalBlockCount = blockIdx + 1;
+	} else {
+		// Inserting a block. Find its physical position.
+		physBlockIdx = 0;
+		for (unsigned int i = 0; i < blockIdx; i++) {
+			if (m_blockMap[i] != 0xFFFF) {
+				physBlockIdx++;
+			}
+		}
+
+		// Move the following blocks up by one block, starting from the end.
+		unique_ptr<uint8_t[]> buf(new uint8_t[block_size]);
+		errno = 0;
+		for (unsigned int i = m_physBlockCount; i > physBlockIdx; i--) {
+			const off64_t srcOffset = LBA_TO_BYTES(m_lba_start + ((i - 1) * m_block_size_lba));
+			if (m_file->pread(buf.get(), block_size, srcOffset) != block_size ||
+			    m_file->pwrite(buf.get(), block_size, srcOffset + block_size) != block_size)
+			{
 				if (errno == 0) {
 					errno = EIO;
 				}
-				return 0;
+				return -1;
 			}
-			lbas_read++;
+		}
+		for (uint16_t &entry : m_blockMap) {
+			if (entry != 0xFFFF && entry >= physBlockIdx) {
+				entry++;
+			}
+		}
+		m_dirty = true;
+
+		// Clear the new block.
+		memset(buf.get(), 0, block_size);
+		if (m_file->pwrite(buf.get(), block_size,
+		    LBA_TO_BYTES(m_lba_start + (physBlockIdx * m_block_size_lba))) != block_size)
+		{
+			if (errno == 0) {
+				errno = EIO;
+			}
+			return -1;
 		}
 	}
 
-	return lbas_read;
+	m_blockMap[blockIdx] = static_cast<uint16_t>(physBlockIdx);
+	m_physBlockCount++;
+	m_dirty = true;
+	return 0;
+}
+
+/**
+ * Write the CISO header.
+ * @return 0 on success; non-zero on error. (errno is set)
+ */
+int CisoReader::writeHeader(void)
+{
+	CisoHeader *cisoHeader = new CisoHeader;
+	memcpy(cisoHeader->magic, CISO_MAGIC.data(), CISO_MAGIC.size());
+	cisoHeader->block_size = cpu_to_le32(static_cast<uint32_t>(LBA_TO_BYTES(m_block_size_lba)));
+	for (size_t i = 0; i < m_blockMap.size(); i++) {
+		cisoHeader->map[i] = (m_blockMap[i] != 0xFFFF);
+	}
+
+	errno = 0;
+	const size_t size = m_file->pwrite(cisoHeader, sizeof(*cisoHeader),
+		LBA_TO_BYTES(m_lba_start) - sizeof(*cisoHeader));
+	delete cisoHeader;
+	if (size != sizeof(*cisoHeader)) {
+		// Write error.
+		if (errno == 0) {
+			errno = EIO;
+		}
+		return -1;
+	}
+
+	m_dirty = false;
+	return 0;
 }
@@ -2,7 +2,7 @@
  * RVT-H Tool (librvth)                                                    *
  * CisoReader.hpp: CISO disc image reader class.                           *
  *                                                                         *
- * Copyright (c) 2018-2025 by David Korth.                                 *
+ * Copyright (c) 2018-2026 by David Korth.                                 *
  * SPDX-License-Identifier: GPL-2.0-or-later                               *
  ***************************************************************************/
 
@@ -28,6 +28,24 @@ public:
 	 */
 	CisoReader(const RefFilePtr &file, uint32_t lba_start, uint32_t lba_len);
 
+	virtual ~CisoReader();
+
+	/**
+	 * Create a new, writable CISO disc image.
+	 *
+	 * A blank CISO header is written to the file, and blocks
+	 * are allocated as they're written. The header is updated
+	 * by flush() and when the reader is deleted.
+	 *
+	 * NOTE: Writing is not thread-safe.
+	 *
+	 * @param file		RefFile (must be empty)
+	 * @param lba_start	[in] Starting LBA
+	 * @param lba_len	[in] Virtual image size, in LBAs
+	 * @return CisoReader*, or NULL on error.
+	 */
+	static CisoReader *create(const RefFilePtr &file, uint32_t lba_start, uint32_t lba_len);
+
 private:
 	typedef Reader super;
 	DISABLE_COPY(CisoReader)
@@ -53,6 +71,56 @@ public:
 	 */
 	uint32_t read(void *ptr, uint32_t lba_start, uint32_t lba_len) final;
 
+	/**
+	 * Write data to the disc image.
+	 * Only supported for images opened with create().
+	 * @param ptr		[in] Write buffer.
+	 * @param lba_start	[in] Starting LBA.
+	 * @param lba_len	[in] Length, in LBAs.
+	 * @return Number of LBAs written, or 0 on error.
+	 */
+	uint32_t write(const void *ptr, uint32_t lba_start, uint32_t lba_len) final;
+
+	/**
+	 * Map a range of LBAs to a location in the underlying file.
+	 * @param lba_start	[in] Starting LBA.
+	 * @param lba_len	[in] Length, in LBAs.
+	 * @param pPhysOffset	[out] Byte offset in the file, or -1 if the run is empty.
+	 * @return Number of LBAs in the run (at most lba_len).
+	 */
+	uint32_t mapRun(uint32_t lba_start, uint32_t lba_len, off64_t *pPhysOffset) const final;
+
+	/**
+	 * Flush the file buffers.
+	 * If the block map was modified, the CISO header is written.
+	 */
+	void flush(void) final;
+
+	/**
+	 * Is this a compact disc image format?
+	 * @return True if compact; false if not.
+	 */
+	bool isCompact(void) const final { return true; }
+
+private:
+	/**
+	 * Allocate a physical block for an empty logical block.
+	 *
+	 * CISO stores used blocks in logical order, so if a block
+	 * is allocated before a block that's already been written,
+	 * the following blocks are moved up by one block.
+	 *
+	 * @param blockIdx	[in] Logical block index.
+	 * @return 0 on success; non-zero on error. (errno is set)
+	 */
+	int allocBlock(unsigned int blockIdx);
+
+	/**
+	 * Write the CISO header.
+	 * @return 0 on success; non-zero on error. (errno is set)
+	 */
+	int writeHeader(void);
+
 public:
 	static constexpr size_t CISO_HEADER_SIZE = 0x8000U;
 	static constexpr size_t CISO_MAP_SIZE = (CISO_HEADER_SIZE - sizeof(uint32_t) - (sizeof(char) * 4U));
@@ -74,4 +142,12 @@ private:
 	// 0x0000 == first block after CISO header.
 	// 0xFFFF == empty block.
 	std::array<uint16_t, CISO_MAP_SIZE> m_blockMap;
+
+	// Number of physical blocks.
+	unsigned int m_physBlockCount;
+	// Number of logical blocks, up to and including the last used block.
+	unsigned int m_logicalBlockCount;
+
+	bool m_writable;	// Opened with create()
+	bool m_dirty;		// Block map was modified
 };
@@ -0,0 +1,326 @@
+/***************************************************************************
+ * RVT-H Tool (librvth)                                                    *
+ * MmapReader.cpp: Memory-mapped plain disc image reader class.            *
+ * Used for plain disc image files and RVT-H Reader disk image files.      *
+ *                                                                         *
+ * Copyright (c) 2026 by David Korth.                                      *
+ * SPDX-License-Identifier: GPL-2.0-or-later                               *
+ ***************************************************************************/
+
+#include "config.librvth.h"
+#include "MmapReader.hpp"
+
+// For LBA_TO_BYTES()
+#include "nhcd_structs.h"
+
+// C includes (C++ namespace)
+#include <cassert>
+#include <cerrno>
+
+#ifdef _WIN32
+#  include <windows.h>
+#  include <io.h>
+#elif defined(HAVE_MMAP)
+#  include <sys/mman.h>
+#  include <unistd.h>
+#  include <csetjmp>
+#  include <csignal>
+#  include <cstring>
+#endif /* _WIN32 */
+
+// C++ includes
+#include <mutex>
+
+#if !defined(_WIN32) && defined(HAVE_MMAP)
+// SIGBUS guard for prefault().
+// If reading a mapped page fails, the kernel raises SIGBUS
+// instead of returning an error.
+// NOTE: volatile so the compiler doesn't drop the stores
+// around the page reads in prefault().
+static thread_local sigjmp_buf *volatile sigbus_jmp = nullptr;
+static struct sigaction sigbus_old_action;
+static std::once_flag sigbus_once_flag;
+
+/**
+ * SIGBUS handler.
+ * @param sig Signal number
+ * @param info Signal information
+ * @param context Context
+ */
+static void sigbus_handler(int sig, siginfo_t *info, void *context)
+{
+	UNUSED(info);
+	UNUSED(context);
+
+	sigjmp_buf *const jmp = sigbus_jmp;
+	if (jmp) {
+		// Fault in prefault(). Return to the guard.
+		siglongjmp(*jmp, 1);
+	}
+
+	// Not from prefault(). Restore the original handler;
+	// it will be called when the faulting instruction is retried.
+	sigaction(sig, &sigbus_old_action, nullptr);
+}
+
+/**
+ * Install the SIGBUS handler.
+ */
+static void sigbus_install(void)
+{
+	struct sigaction sa;
+	memset(&sa, 0, sizeof(sa));
+	sa.sa_sigaction = sigbus_handler;
+	sa.sa_flags = SA_SIGINFO;
+	sigemptyset(&sa.sa_mask);
+	sigaction(SIGBUS, &sa, &sigbus_old_action);
+}
+#endif /* !_WIN32 && HAVE_MMAP */
+
+/**
+ * Read every page in a mapped range, so I/O errors are
+ * caught here instead of crashing the caller later.
+ * @param ptr	[in] Mapped data
+ * @param size	[in] Size, in bytes
+ * @return True if the range was read; false on I/O error.
+ */
+static bool prefault(const uint8_t *ptr, size_t size)
+{
+	// NOTE: 4 KB is the smallest page size on all supported systems.
+	static const size_t PAGE_STEP = 4096;
+
+#if !defined(_WIN32) && defined(HAVE_MMAP)
+	std::call_once(sigbus_once_flag, sigbus_install);
+
+	sigjmp_buf jmp;
+	if (sigsetjmp(jmp, 1) != 0) {
+		// I/O error.
+		sigbus_jmp = nullptr;
+		return false;
+	}
+	sigbus_jmp = &jmp;
+	for (size_t i = 0; i < size; i += PAGE_STEP) {
+		(void)*reinterpret_cast<const volatile uint8_t*>(&ptr[i]);
+	}
+	(void)*reinterpret_cast<const volatile uint8_t*>(&ptr[size - 1]);
+	sigbus_jmp = nullptr;
+	return true;
+#elif defined(_MSC_VER)
+	// I/O errors raise EXCEPTION_IN_PAGE_ERROR.
+	__try {
+		for (size_t i = 0; i < size; i += PAGE_STEP) {
+			(void)*reinterpret_cast<const volatile uint8_t*>(&ptr[i]);
+		}
+		(void)*reinterpret_cast<const volatile uint8_t*>(&ptr[size - 1]);
+	} __except (GetExceptionCode() == EXCEPTION_IN_PAGE_ERROR
+	            ? EXCEPTION_EXECUTE_HANDLER : EXCEPTION_CONTINUE_SEARCH)
+	{
+		return false;
+	}
+	return true;
+#else
+	// TODO: MinGW doesn't support __try/__except.
+	UNUSED(ptr);
+	UNUSED(size);
+	return true;
+#endif
+}
+
+/**
+ * Get the alignment required for mapping offsets.
+ * @return Alignment, in bytes.
+ */
+static uint64_t mmapAlign(void)
+{
+#ifdef _WIN32
+	SYSTEM_INFO sysinfo;
+	GetSystemInfo(&sysinfo);
+	return sysinfo.dwAllocationGranularity;
+#elif defined(HAVE_MMAP)
+	const long pagesize = sysconf(_SC_PAGESIZE);
+	return (pagesize > 0 ? static_cast<uint64_t>(pagesize) : 4096U);
+#else
+	return 4096U;
+#endif
+}
+
+/**
+ * Create a memory-mapped reader for a plain disc image.
+ *
+ * NOTE: If lba_start == 0 and lba_len == 0, the entire file
+ * will be used.
+ *
+ * @param file		RefFile
+ * @param lba_start	[in] Starting LBA
+ * @param lba_len	[in] Length, in LBAs
+ */
+MmapReader::MmapReader(const RefFilePtr &file, uint32_t lba_start, uint32_t lba_len)
+	: super(file, lba_start, lba_len)
+#ifdef _WIN32
+	, m_hMapping(nullptr)
+#endif /* _WIN32 */
+{
+	// Windows are mapped when they're first used.
+}
+
+MmapReader::~MmapReader()
+{
+	for (const Window &window : m_windows) {
+		if (!window.base)
+			continue;
+#ifdef _WIN32
+		UnmapViewOfFile(window.base);
+#elif defined(HAVE_MMAP)
+		munmap(window.base, window.size);
+#endif /* _WIN32 */
+	}
+#ifdef _WIN32
+	if (m_hMapping) {
+		CloseHandle(m_hMapping);
+	}
+#endif /* _WIN32 */
+}
+
+/**
+ * Is memory mapping supported on this system?
+ * 32-bit systems don't have enough address space for disc images.
+ * @return True if supported; false if not.
+ */
+bool MmapReader::isSupported(void)
+{
+#if defined(_WIN32) || defined(HAVE_MMAP)
+	return (sizeof(void*) >= 8);
+#else
+	return false;
+#endif
+}
+
+/**
+ * Map a window.
+ * m_mutex must be locked by the caller.
+ * @param idx Window index
+ * @return 0 on success; negative POSIX error code on error.
+ */
+int MmapReader::mapWindow(size_t idx)
+{
+	Window &window = m_windows[idx];
+	assert(window.base == nullptr);
+
+	// Don't map past the end of the file.
+	// Accessing a mapped page past EOF results in SIGBUS.
+	const off64_t filesize = m_file->size();
+	const uint64_t reader_size = LBA_TO_BYTES(static_cast<uint64_t>(m_lba_len));
+	const uint64_t win_start = idx * WINDOW_SIZE;
+	const uint64_t file_start = LBA_TO_BYTES(static_cast<uint64_t>(m_lba_start)) + win_start;
+	if (filesize <= 0 || file_start >= static_cast<uint64_t>(filesize) || win_start >= reader_size) {
+		return -ENXIO;
+	}
+	uint64_t len = WINDOW_SIZE + WINDOW_OVERLAP;
+	if (len > reader_size - win_start) {
+		len = reader_size - win_start;
+	}
+	if (len > static_cast<uint64_t>(filesize) - file_start) {
+		len = static_cast<uint64_t>(filesize) - file_start;
+	}
+
+	// Mapping offsets must be aligned.
+	const uint64_t align = mmapAlign();
+	const uint64_t map_offset = file_start & ~(align - 1);
+	const size_t delta = static_cast<size_t>(file_start - map_offset);
+	const size_t map_size = static_cast<size_t>(len) + delta;
+
+	// NOTE: The mapping is copy-on-write so callers can modify
+	// the data (e.g. to restore a missing disc header) without
+	// changing the file.
+	void *base;
+#ifdef _WIN32
+	if (!m_hMapping) {
+		HANDLE hFile = (HANDLE)_get_osfhandle(_fileno(m_file->m_file));
+		m_hMapping = CreateFileMapping(hFile, nullptr, PAGE_WRITECOPY, 0, 0, nullptr);
+		if (!m_hMapping) {
+			return -EIO;
+		}
+	}
+	base = MapViewOfFile(m_hMapping, FILE_MAP_COPY,
+		static_cast<DWORD>(map_offset >> 32), static_cast<DWORD>(map_offset), map_size);
+	if (!base) {
+		return -ENOMEM;
+	}
+#elif defined(HAVE_MMAP)
+	base = mmap(nullptr, map_size, PROT_READ | PROT_WRITE, MAP_PRIVATE,
+		fileno(m_file->m_file), static_cast<off_t>(map_offset));
+	if (base == MAP_FAILED) {
+		return -errno;
+	}
+#else
+	return -ENOTSUP;
+#endif
+
+	window.base = base;
+	window.size = map_size;
+	window.data = static_cast<uint8_t*>(base) + delta;
+	window.len = static_cast<size_t>(len);
+	window.sequential = false;
+	return 0;
+}
+
+/**
+ * Get a pointer to the disc image data without copying it.
+ * @param lba_start	[in] Starting LBA.
+ * @param lba_len	[in] Length, in LBAs.
+ * @param sequential	[in] If true, the data will be accessed sequentially. (bulk scans)
+ * @return Pointer to the data, or nullptr if the range can't be mapped or read.
+ */
+uint8_t *MmapReader::map(uint32_t lba_start, uint32_t lba_len, bool sequential)
+{
+	if (!isSupported() || !isOpen() || m_file->isDirectIO()) {
+		// Direct I/O is supposed to bypass the page cache.
+		return nullptr;
+	}
+	if (lba_len == 0 || lba_start + lba_len > m_lba_len || lba_start + lba_len < lba_start) {
+		// Out of range.
+		return nullptr;
+	}
+
+	const uint64_t start = LBA_TO_BYTES(static_cast<uint64_t>(lba_start));
+	const uint64_t size = LBA_TO_BYTES(static_cast<uint64_t>(lba_len));
+	const size_t idx = static_cast<size_t>(start / WINDOW_SIZE);
+	const uint64_t offset = start - (idx * WINDOW_SIZE);
+	if (offset + size > WINDOW_SIZE + WINDOW_OVERLAP) {
+		// Request is too large.
+		return nullptr;
+	}
+
+	std::lock_guard<std::mutex> lock(m_mutex);
+	if (idx >= m_windows.size()) {
+		m_windows.resize(idx + 1, Window{nullptr, 0, nullptr, 0, false});
+	}
+	Window &window = m_windows[idx];
+	if (!window.base && mapWindow(idx) != 0) {
+		// Unable to map the window.
+		return nullptr;
+	}
+	if (offset + size > window.len) {
+		// Past the end of the file.
+		return nullptr;
+	}
+
+#if !defined(_WIN32) && defined(MADV_SEQUENTIAL)
+	if (sequential && !window.sequential) {
+		// Increase kernel read-ahead for this window.
+		// NOTE: Applied to the entire window to avoid splitting the mapping.
+		madvise(window.base, window.size, MADV_SEQUENTIAL);
+		window.sequential = true;
+	}
+#else /* _WIN32 || !MADV_SEQUENTIAL */
+	UNUSED(sequential);
+#endif /* !_WIN32 && MADV_SEQUENTIAL */
+
+	uint8_t *const ptr = window.data + offset;
+	if (!prefault(ptr, static_cast<size_t>(size))) {
+		// I/O error. The caller will use read() instead,
+		// which returns the error normally.
+		return nullptr;
+	}
+	return ptr;
+}
@@ -0,0 +1,103 @@
+/***************************************************************************
+ * RVT-H Tool (librvth)                                                    *
+ * MmapReader.hpp: Memory-mapped plain disc image reader class.            *
+ * Used for plain disc image files and RVT-H Reader disk image files.      *
+ *                                                                         *
+ * Copyright (c) 2026 by David Korth.                                      *
+ * SPDX-License-Identifier: GPL-2.0-or-later                               *
+ ***************************************************************************/
+
+#pragma once
+
+#include "PlainReader.hpp"
+
+// C++ includes
+#include <mutex>
+#include <vector>
+
+/**
+ * Memory-mapped plain disc image reader.
+ *
+ * read() and write() are the same as PlainReader. map() maps the
+ * image into memory in 1 GB windows, which are mapped when they're
+ * first used and stay mapped until the Reader is deleted, so bulk
+ * scans (verify, extract) can use the page cache directly instead
+ * of copying the data into a separate buffer.
+ *
+ * Windows overlap by 64 MB, so requests up to that size can always
+ * be mapped. map() returns nullptr for larger requests, requests past
+ * the end of the file, and if direct I/O is enabled.
+ *
+ * I/O errors on mapped data raise SIGBUS (EXCEPTION_IN_PAGE_ERROR on
+ * Windows) instead of returning an error, so map() reads every page
+ * of the range under a guard before returning it. If a page can't be
+ * read, map() returns nullptr and the caller falls back to read(),
+ * which reports the error. Pages that are evicted from the page cache
+ * after map() returns may still fault if they can't be read again.
+ * The guard isn't available on MinGW builds.
+ */
+class MmapReader : public PlainReader
+{
+public:
+	/**
+	 * Create a memory-mapped reader for a plain disc image.
+	 *
+	 * NOTE: If lba_start == 0 and lba_len == 0, the entire file
+	 * will be used.
+	 *
+	 * @param file		RefFile
+	 * @param lba_start	[in] Starting LBA
+	 * @param lba_len	[in] Length, in LBAs
+	 */
+	MmapReader(const RefFilePtr &file, uint32_t lba_start, uint32_t lba_len);
+	~MmapReader() final;
+
+private:
+	typedef PlainReader super;
+	DISABLE_COPY(MmapReader)
+
+public:
+	/**
+	 * Is memory mapping supported on this system?
+	 * 32-bit systems don't have enough address space for disc images.
+	 * @return True if supported; false if not.
+	 */
+	static bool isSupported(void);
+
+	/**
+	 * Get a pointer to the disc image data without copying it.
+	 * @param lba_start	[in] Starting LBA.
+	 * @param lba_len	[in] Length, in LBAs.
+	 * @param sequential	[in] If true, the data will be accessed sequentially. (bulk scans)
+	 * @return Pointer to the data, or nullptr if the range can't be mapped or read.
+	 */
+	uint8_t *map(uint32_t lba_start, uint32_t lba_len, bool sequential = false) final;
+
+public:
+	// Window size and overlap, in bytes.
+	static constexpr uint64_t WINDOW_SIZE = 1024ULL*1024ULL*1024ULL;
+	static constexpr uint64_t WINDOW_OVERLAP = 64ULL*1024ULL*1024ULL;
+
+private:
+	/**
+	 * Map a window.
+	 * m_mutex must be locked by the caller.
+	 * @param idx Window index
+	 * @return 0 on success; negative POSIX error code on error.
+	 */
+	int mapWindow(size_t idx);
+
+private:
+	struct Window {
+		void *base;		// Base address of the mapping
+		size_t size;		// Size of the mapping
+		uint8_t *data;		// Start of the window within the mapping
+		size_t len;		// Length of the window, in bytes
+		bool sequential;	// Has MADV_SEQUENTIAL been applied?
+	};
+	std::vector<Window> m_windows;
+	std::mutex m_mutex;
+#ifdef _WIN32
+	void *m_hMapping;		// File mapping object
+#endif /* _WIN32 */
+};
@@ -0,0 +1,341 @@
+/***************************************************************************
+ * RVT-H Tool (librvth)                                                    *
+ * PartitionReader.cpp: Decrypted Wii partition reader.                    *
+ *                                                                         *
+ * Copyright (c) 2026 by David Korth.                                      *
+ * SPDX-License-Identifier: GPL-2.0-or-later                               *
+ ***************************************************************************/
+
+#include "PartitionReader.hpp"
+#include "Reader.hpp"
+#include "nhcd_structs.h"
+
+// libwiicrypto
+#include "libwiicrypto/byteswap.h"
+#include "libwiicrypto/wii_structs.h"
+
+// Encryption
+#include "aesw.h"
+
+// C includes. (C++ namespace)
+#include <cassert>
+#include <cerrno>
+#include <cstring>
+
+// C++ includes.
+#include <algorithm>
+#include <array>
+using std::array;
+using std::unique_ptr;
+
+// Number of LBAs in an unencrypted group.
+#define LBAS_PER_GROUP_DEC BYTES_TO_LBA(GROUP_SIZE_DEC)
+
+/**
+ * Create a PartitionReader.
+ * @param reader	[in] Reader
+ * @param pte		[in] Partition table entry
+ * @param cacheSize	[in] Maximum cache size, in bytes
+ * @param checkHashes	[in] If true, check the hashes of each group when it's loaded.
+ */
+PartitionReader::PartitionReader(Reader *reader, const pt_entry_t *pte, size_t cacheSize, bool checkHashes)
+	: m_reader(reader)
+	, m_encrypted(false)
+	, m_checkHashes(checkHashes)
+	, m_lba_len(0)
+	, m_size(0)
+	, m_cacheMax(static_cast<unsigned int>(cacheSize / GROUP_SIZE_DEC))
+	, m_aesw(nullptr)
+	, m_hits(0)
+	, m_misses(0)
+{
+	m_part.reader = reader;
+	m_part.pte = pte;
+	if (m_cacheMax == 0) {
+		m_cacheMax = 1;
+	}
+}
+
+PartitionReader::~PartitionReader()
+{
+	if (m_aesw) {
+		aesw_free(m_aesw);
+	}
+}
+
+/**
+ * Open a Wii partition.
+ * @param reader	[in] Reader (must be valid for the lifetime of the PartitionReader)
+ * @param pte		[in] Partition table entry
+ * @param encrypted	[in] True if the disc image is encrypted.
+ * @param cacheSize	[in,opt] Maximum cache size, in bytes (at least one group is cached)
+ * @param checkHashes	[in,opt] If true, check the hashes of each group when it's loaded. (encrypted only)
+ * @return PartitionReader*, or NULL on error. (errno will be set)
+ */
+PartitionReader *PartitionReader::open(Reader *reader, const pt_entry_t *pte, bool encrypted,
+	size_t cacheSize, bool checkHashes)
+{
+	if (!reader || !pte) {
+		errno = EINVAL;
+		return nullptr;
+	}
+
+	unique_ptr<PartitionReader> ptReader(new PartitionReader(reader, pte, cacheSize, checkHashes && encrypted));
+	const int ret = ptReader->load(encrypted);
+	if (ret != 0) {
+		errno = (ret < 0 ? -ret : EIO);
+		return nullptr;
+	}
+	return ptReader.release();
+}
+
+/**
+ * Load the partition header and set up the group layout.
+ * @param encrypted	[in] True if the disc image is encrypted.
+ * @return 0 on success; negative POSIX error code or RvtH_Errors on error.
+ */
+int PartitionReader::load(bool encrypted)
+{
+	const pt_entry_t *const pte = m_part.pte;
+	unique_ptr<RVL_PartitionHeader> pt_hdr(new RVL_PartitionHeader);
+	m_encrypted = encrypted;
+
+	if (encrypted) {
+		// Load the partition header and H3 table, and decrypt the title key.
+		int ret = rvth_verify_load_partition(pt_hdr.get(), &m_part);
+		if (ret != 0) {
+			return ret;
+		} else if (m_checkHashes && m_part.h4_error) {
+			// The H3 table can't be trusted.
+			return -EIO;
+		}
+
+		// Only use the groups that are actually present.
+		m_lba_len = rvth_verify_groups_lba_len(pte, m_part.lba_data, m_part.group_count);
+		const unsigned int groups_present = (m_lba_len + LBAS_PER_GROUP - 1) / LBAS_PER_GROUP;
+		if (groups_present < m_part.group_count) {
+			m_part.group_count = groups_present;
+		}
+		if (m_part.group_count > 0) {
+			const unsigned int last = m_part.group_count - 1;
+			m_size = (static_cast<uint64_t>(last) * GROUP_SIZE_DEC) + groupSize(last);
+		}
+
+		m_aesw = aesw_new();
+		if (!m_aesw) {
+			int err = errno;
+			if (err == 0) {
+				err = ENOMEM;
+			}
+			return -err;
+		}
+		aesw_set_key(m_aesw, m_part.title_key, sizeof(m_part.title_key));
+		m_encBuf = aligned_uptr<uint8_t>(RefFile::DIRECT_IO_ALIGN, GROUP_SIZE_ENC);
+		if (m_checkHashes) {
+			m_decBuf.reset(new Wii_Disc_Sector_t[64]);
+		}
+		return 0;
+	}
+
+	// Unencrypted partition. The user data is stored as-is,
+	// starting at the data offset.
+	const uint32_t hdr_lba_len = BYTES_TO_LBA(sizeof(RVL_PartitionHeader));
+	if (m_reader->read(pt_hdr.get(), pte->lba_start, hdr_lba_len) != hdr_lba_len) {
+		int err = errno;
+		if (err == 0) {
+			err = EIO;
+		}
+		return -err;
+	}
+
+	const uint64_t data_offset = static_cast<uint64_t>(be32_to_cpu(pt_hdr->data_offset)) << 2;
+	if (data_offset == 0 || data_offset % LBA_SIZE != 0 ||
+	    BYTES_TO_LBA(data_offset) >= pte->lba_len)
+	{
+		// Invalid data offset.
+		return -EIO;
+	}
+	m_part.lba_data = pte->lba_start + static_cast<uint32_t>(BYTES_TO_LBA(data_offset));
+	m_lba_len = pte->lba_len - static_cast<uint32_t>(BYTES_TO_LBA(data_offset));
+
+	m_size = LBA_TO_BYTES(static_cast<uint64_t>(m_lba_len));
+	const uint64_t data_size = static_cast<uint64_t>(be32_to_cpu(pt_hdr->data_size)) << 2;
+	if (data_size != 0 && data_size < m_size) {
+		m_size = data_size;
+	}
+	m_part.group_count = static_cast<unsigned int>((m_size + GROUP_SIZE_DEC - 1) / GROUP_SIZE_DEC);
+	return 0;
+}
+
+/**
+ * Get the size of a group's user data.
+ * @param group	[in] Group number
+ * @return Size, in bytes
+ */
+uint32_t PartitionReader::groupSize(unsigned int group) const
+{
+	assert(group < m_part.group_count);
+
+	if (!m_encrypted) {
+		const uint64_t offset = static_cast<uint64_t>(group) * GROUP_SIZE_DEC;
+		return static_cast<uint32_t>(std::min(m_size - offset, static_cast<uint64_t>(GROUP_SIZE_DEC)));
+	}
+
+	// Incomplete last group. (See read_group() in verify.cpp.)
+	const uint32_t lba_len = std::min(m_lba_len - (group * LBAS_PER_GROUP),
+		static_cast<uint32_t>(LBAS_PER_GROUP));
+	const unsigned int sectors = std::min(m_part.groupSectors(group), lba_len / 64);
+	return sectors * SECTOR_SIZE_DEC;
+}
+
+/**
+ * Read an encrypted group and decrypt its user data.
+ * @param group	[in] Group number
+ * @param out	[out] User data (GROUP_SIZE_DEC)
+ * @return 0 on success; negative POSIX error code on error.
+ */
+int PartitionReader::loadEncrypted(unsigned int group, uint8_t *out)
+{
+	const uint32_t lba_start = m_part.lba_data + (group * LBAS_PER_GROUP);
+	const uint32_t lba_len = std::min(m_lba_len - (group * LBAS_PER_GROUP),
+		static_cast<uint32_t>(LBAS_PER_GROUP));
+	if (m_reader->read(m_encBuf.get(), lba_start, lba_len) != lba_len) {
+		int err = errno;
+		if (err == 0) {
+			err = EIO;
+		}
+		return -err;
+	}
+
+	const Wii_Disc_Sector_t *const gdata_enc = reinterpret_cast<const Wii_Disc_Sector_t*>(m_encBuf.get());
+	const unsigned int sectors = groupSize(group) / SECTOR_SIZE_DEC;
+
+	if (m_checkHashes) {
+		// Decrypt and verify the whole group, then copy the user data.
+		rvth_verify_group(m_aesw, gdata_enc, m_decBuf.get(),
+			m_part.H3_tbl->h3[group], sectors, m_errors);
+		if (!m_errors.empty()) {
+			return -EIO;
+		}
+		for (unsigned int i = 0; i < sectors; i++) {
+			memcpy(&out[i * SECTOR_SIZE_DEC], m_decBuf[i].data, SECTOR_SIZE_DEC);
+		}
+		return 0;
+	}
+
+	// Decrypt only the user data. The hashes aren't needed.
+	// User data IV is stored within the encrypted H2 table.
+	array<AesBatchEntry, 64> batch;
+	for (unsigned int i = 0; i < sectors; i++) {
+		uint8_t *const data = &out[i * SECTOR_SIZE_DEC];
+		memcpy(data, gdata_enc[i].data, SECTOR_SIZE_DEC);
+		batch[i].iv = &gdata_enc[i].hashes.H2[7][4];
+		batch[i].data = data;
+		batch[i].size = SECTOR_SIZE_DEC;
+	}
+	if (sectors > 0) {
+		aesw_decrypt_batch(m_aesw, batch.data(), sectors);
+	}
+	return 0;
+}
+
+/**
+ * Read an unencrypted group.
+ * @param group	[in] Group number
+ * @param out	[out] User data (GROUP_SIZE_DEC)
+ * @return 0 on success; negative POSIX error code on error.
+ */
+int PartitionReader::loadUnencrypted(unsigned int group, uint8_t *out)
+{
+	// NOTE: GROUP_SIZE_DEC is a multiple of the LBA size.
+	const uint32_t lba_start = m_part.lba_data + (group * LBAS_PER_GROUP_DEC);
+	const uint32_t lba_len = static_cast<uint32_t>(BYTES_TO_LBA(groupSize(group) + LBA_SIZE - 1));
+	if (m_reader->read(out, lba_start, lba_len) != lba_len) {
+		int err = errno;
+		if (err == 0) {
+			err = EIO;
+		}
+		return -err;
+	}
+	return 0;
+}
+
+/**
+ * Get a group from the cache, loading it if necessary.
+ * @param group	[in] Group number
+ * @return User data, or nullptr on error. (errno will be set)
+ */
+const uint8_t *PartitionReader::getGroup(unsigned int group)
+{
+	auto iter = m_lruMap.find(group);
+	if (iter != m_lruMap.end()) {
+		// Cache hit. Move the group to the front of the list.
+		m_hits++;
+		m_lru.splice(m_lru.begin(), m_lru, iter->second);
+		return m_lru.front().data.get();
+	}
+
+	// Cache miss. Reuse the least recently used group's
+	// buffer if the cache is full.
+	m_misses++;
+	Group entry;
+	if (m_lru.size() >= m_cacheMax) {
+		entry.data = std::move(m_lru.back().data);
+		m_lruMap.erase(m_lru.back().group);
+		m_lru.pop_back();
+	} else {
+		entry.data.reset(new uint8_t[GROUP_SIZE_DEC]);
+	}
+	entry.group = group;
+
+	const int ret = (m_encrypted
+		? loadEncrypted(group, entry.data.get())
+		: loadUnencrypted(group, entry.data.get()));
+	if (ret != 0) {
+		errno = -ret;
+		return nullptr;
+	}
+
+	m_lru.push_front(std::move(entry));
+	m_lruMap.emplace(group, m_lru.begin());
+	return m_lru.front().data.get();
+}
+
+/**
+ * Read user data from the partition.
+ * @param ptr	[out] Output buffer
+ * @param pos	[in] Starting position, in bytes
+ * @param size	[in] Number of bytes to read
+ * @return Number of bytes read. (If less than size, check errno.)
+ */
+size_t PartitionReader::read(void *ptr, uint64_t pos, size_t size)
+{
+	if (pos >= m_size) {
+		return 0;
+	} else if (size > m_size - pos) {
+		size = static_cast<size_t>(m_size - pos);
+	}
+
+	uint8_t *p = static_cast<uint8_t*>(ptr);
+	size_t total = 0;
+	while (size > 0) {
+		const unsigned int group = static_cast<unsigned int>(pos / GROUP_SIZE_DEC);
+		const uint32_t offset = static_cast<uint32_t>(pos % GROUP_SIZE_DEC);
+		const uint8_t *const data = getGroup(group);
+		if (!data) {
+			// Read error. (errno was set by getGroup().)
+			break;
+		}
+
+		size_t chunk = groupSize(group) - offset;
+		if (chunk > size) {
+			chunk = size;
+		}
+		memcpy(p, &data[offset], chunk);
+		p += chunk;
+		pos += chunk;
+		size -= chunk;
+		total += chunk;
+	}
+	return total;
+}
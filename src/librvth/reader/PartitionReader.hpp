@@ -0,0 +1,185 @@
+/***************************************************************************
+ * RVT-H Tool (librvth)                                                    *
+ * PartitionReader.hpp: Decrypted Wii partition reader.                    *
+ *                                                                         *
+ * Copyright (c) 2026 by David Korth.                                      *
+ * SPDX-License-Identifier: GPL-2.0-or-later                               *
+ ***************************************************************************/
+
+#pragma once
+
+#include "libwiicrypto/common.h"
+#include "aligned_malloc.h"
+#include "verify_group.hpp"
+#include "ptbl.h"
+
+// C includes
+#include <stdint.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+
+// C++ includes
+#include <list>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+class Reader;
+
+/**
+ * Reads the user data of a Wii partition as one logical byte stream,
+ * the way the disc is seen by the game.
+ *
+ * Encrypted partitions are decrypted one 2 MB group at a time, and
+ * the decrypted groups are kept in a size-bounded LRU cache, so small
+ * scattered reads (FST entries, DOL headers) cost at most one group
+ * decryption each. Unencrypted partitions are read in group-sized
+ * blocks and cached the same way.
+ *
+ * If hash checking is enabled, each group is verified with the same
+ * kernel as RvtH::verifyWiiPartitions() when it's loaded, and reads
+ * from a group with hash errors fail with EIO.
+ *
+ * PartitionReader isn't thread-safe, and neither is the Reader
+ * it's layered on.
+ */
+class PartitionReader
+{
+protected:
+	/**
+	 * Create a PartitionReader.
+	 * @param reader	[in] Reader
+	 * @param pte		[in] Partition table entry
+	 * @param cacheSize	[in] Maximum cache size, in bytes
+	 * @param checkHashes	[in] If true, check the hashes of each group when it's loaded.
+	 */
+	PartitionReader(Reader *reader, const pt_entry_t *pte, size_t cacheSize, bool checkHashes);
+
+public:
+	~PartitionReader();
+
+private:
+	DISABLE_COPY(PartitionReader)
+
+public:
+	// Default maximum cache size. (8 groups)
+	static constexpr size_t DEFAULT_CACHE_SIZE = 8 * GROUP_SIZE_DEC;
+
+	/**
+	 * Open a Wii partition.
+	 * @param reader	[in] Reader (must be valid for the lifetime of the PartitionReader)
+	 * @param pte		[in] Partition table entry
+	 * @param encrypted	[in] True if the disc image is encrypted.
+	 * @param cacheSize	[in,opt] Maximum cache size, in bytes (at least one group is cached)
+	 * @param checkHashes	[in,opt] If true, check the hashes of each group when it's loaded. (encrypted only)
+	 * @return PartitionReader*, or NULL on error. (errno will be set)
+	 */
+	static PartitionReader *open(Reader *reader, const pt_entry_t *pte, bool encrypted,
+		size_t cacheSize = DEFAULT_CACHE_SIZE, bool checkHashes = false);
+
+public:
+	/**
+	 * Get the size of the partition's user data.
+	 * @return Size, in bytes
+	 */
+	inline uint64_t size(void) const
+	{
+		return m_size;
+	}
+
+	/**
+	 * Read user data from the partition.
+	 * @param ptr	[out] Output buffer
+	 * @param pos	[in] Starting position, in bytes
+	 * @param size	[in] Number of bytes to read
+	 * @return Number of bytes read. (If less than size, check errno.)
+	 */
+	size_t read(void *ptr, uint64_t pos, size_t size);
+
+	/**
+	 * Get the number of reads from cached groups.
+	 * @return Number of cache hits
+	 */
+	inline unsigned int cacheHits(void) const
+	{
+		return m_hits;
+	}
+
+	/**
+	 * Get the number of groups loaded from the disc image.
+	 * @return Number of cache misses
+	 */
+	inline unsigned int cacheMisses(void) const
+	{
+		return m_misses;
+	}
+
+private:
+	struct Group {
+		unsigned int group;			// Group number
+		std::unique_ptr<uint8_t[]> data;	// User data (GROUP_SIZE_DEC)
+	};
+
+	/**
+	 * Load the partition header and set up the group layout.
+	 * @param encrypted	[in] True if the disc image is encrypted.
+	 * @return 0 on success; negative POSIX error code or RvtH_Errors on error.
+	 */
+	int load(bool encrypted);
+
+	/**
+	 * Get the size of a group's user data.
+	 * @param group	[in] Group number
+	 * @return Size, in bytes
+	 */
+	uint32_t groupSize(unsigned int group) const;
+
+	/**
+	 * Get a group from the cache, loading it if necessary.
+	 * @param group	[in] Group number
+	 * @return User data, or nullptr on error. (errno will be set)
+	 */
+	const uint8_t *getGroup(unsigned int group);
+
+	/**
+	 * Read an encrypted group and decrypt its user data.
+	 * @param group	[in] Group number
+	 * @param out	[out] User data (GROUP_SIZE_DEC)
+	 * @return 0 on success; negative POSIX error code on error.
+	 */
+	int loadEncrypted(unsigned int group, uint8_t *out);
+
+	/**
+	 * Read an unencrypted group.
+	 * @param group	[in] Group number
+	 * @param out	[out] User data (GROUP_SIZE_DEC)
+	 * @return 0 on success; negative POSIX error code on error.
+	 */
+	int loadUnencrypted(unsigned int group, uint8_t *out);
+
+private:
+	Reader *m_reader;
+	VerifyPartition m_part;		// Partition header, title key, and H3 table
+	bool m_encrypted;
+	bool m_checkHashes;
+	uint32_t m_lba_len;		// Number of LBAs of partition data
+	uint64_t m_size;		// Size of the user data
+
+	// LRU cache of groups, most recently used first.
+	std::list<Group> m_lru;
+	std::unordered_map<unsigned int, std::list<Group>::iterator> m_lruMap;
+	unsigned int m_cacheMax;	// Maximum number of cached groups
+
+	// Buffers for loading encrypted groups.
+	aligned_unique_ptr<uint8_t> m_encBuf;		// 2 MB, encrypted group
+	std::unique_ptr<Wii_Disc_Sector_t[]> m_decBuf;	// 2 MB, decrypted group (hash checking only)
+	std::vector<VerifyError> m_errors;
+	AesCtx *m_aesw;
+
+	// Statistics
+	unsigned int m_hits;
+	unsigned int m_misses;
+};
+
+#endif /* __cplusplus */
@@ -3,7 +3,7 @@
  * PlainReader.cpp: Plain disc image reader class.                         *
  * Used for plain binary disc images, e.g. .gcm and RVT-H images.          *
  *                                                                         *
- * Copyright (c) 2018-2025 by David Korth.                                 *
+ * Copyright (c) 2018-2026 by David Korth.                                 *
  * SPDX-License-Identifier: GPL-2.0-or-later                               *
  ***************************************************************************/
 
@@ -103,18 +103,28 @@ uint32_t PlainReader::read(void *ptr, uint32_t lba_start, uint32_t lba_len)
 		return 0;
 	}
 
-	// Seek to lba_start.
-	int ret = m_file->seeko(LBA_TO_BYTES(lba_start), SEEK_SET);
-	if (ret != 0) {
-		// Seek error.
-		if (errno == 0) {
-			errno = EIO;
-		}
-		return 0;
+	// Read the data.
+	const size_t size = m_file->pread(ptr, LBA_TO_BYTES(lba_len), LBA_TO_BYTES(lba_start));
+	if (size != LBA_TO_BYTES(lba_len) && errno == 0) {
+		// Short read.
+		errno = EIO;
 	}
+	return static_cast<uint32_t>(size / LBA_SIZE);
+}
 
-	// Read the data.
-	return static_cast<uint32_t>(m_file->read(ptr, LBA_SIZE, lba_len));
+/**
+ * Map a range of LBAs to a location in the underlying file.
+ * @param lba_start	[in] Starting LBA.
+ * @param lba_len	[in] Length, in LBAs.
+ * @param pPhysOffset	[out] Byte offset in the file, or -1 if the run is empty.
+ * @return Number of LBAs in the run (at most lba_len).
+ */
+uint32_t PlainReader::mapRun(uint32_t lba_start, uint32_t lba_len, off64_t *pPhysOffset) const
+{
+	// Plain images are stored contiguously.
+	assert(lba_start + lba_len <= m_lba_len);
+	*pPhysOffset = LBA_TO_BYTES(m_lba_start + lba_start);
+	return lba_len;
 }
 
 /**
@@ -137,16 +147,11 @@ uint32_t PlainReader::write(const void *ptr, uint32_t lba_start, uint32_t lba_le
 		return 0;
 	}
 
-	// Seek to lba_start.
-	int ret = m_file->seeko(LBA_TO_BYTES(lba_start), SEEK_SET);
-	if (ret != 0) {
-		// Seek error.
-		if (errno == 0) {
-			errno = EIO;
-		}
-		return 0;
-	}
-
 	// Write the data.
-	return static_cast<uint32_t>(m_file->write(ptr, LBA_SIZE, lba_len));
+	const size_t size = m_file->pwrite(ptr, LBA_TO_BYTES(lba_len), LBA_TO_BYTES(lba_start));
+	if (size != LBA_TO_BYTES(lba_len) && errno == 0) {
+		// Short write.
+		errno = EIO;
+	}
+	return static_cast<uint32_t>(size / LBA_SIZE);
 }
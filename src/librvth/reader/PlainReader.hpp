@@ -3,7 +3,7 @@
  * PlainReader.hpp: Plain disc image reader class.                         *
  * Used for plain binary disc images, e.g. .gcm and RVT-H images.          *
  *                                                                         *
- * Copyright (c) 2018-2025 by David Korth.                                 *
+ * Copyright (c) 2018-2026 by David Korth.                                 *
  * SPDX-License-Identifier: GPL-2.0-or-later                               *
  ***************************************************************************/
 
@@ -42,6 +42,15 @@ public:
 	 */
 	uint32_t read(void *ptr, uint32_t lba_start, uint32_t lba_len) final;
 
+	/**
+	 * Map a range of LBAs to a location in the underlying file.
+	 * @param lba_start	[in] Starting LBA.
+	 * @param lba_len	[in] Length, in LBAs.
+	 * @param pPhysOffset	[out] Byte offset in the file, or -1 if the run is empty.
+	 * @return Number of LBAs in the run (at most lba_len).
+	 */
+	uint32_t mapRun(uint32_t lba_start, uint32_t lba_len, off64_t *pPhysOffset) const final;
+
 	/**
 	 * Write data to the disc image.
 	 * @param ptr		[in] Write buffer.
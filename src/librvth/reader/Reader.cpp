@@ -2,7 +2,7 @@
  * RVT-H Tool (librvth)                                                    *
  * Reader.cpp: Disc image reader base class.                               *
  *                                                                         *
- * Copyright (c) 2018-2025 by David Korth.                                 *
+ * Copyright (c) 2018-2026 by David Korth.                                 *
  * SPDX-License-Identifier: GPL-2.0-or-later                               *
  ***************************************************************************/
 
@@ -10,6 +10,7 @@
 #include "PlainReader.hpp"
 #include "CisoReader.hpp"
 #include "WbfsReader.hpp"
+#include "MmapReader.hpp"
 
 // For LBA_TO_BYTES()
 #include "nhcd_structs.h"
@@ -83,16 +84,8 @@ Reader *Reader::open(const RefFilePtr &file, uint32_t lba_start, uint32_t lba_le
 
 	// Check for other disc image formats.
 	uint8_t sbuf[4096];
-	int ret = file->seeko(LBA_TO_BYTES(lba_start), SEEK_SET);
-	if (ret != 0) {
-		// Seek error.
-		if (errno == 0) {
-			errno = EIO;
-		}
-		return nullptr;
-	}
 	errno = 0;
-	size_t size = file->read(sbuf, 1, sizeof(sbuf));
+	size_t size = file->pread(sbuf, sizeof(sbuf), LBA_TO_BYTES(lba_start));
 	if (size != sizeof(sbuf)) {
 		// Short read. May be empty.
 		if (errno != 0) {
@@ -101,11 +94,10 @@ Reader *Reader::open(const RefFilePtr &file, uint32_t lba_start, uint32_t lba_le
 		} else {
 			// Assume it's a new file.
 			// Use the plain disc image reader.
-			file->rewind();
+			// NOTE: The file can't be memory-mapped until it has data.
 			return new PlainReader(file, lba_start, lba_len);
 		}
 	}
-	file->rewind();
 
 	// Check the magic number.
 	if (CisoReader::isSupported(sbuf, sizeof(sbuf))) {
@@ -135,6 +127,10 @@ Reader *Reader::open(const RefFilePtr &file, uint32_t lba_start, uint32_t lba_le
 	}
 
 	// Use the plain disc image reader.
+	if (MmapReader::isSupported()) {
+		// Memory-mapped version for disc image files.
+		return new MmapReader(file, lba_start, lba_len);
+	}
 	return new PlainReader(file, lba_start, lba_len);
 }
 
@@ -161,6 +157,46 @@ uint32_t Reader::write(const void *ptr, uint32_t lba_start, uint32_t lba_len)
 	return 0;
 }
 
+/**
+ * Map a range of LBAs to a location in the underlying file.
+ *
+ * This finds the longest run starting at lba_start that is either
+ * stored contiguously in the file or is entirely empty (zeroes).
+ * It's used for asynchronous I/O, which doesn't go through read().
+ *
+ * The default implementation doesn't support mapping.
+ *
+ * @param lba_start	[in] Starting LBA.
+ * @param lba_len	[in] Length, in LBAs.
+ * @param pPhysOffset	[out] Byte offset in the file, or -1 if the run is empty.
+ * @return Number of LBAs in the run (at most lba_len), or 0 if mapping isn't supported.
+ */
+uint32_t Reader::mapRun(uint32_t lba_start, uint32_t lba_len, off64_t *pPhysOffset) const
+{
+	UNUSED(lba_start);
+	UNUSED(lba_len);
+	UNUSED(pPhysOffset);
+	return 0;
+}
+
+/**
+ * Get a pointer to the disc image data without copying it.
+ *
+ * The default implementation doesn't support mapping.
+ *
+ * @param lba_start	[in] Starting LBA.
+ * @param lba_len	[in] Length, in LBAs.
+ * @param sequential	[in] If true, the data will be accessed sequentially. (bulk scans)
+ * @return Pointer to the data, or nullptr if mapping isn't supported.
+ */
+uint8_t *Reader::map(uint32_t lba_start, uint32_t lba_len, bool sequential)
+{
+	UNUSED(lba_start);
+	UNUSED(lba_len);
+	UNUSED(sequential);
+	return nullptr;
+}
+
 /**
  * Flush the file buffers.
  */
@@ -168,3 +204,32 @@ void Reader::flush(void)
 {
 	m_file->flush();
 }
+
+/**
+ * Drop a range of the disc image from the OS page cache,
+ * so the next read comes from the device.
+ * Written data must be flushed first.
+ * @param lba_start	[in] Starting LBA.
+ * @param lba_len	[in] Length, in LBAs.
+ * @return 0 on success; negative POSIX error code on error.
+ */
+int Reader::dropCache(uint32_t lba_start, uint32_t lba_len)
+{
+	while (lba_len > 0) {
+		off64_t physOffset;
+		const uint32_t run = mapRun(lba_start, lba_len, &physOffset);
+		if (run == 0) {
+			// Mapping isn't supported.
+			return -ENOTSUP;
+		}
+		if (physOffset >= 0) {
+			const int ret = m_file->dropCache(physOffset, LBA_TO_BYTES(static_cast<off64_t>(run)));
+			if (ret != 0) {
+				return ret;
+			}
+		}
+		lba_start += run;
+		lba_len -= run;
+	}
+	return 0;
+}
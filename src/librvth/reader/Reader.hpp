@@ -2,7 +2,7 @@
  * RVT-H Tool (librvth)                                                    *
  * Reader.hpp: Disc image reader base class.                               *
  *                                                                         *
- * Copyright (c) 2018-2025 by David Korth.                                 *
+ * Copyright (c) 2018-2026 by David Korth.                                 *
  * SPDX-License-Identifier: GPL-2.0-or-later                               *
  ***************************************************************************/
 
@@ -63,9 +63,9 @@ public:
 public:
 	/** I/O functions **/
 
-	// TODO: lba_start param, or separate seek()?
-	// Regardless, we have to seek on each read because another
-	// disc image may have altered the file pointer.
+	// NOTE: Readers use RefFile's positional I/O functions,
+	// so multiple Readers (e.g. different banks on the same
+	// RVT-H Reader) can read from the same RefFile at once.
 
 	/**
 	 * Read data from the disc image.
@@ -85,10 +85,71 @@ public:
 	 */
 	virtual uint32_t write(const void *ptr, uint32_t lba_start, uint32_t lba_len);
 
+	/**
+	 * Map a range of LBAs to a location in the underlying file.
+	 *
+	 * This finds the longest run starting at lba_start that is either
+	 * stored contiguously in the file or is entirely empty (zeroes).
+	 * It's used for asynchronous I/O, which doesn't go through read().
+	 *
+	 * The default implementation doesn't support mapping.
+	 *
+	 * @param lba_start	[in] Starting LBA.
+	 * @param lba_len	[in] Length, in LBAs.
+	 * @param pPhysOffset	[out] Byte offset in the file, or -1 if the run is empty.
+	 * @return Number of LBAs in the run (at most lba_len), or 0 if mapping isn't supported.
+	 */
+	virtual uint32_t mapRun(uint32_t lba_start, uint32_t lba_len, off64_t *pPhysOffset) const;
+
+	/**
+	 * Get a pointer to the disc image data without copying it.
+	 *
+	 * The pointer remains valid until the Reader is deleted.
+	 * The data may be modified, but changes are not written
+	 * back to the disc image.
+	 *
+	 * The default implementation doesn't support mapping.
+	 * If nullptr is returned, use read() instead.
+	 *
+	 * @param lba_start	[in] Starting LBA.
+	 * @param lba_len	[in] Length, in LBAs.
+	 * @param sequential	[in] If true, the data will be accessed sequentially. (bulk scans)
+	 * @return Pointer to the data, or nullptr if mapping isn't supported.
+	 */
+	virtual uint8_t *map(uint32_t lba_start, uint32_t lba_len, bool sequential = false);
+
+	/**
+	 * Get the underlying file.
+	 * @return RefFile
+	 */
+	inline const RefFilePtr &file(void) const { return m_file; }
+
 	/**
 	 * Flush the file buffers.
+	 * Subclasses that keep metadata in memory write it here.
+	 */
+	virtual void flush(void);
+
+	/**
+	 * Drop a range of the disc image from the OS page cache,
+	 * so the next read comes from the device.
+	 * Written data must be flushed first.
+	 * @param lba_start	[in] Starting LBA.
+	 * @param lba_len	[in] Length, in LBAs.
+	 * @return 0 on success; negative POSIX error code on error.
+	 */
+	int dropCache(uint32_t lba_start, uint32_t lba_len);
+
+	/**
+	 * Is this a compact disc image format?
+	 *
+	 * Compact formats only store blocks that contain data, and
+	 * writable compact images allocate blocks as they're written.
+	 * The file must not be preallocated or made sparse.
+	 *
+	 * @return True if compact; false if not.
 	 */
-	void flush(void);
+	virtual bool isCompact(void) const { return false; }
 
 public:
 	/** Accessors **/
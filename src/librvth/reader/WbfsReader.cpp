@@ -2,7 +2,7 @@
  * RVT-H Tool (librvth)                                                    *
  * WbfsReader.cpp: WBFS disc image reader class.                           *
  *                                                                         *
- * Copyright (c) 2018-2025 by David Korth.                                 *
+ * Copyright (c) 2018-2026 by David Korth.                                 *
  * SPDX-License-Identifier: GPL-2.0-or-later                               *
  ***************************************************************************/
 
@@ -100,12 +100,7 @@ static wbfs_t *readWbfsHeader(RefFile *file, uint32_t lba_start)
 	}
 
 	// Read the WBFS header.
-	ret = file->seeko(LBA_TO_BYTES(lba_start), SEEK_SET);
-	if (ret != 0) {
-		// Seek error.
-		goto end;
-	}
-	size = file->read(head, 1, hd_sec_sz);
+	size = file->pread(head, hd_sec_sz, LBA_TO_BYTES(lba_start));
 	if (size != hd_sec_sz) {
 		// Read error.
 		ret = -1;
@@ -144,12 +139,7 @@ static wbfs_t *readWbfsHeader(RefFile *file, uint32_t lba_start)
 		}
 
 		// Re-read the WBFS header.
-		ret = file->seeko(LBA_TO_BYTES(lba_start), SEEK_SET);
-		if (ret != 0) {
-			// Seek error.
-			goto end;
-		}
-		size = file->read(head, 1, hd_sec_sz);
+		size = file->pread(head, hd_sec_sz, LBA_TO_BYTES(lba_start));
 		if (size != hd_sec_sz) {
 			// Read error.
 			ret = -1;
@@ -184,6 +174,9 @@ static wbfs_t *readWbfsHeader(RefFile *file, uint32_t lba_start)
 
 	p->n_disc_open = 0;
 
+	// WBFS header read successfully.
+	ret = 0;
+
 end:
 	if (ret != 0) {
 		// Error...
@@ -232,7 +225,6 @@ static wbfs_disc_t *openWbfsDisc(RefFile *file, uint32_t lba_start, wbfs_t *p, u
 		if (head->disc_table[i]) {
 			if (count++ == index) {
 				// Found the disc table index.
-				int ret;
 				size_t size;
 
 				wbfs_disc_t *disc = (wbfs_disc_t*)malloc(sizeof(wbfs_disc_t));
@@ -251,13 +243,8 @@ static wbfs_disc_t *openWbfsDisc(RefFile *file, uint32_t lba_start, wbfs_t *p, u
 					return nullptr;
 				}
 
-				ret = file->seeko(LBA_TO_BYTES(lba_start) + p->hd_sec_sz + (i*p->disc_info_sz), SEEK_SET);
-				if (ret != 0) {
-					// Seek error.
-					free(disc);
-					return nullptr;
-				}
-				size = file->read(disc->header, 1, p->disc_info_sz);
+				size = file->pread(disc->header, p->disc_info_sz,
+					LBA_TO_BYTES(lba_start) + p->hd_sec_sz + (i*p->disc_info_sz));
 				if (size != p->disc_info_sz) {
 					// Error reading the disc information.
 					free(disc->header);
@@ -339,6 +326,9 @@ WbfsReader::WbfsReader(const RefFilePtr &file, uint32_t lba_start, uint32_t lba_
 	, m_wbfs(nullptr)
 	, m_wbfs_disc(nullptr)
 	, m_wlba_table(nullptr)
+	, m_physBlockCount(0)
+	, m_writable(false)
+	, m_dirty(false)
 {
 	int err = 0;
 
@@ -416,6 +406,11 @@ fail:
 
 WbfsReader::~WbfsReader()
 {
+	if (m_dirty && isOpen()) {
+		// Write the updated WBFS header.
+		writeHeader();
+	}
+
 	// Free the WBFS structs.
 	if (m_wbfs_disc) {
 		closeWbfsDisc(m_wbfs_disc);
@@ -427,6 +422,88 @@ WbfsReader::~WbfsReader()
 	// Superclass will unreference the file.
 }
 
+/**
+ * Create a new, writable WBFS disc image.
+ *
+ * A WBFS header with a single blank disc is written to the file,
+ * and blocks are allocated as they're written. The header is
+ * updated by flush() and when the reader is deleted.
+ *
+ * NOTE: Writing is not thread-safe.
+ *
+ * @param file		RefFile (must be empty)
+ * @param lba_start	[in] Starting LBA
+ * @param lba_len	[in] Virtual image size, in LBAs
+ * @return WbfsReader*, or NULL on error.
+ */
+WbfsReader *WbfsReader::create(const RefFilePtr &file, uint32_t lba_start, uint32_t lba_len)
+{
+	assert((bool)file);
+	assert(lba_len != 0);
+	if (!file || lba_len == 0) {
+		// Invalid parameters.
+		errno = EINVAL;
+		return nullptr;
+	}
+
+	// 512-byte HDD sectors and 2 MB WBFS sectors.
+	// Physical block 0 contains the WBFS header and disc information.
+	static const uint8_t hd_sec_sz_s = 9;
+	static const uint8_t wbfs_sec_sz_s = 21;
+	static const unsigned int hd_sec_sz = (1U << hd_sec_sz_s);
+	static const unsigned int n_wbfs_sec_per_disc = (143432*2) >> (wbfs_sec_sz_s - 15);
+	static const unsigned int disc_info_sz =
+		(sizeof(wbfs_disc_info_t) + (n_wbfs_sec_per_disc * sizeof(be16_t)) + hd_sec_sz - 1) & ~(hd_sec_sz - 1);
+	const uint32_t block_size_lba = BYTES_TO_LBA(1U << wbfs_sec_sz_s);
+	if ((lba_len + block_size_lba - 1) / block_size_lba > n_wbfs_sec_per_disc) {
+		// Image is too big for the WBFS block table.
+		errno = EFBIG;
+		return nullptr;
+	}
+
+	// Write a WBFS header with a single blank disc.
+	// NOTE: n_hd_sec is updated by writeHeader().
+	uint8_t *const header = static_cast<uint8_t*>(calloc(1, hd_sec_sz + disc_info_sz));
+	if (!header) {
+		errno = ENOMEM;
+		return nullptr;
+	}
+	wbfs_head_t *const head = reinterpret_cast<wbfs_head_t*>(header);
+	memcpy(&head->magic, WBFS_MAGIC.data(), WBFS_MAGIC.size());
+	head->n_hd_sec = cpu_to_be32(BYTES_TO_LBA(1U << wbfs_sec_sz_s));
+	head->hd_sec_sz_s = hd_sec_sz_s;
+	head->wbfs_sec_sz_s = wbfs_sec_sz_s;
+	head->disc_table[0] = 1;
+
+	errno = 0;
+	size_t size = file->pwrite(header, hd_sec_sz + disc_info_sz, LBA_TO_BYTES(lba_start));
+	free(header);
+	if (size != hd_sec_sz + disc_info_sz) {
+		// Write error.
+		if (errno == 0) {
+			errno = EIO;
+		}
+		return nullptr;
+	}
+
+	// Open the blank image, then set the virtual image size.
+	WbfsReader *const reader = new WbfsReader(file, lba_start, block_size_lba);
+	if (!reader->isOpen()) {
+		// Error opening the WBFS image.
+		int err = errno;
+		if (err == 0) {
+			err = EIO;
+		}
+		delete reader;
+		errno = err;
+		return nullptr;
+	}
+	reader->m_lba_len = lba_len;
+	reader->m_physBlockCount = 1;
+	reader->m_writable = true;
+	return reader;
+}
+
 /**
  * Read data from a disc image.
  * @param ptr		[out] Read buffer.
@@ -451,39 +528,212 @@ uint32_t WbfsReader::read(void *ptr, uint32_t lba_start, uint32_t lba_len)
 		return 0;
 	}
 
-	// TODO: Optimize reading multiple LBAs at once.
-	// For now, we're looking up a single LBA at a time.
+	// Process the request as runs of blocks that are either all empty
+	// or physically contiguous in the WBFS image. Each run is handled
+	// with a single memset() or a single read.
 	uint8_t *ptr8 = static_cast<uint8_t*>(ptr);
-	uint32_t lba_end = lba_start + lba_len;
-	for (uint32_t lba = lba_start; lba < lba_end; lba++, ptr8 += LBA_SIZE) {
-		unsigned int physBlockIdx = be16_to_cpu(m_wlba_table[lba / m_block_size_lba]);
-		if (physBlockIdx == 0) {
-			// Empty block.
-			memset(ptr8, 0, LBA_SIZE);
+	const uint32_t lba_end = lba_start + lba_len;
+	uint32_t lba = lba_start;
+	while (lba < lba_end) {
+		off64_t physOffset;
+		const uint32_t run_len = mapRun(lba, lba_end - lba, &physOffset);
+
+		if (physOffset < 0) {
+			// Empty blocks.
+			memset(ptr8, 0, LBA_TO_BYTES(run_len));
 		} else {
-			// Determine the offset.
-			const unsigned int blockStart = physBlockIdx * m_block_size_lba;
-			const unsigned int offset = lba % m_block_size_lba;
-
-			int ret = m_file->seeko(LBA_TO_BYTES(blockStart + offset + m_lba_start), SEEK_SET);
-			if (ret != 0) {
-				// Seek error.
-				if (errno == 0) {
-					errno = EIO;
-				}
-				return 0;
-			}
-			size_t size = m_file->read(ptr8, LBA_SIZE, 1);
-			if (size != 1) {
+			size_t size = m_file->pread(ptr8, LBA_TO_BYTES(run_len), physOffset);
+			if (size != LBA_TO_BYTES(run_len)) {
 				// Read error.
 				if (errno == 0) {
 					errno = EIO;
 				}
 				return 0;
 			}
-			lbas_read++;
+			lbas_read += run_len;
 		}
+
+		ptr8 += LBA_TO_BYTES(run_len);
+		lba += run_len;
 	}
 
 	return lbas_read;
 }
+
+/**
+ * Map a range of LBAs to a location in the underlying file.
+ * @param lba_start	[in] Starting LBA.
+ * @param lba_len	[in] Length, in LBAs.
+ * @param pPhysOffset	[out] Byte offset in the file, or -1 if the run is empty.
+ * @return Number of LBAs in the run (at most lba_len).
+ */
+uint32_t WbfsReader::mapRun(uint32_t lba_start, uint32_t lba_len, off64_t *pPhysOffset) const
+{
+	assert(lba_start + lba_len <= m_lba_len);
+	const uint32_t lba_end = lba_start + lba_len;
+	const unsigned int firstBlockIdx = lba_start / m_block_size_lba;
+	const unsigned int firstPhysBlockIdx = be16_to_cpu(m_wlba_table[firstBlockIdx]);
+
+	// Extend the run while the blocks are either all empty
+	// or physically contiguous.
+	unsigned int blockIdx = firstBlockIdx + 1;
+	uint32_t run_end = blockIdx * m_block_size_lba;
+	for (; run_end < lba_end; blockIdx++, run_end += m_block_size_lba) {
+		const unsigned int physBlockIdx = be16_to_cpu(m_wlba_table[blockIdx]);
+		if (firstPhysBlockIdx == 0) {
+			if (physBlockIdx != 0)
+				break;
+		} else if (physBlockIdx == 0 ||
+		           physBlockIdx != firstPhysBlockIdx + (blockIdx - firstBlockIdx))
+		{
+			break;
+		}
+	}
+	if (run_end > lba_end) {
+		run_end = lba_end;
+	}
+
+	if (firstPhysBlockIdx == 0) {
+		// Empty blocks.
+		*pPhysOffset = -1;
+	} else {
+		// Determine the offset.
+		const unsigned int blockStart = firstPhysBlockIdx * m_block_size_lba;
+		const unsigned int offset = lba_start % m_block_size_lba;
+		*pPhysOffset = LBA_TO_BYTES(blockStart + offset + m_lba_start);
+	}
+	return run_end - lba_start;
+}
+
+/**
+ * Write data to the disc image.
+ * Only supported for images opened with create().
+ * @param ptr		[in] Write buffer.
+ * @param lba_start	[in] Starting LBA.
+ * @param lba_len	[in] Length, in LBAs.
+ * @return Number of LBAs written, or 0 on error.
+ */
+uint32_t WbfsReader::write(const void *ptr, uint32_t lba_start, uint32_t lba_len)
+{
+	if (!m_writable) {
+		// Existing WBFS images are read-only.
+		errno = EROFS;
+		return 0;
+	}
+
+	// LBA bounds checking.
+	// TODO: Check for overflow?
+	assert(lba_start + lba_len <= m_lba_len);
+	if (lba_len == 0 || lba_start + lba_len > m_lba_len) {
+		// Out of range.
+		errno = EIO;
+		return 0;
+	}
+
+	// Allocate physical blocks for any empty blocks in the range.
+	// Blocks are allocated in the order they're written.
+	const unsigned int lastBlockIdx = (lba_start + lba_len - 1) / m_block_size_lba;
+	for (unsigned int blockIdx = lba_start / m_block_size_lba; blockIdx <= lastBlockIdx; blockIdx++) {
+		if (m_wlba_table[blockIdx] != cpu_to_be16(0))
+			continue;
+
+		if (m_physBlockCount >= 0xFFFF) {
+			// No more physical blocks.
+			errno = ENOSPC;
+			return 0;
+		}
+
+		// Write the last LBA so the file covers the entire block,
+		// since the block might only be partially written.
+		static const uint8_t zero_lba[LBA_SIZE] = {0};
+		const off64_t lastLbaOffset = LBA_TO_BYTES(m_lba_start +
+			((m_physBlockCount + 1) * m_block_size_lba) - 1);
+		errno = 0;
+		if (m_file->pwrite(zero_lba, sizeof(zero_lba), lastLbaOffset) != sizeof(zero_lba)) {
+			if (errno == 0) {
+				errno = EIO;
+			}
+			return 0;
+		}
+
+		m_wlba_table[blockIdx] = cpu_to_be16(static_cast<uint16_t>(m_physBlockCount));
+		m_physBlockCount++;
+		m_dirty = true;
+	}
+
+	if (lba_start == 0) {
+		// Update the disc header copy.
+		memcpy(m_wbfs_disc->header->disc_header_copy, ptr,
+			sizeof(m_wbfs_disc->header->disc_header_copy));
+		m_dirty = true;
+	}
+
+	// Write the data as runs of physically contiguous blocks.
+	uint32_t lbas_written = 0;
+	const uint8_t *ptr8 = static_cast<const uint8_t*>(ptr);
+	const uint32_t lba_end = lba_start + lba_len;
+	uint32_t lba = lba_start;
+	while (lba < lba_end) {
+		off64_t physOffset;
+		const uint32_t run_len = mapRun(lba, lba_end - lba, &physOffset);
+		assert(physOffset >= 0);
+
+		errno = 0;
+		size_t size = m_file->pwrite(ptr8, LBA_TO_BYTES(run_len), physOffset);
+		if (size != LBA_TO_BYTES(run_len)) {
+			// Short write.
+			if (errno == 0) {
+				errno = EIO;
+			}
+			return lbas_written + static_cast<uint32_t>(size / LBA_SIZE);
+		}
+		lbas_written += run_len;
+
+		ptr8 += LBA_TO_BYTES(run_len);
+		lba += run_len;
+	}
+
+	return lbas_written;
+}
+
+/**
+ * Flush the file buffers.
+ * If the block table was modified, the WBFS header is written.
+ */
+void WbfsReader::flush(void)
+{
+	if (m_dirty) {
+		writeHeader();
+	}
+	super::flush();
+}
+
+/**
+ * Write the WBFS header and disc information.
+ * @return 0 on success; non-zero on error. (errno is set)
+ */
+int WbfsReader::writeHeader(void)
+{
+	// NOTE: The free blocks table is left as all zeroes,
+	// which indicates that there are no free blocks.
+	// This is fine for a single-disc WBFS image file.
+	const wbfs_t *const p = m_wbfs;
+	p->head->n_hd_sec = cpu_to_be32(m_physBlockCount * m_block_size_lba);
+
+	errno = 0;
+	size_t size = m_file->pwrite(p->head, p->hd_sec_sz, LBA_TO_BYTES(m_lba_start));
+	if (size == p->hd_sec_sz) {
+		size = m_file->pwrite(m_wbfs_disc->header, p->disc_info_sz,
+			LBA_TO_BYTES(m_lba_start) + p->hd_sec_sz + (m_wbfs_disc->i * p->disc_info_sz));
+		if (size == p->disc_info_sz) {
+			m_dirty = false;
+			return 0;
+		}
+	}
+
+	// Write error.
+	if (errno == 0) {
+		errno = EIO;
+	}
+	return -1;
+}
@@ -2,7 +2,7 @@
  * RVT-H Tool (librvth)                                                    *
  * WbfsReader.hpp: WBFS disc image reader class.                           *
  *                                                                         *
- * Copyright (c) 2018-2025 by David Korth.                                 *
+ * Copyright (c) 2018-2026 by David Korth.                                 *
  * SPDX-License-Identifier: GPL-2.0-or-later                               *
  ***************************************************************************/
 
@@ -34,6 +34,22 @@ public:
 
 	virtual ~WbfsReader();
 
+	/**
+	 * Create a new, writable WBFS disc image.
+	 *
+	 * A WBFS header with a single blank disc is written to the file,
+	 * and blocks are allocated as they're written. The header is
+	 * updated by flush() and when the reader is deleted.
+	 *
+	 * NOTE: Writing is not thread-safe.
+	 *
+	 * @param file		RefFile (must be empty)
+	 * @param lba_start	[in] Starting LBA
+	 * @param lba_len	[in] Virtual image size, in LBAs
+	 * @return WbfsReader*, or NULL on error.
+	 */
+	static WbfsReader *create(const RefFilePtr &file, uint32_t lba_start, uint32_t lba_len);
+
 private:
 	typedef Reader super;
 	DISABLE_COPY(WbfsReader);
@@ -59,6 +75,44 @@ public:
 	 */
 	uint32_t read(void *ptr, uint32_t lba_start, uint32_t lba_len) final;
 
+	/**
+	 * Write data to the disc image.
+	 * Only supported for images opened with create().
+	 * @param ptr		[in] Write buffer.
+	 * @param lba_start	[in] Starting LBA.
+	 * @param lba_len	[in] Length, in LBAs.
+	 * @return Number of LBAs written, or 0 on error.
+	 */
+	uint32_t write(const void *ptr, uint32_t lba_start, uint32_t lba_len) final;
+
+	/**
+	 * Map a range of LBAs to a location in the underlying file.
+	 * @param lba_start	[in] Starting LBA.
+	 * @param lba_len	[in] Length, in LBAs.
+	 * @param pPhysOffset	[out] Byte offset in the file, or -1 if the run is empty.
+	 * @return Number of LBAs in the run (at most lba_len).
+	 */
+	uint32_t mapRun(uint32_t lba_start, uint32_t lba_len, off64_t *pPhysOffset) const final;
+
+	/**
+	 * Flush the file buffers.
+	 * If the block table was modified, the WBFS header is written.
+	 */
+	void flush(void) final;
+
+	/**
+	 * Is this a compact disc image format?
+	 * @return True if compact; false if not.
+	 */
+	bool isCompact(void) const final { return true; }
+
+private:
+	/**
+	 * Write the WBFS header and disc information.
+	 * @return 0 on success; non-zero on error. (errno is set)
+	 */
+	int writeHeader(void);
+
 private:
 	// NOTE: reader.lba_len is the virtual image size.
 	// real_lba_len is the actual image size.
@@ -71,5 +125,11 @@ private:
 	wbfs_t *m_wbfs;			// WBFS image.
 	wbfs_disc_t *m_wbfs_disc;	// Current disc.
 
-	const be16_t *m_wlba_table;	// Pointer to m_wbfs_disc->disc->header->wlba_table.
+	be16_t *m_wlba_table;		// Pointer to m_wbfs_disc->disc->header->wlba_table.
+
+	// Number of physical blocks, including the header block.
+	unsigned int m_physBlockCount;
+
+	bool m_writable;	// Opened with create()
+	bool m_dirty;		// Block table was modified
 };
@@ -2,7 +2,7 @@
  * RVT-H Tool (librvth)                                                    *
  * recrypt.cpp: RVT-H "recryption" functions.                              *
  *                                                                         *
- * Copyright (c) 2018-2025 by David Korth.                                 *
+ * Copyright (c) 2018-2026 by David Korth.                                 *
  * SPDX-License-Identifier: GPL-2.0-or-later                               *
  ***************************************************************************/
 
@@ -161,7 +161,7 @@ int RvtHPrivate::recryptID(unsigned int bank)
 	}
 
 	// Check the bank type.
-	RvtH_BankEntry *const entry = &entries[bank];
+	RvtH_BankEntry *const entry = bankEntry(bank);
 	bool is_wii;
 	switch (entry->type) {
 		case RVTH_BankType_GCN:
@@ -367,7 +367,7 @@ int RvtH::recryptWiiPartitions(unsigned int bank,
 	}
 
 	// Check the bank type.
-	RvtH_BankEntry *const entry = &d_ptr->entries[bank];
+	RvtH_BankEntry *const entry = d_ptr->bankEntry(bank);
 	switch (entry->type) {
 		case RVTH_BankType_Wii_SL:
 		case RVTH_BankType_Wii_DL:
@@ -2,7 +2,7 @@
  * RVT-H Tool (librvth)                                                    *
  * rvth.cpp: RVT-H image handler.                                          *
  *                                                                         *
- * Copyright (c) 2018-2025 by David Korth.                                 *
+ * Copyright (c) 2018-2026 by David Korth.                                 *
  * SPDX-License-Identifier: GPL-2.0-or-later                               *
  ***************************************************************************/
 
@@ -15,6 +15,7 @@
 #include "ptbl.h"
 #include "bank_init.h"
 #include "reader/Reader.hpp"
+#include "reader/PartitionReader.hpp"
 
 #include "libwiicrypto/byteswap.h"
 #include "libwiicrypto/cert.h"
@@ -159,5 +160,155 @@ const RvtH_BankEntry *RvtH::bankEntry(unsigned int bank, int *pErr) const
 		return nullptr;
 	}
 
-	return &d_ptr->entries[bank];
+	return d_ptr->bankEntry(bank);
+}
+
+/**
+ * Open the game partition of a Wii bank for reading decrypted data.
+ *
+ * The PartitionReader uses the bank's Reader, so it must be deleted
+ * before the RvtH object, and neither of them may be used by
+ * multiple threads at the same time.
+ *
+ * @param bank	[in] Bank number. (0-7)
+ * @param pErr	[out,opt] Error code. (If negative, POSIX error; otherwise, see RvtH_Errors.)
+ * @return PartitionReader*, or nullptr on error. (Caller must delete it.)
+ */
+PartitionReader *RvtH::openGamePartition(unsigned int bank, int *pErr)
+{
+	if (bank >= bankCount()) {
+		errno = ERANGE;
+		if (pErr) {
+			*pErr = -ERANGE;
+		}
+		return nullptr;
+	}
+
+	RvtH_BankEntry *const entry = d_ptr->bankEntry(bank);
+	int err = 0;
+	switch (entry->type) {
+		case RVTH_BankType_Wii_SL:
+		case RVTH_BankType_Wii_DL:
+			break;
+		case RVTH_BankType_Empty:
+			err = RVTH_ERROR_BANK_EMPTY;
+			break;
+		case RVTH_BankType_GCN:
+			err = RVTH_ERROR_NOT_WII_IMAGE;
+			break;
+		case RVTH_BankType_Wii_DL_Bank2:
+			err = RVTH_ERROR_BANK_DL_2;
+			break;
+		case RVTH_BankType_Unknown:
+		default:
+			err = RVTH_ERROR_BANK_UNKNOWN;
+			break;
+	}
+	if (err != 0) {
+		if (pErr) {
+			*pErr = err;
+		}
+		return nullptr;
+	}
+
+	const pt_entry_t *const game_pte = rvth_ptbl_find_game(entry);
+	if (!game_pte) {
+		// No game partition.
+		errno = ENOENT;
+		if (pErr) {
+			*pErr = -ENOENT;
+		}
+		return nullptr;
+	}
+
+	const bool encrypted = (entry->crypto_type > RVL_CryptoType_None &&
+	                        entry->crypto_type < RVL_CryptoType_MAX);
+	PartitionReader *const ptReader = PartitionReader::open(entry->reader, game_pte, encrypted);
+	if (!ptReader) {
+		if (pErr) {
+			*pErr = -(errno != 0 ? errno : EIO);
+		}
+		return nullptr;
+	}
+	if (pErr) {
+		*pErr = 0;
+	}
+	return ptReader;
+}
+
+/**
+ * Start loading all bank table entries on a background thread.
+ *
+ * This is useful if all bank table entries will be accessed,
+ * e.g. when listing banks, since the bank entries can be
+ * loaded while the caller is processing other banks.
+ * bankEntry() waits for the background thread if it's
+ * currently loading the requested bank.
+ */
+void RvtH::prefetchBankEntries(void)
+{
+	d_ptr->startPrefetch();
+}
+
+/**
+ * Enable or disable direct (unbuffered) I/O.
+ *
+ * This is intended for RVT-H Reader devices. Bank data transferred
+ * by extract(), import(), and verifyWiiPartitions() will bypass
+ * the OS page cache. Metadata, such as the bank table and disc
+ * headers, is still read using buffered I/O.
+ *
+ * @param enable	[in] True to enable; false to disable.
+ * @return 0 on success; negative POSIX error code on error.
+ */
+int RvtH::setDirectIO(bool enable)
+{
+	if (!d_ptr->file) {
+		// File is not open.
+		return -EBADF;
+	}
+
+	// The direct I/O handle may be closed, so the
+	// background thread must not be reading from it.
+	d_ptr->stopPrefetch();
+	return d_ptr->file->setDirectIO(enable);
+}
+
+/**
+ * Set the read-ahead buffer size and depth for bulk copies.
+ *
+ * extract() and import() read the source bank on a separate
+ * thread using a ring of `depth` buffers, each `buf_size` bytes,
+ * so the source and destination are busy at the same time.
+ * Larger buffers can help with slow USB devices.
+ *
+ * @param buf_size	[in] Buffer size, in bytes (0 for default; rounded up to 4 KB)
+ * @param depth		[in] Number of buffers (0 for default)
+ */
+void RvtH::setReadAhead(unsigned int buf_size, unsigned int depth)
+{
+	d_ptr->readAheadBufSize = buf_size;
+	d_ptr->readAheadDepth = depth;
+}
+
+/**
+ * Set the verification cache mode.
+ *
+ * If enabled, verifyWiiPartitions() and verifyAllWiiPartitions()
+ * save each RVT-H bank's results in the user's cache directory.
+ * If the bank hasn't changed, the cached results are reported
+ * instead of reading and hashing the bank again.
+ *
+ * A bank is identified by its NHCD timestamp, LBA range, disc header,
+ * partition table, and the SHA-1 of each partition's H3 table.
+ * Standalone disc images aren't cached, since they don't have
+ * an NHCD timestamp.
+ *
+ * Default is RVTH_VERIFY_CACHE_OFF.
+ *
+ * @param mode	[in] Verification cache mode
+ */
+void RvtH::setVerifyCacheMode(RvtH_Verify_Cache_Mode mode)
+{
+	d_ptr->verifyCacheMode = mode;
 }
@@ -2,7 +2,7 @@
  * RVT-H Tool (librvth)                                                    *
  * rvth.hpp: RVT-H image handler.                                          *
  *                                                                         *
- * Copyright (c) 2018-2025 by David Korth.                                 *
+ * Copyright (c) 2018-2026 by David Korth.                                 *
  * SPDX-License-Identifier: GPL-2.0-or-later                               *
  ***************************************************************************/
 
@@ -27,6 +27,7 @@
 // Reader class
 #ifdef __cplusplus
 class Reader;
+class PartitionReader;
 #else
 struct Reader;
 typedef struct Reader Reader;
@@ -87,6 +88,7 @@ typedef enum {
 	RVTH_PROGRESS_EXTRACT,		// Extract image
 	RVTH_PROGRESS_IMPORT,		// Import image
 	RVTH_PROGRESS_RECRYPT,		// Recrypt image
+	RVTH_PROGRESS_HASH,		// Hash image
 } RvtH_Progress_Type;
 
 // General progress callback status.
@@ -119,6 +121,28 @@ typedef struct _RvtH_Progress_State {
  */
 typedef bool (*RvtH_Progress_Callback)(const RvtH_Progress_State *state, void *userdata);
 
+// Import statistics.
+typedef struct _RvtH_Import_Stats {
+	bool incremental;	// True if an incremental import was done.
+	uint64_t bytes_written;	// Bytes written to the bank.
+	uint64_t bytes_skipped;	// Bytes skipped because they didn't change.
+	uint64_t bytes_read;	// Bytes read from the bank for comparison.
+
+	// Hash verification (RVTH_IMPORT_VERIFY)
+	bool verified;			// True if the hashes were verified.
+	bool reread;			// True if written groups were re-read from the device.
+	unsigned int verify_errs[5];	// Hash errors, by level. (H0-H4)
+	unsigned int reread_errs;	// Groups that didn't match when re-read.
+} RvtH_Import_Stats;
+
+// Disc image digests, as listed in disc image catalogs.
+typedef struct _RvtH_Digests {
+	uint64_t size;		// Number of bytes hashed.
+	uint32_t crc32;		// CRC-32
+	uint8_t md5[16];	// MD5
+	uint8_t sha1[20];	// SHA-1
+} RvtH_Digests;
+
 // Verify progress callback type.
 // NOTE: This indicates the message type, whereas the
 // regular progress type indicates the operation type.
@@ -134,6 +158,12 @@ typedef enum {
 	RVTH_VERIFY_ERROR_TABLE_COPY,	// Sector's hash table copy doesn't match base sector.
 } RvtH_Verify_Error_Type;
 
+typedef enum {
+	RVTH_VERIFY_CACHE_OFF = 0,	// Don't use the verification cache.
+	RVTH_VERIFY_CACHE_ON,		// Use cached results if available; save new results.
+	RVTH_VERIFY_CACHE_REBUILD,	// Ignore cached results; save new results.
+} RvtH_Verify_Cache_Mode;
+
 // Verification progress callback status.
 typedef struct _RvtH_Verify_Progress_State {
 	const RvtH *rvth;
@@ -158,6 +188,9 @@ typedef struct _RvtH_Verify_Progress_State {
 	uint8_t kb;		// Kilobyte 1-31 (H0 only) [KB 0 == hashes]
 	uint8_t err_type;	// Error type (see RvtH_Verify_Error_Type)
 	bool is_zero;		// If true, sector is zeroed. (scrubbed/truncated)
+
+	// If true, the results are from the verification cache.
+	bool is_cached;
 } RvtH_Verify_Progress_State;
 
 /**
@@ -203,6 +236,19 @@ public:
 	 */
 	RvtH(const TCHAR *filename, uint32_t lba_len, int *pErr = nullptr);
 
+	/**
+	 * Create a writable RVT-H disc image object using the specified format.
+	 *
+	 * Check isOpen() after constructing the object to determine
+	 * if the file was opened successfully.
+	 *
+	 * @param filename	[in] Filename.
+	 * @param lba_len	[in] LBA length. (Will NOT be allocated initially.)
+	 * @param format	[in] Disc image format.
+	 * @param pErr		[out,opt] Error code. (If negative, POSIX error; otherwise, see RvtH_Errors.)
+	 */
+	RvtH(const TCHAR *filename, uint32_t lba_len, RvtH_ImageFormat_e format, int *pErr = nullptr);
+
 	~RvtH();
 
 private:
@@ -264,12 +310,89 @@ public:
 
 	/**
 	 * Get a bank table entry.
+	 *
+	 * For RVT-H Readers and HDD images, the region code, encryption,
+	 * signature, and AppLoader fields are loaded on first access,
+	 * which requires reading from the bank.
+	 *
 	 * @param bank	[in] Bank number. (0-7)
 	 * @param pErr	[out,opt] Error code. (If negative, POSIX error; otherwise, see RvtH_Errors.)
 	 * @return Bank table entry.
 	 */
 	const RvtH_BankEntry *bankEntry(unsigned int bank, int *pErr = nullptr) const;
 
+	/**
+	 * Open the game partition of a Wii bank for reading decrypted data.
+	 *
+	 * The PartitionReader uses the bank's Reader, so it must be deleted
+	 * before the RvtH object, and neither of them may be used by
+	 * multiple threads at the same time.
+	 *
+	 * @param bank	[in] Bank number. (0-7)
+	 * @param pErr	[out,opt] Error code. (If negative, POSIX error; otherwise, see RvtH_Errors.)
+	 * @return PartitionReader*, or nullptr on error. (Caller must delete it.)
+	 */
+	PartitionReader *openGamePartition(unsigned int bank, int *pErr = nullptr);
+
+	/**
+	 * Start loading all bank table entries on a background thread.
+	 *
+	 * This is useful if all bank table entries will be accessed,
+	 * e.g. when listing banks, since the bank entries can be
+	 * loaded while the caller is processing other banks.
+	 * bankEntry() waits for the background thread if it's
+	 * currently loading the requested bank.
+	 */
+	void prefetchBankEntries(void);
+
+public:
+	/** I/O settings **/
+
+	/**
+	 * Enable or disable direct (unbuffered) I/O.
+	 *
+	 * This is intended for RVT-H Reader devices. Bank data transferred
+	 * by extract(), import(), and verifyWiiPartitions() will bypass
+	 * the OS page cache. Metadata, such as the bank table and disc
+	 * headers, is still read using buffered I/O.
+	 *
+	 * @param enable	[in] True to enable; false to disable.
+	 * @return 0 on success; negative POSIX error code on error.
+	 */
+	int setDirectIO(bool enable);
+
+	/**
+	 * Set the read-ahead buffer size and depth for bulk copies.
+	 *
+	 * extract() and import() read the source bank on a separate
+	 * thread using a ring of `depth` buffers, each `buf_size` bytes,
+	 * so the source and destination are busy at the same time.
+	 * Larger buffers can help with slow USB devices.
+	 *
+	 * @param buf_size	[in] Buffer size, in bytes (0 for default; rounded up to 4 KB)
+	 * @param depth		[in] Number of buffers (0 for default)
+	 */
+	void setReadAhead(unsigned int buf_size, unsigned int depth);
+
+	/**
+	 * Set the verification cache mode.
+	 *
+	 * If enabled, verifyWiiPartitions() and verifyAllWiiPartitions()
+	 * save each RVT-H bank's results in the user's cache directory.
+	 * If the bank hasn't changed, the cached results are reported
+	 * instead of reading and hashing the bank again.
+	 *
+	 * A bank is identified by its NHCD timestamp, LBA range, disc header,
+	 * partition table, and the SHA-1 of each partition's H3 table.
+	 * Standalone disc images aren't cached, since they don't have
+	 * an NHCD timestamp.
+	 *
+	 * Default is RVTH_VERIFY_CACHE_OFF.
+	 *
+	 * @param mode	[in] Verification cache mode
+	 */
+	void setVerifyCacheMode(RvtH_Verify_Cache_Mode mode);
+
 public:
 	/** Write functions (write.cpp) **/
 
@@ -292,15 +415,21 @@ public:
 
 	/**
 	 * Copy a bank from this RVT-H HDD or standalone disc image to a writable standalone disc image.
+	 *
+	 * If pDigests is specified, the digests of the data written to the
+	 * destination are computed on separate threads while copying.
+	 *
 	 * @param rvth_dest	[out] Destination RvtH object.
 	 * @param bank_src	[in] Source bank number. (0-7)
 	 * @param callback	[in,opt] Progress callback.
 	 * @param userdata	[in,opt] User data for progress callback.
+	 * @param pDigests	[out,opt] Digests of the destination image.
 	 * @return Error code. (If negative, POSIX error; otherwise, see RvtH_Errors.)
 	 */
 	int copyToGcm(RvtH *rvth_dest, unsigned int bank_src,
 		RvtH_Progress_Callback callback = nullptr,
-		void *userdata = nullptr);
+		void *userdata = nullptr,
+		RvtH_Digests *pDigests = nullptr);
 
 	/**
 	 * Copy a bank from this RVT-H HDD or standalone disc image to a writable standalone disc image.
@@ -309,62 +438,104 @@ public:
 	 * using the existing title key. It does *not* change the encryption
 	 * method or signature, so recryption will be needed afterwards.
 	 *
+	 * Groups are encrypted by a pool of worker threads. The progress
+	 * callback is always run on the calling thread.
+	 *
 	 * @param rvth_dest	[out] Destination RvtH object.
 	 * @param bank_src	[in] Source bank number. (0-7)
 	 * @param callback	[in,opt] Progress callback.
 	 * @param userdata	[in,opt] User data for progress callback.
+	 * @param threads	[in,opt] Number of worker threads (0 for auto; 1 to disable threading)
 	 * @return Error code. (If negative, POSIX error; otherwise, see RvtH_Errors.)
 	 */
 	int copyToGcm_doCrypt(RvtH *rvth_dest, unsigned int bank_src,
 		RvtH_Progress_Callback callback = nullptr,
-		void *userdata = nullptr);
+		void *userdata = nullptr,
+		unsigned int threads = 0);
 
 	/**
 	 * Extract a disc image from this RVT-H disk image.
 	 * Compatibility wrapper; this function creates a new RvtH
 	 * using the GCM constructor and then copyToGcm().
+	 *
+	 * If pDigests is specified, the digests of the extracted disc image
+	 * are computed while copying. (The SDK header isn't included.)
+	 * If the image is encrypted or recrypted, the ticket and TMD are
+	 * rewritten after copying, so the finished image is read back
+	 * and hashed instead.
+	 *
 	 * @param bank		[in] Bank number. (0-7)
 	 * @param filename	[in] Destination filename.
 	 * @param recrypt_key	[in] Key for recryption. (-1 for default; otherwise, see RVL_CryptoType_e)
 	 * @param flags		[in] Flags. (See RvtH_Extract_Flags.)
 	 * @param callback	[in,opt] Progress callback.
 	 * @param userdata	[in,opt] User data for progress callback.
+	 * @param threads	[in,opt] Number of worker threads for encryption (0 for auto; 1 to disable threading)
+	 * @param pDigests	[out,opt] Digests of the extracted disc image.
 	 * @return Error code. (If negative, POSIX error; otherwise, see RvtH_Errors.)
 	 */
 	int extract(unsigned int bank, const TCHAR *filename,
 		int recrypt_key, unsigned int flags,
 		RvtH_Progress_Callback callback = nullptr,
-		void *userdata = nullptr);
+		void *userdata = nullptr,
+		unsigned int threads = 0,
+		RvtH_Digests *pDigests = nullptr);
 
 	/**
 	 * Copy a bank from this HDD or standalone disc image to an RVT-H system.
+	 *
+	 * If pDigests is specified, the digests of the copied disc image
+	 * are computed on separate threads while copying.
+	 *
+	 * If RVTH_IMPORT_VERIFY is set, the hashes of the encrypted Wii
+	 * partitions are checked while copying, and the results are
+	 * stored in pStats. Hash errors don't stop the import.
+	 *
 	 * @param rvth_dest	[in] Destination RvtH object.
 	 * @param bank_dest	[in] Destination bank number. (0-7)
 	 * @param bank_src	[in] Source bank number. (0-7)
 	 * @param callback	[in,opt] Progress callback.
 	 * @param userdata	[in,opt] User data for progress callback.
+	 * @param flags		[in,opt] Flags. (See RvtH_Import_Flags.)
+	 * @param pStats	[out,opt] Import statistics.
+	 * @param pDigests	[out,opt] Digests of the copied disc image.
 	 * @return Error code. (If negative, POSIX error; otherwise, see RvtH_Errors.)
 	 */
 	int copyToHDD(RvtH *rvth_dest, unsigned int bank_dest,
 		unsigned int bank_src,
 		RvtH_Progress_Callback callback = nullptr,
-		void *userdata = nullptr);
+		void *userdata = nullptr,
+		unsigned int flags = 0,
+		RvtH_Import_Stats *pStats = nullptr,
+		RvtH_Digests *pDigests = nullptr);
 
 	/**
 	 * Import a disc image into this RVT-H disk image.
 	 * Compatibility wrapper; this function creates an RvtH object for the
 	 * RVT-H disk image and then copyToHDD().
+	 *
+	 * If pDigests is specified, the digests of the disc image are
+	 * computed while copying. These are the digests of the image as
+	 * it was copied, before it's converted to debug encryption and
+	 * marked as imported.
+	 *
 	 * @param bank		[in] Bank number. (0-7)
 	 * @param filename	[in] Source GCM filename.
 	 * @param callback	[in,opt] Progress callback.
 	 * @param userdata	[in,opt] User data for progress callback.
 	 * @param ios_force	[in,opt] IOS version to force. (-1 to use the existing IOS)
+	 * @param flags		[in,opt] Flags. (See RvtH_Import_Flags.)
+	 * @param pStats	[out,opt] Import statistics.
+	 * @param pDigests	[out,opt] Digests of the disc image.
 	 * @return Error code. (If negative, POSIX error; otherwise, see RvtH_Errors.)
 	 */
 	int import(unsigned int bank, const TCHAR *filename,
 		RvtH_Progress_Callback callback = nullptr,
 		void *userdata = nullptr,
-		int ios_force = -1);
+		int ios_force = -1,
+		unsigned int flags = 0,
+		RvtH_Import_Stats *pStats = nullptr,
+		RvtH_Digests *pDigests = nullptr);
 
 public:
 	/** Recryption functions (recrypt.cpp) **/
@@ -425,16 +596,55 @@ public:
 	 * NOTE: Assuming the TMD signature is valid, which means
 	 * the H4 hash is correct.
 	 *
+	 * Groups are decrypted and hashed by a pool of worker threads.
+	 * Errors are still reported through the callback in group order,
+	 * and the callback is always run on the calling thread.
+	 *
+	 * If the verification cache is enabled (see setVerifyCacheMode()),
+	 * an unchanged RVT-H bank's results are reported from the cache.
+	 *
 	 * @param bank		[in] Bank number (0-7)
 	 * @param errorCount	[out] Error counts for all 5 hash tables
 	 * @param callback	[in,opt] Progress callback
 	 * @param userdata	[in,opt] User data for progress callback
+	 * @param threads	[in,opt] Number of worker threads (0 for auto; 1 to disable threading)
 	 * @return Error code. (If negative, POSIX error; otherwise, see RvtH_Errors.)
 	 */
 	int verifyWiiPartitions(unsigned int bank,
 		WiiErrorCount_t *errorCount = nullptr,
 		RvtH_Verify_Progress_Callback callback = nullptr,
-		void *userdata = nullptr);
+		void *userdata = nullptr,
+		unsigned int threads = 0);
+
+	/**
+	 * Verify partitions in all Wii banks.
+	 *
+	 * This is equivalent to calling verifyWiiPartitions() for each bank,
+	 * but the banks share a single pool of worker threads. Group data is
+	 * read in LBA order across all banks, so an HDD still sees mostly
+	 * sequential access.
+	 *
+	 * Progress is reported one bank at a time, in LBA order.
+	 * state->bank indicates which bank is being reported.
+	 *
+	 * Banks that can't be verified, e.g. empty banks or GameCube banks,
+	 * are skipped, and their error codes are stored in bankErrs.
+	 *
+	 * If the verification cache is enabled (see setVerifyCacheMode()),
+	 * unchanged banks' results are reported from the cache.
+	 *
+	 * @param errorCounts	[out,opt] Array of bankCount() error counts
+	 * @param bankErrs	[out,opt] Array of bankCount() error codes (If negative, POSIX error; otherwise, see RvtH_Errors.)
+	 * @param callback	[in,opt] Progress callback
+	 * @param userdata	[in,opt] User data for progress callback
+	 * @param threads	[in,opt] Number of worker threads (0 for auto; 1 to disable threading)
+	 * @return 0 on success; negative POSIX error code on error. (Bank errors are stored in bankErrs.)
+	 */
+	int verifyAllWiiPartitions(WiiErrorCount_t *errorCounts,
+		int *bankErrs,
+		RvtH_Verify_Progress_Callback callback = nullptr,
+		void *userdata = nullptr,
+		unsigned int threads = 0);
 };
 
 #endif /* __cplusplus */
@@ -2,7 +2,7 @@
  * RVT-H Tool (librvth)                                                    *
  * rvth_enums.h: RVT-H enums.                                              *
  *                                                                         *
- * Copyright (c) 2018-2019 by David Korth.                                 *
+ * Copyright (c) 2018-2026 by David Korth.                                 *
  * SPDX-License-Identifier: GPL-2.0-or-later                               *
  ***************************************************************************/
 
@@ -48,8 +48,41 @@ typedef enum {
 	// Prepend a 32 KB SDK header.
 	// Required for rvtwriter, NDEV ODEM, etc.
 	RVTH_EXTRACT_PREPEND_SDK_HEADER		= (1 << 0),
+
+	// Output format. (default is a plain GCM)
+	// Compact formats only store blocks that contain data.
+	// Can't be combined with RVTH_EXTRACT_PREPEND_SDK_HEADER.
+	RVTH_EXTRACT_FORMAT_CISO		= (1 << 1),
+	RVTH_EXTRACT_FORMAT_WBFS		= (1 << 2),
 } RvtH_Extract_Flags;
 
+// RVT-H import flags.
+typedef enum {
+	// If the destination bank already has the same title,
+	// only write the parts of the image that changed.
+	// Ignored by RvtH::import() if the image will be converted
+	// to debug realsigned, since none of the bank would match.
+	RVTH_IMPORT_INCREMENTAL			= (1 << 0),
+
+	// Verify the hashes of the encrypted Wii partitions
+	// while the image is being imported.
+	RVTH_IMPORT_VERIFY			= (1 << 1),
+
+	// Re-read each group from the bank after writing it
+	// and compare it with the source data.
+	// Only used with RVTH_IMPORT_VERIFY.
+	// Skipped if the group can't be read from the device
+	// instead of the OS page cache. (See RvtH_Import_Stats.)
+	RVTH_IMPORT_VERIFY_REREAD		= (1 << 2),
+} RvtH_Import_Flags;
+
+// Disc image formats for writable disc images.
+typedef enum {
+	RVTH_ImageFormat_GCM	= 0,	// Plain disc image
+	RVTH_ImageFormat_CISO	= 1,	// CISO (compact)
+	RVTH_ImageFormat_WBFS	= 2,	// WBFS (compact)
+} RvtH_ImageFormat_e;
+
 #ifdef __cplusplus
 }
 #endif
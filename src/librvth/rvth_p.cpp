@@ -2,7 +2,7 @@
  * RVT-H Tool (librvth)                                                    *
  * rvth_p.cpp: RVT-H image handler. (PRIVATE CLASS)                        *
  *                                                                         *
- * Copyright (c) 2018-2025 by David Korth.                                 *
+ * Copyright (c) 2018-2026 by David Korth.                                 *
  * SPDX-License-Identifier: GPL-2.0-or-later                               *
  ***************************************************************************/
 
@@ -19,19 +19,72 @@
 #include "bank_init.h"
 #include "reader/Reader.hpp"
 
+// libwiicrypto
+#include "libwiicrypto/zero_scan.h"
+
 // C includes. (C++ namespace)
 #include <cassert>
 #include <cerrno>
 #include <cstring>
 
+// C++ includes.
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <vector>
+using std::unique_ptr;
+using std::vector;
+
+// Maximum number of threads to use when initializing bank entries.
+// Initialization is mostly waiting for I/O, so this doesn't depend
+// on the number of CPUs.
+static constexpr unsigned int BANK_INIT_THREADS_MAX = 8;
+
+/**
+ * Run a function for each bank using a small pool of threads.
+ * The calling thread is also used as a worker.
+ * @param count	[in] Number of banks.
+ * @param func	[in] Function to run for each bank index. (0 to count-1)
+ */
+template<typename Func>
+static void forEachBankParallel(unsigned int count, Func func)
+{
+	std::atomic<unsigned int> next(0);
+	auto worker = [&next, count, &func]() {
+		for (unsigned int i = next++; i < count; i = next++) {
+			func(i);
+		}
+	};
+
+	const unsigned int threads = std::min(count, BANK_INIT_THREADS_MAX);
+	vector<std::thread> workers;
+	if (threads > 1) {
+		workers.reserve(threads - 1);
+		for (unsigned int i = 1; i < threads; i++) {
+			workers.emplace_back(worker);
+		}
+	}
+	worker();
+	for (std::thread &thr : workers) {
+		thr.join();
+	}
+}
+
 RvtHPrivate::RvtHPrivate(RvtH *q)
 	: q_ptr(q)
 	, imageType(RVTH_ImageType_Unknown)
 	, nhcdStatus(NHCD_STATUS_UNKNOWN)
+	, readAheadBufSize(0)
+	, readAheadDepth(0)
+	, verifyCacheMode(RVTH_VERIFY_CACHE_OFF)
+	, prefetchStop(false)
 { }
 
 RvtHPrivate::~RvtHPrivate()
 {
+	// Make sure the background thread isn't using the bank entries.
+	stopPrefetch();
+
 	// Close all bank entry files.
 	// RefFile has a reference count, so we have to clear the count.
 	for (RvtH_BankEntry &entry : entries) {
@@ -45,32 +98,12 @@ RvtHPrivate::~RvtHPrivate()
 /**
  * Check if a block is empty.
  * @param block Block
- * @param size Block size (Must be a multiple of 64 bytes.)
+ * @param size Block size
  * @return True if the block is all zeroes; false if not.
  */
-bool RvtHPrivate::isBlockEmpty(const uint8_t *block, unsigned int size)
+bool RvtHPrivate::isBlockEmpty(const uint8_t *block, size_t size)
 {
-	// Process the block using 64-bit pointers.
-	const uint64_t *block64 = (const uint64_t*)block;
-	unsigned int i;
-	assert(size % 64 == 0);
-	for (i = size/8/8; i > 0; i--, block64 += 8) {
-		uint64_t x = block64[0];
-		x |= block64[1];
-		x |= block64[2];
-		x |= block64[3];
-		x |= block64[4];
-		x |= block64[5];
-		x |= block64[6];
-		x |= block64[7];
-		if (x != 0) {
-			// Non-zero block.
-			return false;
-		}
-	}
-
-	// Block is all zeroes.
-	return true;
+	return zero_scan_is_zero(block, size);
 }
 
 /** Constructor functions **/
@@ -293,12 +326,10 @@ int RvtHPrivate::checkMBR(RefFile *f_img, bool *pMBR, bool *pGPT)
  */
 int RvtHPrivate::openHDD(const RefFilePtr &f_img)
 {
-	RvtH_BankEntry *rvth_entry;
 	uint32_t bankCount;
 	int ret = 0;	// errno or RvtH_Errors
 	int err = 0;	// errno setting
 
-	off64_t addr;
 	size_t size;
 
 	// Check the bank table header.
@@ -352,15 +383,17 @@ int RvtHPrivate::openHDD(const RefFilePtr &f_img)
 		static constexpr unsigned int bankCount_default = 8;
 		entries.resize(bankCount_default);
 
+		bankInitState.resize(bankCount_default);
+
 		file = f_img;
-		rvth_entry = entries.data();
 		lba_start = NHCD_BANK_START_LBA(0, 8);
-		for (unsigned int i = 0; i < bankCount_default; i++, rvth_entry++, lba_start += NHCD_BANK_SIZE_LBA) {
+		forEachBankParallel(bankCount_default, [this, &f_img, lba_start](unsigned int i) {
 			// Use "Empty" so we can try to detect the actual bank type.
-			rvth_init_BankEntry(rvth_entry, f_img,
+			const int ret = rvth_init_BankEntry(&entries[i], f_img,
 				RVTH_BankType_Empty,
-				lba_start, NHCD_BANK_SIZE_LBA, 0);
-		}
+				lba_start + (i * NHCD_BANK_SIZE_LBA), NHCD_BANK_SIZE_LBA, 0);
+			bankInitState[i] = (ret > 0 ? BANK_INIT_PENDING : BANK_INIT_DONE);
+		});
 
 		// RVT-H image loaded.
 		return RVTH_ERROR_SUCCESS;
@@ -384,35 +417,18 @@ int RvtHPrivate::openHDD(const RefFilePtr &f_img)
 
 	// Allocate memory for the RvtH_BankEntry objects.
 	entries.resize(bankCount);
-
+	bankInitState.resize(bankCount);
 	file = f_img;
-	rvth_entry = entries.data();
-	// FIXME: Why cast to uint32_t?
-	addr = (uint32_t)(LBA_TO_BYTES(NHCD_BANKTABLE_ADDRESS_LBA) + NHCD_BLOCK_SIZE);
-	for (unsigned int i = 0; i < bankCount; i++, rvth_entry++, addr += 512) {
-		NHCD_BankEntry nhcd_entry;
-		uint32_t lba_start = 0, lba_len = 0;
-		uint8_t type = RVTH_BankType_Unknown;
-
-		if (i > 0 && (rvth_entry-1)->type == RVTH_BankType_Wii_DL) {
-			// Second bank for a dual-layer Wii image.
-			rvth_entry->type = RVTH_BankType_Wii_DL_Bank2;
-			rvth_entry->timestamp = -1;
-			continue;
-		}
 
-		ret = f_img->seeko(addr, SEEK_SET);
-		if (ret != 0) {
-			// Seek error.
-			err = errno;
-			if (err == 0) {
-				err = EIO;
-			}
-			ret = -err;
-			goto fail;
-		}
-		size = f_img->read(&nhcd_entry, 1, sizeof(nhcd_entry));
-		if (size != sizeof(nhcd_entry)) {
+	{
+		// Read all of the bank table entries at once.
+		// NOTE: Each read has a lot of latency on RVT-H Readers.
+		unique_ptr<NHCD_BankEntry[]> nhcd_entries(new NHCD_BankEntry[bankCount]);
+		const size_t nhcd_entries_size = bankCount * sizeof(NHCD_BankEntry);
+		errno = 0;
+		size = f_img->pread(nhcd_entries.get(), nhcd_entries_size,
+			LBA_TO_BYTES(NHCD_BANKTABLE_ADDRESS_LBA) + NHCD_BLOCK_SIZE);
+		if (size != nhcd_entries_size) {
 			// Short read.
 			err = errno;
 			if (err == 0) {
@@ -422,47 +438,79 @@ int RvtHPrivate::openHDD(const RefFilePtr &f_img)
 			goto fail;
 		}
 
-		// Check the type.
-		switch (be32_to_cpu(nhcd_entry.type)) {
-			default:
-				// Unknown bank type...
-				type = RVTH_BankType_Unknown;
-				break;
-			case NHCD_BankType_Empty:
-				// "Empty" bank. May have a deleted image.
-				type = RVTH_BankType_Empty;
-				break;
-			case NHCD_BankType_GCN:
-				// GameCube
-				type = RVTH_BankType_GCN;
-				break;
-			case NHCD_BankType_Wii_SL:
-				// Wii (single-layer)
-				type = RVTH_BankType_Wii_SL;
-				break;
-			case NHCD_BankType_Wii_DL:
-				// Wii (dual-layer)
-				// TODO: Cannot start in Bank 8.
-				type = RVTH_BankType_Wii_DL;
-				break;
-		}
+		// Determine the bank types.
+		// The bank after a dual-layer Wii image is the second layer.
+		// It doesn't have its own disc header, so it isn't initialized.
+		vector<uint8_t> types(bankCount);
+		for (unsigned int i = 0; i < bankCount; i++) {
+			if (i > 0 && types[i-1] == RVTH_BankType_Wii_DL) {
+				// Second bank for a dual-layer Wii image.
+				types[i] = RVTH_BankType_Wii_DL_Bank2;
+				continue;
+			}
 
-		// For valid types, use the listed LBAs if they're non-zero.
-		if (type >= RVTH_BankType_GCN) {
-			lba_start = be32_to_cpu(nhcd_entry.lba_start);
-			lba_len = be32_to_cpu(nhcd_entry.lba_len);
+			// Check the type.
+			switch (be32_to_cpu(nhcd_entries[i].type)) {
+				default:
+					// Unknown bank type...
+					types[i] = RVTH_BankType_Unknown;
+					break;
+				case NHCD_BankType_Empty:
+					// "Empty" bank. May have a deleted image.
+					types[i] = RVTH_BankType_Empty;
+					break;
+				case NHCD_BankType_GCN:
+					// GameCube
+					types[i] = RVTH_BankType_GCN;
+					break;
+				case NHCD_BankType_Wii_SL:
+					// Wii (single-layer)
+					types[i] = RVTH_BankType_Wii_SL;
+					break;
+				case NHCD_BankType_Wii_DL:
+					// Wii (dual-layer)
+					// TODO: Cannot start in Bank 8.
+					types[i] = RVTH_BankType_Wii_DL;
+					break;
+			}
 		}
 
-		if (lba_start == 0 || lba_len == 0) {
-			// Invalid LBAs. Use the default starting offset.
-			// Bank size will be determined by rvth_init_BankEntry().
-			lba_start = NHCD_BANK_START_LBA(i, bankCount);
-			lba_len = 0;
-		}
+		// Initialize the bank entries.
+		// The banks are independent, so they're initialized in parallel.
+		// The region, encryption, and AppLoader fields are initialized
+		// on first access, since they require several more reads.
+		forEachBankParallel(bankCount, [this, &f_img, &nhcd_entries, &types, bankCount](unsigned int i) {
+			const NHCD_BankEntry *const nhcd_entry = &nhcd_entries[i];
+			const uint8_t type = types[i];
+			uint32_t lba_start = 0, lba_len = 0;
+
+			if (type == RVTH_BankType_Wii_DL_Bank2) {
+				// Second bank for a dual-layer Wii image.
+				memset(&entries[i], 0, sizeof(entries[i]));
+				entries[i].type = RVTH_BankType_Wii_DL_Bank2;
+				entries[i].timestamp = -1;
+				bankInitState[i] = BANK_INIT_DONE;
+				return;
+			}
+
+			// For valid types, use the listed LBAs if they're non-zero.
+			if (type >= RVTH_BankType_GCN) {
+				lba_start = be32_to_cpu(nhcd_entry->lba_start);
+				lba_len = be32_to_cpu(nhcd_entry->lba_len);
+			}
+
+			if (lba_start == 0 || lba_len == 0) {
+				// Invalid LBAs. Use the default starting offset.
+				// Bank size will be determined by rvth_init_BankEntry().
+				lba_start = NHCD_BANK_START_LBA(i, bankCount);
+				lba_len = 0;
+			}
 
-		// Initialize the bank entry.
-		rvth_init_BankEntry(rvth_entry, f_img, type,
-			lba_start, lba_len, nhcd_entry.timestamp);
+			// Initialize the bank entry.
+			const int ret = rvth_init_BankEntry(&entries[i], f_img, type,
+				lba_start, lba_len, nhcd_entry->timestamp);
+			bankInitState[i] = (ret > 0 ? BANK_INIT_PENDING : BANK_INIT_DONE);
+		});
 	}
 
 	// RVT-H image loaded.
@@ -477,6 +525,109 @@ fail:
 	return ret;
 }
 
+/** Accessors **/
+
+/**
+ * Get a bank entry, initializing its lazily-loaded fields if necessary.
+ * The bank number must be in range.
+ * @param bank	[in] Bank number. (0-7)
+ * @return Bank entry.
+ */
+RvtH_BankEntry *RvtHPrivate::bankEntry(unsigned int bank)
+{
+	assert(bank < bankCount());
+	initBankEntryLazy(bank);
+	return &entries[bank];
+}
+
+/** Lazy bank entry initialization **/
+
+/**
+ * Initialize a bank entry's lazily-loaded fields if they
+ * haven't been initialized yet.
+ *
+ * If another thread is currently initializing the bank entry,
+ * this waits for that thread to finish.
+ *
+ * @param bank	[in] Bank number. (0-7)
+ */
+void RvtHPrivate::initBankEntryLazy(unsigned int bank)
+{
+	std::unique_lock<std::mutex> lock(bankInitMutex);
+	if (bank >= bankInitState.size()) {
+		// Nothing to initialize.
+		return;
+	}
+
+	while (bankInitState[bank] == BANK_INIT_LOADING) {
+		// Another thread is initializing this bank entry.
+		bankInitCond.wait(lock);
+	}
+	if (bankInitState[bank] != BANK_INIT_PENDING) {
+		// Already initialized.
+		return;
+	}
+
+	// Initialize the bank entry without holding the lock,
+	// so other bank entries can be initialized in parallel.
+	bankInitState[bank] = BANK_INIT_LOADING;
+	lock.unlock();
+	rvth_init_BankEntry_lazy(&entries[bank]);
+	lock.lock();
+	bankInitState[bank] = BANK_INIT_DONE;
+	bankInitCond.notify_all();
+}
+
+/**
+ * Start initializing all bank entries on a background thread.
+ */
+void RvtHPrivate::startPrefetch(void)
+{
+	if (prefetchThread.joinable()) {
+		// Already started.
+		return;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(bankInitMutex);
+		bool pending = false;
+		for (uint8_t state : bankInitState) {
+			if (state == BANK_INIT_PENDING) {
+				pending = true;
+				break;
+			}
+		}
+		if (!pending) {
+			// Nothing to initialize.
+			return;
+		}
+	}
+
+	// Bank entries are usually accessed starting with Bank 1,
+	// so initialize them starting from the last bank.
+	// The banks are independent, so they're initialized in parallel.
+	prefetchStop = false;
+	prefetchThread = std::thread([this]() {
+		const unsigned int bank_count = bankCount();
+		forEachBankParallel(bank_count, [this, bank_count](unsigned int i) {
+			if (!prefetchStop) {
+				initBankEntryLazy(bank_count - 1 - i);
+			}
+		});
+	});
+}
+
+/**
+ * Stop the background thread, if it's running.
+ */
+void RvtHPrivate::stopPrefetch(void)
+{
+	if (prefetchThread.joinable()) {
+		prefetchStop = true;
+		prefetchThread.join();
+	}
+}
+
 /** Private functions **/
 
 /**
@@ -507,6 +658,9 @@ int RvtHPrivate::makeWritable(void)
 	}
 
 	// Make this writable.
+	// RefFile::makeWritable() reopens the file, so the
+	// background thread must not be reading from it.
+	stopPrefetch();
 	return file->makeWritable();
 }
 
@@ -541,7 +695,7 @@ int RvtHPrivate::writeBankEntry(unsigned int bank, time_t *pTimestamp)
 
 	// If the bank entry is deleted, then it should be
 	// all zeroes, so skip all of this.
-	RvtH_BankEntry *const rvth_entry = &entries[bank];
+	RvtH_BankEntry *const rvth_entry = bankEntry(bank);
 	if (!rvth_entry->is_deleted) {
 		// Bank entry is not deleted.
 		// Construct the NHCD bank entry.
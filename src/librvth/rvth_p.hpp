@@ -2,7 +2,7 @@
  * RVT-H Tool (librvth)                                                    *
  * rvth_p.cpp: RVT-H image handler. (PRIVATE CLASS)                        *
  *                                                                         *
- * Copyright (c) 2018-2025 by David Korth.                                 *
+ * Copyright (c) 2018-2026 by David Korth.                                 *
  * SPDX-License-Identifier: GPL-2.0-or-later                               *
  ***************************************************************************/
 
@@ -16,7 +16,11 @@
 #include "nhcd_structs.h"
 
 // C++ STL classes
+#include <atomic>
+#include <condition_variable>
 #include <memory>
+#include <mutex>
+#include <thread>
 #include <vector>
 
 class RvtH;
@@ -36,10 +40,10 @@ public:
 	/**
 	 * Check if a block is empty.
 	 * @param block Block
-	 * @param size Block size (Must be a multiple of 64 bytes.)
+	 * @param size Block size
 	 * @return True if the block is all zeroes; false if not.
 	 */
-	static bool isBlockEmpty(const uint8_t *block, unsigned int size);
+	static bool isBlockEmpty(const uint8_t *block, size_t size);
 
 public:
 	/** Constructor functions **/
@@ -98,6 +102,38 @@ public:
 		return false;
 	}
 
+	/**
+	 * Get a bank entry, initializing its lazily-loaded fields if necessary.
+	 * The bank number must be in range.
+	 * @param bank	[in] Bank number. (0-7)
+	 * @return Bank entry.
+	 */
+	RvtH_BankEntry *bankEntry(unsigned int bank);
+
+public:
+	/** Lazy bank entry initialization **/
+
+	/**
+	 * Initialize a bank entry's lazily-loaded fields if they
+	 * haven't been initialized yet.
+	 *
+	 * If another thread is currently initializing the bank entry,
+	 * this waits for that thread to finish.
+	 *
+	 * @param bank	[in] Bank number. (0-7)
+	 */
+	void initBankEntryLazy(unsigned int bank);
+
+	/**
+	 * Start initializing all bank entries on a background thread.
+	 */
+	void startPrefetch(void);
+
+	/**
+	 * Stop the background thread, if it's running.
+	 */
+	void stopPrefetch(void);
+
 public:
 	/** Private functions **/
 
@@ -138,4 +174,26 @@ public:
 
 	// NHCD header status
 	NHCD_Status_e nhcdStatus;
+
+	// Read-ahead settings for bulk copies (0 for default)
+	unsigned int readAheadBufSize;
+	unsigned int readAheadDepth;
+
+	// Verification cache mode
+	RvtH_Verify_Cache_Mode verifyCacheMode;
+
+	// Lazy bank entry initialization state
+	// NOTE: Banks past the end of this vector don't need initialization.
+	enum BankInitState : uint8_t {
+		BANK_INIT_DONE		= 0,
+		BANK_INIT_PENDING	= 1,
+		BANK_INIT_LOADING	= 2,
+	};
+	std::vector<uint8_t> bankInitState;
+	std::mutex bankInitMutex;
+	std::condition_variable bankInitCond;
+
+	// Background thread for initializing bank entries
+	std::thread prefetchThread;
+	std::atomic<bool> prefetchStop;
 };
@@ -0,0 +1,299 @@
+/***************************************************************************
+ * RVT-H Tool (librvth/tests)                                              *
+ * DeltaCompareTest.cpp: Incremental import comparison tests.              *
+ *                                                                         *
+ * Copyright (c) 2026 by David Korth.                                      *
+ * SPDX-License-Identifier: GPL-2.0-or-later                               *
+ ***************************************************************************/
+
+// Google Test
+#include "gtest/gtest.h"
+
+#include "DeltaCompare.hpp"
+#include "RefFile.hpp"
+#include "reader/Reader.hpp"
+#include "nhcd_structs.h"
+#include "libwiicrypto/byteswap.h"
+#include "libwiicrypto/wii_structs.h"
+#include "libwiicrypto/wii_sector.h"
+
+// C includes. (C++ namespace)
+#include <cstdio>
+#include <cstring>
+
+// C++ includes.
+#include <memory>
+#include <random>
+#include <vector>
+using std::unique_ptr;
+using std::vector;
+
+namespace LibRvth { namespace Tests {
+
+// Test image layout.
+// The partition header is followed by the H3 table,
+// and the group data starts at partition offset 0x20000.
+static const uint32_t PARTITION_ADDRESS = 0x50000;
+static const uint32_t PT_H3_OFFSET = 0x8000;
+static const uint32_t PT_DATA_OFFSET = 0x20000;
+static const uint32_t GROUP_SIZE = 2U*1024U*1024U;
+static const unsigned int GROUP_COUNT = 4;
+
+static const uint32_t PT_LBA = BYTES_TO_LBA(PARTITION_ADDRESS);
+static const uint32_t DATA_LBA = BYTES_TO_LBA(PARTITION_ADDRESS + PT_DATA_OFFSET);
+static const uint32_t GROUP_SIZE_LBA = BYTES_TO_LBA(GROUP_SIZE);
+static const uint32_t IMAGE_SIZE = PARTITION_ADDRESS + PT_DATA_OFFSET + (GROUP_COUNT * GROUP_SIZE);
+static const uint32_t IMAGE_SIZE_LBA = BYTES_TO_LBA(IMAGE_SIZE);
+
+// Image filenames. (created in the current directory)
+static const TCHAR DST_FILENAME[] = _T("DeltaCompareTest.dst.gcm");
+static const TCHAR SRC_FILENAME[] = _T("DeltaCompareTest.src.gcm");
+
+class DeltaCompareTest : public ::testing::Test
+{
+protected:
+	void SetUp(void) final;
+	void TearDown(void) final;
+
+	/**
+	 * Write an image to a file and open a Reader for it.
+	 * @param filename Filename
+	 * @param image Image
+	 * @return Reader, or nullptr on error.
+	 */
+	static Reader *writeImage(const TCHAR *filename, const vector<uint8_t> &image);
+
+	/**
+	 * Compare the source image with the destination image.
+	 * @param delta DeltaCompare object
+	 * @return Starting LBAs of the changed units.
+	 */
+	vector<uint32_t> changedUnits(DeltaCompare &delta) const;
+
+	/**
+	 * Get a pointer to a group's H3 entry.
+	 * @param image Image
+	 * @param group Group number
+	 * @return H3 entry
+	 */
+	static inline uint8_t *h3Entry(vector<uint8_t> &image, unsigned int group)
+	{
+		return &image[PARTITION_ADDRESS + PT_H3_OFFSET + (group * RVL_SHA1_DIGEST_SIZE)];
+	}
+
+	/**
+	 * Get a pointer to a group's data.
+	 * @param image Image
+	 * @param group Group number
+	 * @return Group data
+	 */
+	static inline uint8_t *groupData(vector<uint8_t> &image, unsigned int group)
+	{
+		return &image[PARTITION_ADDRESS + PT_DATA_OFFSET + (group * GROUP_SIZE)];
+	}
+
+	vector<uint8_t> m_dstImage;
+	vector<uint8_t> m_srcImage;
+	unique_ptr<Reader> m_dst;
+	unique_ptr<Reader> m_src;
+};
+
+/**
+ * Write an image to a file and open a Reader for it.
+ * @param filename Filename
+ * @param image Image
+ * @return Reader, or nullptr on error.
+ */
+Reader *DeltaCompareTest::writeImage(const TCHAR *filename, const vector<uint8_t> &image)
+{
+	RefFilePtr file = std::make_shared<RefFile>(filename, true);
+	if (!file->isOpen())
+		return nullptr;
+	if (file->write(image.data(), 1, image.size()) != image.size())
+		return nullptr;
+	file->flush();
+	return Reader::open(file, 0, IMAGE_SIZE_LBA);
+}
+
+/**
+ * Generate the destination image.
+ * The source image starts out as a copy of the destination image.
+ */
+void DeltaCompareTest::SetUp(void)
+{
+	std::mt19937 rng(0x52565448);	// 'RVTH'
+	m_dstImage.resize(IMAGE_SIZE);
+	for (uint32_t i = 0; i < IMAGE_SIZE; i += 4) {
+		const uint32_t v = rng();
+		memcpy(&m_dstImage[i], &v, sizeof(v));
+	}
+
+	// Partition header.
+	RVL_PartitionHeader *const pthdr = reinterpret_cast<RVL_PartitionHeader*>(&m_dstImage[PARTITION_ADDRESS]);
+	pthdr->h3_table_offset = cpu_to_be32(PT_H3_OFFSET >> 2);
+	pthdr->data_offset = cpu_to_be32(PT_DATA_OFFSET >> 2);
+	pthdr->data_size = cpu_to_be32((GROUP_COUNT * GROUP_SIZE) >> 2);
+
+	m_srcImage = m_dstImage;
+}
+
+/**
+ * Delete the test images.
+ */
+void DeltaCompareTest::TearDown(void)
+{
+	m_src.reset();
+	m_dst.reset();
+	_tremove(DST_FILENAME);
+	_tremove(SRC_FILENAME);
+}
+
+/**
+ * Compare the source image with the destination image.
+ * @param delta DeltaCompare object
+ * @return Starting LBAs of the changed units.
+ */
+vector<uint32_t> DeltaCompareTest::changedUnits(DeltaCompare &delta) const
+{
+	vector<uint32_t> changed;
+	uint32_t lba = 0;
+	while (lba < IMAGE_SIZE_LBA) {
+		uint32_t end = delta.unitEnd(lba);
+		EXPECT_GT(end, lba);
+		if (end > IMAGE_SIZE_LBA) {
+			end = IMAGE_SIZE_LBA;
+		}
+		if (delta.isChanged(&m_srcImage[LBA_TO_BYTES(lba)], lba, end - lba)) {
+			changed.push_back(lba);
+		}
+		lba = end;
+	}
+	return changed;
+}
+
+/**
+ * Units follow the partition's groups.
+ */
+TEST_F(DeltaCompareTest, unitBoundaries)
+{
+	m_dst.reset(writeImage(DST_FILENAME, m_dstImage));
+	m_src.reset(writeImage(SRC_FILENAME, m_srcImage));
+	ASSERT_TRUE(m_dst != nullptr);
+	ASSERT_TRUE(m_src != nullptr);
+
+	DeltaCompare delta(m_dst.get());
+
+	// Without a partition, units are 2 MB blocks.
+	EXPECT_EQ(DeltaCompare::UNIT_SIZE_LBA, delta.unitEnd(0));
+	EXPECT_EQ(DeltaCompare::UNIT_SIZE_LBA * 2, delta.unitEnd(DATA_LBA + GROUP_SIZE_LBA));
+
+	// With a partition, units end at the start of the
+	// group data, then follow the groups.
+	ASSERT_EQ(0, delta.addPartition(m_src.get(), PT_LBA, IMAGE_SIZE_LBA - PT_LBA));
+	EXPECT_EQ(DATA_LBA, delta.unitEnd(0));
+	EXPECT_EQ(DATA_LBA, delta.unitEnd(PT_LBA));
+	EXPECT_EQ(DATA_LBA + GROUP_SIZE_LBA, delta.unitEnd(DATA_LBA));
+	EXPECT_EQ(DATA_LBA + (GROUP_SIZE_LBA * 2), delta.unitEnd(DATA_LBA + GROUP_SIZE_LBA + 1));
+	EXPECT_EQ(IMAGE_SIZE_LBA, delta.unitEnd(IMAGE_SIZE_LBA - 1));
+}
+
+/**
+ * Identical images don't have any changed units.
+ */
+TEST_F(DeltaCompareTest, identical)
+{
+	m_dst.reset(writeImage(DST_FILENAME, m_dstImage));
+	m_src.reset(writeImage(SRC_FILENAME, m_srcImage));
+	ASSERT_TRUE(m_dst != nullptr);
+	ASSERT_TRUE(m_src != nullptr);
+
+	DeltaCompare delta(m_dst.get());
+	ASSERT_EQ(0, delta.addPartition(m_src.get(), PT_LBA, IMAGE_SIZE_LBA - PT_LBA));
+	EXPECT_TRUE(changedUnits(delta).empty());
+
+	// Everything was read from the destination.
+	EXPECT_EQ((uint64_t)IMAGE_SIZE + sizeof(RVL_PartitionHeader) + sizeof(Wii_Disc_H3_t), delta.bytesRead());
+}
+
+/**
+ * Changed groups are found with and without H3 changes.
+ * Groups with different H3 entries aren't read from the destination.
+ */
+TEST_F(DeltaCompareTest, changedGroups)
+{
+	// Disc header change.
+	m_srcImage[0x100] ^= 0xFF;
+	// Group 1: Data and H3 change.
+	groupData(m_srcImage, 1)[0x12345] ^= 0xFF;
+	h3Entry(m_srcImage, 1)[0] ^= 0xFF;
+	// Group 3: Data change only.
+	groupData(m_srcImage, 3)[GROUP_SIZE - 1] ^= 0xFF;
+
+	m_dst.reset(writeImage(DST_FILENAME, m_dstImage));
+	m_src.reset(writeImage(SRC_FILENAME, m_srcImage));
+	ASSERT_TRUE(m_dst != nullptr);
+	ASSERT_TRUE(m_src != nullptr);
+
+	DeltaCompare delta(m_dst.get());
+	ASSERT_EQ(0, delta.addPartition(m_src.get(), PT_LBA, IMAGE_SIZE_LBA - PT_LBA));
+	const vector<uint32_t> changed = changedUnits(delta);
+	ASSERT_EQ(3U, changed.size());
+	EXPECT_EQ(0U, changed[0]);
+	EXPECT_EQ(DATA_LBA + GROUP_SIZE_LBA, changed[1]);
+	EXPECT_EQ(DATA_LBA + (GROUP_SIZE_LBA * 3), changed[2]);
+
+	// Group 1 wasn't read from the destination.
+	EXPECT_EQ((uint64_t)IMAGE_SIZE - GROUP_SIZE + sizeof(RVL_PartitionHeader) + sizeof(Wii_Disc_H3_t), delta.bytesRead());
+}
+
+/**
+ * If the partition layouts don't match, the H3 tables aren't used,
+ * but changed groups are still found by comparing the data.
+ */
+TEST_F(DeltaCompareTest, layoutMismatch)
+{
+	// Group 2: Data and H3 change.
+	groupData(m_srcImage, 2)[0] ^= 0xFF;
+	h3Entry(m_srcImage, 2)[0] ^= 0xFF;
+	// Different data offset in the destination.
+	RVL_PartitionHeader *const pthdr = reinterpret_cast<RVL_PartitionHeader*>(&m_dstImage[PARTITION_ADDRESS]);
+	pthdr->data_offset = cpu_to_be32((PT_DATA_OFFSET + GROUP_SIZE) >> 2);
+
+	m_dst.reset(writeImage(DST_FILENAME, m_dstImage));
+	m_src.reset(writeImage(SRC_FILENAME, m_srcImage));
+	ASSERT_TRUE(m_dst != nullptr);
+	ASSERT_TRUE(m_src != nullptr);
+
+	DeltaCompare delta(m_dst.get());
+	ASSERT_EQ(0, delta.addPartition(m_src.get(), PT_LBA, IMAGE_SIZE_LBA - PT_LBA));
+	EXPECT_EQ(DeltaCompare::UNIT_SIZE_LBA, delta.unitEnd(0));
+
+	// Everything was read from the destination, so the changed units
+	// are the 2 MB blocks that contain the partition header and group 2.
+	const vector<uint32_t> changed = changedUnits(delta);
+	ASSERT_EQ(2U, changed.size());
+	EXPECT_EQ(0U, changed[0]);
+	EXPECT_EQ((DATA_LBA + (GROUP_SIZE_LBA * 2)) / DeltaCompare::UNIT_SIZE_LBA * DeltaCompare::UNIT_SIZE_LBA, changed[1]);
+	EXPECT_EQ((uint64_t)IMAGE_SIZE + sizeof(RVL_PartitionHeader), delta.bytesRead());
+}
+
+} }
+
+#ifdef _MSC_VER
+# define RVTH_CDECL __cdecl
+#else
+# define RVTH_CDECL
+#endif
+
+/**
+ * Test suite main function.
+ */
+int RVTH_CDECL main(int argc, char *argv[])
+{
+	fprintf(stderr, "librvth test suite: Incremental import comparison tests.\n\n");
+	fflush(nullptr);
+
+	// coverity[fun_call_w_exception]: uncaught exceptions cause nonzero exit anyway, so don't warn.
+	::testing::InitGoogleTest(&argc, argv);
+	return RUN_ALL_TESTS();
+}
@@ -0,0 +1,203 @@
+/***************************************************************************
+ * RVT-H Tool (librvth/tests)                                              *
+ * DiscFsTest.cpp: Wii partition filesystem tree tests.                    *
+ *                                                                         *
+ * Copyright (c) 2026 by David Korth.                                      *
+ * SPDX-License-Identifier: GPL-2.0-or-later                               *
+ ***************************************************************************/
+
+// Google Test
+#include "gtest/gtest.h"
+
+#include "DiscFs.hpp"
+#include "byteswap.h"
+
+// C includes. (C++ namespace)
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+
+// C++ includes.
+#include <string>
+#include <vector>
+using std::string;
+using std::vector;
+
+namespace LibRvth { namespace Tests {
+
+class DiscFsTest : public ::testing::Test
+{
+protected:
+	/**
+	 * Add an FST entry.
+	 * @param is_dir True for a directory
+	 * @param name Name
+	 * @param offset File: offset (RSH2); Directory: parent index
+	 * @param size File: size; Directory: index of the next entry after it
+	 */
+	void addEntry(bool is_dir, const char *name, uint32_t offset, uint32_t size);
+
+	/**
+	 * Build the FST from the added entries.
+	 * @return FST
+	 */
+	vector<uint8_t> build(void) const;
+
+	struct FstEntry {
+		bool is_dir;
+		string name;
+		uint32_t offset;
+		uint32_t size;
+	};
+	vector<FstEntry> m_entries;
+};
+
+/**
+ * Add an FST entry.
+ * @param is_dir True for a directory
+ * @param name Name
+ * @param offset File: offset (RSH2); Directory: parent index
+ * @param size File: size; Directory: index of the next entry after it
+ */
+void DiscFsTest::addEntry(bool is_dir, const char *name, uint32_t offset, uint32_t size)
+{
+	m_entries.push_back(FstEntry{is_dir, name, offset, size});
+}
+
+/**
+ * Build the FST from the added entries.
+ * The root entry is added automatically.
+ * @return FST
+ */
+vector<uint8_t> DiscFsTest::build(void) const
+{
+	const uint32_t count = static_cast<uint32_t>(m_entries.size() + 1);
+	vector<uint8_t> fst(count * 12);
+	string strtbl;
+
+	auto put = [&fst](unsigned int idx, uint32_t w0, uint32_t w1, uint32_t w2) {
+		const uint32_t words[3] = {cpu_to_be32(w0), cpu_to_be32(w1), cpu_to_be32(w2)};
+		memcpy(&fst[idx * 12], words, sizeof(words));
+	};
+
+	put(0, 0x01000000, 0, count);
+	for (unsigned int i = 0; i < m_entries.size(); i++) {
+		const FstEntry &e = m_entries[i];
+		const uint32_t name_offset = static_cast<uint32_t>(strtbl.size());
+		strtbl.append(e.name);
+		strtbl.push_back('\0');
+		put(i + 1, (e.is_dir ? 0x01000000 : 0) | name_offset, e.offset, e.size);
+	}
+
+	fst.insert(fst.end(), strtbl.begin(), strtbl.end());
+	return fst;
+}
+
+/**
+ * Nested directories and files are added with the correct offsets.
+ */
+TEST_F(DiscFsTest, nested)
+{
+	addEntry(false, "opening.bnr", 0x10000, 0x5000);	// 1
+	addEntry(true, "data", 0, 6);				// 2
+	addEntry(false, "a.bin", 0x20000, 100);			// 3
+	addEntry(true, "sub", 2, 6);				// 4
+	addEntry(false, "b.bin", 0x40000000, 200);		// 5 (> 4 GB after RSH2)
+	addEntry(false, "c.bin", 0x30000, 300);			// 6 (back in the root)
+	const vector<uint8_t> fst = build();
+
+	DiscFs fs;
+	const unsigned int files = fs.addDir(DiscFs::ROOT, "files");
+	ASSERT_EQ(0, fs.addFst(files, fst.data(), fst.size(), 2));
+
+	int idx = fs.lookup("/files/opening.bnr");
+	ASSERT_GE(idx, 0);
+	EXPECT_FALSE(fs.entry(idx).is_dir);
+	EXPECT_EQ(0x40000U, fs.entry(idx).offset);
+	EXPECT_EQ(0x5000U, fs.entry(idx).size);
+
+	idx = fs.lookup("/files/data/sub/b.bin");
+	ASSERT_GE(idx, 0);
+	EXPECT_EQ(0x100000000ULL, fs.entry(idx).offset);
+	EXPECT_EQ(200U, fs.entry(idx).size);
+
+	idx = fs.lookup("/files/c.bin");
+	ASSERT_GE(idx, 0);
+	EXPECT_EQ(0xC0000U, fs.entry(idx).offset);
+
+	idx = fs.lookup("/files/data");
+	ASSERT_GE(idx, 0);
+	EXPECT_TRUE(fs.entry(idx).is_dir);
+	EXPECT_EQ(2U, fs.entry(idx).children.size());
+
+	EXPECT_EQ(static_cast<int>(DiscFs::ROOT), fs.lookup("/"));
+	EXPECT_EQ(-1, fs.lookup("/files/c.bin/x"));
+	EXPECT_EQ(-1, fs.lookup("/files/missing"));
+	EXPECT_EQ(-1, fs.lookup("/files/data/c.bin"));
+}
+
+/**
+ * A directory that ends past its parent directory is an error.
+ */
+TEST_F(DiscFsTest, badDirEnd)
+{
+	addEntry(true, "a", 0, 4);	// 1
+	addEntry(true, "b", 1, 5);	// 2 (ends after "a")
+	addEntry(false, "c", 0, 1);	// 3
+	addEntry(false, "d", 0, 1);	// 4
+	const vector<uint8_t> fst = build();
+
+	DiscFs fs;
+	EXPECT_EQ(-EIO, fs.addFst(DiscFs::ROOT, fst.data(), fst.size(), 2));
+}
+
+/**
+ * Invalid names and truncated FSTs are errors.
+ */
+TEST_F(DiscFsTest, invalid)
+{
+	addEntry(false, "..", 0, 1);
+	vector<uint8_t> fst = build();
+	DiscFs fs1;
+	EXPECT_EQ(-EIO, fs1.addFst(DiscFs::ROOT, fst.data(), fst.size(), 2));
+
+	m_entries.clear();
+	addEntry(false, "a/b", 0, 1);
+	fst = build();
+	DiscFs fs2;
+	EXPECT_EQ(-EIO, fs2.addFst(DiscFs::ROOT, fst.data(), fst.size(), 2));
+
+	// Unterminated string table.
+	m_entries.clear();
+	addEntry(false, "file", 0, 1);
+	fst = build();
+	fst.pop_back();
+	DiscFs fs3;
+	EXPECT_EQ(-EIO, fs3.addFst(DiscFs::ROOT, fst.data(), fst.size(), 2));
+
+	// Entry count larger than the FST.
+	fst = build();
+	DiscFs fs4;
+	EXPECT_EQ(-EIO, fs4.addFst(DiscFs::ROOT, fst.data(), 12, 2));
+}
+
+} }
+
+#ifdef _MSC_VER
+# define RVTH_CDECL __cdecl
+#else
+# define RVTH_CDECL
+#endif
+
+/**
+ * Test suite main function.
+ */
+int RVTH_CDECL main(int argc, char *argv[])
+{
+	fprintf(stderr, "librvth test suite: Wii partition filesystem tree tests.\n\n");
+	fflush(nullptr);
+
+	// coverity[fun_call_w_exception]: uncaught exceptions cause nonzero exit anyway, so don't warn.
+	::testing::InitGoogleTest(&argc, argv);
+	return RUN_ALL_TESTS();
+}
@@ -0,0 +1,144 @@
+/***************************************************************************
+ * RVT-H Tool (librvth/tests)                                              *
+ * DiscHasherTest.cpp: Disc image digest tests.                            *
+ *                                                                         *
+ * Copyright (c) 2026 by David Korth.                                      *
+ * SPDX-License-Identifier: GPL-2.0-or-later                               *
+ ***************************************************************************/
+
+// Google Test
+#include "gtest/gtest.h"
+
+#include "DiscHasher.hpp"
+#include "rvth.hpp"
+#include "libwiicrypto/crc32.h"
+
+// C includes. (C++ namespace)
+#include <cstdio>
+#include <cstring>
+
+// C++ includes.
+#include <random>
+#include <vector>
+using std::vector;
+
+// Nettle
+#include <nettle/md5.h>
+#include <nettle/sha1.h>
+
+namespace LibRvth { namespace Tests {
+
+/**
+ * Compute the expected digests of a buffer in a single call.
+ * @param data Data
+ * @param pDigests Digests
+ */
+static void expectedDigests(const vector<uint8_t> &data, RvtH_Digests *pDigests)
+{
+	pDigests->size = data.size();
+	pDigests->crc32 = crc32_update(0, data.data(), data.size());
+
+	struct md5_ctx md5;
+	md5_init(&md5);
+	md5_update(&md5, data.size(), data.data());
+	md5_digest(&md5, sizeof(pDigests->md5), pDigests->md5);
+
+	struct sha1_ctx sha1;
+	sha1_init(&sha1);
+	sha1_update(&sha1, data.size(), data.data());
+	sha1_digest(&sha1, sizeof(pDigests->sha1), pDigests->sha1);
+}
+
+/**
+ * Check that two sets of digests are identical.
+ * @param expected Expected digests
+ * @param actual Actual digests
+ */
+static void checkDigests(const RvtH_Digests &expected, const RvtH_Digests &actual)
+{
+	EXPECT_EQ(expected.size, actual.size);
+	EXPECT_EQ(expected.crc32, actual.crc32);
+	EXPECT_EQ(0, memcmp(expected.md5, actual.md5, sizeof(expected.md5)));
+	EXPECT_EQ(0, memcmp(expected.sha1, actual.sha1, sizeof(expected.sha1)));
+}
+
+/**
+ * An empty stream has the digests of no data.
+ */
+TEST(DiscHasherTest, empty)
+{
+	RvtH_Digests expected, actual;
+	expectedDigests(vector<uint8_t>(), &expected);
+
+	DiscHasher hasher;
+	hasher.finish(&actual);
+	checkDigests(expected, actual);
+}
+
+/**
+ * Data added in pieces of various sizes, including pieces larger
+ * than the whole buffer ring, has the same digests as the data
+ * hashed all at once.
+ */
+TEST(DiscHasherTest, pieces)
+{
+	// Enough data to cycle through the buffer ring a few times.
+	vector<uint8_t> data((DiscHasher::BUF_SIZE * DiscHasher::BUF_COUNT * 3) + 12345);
+	std::mt19937 rng(0x52565448);	// 'RVTH'
+	for (uint8_t &b : data) {
+		b = static_cast<uint8_t>(rng());
+	}
+
+	RvtH_Digests expected, actual;
+	expectedDigests(data, &expected);
+
+	static const size_t piece_sizes[] = {
+		1, 511, 512, 4096, 65537,
+		DiscHasher::BUF_SIZE - 1,
+		DiscHasher::BUF_SIZE,
+		DiscHasher::BUF_SIZE * DiscHasher::BUF_COUNT * 2,
+	};
+	DiscHasher hasher;
+	size_t pos = 0;
+	for (unsigned int i = 0; pos < data.size(); i++) {
+		size_t size = piece_sizes[i % ARRAY_SIZE(piece_sizes)];
+		if (size > data.size() - pos) {
+			size = data.size() - pos;
+		}
+		hasher.update(&data[pos], size);
+		pos += size;
+	}
+	hasher.finish(&actual);
+	checkDigests(expected, actual);
+}
+
+/**
+ * Destroying the hasher without finishing it doesn't hang.
+ */
+TEST(DiscHasherTest, abandon)
+{
+	vector<uint8_t> data(DiscHasher::BUF_SIZE * 2 + 1);
+	DiscHasher hasher;
+	hasher.update(data.data(), data.size());
+}
+
+} }
+
+#ifdef _MSC_VER
+# define RVTH_CDECL __cdecl
+#else
+# define RVTH_CDECL
+#endif
+
+/**
+ * Test suite main function.
+ */
+int RVTH_CDECL main(int argc, char *argv[])
+{
+	fprintf(stderr, "librvth test suite: Disc image digest tests.\n\n");
+	fflush(nullptr);
+
+	// coverity[fun_call_w_exception]: uncaught exceptions cause nonzero exit anyway, so don't warn.
+	::testing::InitGoogleTest(&argc, argv);
+	return RUN_ALL_TESTS();
+}
@@ -0,0 +1,158 @@
+/***************************************************************************
+ * RVT-H Tool (librvth/tests)                                              *
+ * HddImageTest.cpp: RVT-H HDD image bank initialization tests.            *
+ *                                                                         *
+ * Copyright (c) 2026 by David Korth.                                      *
+ * SPDX-License-Identifier: GPL-2.0-or-later                               *
+ ***************************************************************************/
+
+// Google Test
+#include "gtest/gtest.h"
+
+#include "RefFile.hpp"
+#include "rvth.hpp"
+#include "reader/Reader.hpp"
+#include "nhcd_structs.h"
+#include "byteswap.h"
+#include "bench/ImageGenerator.hpp"
+
+// C includes. (C++ namespace)
+#include <cstdio>
+#include <cstring>
+
+// C++ includes.
+#include <memory>
+using std::unique_ptr;
+
+namespace LibRvth { namespace Tests {
+
+// Number of 2 MB groups in each bank's disc image.
+static const unsigned int GROUP_COUNT = 2;
+
+// Number of banks with disc images.
+// The remaining banks are empty.
+static const unsigned int BANKS_USED = 5;
+
+// This bank is changed to a dual-layer Wii image,
+// so the next bank is its second layer.
+static const unsigned int BANK_DL = 2;
+
+// Number of times to open the image.
+// Banks are initialized in parallel, so races between
+// banks don't show up every time.
+static const unsigned int OPEN_COUNT = 64;
+
+// Test image filename.
+static const TCHAR HDD_FILENAME[] = _T("HddImageTest.hdd.img");
+
+class HddImageTest : public ::testing::Test
+{
+protected:
+	static void SetUpTestCase(void);
+	static void TearDownTestCase(void);
+
+	// Disc image size, in LBAs.
+	static uint32_t lba_len;
+};
+
+uint32_t HddImageTest::lba_len = 0;
+
+/**
+ * Generate the HDD image.
+ */
+void HddImageTest::SetUpTestCase(void)
+{
+	ImageGenerator gen(GROUP_COUNT);
+	ASSERT_EQ(0, gen.writeHdd(HDD_FILENAME, BANKS_USED));
+	lba_len = static_cast<uint32_t>(BYTES_TO_LBA(gen.imageSize()));
+
+	// Change one of the banks to dual-layer.
+	RefFile file(HDD_FILENAME);
+	ASSERT_TRUE(file.isOpen());
+	ASSERT_EQ(0, file.makeWritable());
+	const off64_t addr = LBA_TO_BYTES(NHCD_BANKTABLE_ADDRESS_LBA) +
+		NHCD_BLOCK_SIZE + (BANK_DL * sizeof(NHCD_BankEntry));
+	NHCD_BankEntry entry;
+	ASSERT_EQ(sizeof(entry), file.pread(&entry, sizeof(entry), addr));
+	entry.type = cpu_to_be32(NHCD_BankType_Wii_DL);
+	ASSERT_EQ(sizeof(entry), file.pwrite(&entry, sizeof(entry), addr));
+	file.flush();
+}
+
+/**
+ * Delete the HDD image.
+ */
+void HddImageTest::TearDownTestCase(void)
+{
+	_tremove(HDD_FILENAME);
+}
+
+/**
+ * Each bank's reader must have the correct location and type.
+ * The readers share one RefFile and are opened in parallel.
+ */
+TEST_F(HddImageTest, bankReaders)
+{
+	for (unsigned int n = 0; n < OPEN_COUNT; n++) {
+		int err = 0;
+		unique_ptr<RvtH> rvth(new RvtH(HDD_FILENAME, &err));
+		ASSERT_TRUE(rvth->isOpen()) << "err == " << err;
+		ASSERT_EQ(RVTH_ImageType_HDD_Image, rvth->imageType());
+		ASSERT_EQ(static_cast<unsigned int>(NHCD_BANK_COUNT), rvth->bankCount());
+
+		for (unsigned int bank = 0; bank < rvth->bankCount(); bank++) {
+			SCOPED_TRACE(testing::Message() << "open #" << n << ", bank " << bank+1);
+			const RvtH_BankEntry *const entry = rvth->bankEntry(bank);
+			ASSERT_TRUE(entry != nullptr);
+
+			if (bank == BANK_DL + 1) {
+				// Second layer of the dual-layer image.
+				EXPECT_EQ(RVTH_BankType_Wii_DL_Bank2, entry->type);
+				EXPECT_TRUE(entry->reader == nullptr);
+				continue;
+			}
+
+			const uint32_t lba_start = NHCD_BANK_START_LBA(bank, NHCD_BANK_COUNT);
+			ASSERT_TRUE(entry->reader != nullptr);
+			EXPECT_EQ(lba_start, entry->lba_start);
+			EXPECT_EQ(lba_start, entry->reader->lba_start());
+			EXPECT_EQ(RVTH_ImageType_HDD_Image, entry->reader->type());
+
+			if (bank == BANK_DL) {
+				EXPECT_EQ(RVTH_BankType_Wii_DL, entry->type);
+				EXPECT_EQ(lba_len, entry->lba_len);
+				EXPECT_EQ(NHCD_BANK_WII_DL_SIZE_RVTR_LBA, entry->reader->lba_len());
+			} else if (bank < BANKS_USED) {
+				EXPECT_EQ(RVTH_BankType_Wii_SL, entry->type);
+				EXPECT_EQ(lba_len, entry->lba_len);
+				EXPECT_EQ(NHCD_BANK_WII_SL_SIZE_RVTR_LBA, entry->reader->lba_len());
+			} else {
+				// Empty bank. The length is determined from the bank size.
+				EXPECT_EQ(RVTH_BankType_Empty, entry->type);
+				EXPECT_EQ(NHCD_BANK_WII_SL_SIZE_RVTR_LBA, entry->lba_len);
+				EXPECT_EQ(NHCD_BANK_WII_SL_SIZE_RVTR_LBA, entry->reader->lba_len());
+			}
+		}
+	}
+}
+
+} }
+
+#ifdef _MSC_VER
+# define RVTH_CDECL __cdecl
+#else
+# define RVTH_CDECL
+#endif
+
+/**
+ * Test suite main function.
+ */
+int RVTH_CDECL main(int argc, char *argv[])
+{
+	fprintf(stderr, "librvth test suite: RVT-H HDD image bank initialization tests.\n\n");
+	fflush(nullptr);
+
+	// coverity[fun_call_w_exception]: uncaught exceptions cause nonzero exit anyway, so don't warn.
+	::testing::InitGoogleTest(&argc, argv);
+	return RUN_ALL_TESTS();
+}
@@ -0,0 +1,242 @@
+/***************************************************************************
+ * RVT-H Tool (librvth/tests)                                              *
+ * ImportVerifierTest.cpp: Import verification tests.                      *
+ *                                                                         *
+ * Copyright (c) 2026 by David Korth.                                      *
+ * SPDX-License-Identifier: GPL-2.0-or-later                               *
+ ***************************************************************************/
+
+// Google Test
+#include "gtest/gtest.h"
+
+#include "ImportVerifier.hpp"
+#include "RefFile.hpp"
+#include "rvth.hpp"
+#include "reader/Reader.hpp"
+#include "nhcd_structs.h"
+#include "bench/ImageGenerator.hpp"
+
+// C includes. (C++ namespace)
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+
+// C++ includes.
+#include <memory>
+#include <vector>
+using std::unique_ptr;
+using std::vector;
+
+namespace LibRvth { namespace Tests {
+
+// Test image layout. (See ImageGenerator.)
+static const uint32_t PARTITION_ADDRESS = 0x50000;
+static const uint32_t PT_DATA_OFFSET = 0x20000;
+static const uint32_t GROUP_SIZE = 2U*1024U*1024U;
+static const unsigned int GROUP_COUNT = 3;
+
+// Chunk size used to feed the verifier, in LBAs.
+// This isn't a multiple of the group size, so groups
+// are split across chunks.
+static const uint32_t CHUNK_LBA_LEN = 3001;
+
+// Test image filenames.
+static const TCHAR SRC_FILENAME[] = _T("ImportVerifierTest.src.gcm");
+static const TCHAR DST_FILENAME[] = _T("ImportVerifierTest.dst.gcm");
+
+class ImportVerifierTest : public ::testing::Test
+{
+protected:
+	void SetUp(void) final;
+	void TearDown(void) final;
+
+	/**
+	 * Write the source image to the destination and pass it to the verifier,
+	 * the same way RvtH::copyToHDD() does.
+	 * @param verifier ImportVerifier
+	 * @param src Source image
+	 * @param dst Data to write to the destination (nullptr to use src)
+	 */
+	void copy(ImportVerifier &verifier, const vector<uint8_t> &src, const vector<uint8_t> *dst = nullptr);
+
+	/**
+	 * Get a pointer to a group's data.
+	 * @param image Image
+	 * @param group Group number
+	 * @return Group data
+	 */
+	static inline uint8_t *groupData(vector<uint8_t> &image, unsigned int group)
+	{
+		return &image[PARTITION_ADDRESS + PT_DATA_OFFSET + (group * GROUP_SIZE)];
+	}
+
+	vector<uint8_t> m_image;
+	uint32_t m_lba_len;
+	pt_entry_t m_pte;
+	unique_ptr<Reader> m_src;
+	unique_ptr<Reader> m_dst;
+};
+
+/**
+ * Generate the source image and create an empty destination image.
+ */
+void ImportVerifierTest::SetUp(void)
+{
+	ImageGenerator gen(GROUP_COUNT);
+	ASSERT_EQ(0, gen.writeGcm(SRC_FILENAME));
+	m_lba_len = static_cast<uint32_t>(BYTES_TO_LBA(gen.imageSize()));
+
+	RefFilePtr src_file = std::make_shared<RefFile>(SRC_FILENAME);
+	ASSERT_TRUE(src_file->isOpen());
+	m_src.reset(Reader::open(src_file, 0, m_lba_len));
+	ASSERT_TRUE((bool)m_src);
+	m_image.resize(LBA_TO_BYTES(m_lba_len));
+	ASSERT_EQ(m_lba_len, m_src->read(m_image.data(), 0, m_lba_len));
+
+	RefFilePtr dst_file = std::make_shared<RefFile>(DST_FILENAME, true);
+	ASSERT_TRUE(dst_file->isOpen());
+	const vector<uint8_t> empty(m_image.size());
+	ASSERT_EQ(empty.size(), dst_file->write(empty.data(), 1, empty.size()));
+	dst_file->flush();
+	m_dst.reset(Reader::open(dst_file, 0, m_lba_len));
+	ASSERT_TRUE((bool)m_dst);
+
+	memset(&m_pte, 0, sizeof(m_pte));
+	m_pte.lba_start = BYTES_TO_LBA(PARTITION_ADDRESS);
+	m_pte.lba_len = BYTES_TO_LBA(PT_DATA_OFFSET + (GROUP_COUNT * GROUP_SIZE));
+}
+
+/**
+ * Delete the test images.
+ */
+void ImportVerifierTest::TearDown(void)
+{
+	m_src.reset();
+	m_dst.reset();
+	_tremove(SRC_FILENAME);
+	_tremove(DST_FILENAME);
+}
+
+/**
+ * Write the source image to the destination and pass it to the verifier,
+ * the same way RvtH::copyToHDD() does.
+ * @param verifier ImportVerifier
+ * @param src Source image
+ * @param dst Data to write to the destination (nullptr to use src)
+ */
+void ImportVerifierTest::copy(ImportVerifier &verifier, const vector<uint8_t> &src, const vector<uint8_t> *dst)
+{
+	if (!dst) {
+		dst = &src;
+	}
+	for (uint32_t lba = 0; lba < m_lba_len; lba += CHUNK_LBA_LEN) {
+		uint32_t lba_len = m_lba_len - lba;
+		if (lba_len > CHUNK_LBA_LEN) {
+			lba_len = CHUNK_LBA_LEN;
+		}
+		EXPECT_EQ(lba_len, m_dst->write(&(*dst)[LBA_TO_BYTES(lba)], lba, lba_len));
+		m_dst->flush();
+		verifier.update(&src[LBA_TO_BYTES(lba)], lba, lba_len);
+	}
+}
+
+/**
+ * A valid image has no errors.
+ */
+TEST_F(ImportVerifierTest, valid)
+{
+	ImportVerifier verifier(2);
+	ASSERT_EQ(0, verifier.addPartition(m_src.get(), &m_pte));
+	verifier.start(m_dst.get());
+	copy(verifier, m_image);
+
+	RvtH_Import_Stats stats;
+	ASSERT_EQ(0, verifier.finish(&stats));
+	EXPECT_TRUE(stats.verified);
+	EXPECT_TRUE(stats.reread);
+	for (unsigned int i = 0; i < ARRAY_SIZE(stats.verify_errs); i++) {
+		EXPECT_EQ(0U, stats.verify_errs[i]) << "H" << i;
+	}
+	EXPECT_EQ(0U, stats.reread_errs);
+}
+
+/**
+ * Corrupted user data in the source is found by the H0 check.
+ */
+TEST_F(ImportVerifierTest, corruptedData)
+{
+	ImportVerifier verifier(2);
+	ASSERT_EQ(0, verifier.addPartition(m_src.get(), &m_pte));
+	verifier.start(nullptr);
+
+	// Corrupt one byte of user data in group 1, sector 5.
+	// The first 1 KB of each sector is the hash table.
+	vector<uint8_t> src = m_image;
+	groupData(src, 1)[(5 * 32768) + 1024 + 100] ^= 0x55;
+	copy(verifier, src);
+
+	RvtH_Import_Stats stats;
+	ASSERT_EQ(0, verifier.finish(&stats));
+	EXPECT_TRUE(stats.verified);
+	EXPECT_FALSE(stats.reread);
+	EXPECT_EQ(1U, stats.verify_errs[0]);
+	for (unsigned int i = 1; i < ARRAY_SIZE(stats.verify_errs); i++) {
+		EXPECT_EQ(0U, stats.verify_errs[i]) << "H" << i;
+	}
+}
+
+/**
+ * Data that doesn't match when it's read back from the destination
+ * is found by the re-read check.
+ */
+TEST_F(ImportVerifierTest, rereadMismatch)
+{
+	ImportVerifier verifier(2);
+	ASSERT_EQ(0, verifier.addPartition(m_src.get(), &m_pte));
+	verifier.start(m_dst.get());
+
+	// Write bad data to group 2 in the destination.
+	vector<uint8_t> dst = m_image;
+	groupData(dst, 2)[GROUP_SIZE - 1] ^= 0x01;
+	copy(verifier, m_image, &dst);
+
+	RvtH_Import_Stats stats;
+	ASSERT_EQ(0, verifier.finish(&stats));
+	for (unsigned int i = 0; i < ARRAY_SIZE(stats.verify_errs); i++) {
+		EXPECT_EQ(0U, stats.verify_errs[i]) << "H" << i;
+	}
+	EXPECT_EQ(1U, stats.reread_errs);
+}
+
+/**
+ * Finishing before all groups are received is an error.
+ */
+TEST_F(ImportVerifierTest, incomplete)
+{
+	ImportVerifier verifier(2);
+	ASSERT_EQ(0, verifier.addPartition(m_src.get(), &m_pte));
+	verifier.start(nullptr);
+	verifier.update(m_image.data(), 0, CHUNK_LBA_LEN);
+	EXPECT_EQ(-EIO, verifier.finish(nullptr));
+}
+
+} }
+
+#ifdef _MSC_VER
+# define RVTH_CDECL __cdecl
+#else
+# define RVTH_CDECL
+#endif
+
+/**
+ * Test suite main function.
+ */
+int RVTH_CDECL main(int argc, char *argv[])
+{
+	fprintf(stderr, "librvth test suite: Import verification tests.\n\n");
+	fflush(nullptr);
+
+	// coverity[fun_call_w_exception]: uncaught exceptions cause nonzero exit anyway, so don't warn.
+	::testing::InitGoogleTest(&argc, argv);
+	return RUN_ALL_TESTS();
+}
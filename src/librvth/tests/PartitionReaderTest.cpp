@@ -0,0 +1,270 @@
+/***************************************************************************
+ * RVT-H Tool (librvth/tests)                                              *
+ * PartitionReaderTest.cpp: Decrypted Wii partition reader tests.          *
+ *                                                                         *
+ * Copyright (c) 2026 by David Korth.                                      *
+ * SPDX-License-Identifier: GPL-2.0-or-later                               *
+ ***************************************************************************/
+
+// Google Test
+#include "gtest/gtest.h"
+
+#include "reader/PartitionReader.hpp"
+#include "reader/Reader.hpp"
+#include "RefFile.hpp"
+#include "nhcd_structs.h"
+#include "bench/ImageGenerator.hpp"
+
+// C includes. (C++ namespace)
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+
+// C++ includes.
+#include <memory>
+#include <random>
+#include <vector>
+using std::unique_ptr;
+using std::vector;
+
+namespace LibRvth { namespace Tests {
+
+// Test image layout. (See ImageGenerator.)
+static const uint32_t PARTITION_ADDRESS = 0x50000;
+static const uint32_t PT_DATA_OFFSET_ENC = 0x20000;
+static const uint32_t PT_DATA_OFFSET_DEC = 0x8000;
+static const unsigned int GROUP_COUNT = 5;
+
+// Test image filename.
+static const TCHAR IMG_FILENAME[] = _T("PartitionReaderTest.gcm");
+
+class PartitionReaderTest : public ::testing::Test
+{
+protected:
+	PartitionReaderTest()
+		: m_gen(GROUP_COUNT)
+	{ }
+
+	void TearDown(void) final;
+
+	/**
+	 * Open a Reader for the test image.
+	 * @param image Image to write first (nullptr to use the existing file)
+	 * @return Reader, or nullptr on error.
+	 */
+	Reader *openImage(const vector<uint8_t> *image = nullptr);
+
+	/**
+	 * Get the partition table entry for the test image.
+	 * @param encrypted True if the image is encrypted.
+	 * @return Partition table entry
+	 */
+	static pt_entry_t pte(bool encrypted);
+
+	ImageGenerator m_gen;
+	unique_ptr<Reader> m_reader;
+};
+
+/**
+ * Delete the test image.
+ */
+void PartitionReaderTest::TearDown(void)
+{
+	m_reader.reset();
+	_tremove(IMG_FILENAME);
+}
+
+/**
+ * Open a Reader for the test image.
+ * @param image Image to write first (nullptr to use the existing file)
+ * @return Reader, or nullptr on error.
+ */
+Reader *PartitionReaderTest::openImage(const vector<uint8_t> *image)
+{
+	RefFilePtr file = std::make_shared<RefFile>(IMG_FILENAME, (image != nullptr));
+	if (!file->isOpen())
+		return nullptr;
+	if (image) {
+		if (file->write(image->data(), 1, image->size()) != image->size())
+			return nullptr;
+		file->flush();
+	}
+	return Reader::open(file, 0, 0);
+}
+
+/**
+ * Get the partition table entry for the test image.
+ * @param encrypted True if the image is encrypted.
+ * @return Partition table entry
+ */
+pt_entry_t PartitionReaderTest::pte(bool encrypted)
+{
+	pt_entry_t pte;
+	memset(&pte, 0, sizeof(pte));
+	pte.lba_start = BYTES_TO_LBA(PARTITION_ADDRESS);
+	pte.lba_len = (encrypted
+		? BYTES_TO_LBA(PT_DATA_OFFSET_ENC + (GROUP_COUNT * GROUP_SIZE_ENC))
+		: BYTES_TO_LBA(PT_DATA_OFFSET_DEC + (GROUP_COUNT * GROUP_SIZE_DEC)));
+	return pte;
+}
+
+/**
+ * Reading the whole encrypted partition returns the user data.
+ */
+TEST_F(PartitionReaderTest, encryptedFull)
+{
+	ASSERT_EQ(0, m_gen.writeGcm(IMG_FILENAME));
+	m_reader.reset(openImage());
+	ASSERT_TRUE((bool)m_reader);
+
+	const pt_entry_t pt = pte(true);
+	unique_ptr<PartitionReader> ptReader(PartitionReader::open(m_reader.get(), &pt, true));
+	ASSERT_TRUE((bool)ptReader);
+	ASSERT_EQ(static_cast<uint64_t>(GROUP_COUNT) * GROUP_SIZE_DEC, ptReader->size());
+
+	vector<uint8_t> buf(static_cast<size_t>(ptReader->size()));
+	EXPECT_EQ(buf.size(), ptReader->read(buf.data(), 0, buf.size()));
+	EXPECT_EQ(0, memcmp(m_gen.userData(), buf.data(), buf.size()));
+	EXPECT_EQ(GROUP_COUNT, ptReader->cacheMisses());
+
+	// Reads past the end are truncated.
+	uint8_t tmp[64];
+	EXPECT_EQ(16U, ptReader->read(tmp, ptReader->size() - 16, sizeof(tmp)));
+	EXPECT_EQ(0U, ptReader->read(tmp, ptReader->size(), sizeof(tmp)));
+}
+
+/**
+ * Small scattered reads, including reads that cross sector
+ * and group boundaries, only decrypt each group once.
+ */
+TEST_F(PartitionReaderTest, scatteredReads)
+{
+	ASSERT_EQ(0, m_gen.writeGcm(IMG_FILENAME));
+	m_reader.reset(openImage());
+	ASSERT_TRUE((bool)m_reader);
+
+	const pt_entry_t pt = pte(true);
+	unique_ptr<PartitionReader> ptReader(PartitionReader::open(m_reader.get(), &pt, true));
+	ASSERT_TRUE((bool)ptReader);
+
+	std::mt19937 rng(0x52565448);	// 'RVTH'
+	const uint8_t *const userData = m_gen.userData();
+	uint8_t buf[1024];
+	for (unsigned int i = 0; i < 1000; i++) {
+		const uint64_t pos = rng() % (ptReader->size() - sizeof(buf));
+		const size_t size = 1 + (rng() % sizeof(buf));
+		ASSERT_EQ(size, ptReader->read(buf, pos, size)) << "pos " << pos;
+		ASSERT_EQ(0, memcmp(&userData[pos], buf, size)) << "pos " << pos;
+	}
+
+	// Sector and group boundaries.
+	static const uint64_t boundaries[] = {SECTOR_SIZE_DEC, GROUP_SIZE_DEC, 3 * GROUP_SIZE_DEC};
+	for (uint64_t pos : boundaries) {
+		ASSERT_EQ(sizeof(buf), ptReader->read(buf, pos - 100, sizeof(buf)));
+		EXPECT_EQ(0, memcmp(&userData[pos - 100], buf, sizeof(buf))) << "pos " << pos;
+	}
+
+	// All groups fit in the default cache.
+	EXPECT_EQ(GROUP_COUNT, ptReader->cacheMisses());
+}
+
+/**
+ * The least recently used group is evicted when the cache is full.
+ */
+TEST_F(PartitionReaderTest, lruEviction)
+{
+	ASSERT_EQ(0, m_gen.writeGcm(IMG_FILENAME));
+	m_reader.reset(openImage());
+	ASSERT_TRUE((bool)m_reader);
+
+	const pt_entry_t pt = pte(true);
+	unique_ptr<PartitionReader> ptReader(PartitionReader::open(m_reader.get(), &pt, true, 2 * GROUP_SIZE_DEC));
+	ASSERT_TRUE((bool)ptReader);
+
+	uint8_t tmp[16];
+	static const unsigned int groups[] = {0, 1, 0, 2, 1, 2};
+	static const bool hit[] = {false, false, true, false, false, true};
+	unsigned int misses = 0;
+	for (unsigned int i = 0; i < ARRAY_SIZE(groups); i++) {
+		ASSERT_EQ(sizeof(tmp), ptReader->read(tmp, static_cast<uint64_t>(groups[i]) * GROUP_SIZE_DEC, sizeof(tmp)));
+		if (!hit[i]) {
+			misses++;
+		}
+		EXPECT_EQ(misses, ptReader->cacheMisses()) << "read " << i;
+	}
+}
+
+/**
+ * With hash checking enabled, reads from a corrupted group fail,
+ * and other groups can still be read.
+ */
+TEST_F(PartitionReaderTest, checkHashes)
+{
+	ASSERT_EQ(0, m_gen.writeGcm(IMG_FILENAME));
+	m_reader.reset(openImage());
+	ASSERT_TRUE((bool)m_reader);
+	vector<uint8_t> image(LBA_TO_BYTES(m_reader->lba_len()));
+	ASSERT_EQ(m_reader->lba_len(), m_reader->read(image.data(), 0, m_reader->lba_len()));
+
+	// Corrupt the user data in group 2, sector 10.
+	image[PARTITION_ADDRESS + PT_DATA_OFFSET_ENC + (2 * GROUP_SIZE_ENC) + (10 * SECTOR_SIZE_ENC) + 2048] ^= 0xFF;
+	m_reader.reset(openImage(&image));
+	ASSERT_TRUE((bool)m_reader);
+
+	const pt_entry_t pt = pte(true);
+	unique_ptr<PartitionReader> ptReader(PartitionReader::open(m_reader.get(), &pt, true,
+		PartitionReader::DEFAULT_CACHE_SIZE, true));
+	ASSERT_TRUE((bool)ptReader);
+
+	uint8_t tmp[16];
+	errno = 0;
+	EXPECT_EQ(0U, ptReader->read(tmp, 2 * GROUP_SIZE_DEC, sizeof(tmp)));
+	EXPECT_EQ(EIO, errno);
+	EXPECT_EQ(sizeof(tmp), ptReader->read(tmp, 1 * GROUP_SIZE_DEC, sizeof(tmp)));
+	EXPECT_EQ(0, memcmp(&m_gen.userData()[GROUP_SIZE_DEC], tmp, sizeof(tmp)));
+
+	// Without hash checking, the corrupted group can be read.
+	ptReader.reset(PartitionReader::open(m_reader.get(), &pt, true));
+	ASSERT_TRUE((bool)ptReader);
+	EXPECT_EQ(sizeof(tmp), ptReader->read(tmp, 2 * GROUP_SIZE_DEC, sizeof(tmp)));
+}
+
+/**
+ * Reading an unencrypted partition returns the user data.
+ */
+TEST_F(PartitionReaderTest, unencrypted)
+{
+	ASSERT_EQ(0, m_gen.writeUnencrypted(IMG_FILENAME));
+	m_reader.reset(openImage());
+	ASSERT_TRUE((bool)m_reader);
+
+	const pt_entry_t pt = pte(false);
+	unique_ptr<PartitionReader> ptReader(PartitionReader::open(m_reader.get(), &pt, false));
+	ASSERT_TRUE((bool)ptReader);
+	ASSERT_EQ(static_cast<uint64_t>(GROUP_COUNT) * GROUP_SIZE_DEC, ptReader->size());
+
+	vector<uint8_t> buf(static_cast<size_t>(ptReader->size()));
+	EXPECT_EQ(buf.size(), ptReader->read(buf.data(), 0, buf.size()));
+	EXPECT_EQ(0, memcmp(m_gen.userData(), buf.data(), buf.size()));
+}
+
+} }
+
+#ifdef _MSC_VER
+# define RVTH_CDECL __cdecl
+#else
+# define RVTH_CDECL
+#endif
+
+/**
+ * Test suite main function.
+ */
+int RVTH_CDECL main(int argc, char *argv[])
+{
+	fprintf(stderr, "librvth test suite: Decrypted Wii partition reader tests.\n\n");
+	fflush(nullptr);
+
+	// coverity[fun_call_w_exception]: uncaught exceptions cause nonzero exit anyway, so don't warn.
+	::testing::InitGoogleTest(&argc, argv);
+	return RUN_ALL_TESTS();
+}
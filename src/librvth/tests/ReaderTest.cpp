@@ -0,0 +1,770 @@
+/***************************************************************************
+ * RVT-H Tool (librvth/tests)                                              *
+ * ReaderTest.cpp: Disc image reader tests and micro-benchmark.            *
+ *                                                                         *
+ * Copyright (c) 2026 by David Korth.                                      *
+ * SPDX-License-Identifier: GPL-2.0-or-later                               *
+ ***************************************************************************/
+
+// Google Test
+#include "gtest/gtest.h"
+
+#include "reader/Reader.hpp"
+#include "reader/PlainReader.hpp"
+#include "reader/CisoReader.hpp"
+#include "reader/WbfsReader.hpp"
+#include "reader/MmapReader.hpp"
+#include "reader/libwbfs.h"
+#include "nhcd_structs.h"
+#include "aligned_malloc.h"
+#include "ReadAhead.hpp"
+#include "IoQueue.hpp"
+#include "libwiicrypto/byteswap.h"
+
+// C includes. (C++ namespace)
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+
+#ifndef _WIN32
+#  include <unistd.h>
+#endif /* !_WIN32 */
+
+// C++ includes.
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <random>
+#include <thread>
+#include <vector>
+using std::unique_ptr;
+using std::vector;
+
+namespace LibRvth { namespace Tests {
+
+// Test image parameters.
+// The image is made of 2 MB blocks, which is the usual block size
+// for both CISO and WBFS. Some blocks are left empty, and the WBFS
+// image stores its blocks out of order so that the readers have to
+// split requests at non-contiguous block boundaries.
+static const uint32_t BLOCK_SIZE = 2U*1024U*1024U;
+static const uint32_t BLOCK_SIZE_LBA = BYTES_TO_LBA(BLOCK_SIZE);
+static const unsigned int BLOCK_COUNT = 48;
+
+// Image filenames. (created in the current directory)
+static const TCHAR PLAIN_FILENAME[] = _T("ReaderTest.plain.gcm");
+static const TCHAR CISO_FILENAME[] = _T("ReaderTest.ciso");
+static const TCHAR WBFS_FILENAME[] = _T("ReaderTest.wbfs");
+static const TCHAR MMAP_FILENAME[] = _T("ReaderTest.mmap.gcm");
+
+enum class ImageFormat {
+	Plain,
+	CISO,
+	WBFS,
+};
+
+class ReaderTest : public ::testing::TestWithParam<ImageFormat>
+{
+protected:
+	static void SetUpTestCase(void);
+	static void TearDownTestCase(void);
+
+	/**
+	 * Is a logical block empty?
+	 * @param block Logical block index
+	 * @return True if empty; false if not.
+	 */
+	static inline bool isBlockEmpty(unsigned int block)
+	{
+		// Every fourth block, plus a run of three blocks,
+		// but never the first or last block.
+		return (block % 4 == 2) || (block >= 20 && block < 23);
+	}
+
+	/**
+	 * Get the WBFS physical block index for a logical block.
+	 * Physical block 0 is the WBFS header.
+	 * @param block Logical block index
+	 * @return Physical block index
+	 */
+	static inline unsigned int wbfsPhysBlock(unsigned int block)
+	{
+		// Blocks [0,16) and [32,48) are stored in order.
+		// Blocks [16,32) are stored in reverse order.
+		if (block >= 16 && block < 32) {
+			return 1 + (16 + 31 - block);
+		}
+		return 1 + block;
+	}
+
+	/**
+	 * Get the test image filename for the current test parameter.
+	 * @return Filename
+	 */
+	const TCHAR *imageFilename(void) const
+	{
+		switch (GetParam()) {
+			default:
+			case ImageFormat::Plain:	return PLAIN_FILENAME;
+			case ImageFormat::CISO:		return CISO_FILENAME;
+			case ImageFormat::WBFS:		return WBFS_FILENAME;
+		}
+	}
+
+	/**
+	 * Open the test image for the current test parameter.
+	 * @return Reader, or nullptr on error.
+	 */
+	Reader *openReader(void);
+
+public:
+	// Expected logical image contents.
+	static vector<uint8_t> image;
+};
+
+vector<uint8_t> ReaderTest::image;
+
+/**
+ * Write a buffer to a file.
+ * @param file File
+ * @param offset Offset
+ * @param ptr Buffer
+ * @param size Size
+ * @return True on success; false on error.
+ */
+static bool writeAt(RefFile *file, off64_t offset, const void *ptr, size_t size)
+{
+	if (file->seeko(offset, SEEK_SET) != 0)
+		return false;
+	return (file->write(ptr, 1, size) == size);
+}
+
+/**
+ * Generate the test images.
+ */
+void ReaderTest::SetUpTestCase(void)
+{
+	// Generate the logical image.
+	std::mt19937 rng(0x52565448);	// 'RVTH'
+	image.resize((size_t)BLOCK_COUNT * BLOCK_SIZE);
+	for (unsigned int block = 0; block < BLOCK_COUNT; block++) {
+		uint8_t *const p = &image[(size_t)block * BLOCK_SIZE];
+		if (isBlockEmpty(block)) {
+			memset(p, 0, BLOCK_SIZE);
+			continue;
+		}
+		for (uint32_t i = 0; i < BLOCK_SIZE; i += 4) {
+			const uint32_t v = rng();
+			memcpy(&p[i], &v, sizeof(v));
+		}
+	}
+
+	// Plain image.
+	unique_ptr<RefFile> plain(new RefFile(PLAIN_FILENAME, true));
+	ASSERT_TRUE(plain->isOpen());
+	ASSERT_TRUE(writeAt(plain.get(), 0, image.data(), image.size()));
+
+	// CISO image: 32 KB header, followed by the used blocks in order.
+	unique_ptr<RefFile> ciso(new RefFile(CISO_FILENAME, true));
+	ASSERT_TRUE(ciso->isOpen());
+	vector<uint8_t> ciso_header(CisoReader::CISO_HEADER_SIZE);
+	memcpy(&ciso_header[0], "CISO", 4);
+	const uint32_t block_size_le = cpu_to_le32(BLOCK_SIZE);
+	memcpy(&ciso_header[4], &block_size_le, sizeof(block_size_le));
+	off64_t ciso_offset = CisoReader::CISO_HEADER_SIZE;
+	for (unsigned int block = 0; block < BLOCK_COUNT; block++) {
+		if (isBlockEmpty(block))
+			continue;
+		ciso_header[8 + block] = 1;
+		ASSERT_TRUE(writeAt(ciso.get(), ciso_offset, &image[(size_t)block * BLOCK_SIZE], BLOCK_SIZE));
+		ciso_offset += BLOCK_SIZE;
+	}
+	ASSERT_TRUE(writeAt(ciso.get(), 0, ciso_header.data(), ciso_header.size()));
+
+	// WBFS image: 512-byte HDD sectors, 2 MB WBFS sectors.
+	// The WBFS header and disc table use physical block 0.
+	unique_ptr<RefFile> wbfs(new RefFile(WBFS_FILENAME, true));
+	ASSERT_TRUE(wbfs->isOpen());
+	const unsigned int n_wbfs_sec_per_disc = (143432*2) >> (21 - 15);
+	vector<uint8_t> wbfs_header(LBA_SIZE + sizeof(wbfs_disc_info_t) + n_wbfs_sec_per_disc * sizeof(be16_t));
+	wbfs_head_t *const head = reinterpret_cast<wbfs_head_t*>(wbfs_header.data());
+	memcpy(&head->magic, "WBFS", 4);
+	head->n_hd_sec = cpu_to_be32(BYTES_TO_LBA((off64_t)(BLOCK_COUNT + 1) * BLOCK_SIZE));
+	head->hd_sec_sz_s = 9;
+	head->wbfs_sec_sz_s = 21;
+	head->disc_table[0] = 1;
+	wbfs_disc_info_t *const disc_info = reinterpret_cast<wbfs_disc_info_t*>(&wbfs_header[LBA_SIZE]);
+	for (unsigned int block = 0; block < BLOCK_COUNT; block++) {
+		if (isBlockEmpty(block))
+			continue;
+		const unsigned int phys = wbfsPhysBlock(block);
+		disc_info->wlba_table[block] = cpu_to_be16(phys);
+		ASSERT_TRUE(writeAt(wbfs.get(), (off64_t)phys * BLOCK_SIZE, &image[(size_t)block * BLOCK_SIZE], BLOCK_SIZE));
+	}
+	ASSERT_TRUE(writeAt(wbfs.get(), 0, wbfs_header.data(), wbfs_header.size()));
+}
+
+/**
+ * Delete the test images.
+ */
+void ReaderTest::TearDownTestCase(void)
+{
+	image.clear();
+	image.shrink_to_fit();
+	_tremove(PLAIN_FILENAME);
+	_tremove(CISO_FILENAME);
+	_tremove(WBFS_FILENAME);
+}
+
+/**
+ * Open the test image for the current test parameter.
+ * @return Reader, or nullptr on error.
+ */
+Reader *ReaderTest::openReader(void)
+{
+	RefFilePtr file = std::make_shared<RefFile>(imageFilename());
+	if (!file->isOpen())
+		return nullptr;
+	Reader *const reader = Reader::open(file, 0, 0);
+	if (reader && !reader->isOpen()) {
+		delete reader;
+		return nullptr;
+	}
+	return reader;
+}
+
+/**
+ * Make sure Reader::open() selected the correct reader
+ * and that the image size is correct.
+ */
+TEST_P(ReaderTest, open)
+{
+	unique_ptr<Reader> reader(openReader());
+	ASSERT_TRUE(reader != nullptr);
+	EXPECT_EQ(BLOCK_COUNT * BLOCK_SIZE_LBA, reader->lba_len());
+
+	switch (GetParam()) {
+		case ImageFormat::Plain:
+			EXPECT_TRUE(dynamic_cast<PlainReader*>(reader.get()) != nullptr);
+			EXPECT_EQ(MmapReader::isSupported(), dynamic_cast<MmapReader*>(reader.get()) != nullptr);
+			break;
+		case ImageFormat::CISO:
+			EXPECT_TRUE(dynamic_cast<CisoReader*>(reader.get()) != nullptr);
+			break;
+		case ImageFormat::WBFS:
+			EXPECT_TRUE(dynamic_cast<WbfsReader*>(reader.get()) != nullptr);
+			break;
+	}
+}
+
+/**
+ * Map the image without copying it.
+ * Only plain images can be mapped. Changes to the mapped
+ * data must not be written back to the file.
+ */
+TEST_P(ReaderTest, map)
+{
+	unique_ptr<Reader> reader(openReader());
+	ASSERT_TRUE(reader != nullptr);
+
+	const uint32_t lba_count = BLOCK_COUNT * BLOCK_SIZE_LBA;
+	uint8_t *const p = reader->map(0, lba_count, true);
+	if (GetParam() != ImageFormat::Plain || !MmapReader::isSupported()) {
+		EXPECT_TRUE(p == nullptr);
+		return;
+	}
+	ASSERT_TRUE(p != nullptr);
+	EXPECT_EQ(0, memcmp(p, image.data(), image.size()));
+
+	// Mapping the same range again returns the same data.
+	uint8_t *const p2 = reader->map(BLOCK_SIZE_LBA, BLOCK_SIZE_LBA);
+	ASSERT_TRUE(p2 != nullptr);
+	EXPECT_EQ(&p[BLOCK_SIZE], p2);
+
+	// Out of range.
+	EXPECT_TRUE(reader->map(lba_count - 1, 2) == nullptr);
+
+	// Modify the mapped data. The file must not change.
+	p[0] ^= 0xFF;
+	uint8_t lba0[LBA_SIZE];
+	EXPECT_EQ(1U, reader->read(lba0, 0, 1));
+	EXPECT_EQ(0, memcmp(lba0, image.data(), sizeof(lba0)));
+	p[0] ^= 0xFF;
+}
+
+#ifndef _WIN32
+/**
+ * If mapped data can't be read, map() must return nullptr
+ * instead of crashing with SIGBUS, and read() must report
+ * the error.
+ * NOTE: Windows doesn't allow truncating a mapped file.
+ */
+TEST_F(ReaderTest, mapIoError)
+{
+	if (!MmapReader::isSupported()) {
+		return;
+	}
+
+	// Four blocks, truncated to one block after mapping.
+	// Reading the truncated pages raises SIGBUS.
+	RefFilePtr file = std::make_shared<RefFile>(MMAP_FILENAME, true);
+	ASSERT_TRUE(file->isOpen());
+	ASSERT_TRUE(writeAt(file.get(), 0, image.data(), 4 * BLOCK_SIZE));
+	file->flush();
+
+	unique_ptr<MmapReader> reader(new MmapReader(file, 0, 4 * BLOCK_SIZE_LBA));
+	ASSERT_TRUE(reader->isOpen());
+	ASSERT_TRUE(reader->map(0, BLOCK_SIZE_LBA) != nullptr);
+	ASSERT_EQ(0, truncate(MMAP_FILENAME, BLOCK_SIZE));
+
+	EXPECT_TRUE(reader->map(0, BLOCK_SIZE_LBA) != nullptr);
+	EXPECT_TRUE(reader->map(2 * BLOCK_SIZE_LBA, BLOCK_SIZE_LBA) == nullptr);
+	vector<uint8_t> buf(BLOCK_SIZE);
+	EXPECT_NE(BLOCK_SIZE_LBA, reader->read(buf.data(), 2 * BLOCK_SIZE_LBA, BLOCK_SIZE_LBA));
+
+	reader.reset();
+	file.reset();
+	_tremove(MMAP_FILENAME);
+}
+#endif /* !_WIN32 */
+
+/**
+ * Read the entire image in one request.
+ */
+TEST_P(ReaderTest, readAll)
+{
+	unique_ptr<Reader> reader(openReader());
+	ASSERT_TRUE(reader != nullptr);
+
+	vector<uint8_t> buf(image.size(), 0xA5);
+	EXPECT_NE(0U, reader->read(buf.data(), 0, BLOCK_COUNT * BLOCK_SIZE_LBA));
+	EXPECT_TRUE(buf == image);
+}
+
+/**
+ * Read random ranges, including ranges that start and end
+ * in the middle of blocks and span several blocks.
+ */
+TEST_P(ReaderTest, readRandom)
+{
+	unique_ptr<Reader> reader(openReader());
+	ASSERT_TRUE(reader != nullptr);
+
+	std::mt19937 rng(GetParam() == ImageFormat::WBFS ? 2 : 1);
+	const uint32_t lba_count = BLOCK_COUNT * BLOCK_SIZE_LBA;
+	vector<uint8_t> buf;
+	for (int i = 0; i < 200; i++) {
+		const uint32_t lba_start = rng() % lba_count;
+		uint32_t lba_len;
+		switch (i % 3) {
+			default:
+			case 0:	lba_len = 1 + (rng() % 64); break;
+			case 1:	lba_len = 1 + (rng() % (BLOCK_SIZE_LBA * 2)); break;
+			case 2:	lba_len = 1 + (rng() % (BLOCK_SIZE_LBA * 12)); break;
+		}
+		if (lba_len > lba_count - lba_start) {
+			lba_len = lba_count - lba_start;
+		}
+
+		buf.assign(LBA_TO_BYTES(lba_len), 0xA5);
+		const uint32_t lbas_read = reader->read(buf.data(), lba_start, lba_len);
+		if (GetParam() == ImageFormat::Plain) {
+			EXPECT_EQ(lba_len, lbas_read);
+		}
+		ASSERT_EQ(0, memcmp(buf.data(), &image[LBA_TO_BYTES(lba_start)], buf.size()))
+			<< "lba_start == " << lba_start << ", lba_len == " << lba_len;
+	}
+}
+
+/**
+ * Read from several Readers that share a single RefFile
+ * on multiple threads at once.
+ */
+TEST_P(ReaderTest, readConcurrent)
+{
+	static const unsigned int thread_count = 4;
+
+	RefFilePtr file = std::make_shared<RefFile>(imageFilename());
+	ASSERT_TRUE(file->isOpen());
+
+	vector<unique_ptr<Reader> > readers;
+	for (unsigned int i = 0; i < thread_count; i++) {
+		readers.emplace_back(Reader::open(file, 0, 0));
+		ASSERT_TRUE(readers.back() != nullptr);
+		ASSERT_TRUE(readers.back()->isOpen());
+	}
+
+	// Each thread reads the image in a different order.
+	std::atomic<unsigned int> mismatches(0);
+	vector<std::thread> threads;
+	for (unsigned int t = 0; t < thread_count; t++) {
+		threads.emplace_back([&, t]() {
+			Reader *const reader = readers[t].get();
+			vector<uint8_t> buf(BLOCK_SIZE);
+			const uint32_t len = BLOCK_SIZE_LBA - 7;
+			for (unsigned int i = 0; i < BLOCK_COUNT; i++) {
+				const unsigned int block = (i * (2*t + 1) + t) % BLOCK_COUNT;
+				const uint32_t lba = block * BLOCK_SIZE_LBA + 3;
+				reader->read(buf.data(), lba, len);
+				if (memcmp(buf.data(), &image[LBA_TO_BYTES(lba)], LBA_TO_BYTES(len)) != 0) {
+					mismatches++;
+				}
+			}
+		});
+	}
+	for (std::thread &thread : threads) {
+		thread.join();
+	}
+	EXPECT_EQ(0U, mismatches.load());
+}
+
+/**
+ * Read the image using the read-ahead pipeline.
+ * Uses a buffer size that doesn't evenly divide the image
+ * so the last chunk is partial.
+ */
+TEST_P(ReaderTest, readAhead)
+{
+	unique_ptr<Reader> reader(openReader());
+	ASSERT_TRUE(reader != nullptr);
+
+	const uint32_t lba_start = 7;
+	const uint32_t lba_len = BLOCK_COUNT * BLOCK_SIZE_LBA - lba_start;
+	ReadAhead readAhead(reader.get(), lba_start, lba_len, 3U*1024U*1024U + 1, 3);
+	EXPECT_EQ(3U*1024U*1024U + 4096U, readAhead.bufSize());
+
+	uint32_t lba_expected = lba_start;
+	ReadAhead::Chunk chunk;
+	while (readAhead.next(chunk)) {
+		ASSERT_EQ(lba_expected, chunk.lba_start);
+		ASSERT_LE(chunk.lba_len, BYTES_TO_LBA(readAhead.bufSize()));
+		EXPECT_EQ(0, chunk.err);
+		EXPECT_EQ(0, memcmp(chunk.buf, &image[LBA_TO_BYTES(chunk.lba_start)], LBA_TO_BYTES(chunk.lba_len)))
+			<< "lba_start == " << chunk.lba_start;
+		lba_expected += chunk.lba_len;
+		readAhead.release(chunk);
+	}
+	EXPECT_EQ(lba_start + lba_len, lba_expected);
+}
+
+/**
+ * Stop consuming chunks before the read-ahead pipeline is finished.
+ * The destructor must not deadlock.
+ */
+TEST_P(ReaderTest, readAheadAbort)
+{
+	unique_ptr<Reader> reader(openReader());
+	ASSERT_TRUE(reader != nullptr);
+
+	ReadAhead readAhead(reader.get(), 0, BLOCK_COUNT * BLOCK_SIZE_LBA, BLOCK_SIZE, 2);
+	ReadAhead::Chunk chunk;
+	ASSERT_TRUE(readAhead.next(chunk));
+	EXPECT_EQ(0U, chunk.lba_start);
+	// Not releasing the chunk; the destructor must still shut down.
+}
+
+/**
+ * Queue several reads at once using IoQueue, including a read
+ * that extends past the end of the file.
+ */
+TEST_F(ReaderTest, ioQueue)
+{
+	RefFilePtr file = std::make_shared<RefFile>(PLAIN_FILENAME);
+	ASSERT_TRUE(file->isOpen());
+
+	IoQueue ioQueue(file, 4);
+	printf("IoQueue is %s.\n", ioQueue.isAsync() ? "asynchronous" : "synchronous");
+	fflush(stdout);
+
+	// Queue reads until the queue is full.
+	vector<vector<uint8_t> > bufs(4, vector<uint8_t>(BLOCK_SIZE));
+	for (uintptr_t i = 0; i < 3; i++) {
+		EXPECT_FALSE(ioQueue.isFull());
+		ioQueue.read(bufs[i].data(), BLOCK_SIZE, (off64_t)(i * 5 + 1) * BLOCK_SIZE, i);
+	}
+	// Last read extends past EOF.
+	const off64_t last_offset = (off64_t)image.size() - BLOCK_SIZE/2;
+	ioQueue.read(bufs[3].data(), BLOCK_SIZE, last_offset, 3);
+	EXPECT_TRUE(ioQueue.isFull());
+	ioQueue.submit();
+
+	unsigned int seen = 0;
+	IoQueue::Completion completion;
+	while (ioQueue.wait(completion)) {
+		ASSERT_LT(completion.tag, 4U);
+		seen |= (1U << completion.tag);
+		EXPECT_EQ(bufs[completion.tag].data(), completion.ptr);
+		if (completion.tag < 3) {
+			EXPECT_EQ((size_t)BLOCK_SIZE, completion.done);
+			EXPECT_EQ(0, completion.err);
+			EXPECT_EQ(0, memcmp(completion.ptr, &image[(size_t)(completion.tag * 5 + 1) * BLOCK_SIZE], BLOCK_SIZE));
+		} else {
+			EXPECT_EQ((size_t)BLOCK_SIZE/2, completion.done);
+			EXPECT_NE(0, completion.err);
+			EXPECT_EQ(0, memcmp(completion.ptr, &image[last_offset], BLOCK_SIZE/2));
+		}
+	}
+	EXPECT_EQ(0xFU, seen);
+	EXPECT_EQ(0U, ioQueue.inFlight());
+}
+
+/**
+ * Find the data in a sparse file and copy it to another file.
+ */
+TEST_F(ReaderTest, copyRangeFrom)
+{
+	static const TCHAR SPARSE_SRC_FILENAME[] = _T("ReaderTest.sparse-src.gcm");
+	static const TCHAR SPARSE_DST_FILENAME[] = _T("ReaderTest.sparse-dst.gcm");
+
+	// Source: One data block between two holes.
+	unique_ptr<RefFile> src(new RefFile(SPARSE_SRC_FILENAME, true));
+	ASSERT_TRUE(src->isOpen());
+	ASSERT_EQ(0, src->makeSparse((off64_t)BLOCK_SIZE * 3));
+	ASSERT_EQ((size_t)BLOCK_SIZE, src->pwrite(&image[0], BLOCK_SIZE, BLOCK_SIZE));
+
+	const off64_t data = src->seekData(0);
+	if (data < 0 && errno == ENOTSUP) {
+		printf("SEEK_DATA is not supported here.\n");
+		fflush(stdout);
+	} else {
+		// Filesystems without hole support report the whole file as data.
+		EXPECT_TRUE(data == 0 || data == (off64_t)BLOCK_SIZE) << "data == " << data;
+		const off64_t hole = src->seekHole(data);
+		EXPECT_TRUE(hole == (off64_t)BLOCK_SIZE * 2 || hole == (off64_t)BLOCK_SIZE * 3) << "hole == " << hole;
+	}
+
+	// Copy the data block to the start of the destination.
+	unique_ptr<RefFile> dst(new RefFile(SPARSE_DST_FILENAME, true));
+	ASSERT_TRUE(dst->isOpen());
+	ASSERT_EQ(0, dst->makeSparse((off64_t)BLOCK_SIZE * 2));
+	EXPECT_EQ((size_t)BLOCK_SIZE, dst->copyRangeFrom(src.get(), BLOCK_SIZE, 0, BLOCK_SIZE));
+	// Unaligned copy.
+	EXPECT_EQ((size_t)LBA_SIZE * 3, dst->copyRangeFrom(src.get(), BLOCK_SIZE + LBA_SIZE, BLOCK_SIZE + LBA_SIZE, LBA_SIZE * 3));
+
+	vector<uint8_t> buf(BLOCK_SIZE);
+	ASSERT_EQ((size_t)BLOCK_SIZE, dst->pread(buf.data(), BLOCK_SIZE, 0));
+	EXPECT_EQ(0, memcmp(buf.data(), &image[0], BLOCK_SIZE));
+	ASSERT_EQ((size_t)LBA_SIZE * 4, dst->pread(buf.data(), LBA_SIZE * 4, BLOCK_SIZE));
+	EXPECT_EQ(0, memcmp(&buf[LBA_SIZE], &image[LBA_SIZE], LBA_SIZE * 3));
+
+	src.reset();
+	dst.reset();
+	_tremove(SPARSE_SRC_FILENAME);
+	_tremove(SPARSE_DST_FILENAME);
+}
+
+/**
+ * Write the test image to a new compact image, then reopen it.
+ * Empty blocks are skipped, the same way extract skips them.
+ * @param format CISO or WBFS
+ * @param shuffle If true, write partial blocks in random order.
+ */
+static void writeCompactImage(ImageFormat format, bool shuffle)
+{
+	const vector<uint8_t> &image = ReaderTest::image;
+	const TCHAR *const filename = (format == ImageFormat::CISO
+		? _T("ReaderTest.write.ciso")
+		: _T("ReaderTest.write.wbfs"));
+	const uint32_t lba_count = BLOCK_COUNT * BLOCK_SIZE_LBA;
+
+	// Split each used block into three uneven pieces.
+	struct Piece {
+		uint32_t lba_start;
+		uint32_t lba_len;
+	};
+	vector<Piece> pieces;
+	unsigned int usedBlocks = 0;
+	for (unsigned int block = 0; block < BLOCK_COUNT; block++) {
+		if ((block % 4 == 2) || (block >= 20 && block < 23))
+			continue;
+		const uint32_t lba = block * BLOCK_SIZE_LBA;
+		pieces.push_back({lba, 7});
+		pieces.push_back({lba + 7, BLOCK_SIZE_LBA - 1000});
+		pieces.push_back({lba + 7 + BLOCK_SIZE_LBA - 1000, 993});
+		usedBlocks++;
+	}
+	if (shuffle) {
+		std::mt19937 rng(3);
+		std::shuffle(pieces.begin(), pieces.end(), rng);
+	}
+
+	RefFilePtr file = std::make_shared<RefFile>(filename, true);
+	ASSERT_TRUE(file->isOpen());
+	unique_ptr<Reader> writer(format == ImageFormat::CISO
+		? static_cast<Reader*>(CisoReader::create(file, 0, lba_count))
+		: static_cast<Reader*>(WbfsReader::create(file, 0, lba_count)));
+	ASSERT_TRUE(writer != nullptr);
+	EXPECT_TRUE(writer->isCompact());
+	EXPECT_EQ(lba_count, writer->lba_len());
+	for (const Piece &piece : pieces) {
+		ASSERT_EQ(piece.lba_len, writer->write(&image[LBA_TO_BYTES(piece.lba_start)], piece.lba_start, piece.lba_len))
+			<< "lba_start == " << piece.lba_start;
+	}
+
+	// Data can be read back before the header is written.
+	vector<uint8_t> buf(image.size(), 0xA5);
+	writer->read(buf.data(), 0, lba_count);
+	EXPECT_TRUE(buf == image);
+	writer->flush();
+	writer.reset();
+
+	// Only the used blocks are stored.
+	const off64_t header_size = (format == ImageFormat::CISO ? CisoReader::CISO_HEADER_SIZE : BLOCK_SIZE);
+	EXPECT_EQ(header_size + (off64_t)usedBlocks * BLOCK_SIZE, file->size());
+
+	// Reopen the image. Existing compact images are read-only.
+	unique_ptr<Reader> reader(Reader::open(file, 0, 0));
+	ASSERT_TRUE(reader != nullptr);
+	ASSERT_TRUE(reader->isOpen());
+	if (format == ImageFormat::CISO) {
+		EXPECT_TRUE(dynamic_cast<CisoReader*>(reader.get()) != nullptr);
+	} else {
+		EXPECT_TRUE(dynamic_cast<WbfsReader*>(reader.get()) != nullptr);
+	}
+	EXPECT_EQ(lba_count, reader->lba_len());
+	buf.assign(image.size(), 0xA5);
+	EXPECT_NE(0U, reader->read(buf.data(), 0, lba_count));
+	EXPECT_TRUE(buf == image);
+	errno = 0;
+	EXPECT_EQ(0U, reader->write(image.data(), 0, 1));
+	EXPECT_EQ(EROFS, errno);
+
+	reader.reset();
+	file.reset();
+	_tremove(filename);
+}
+
+/**
+ * Write CISO and WBFS images sequentially.
+ */
+TEST_F(ReaderTest, writeCompact)
+{
+	writeCompactImage(ImageFormat::CISO, false);
+	writeCompactImage(ImageFormat::WBFS, false);
+}
+
+/**
+ * Write CISO and WBFS images in random order.
+ * CISO has to move blocks around to keep them in logical order.
+ */
+TEST_F(ReaderTest, writeCompactRandom)
+{
+	writeCompactImage(ImageFormat::CISO, true);
+	writeCompactImage(ImageFormat::WBFS, true);
+}
+
+/**
+ * Read using direct I/O, with both aligned and unaligned requests.
+ * Unaligned requests fall back to buffered I/O.
+ */
+TEST_P(ReaderTest, readDirectIO)
+{
+	RefFilePtr file = std::make_shared<RefFile>(imageFilename());
+	ASSERT_TRUE(file->isOpen());
+	const int ret = file->setDirectIO(true);
+	if (ret != 0) {
+		GTEST_SKIP() << "Direct I/O is not supported here: " << strerror(-ret);
+	}
+	EXPECT_TRUE(file->isDirectIO());
+
+	unique_ptr<Reader> reader(Reader::open(file, 0, 0));
+	ASSERT_TRUE(reader != nullptr);
+	ASSERT_TRUE(reader->isOpen());
+
+	aligned_unique_ptr<uint8_t> buf = aligned_uptr<uint8_t>(RefFile::DIRECT_IO_ALIGN, BLOCK_SIZE + LBA_SIZE);
+	static const struct {
+		uint32_t lba_start;
+		uint32_t lba_len;
+		size_t buf_offset;
+	} reqs[] = {
+		{0, BLOCK_SIZE_LBA, 0},				// aligned
+		{BLOCK_SIZE_LBA * 3, BLOCK_SIZE_LBA, 0},	// aligned
+		{BLOCK_SIZE_LBA * 5 + 1, 64, 0},		// unaligned offset
+		{BLOCK_SIZE_LBA * 7, 63, 0},			// unaligned size
+		{BLOCK_SIZE_LBA * 9, 64, LBA_SIZE},		// unaligned buffer
+	};
+	for (const auto &req : reqs) {
+		uint8_t *const p = &buf[req.buf_offset];
+		memset(p, 0xA5, LBA_TO_BYTES(req.lba_len));
+		reader->read(p, req.lba_start, req.lba_len);
+		EXPECT_EQ(0, memcmp(p, &image[LBA_TO_BYTES(req.lba_start)], LBA_TO_BYTES(req.lba_len)))
+			<< "lba_start == " << req.lba_start << ", lba_len == " << req.lba_len;
+	}
+}
+
+/**
+ * Drop the image from the OS page cache.
+ * The data must still be readable afterwards.
+ */
+TEST_P(ReaderTest, dropCache)
+{
+	unique_ptr<Reader> reader(openReader());
+	ASSERT_TRUE(reader != nullptr);
+
+	const uint32_t lba_count = BLOCK_COUNT * BLOCK_SIZE_LBA;
+	const int ret = reader->dropCache(0, lba_count);
+	if (ret == -ENOTSUP) {
+		GTEST_SKIP() << "Dropping cached data is not supported here.";
+	}
+	EXPECT_EQ(0, ret);
+
+	vector<uint8_t> buf(image.size(), 0xA5);
+	EXPECT_NE(0U, reader->read(buf.data(), 0, lba_count));
+	EXPECT_TRUE(buf == image);
+}
+
+/**
+ * Micro-benchmark: Read the entire image in 2 MB requests,
+ * the same way verify and extract read a disc.
+ * This mostly measures per-request overhead, since the image
+ * will be in the page cache after the first pass.
+ */
+TEST_P(ReaderTest, benchmark)
+{
+	static const char *const format_names[] = {"Plain", "CISO", "WBFS"};
+	static const unsigned int passes = 8;
+
+	unique_ptr<Reader> reader(openReader());
+	ASSERT_TRUE(reader != nullptr);
+
+	vector<uint8_t> buf(BLOCK_SIZE);
+	const uint32_t lba_count = BLOCK_COUNT * BLOCK_SIZE_LBA;
+	auto start = std::chrono::steady_clock::now();
+	for (unsigned int pass = 0; pass < passes; pass++) {
+		for (uint32_t lba = 0; lba < lba_count; lba += BLOCK_SIZE_LBA) {
+			reader->read(buf.data(), lba, BLOCK_SIZE_LBA);
+		}
+	}
+	auto end = std::chrono::steady_clock::now();
+
+	const double secs = std::chrono::duration<double>(end - start).count();
+	const double mib = (double)image.size() * passes / (1024.0*1024.0);
+	printf("%-5s reader: %.0f MiB in %.3f s (%.1f MiB/s)\n",
+		format_names[(int)GetParam()], mib, secs, (secs > 0 ? mib / secs : 0.0));
+	fflush(stdout);
+}
+
+INSTANTIATE_TEST_CASE_P(formats, ReaderTest,
+	::testing::Values(ImageFormat::Plain, ImageFormat::CISO, ImageFormat::WBFS));
+
+} }
+
+#ifdef _MSC_VER
+# define RVTH_CDECL __cdecl
+#else
+# define RVTH_CDECL
+#endif
+
+/**
+ * Test suite main function.
+ */
+int RVTH_CDECL main(int argc, char *argv[])
+{
+	fprintf(stderr, "librvth test suite: Disc image reader tests.\n\n");
+	fflush(nullptr);
+
+	// coverity[fun_call_w_exception]: uncaught exceptions cause nonzero exit anyway, so don't warn.
+	::testing::InitGoogleTest(&argc, argv);
+	return RUN_ALL_TESTS();
+}
@@ -0,0 +1,187 @@
+/***************************************************************************
+ * RVT-H Tool (librvth/tests)                                              *
+ * VerifyCacheTest.cpp: Verification cache tests.                          *
+ *                                                                         *
+ * Copyright (c) 2026 by David Korth.                                      *
+ * SPDX-License-Identifier: GPL-2.0-or-later                               *
+ ***************************************************************************/
+
+// Google Test
+#include "gtest/gtest.h"
+
+#include "VerifyCache.hpp"
+
+// C includes. (C++ namespace)
+#include <cstdio>
+#include <cstring>
+
+// C++ includes.
+#include <vector>
+using std::vector;
+
+namespace LibRvth { namespace Tests {
+
+// Cache directory. (created in the current directory)
+static const TCHAR CACHE_DIR[] = _T("VerifyCacheTest.cache");
+
+class VerifyCacheTest : public ::testing::Test
+{
+protected:
+	/**
+	 * Create a test key.
+	 * @param key	[out] Key
+	 * @param seed	[in] Seed
+	 */
+	static void makeKey(uint8_t key[VerifyCache::KEY_SIZE], uint8_t seed)
+	{
+		for (unsigned int i = 0; i < VerifyCache::KEY_SIZE; i++) {
+			key[i] = static_cast<uint8_t>(seed + i * 17);
+		}
+	}
+
+	/**
+	 * Create a test error.
+	 * @param pt_idx	[in] Partition index
+	 * @param group		[in] Group number
+	 * @param hash_level	[in] Hash level
+	 * @param sector	[in] Sector number
+	 * @param kb		[in] KB number
+	 * @param is_zero	[in] Is zero?
+	 * @return Error
+	 */
+	static VerifyCache::Error makeError(uint8_t pt_idx, uint32_t group,
+		uint8_t hash_level, uint8_t sector, uint8_t kb, bool is_zero)
+	{
+		VerifyCache::Error error;
+		error.pt_idx = pt_idx;
+		error.hash_level = hash_level;
+		error.sector = sector;
+		error.kb = kb;
+		error.err_type = 1;
+		error.is_zero = is_zero;
+		error.group = group;
+		return error;
+	}
+};
+
+/**
+ * Save results, then load them again.
+ */
+TEST_F(VerifyCacheTest, saveAndLoad)
+{
+	VerifyCache cache(CACHE_DIR);
+	ASSERT_TRUE(cache.isValid());
+
+	uint8_t key[VerifyCache::KEY_SIZE];
+	makeKey(key, 1);
+
+	vector<VerifyCache::Error> errors;
+	errors.push_back(makeError(0, 0, 0, 13, 13, false));
+	errors.push_back(makeError(0, 3, 2, 63, 0, true));
+	errors.push_back(makeError(1, 4914, 3, 0, 0, false));
+	ASSERT_EQ(0, cache.save(key, errors));
+
+	vector<VerifyCache::Error> loaded;
+	ASSERT_TRUE(cache.load(key, loaded));
+	ASSERT_EQ(errors.size(), loaded.size());
+	for (size_t i = 0; i < errors.size(); i++) {
+		EXPECT_EQ(errors[i].pt_idx, loaded[i].pt_idx) << "error " << i;
+		EXPECT_EQ(errors[i].group, loaded[i].group) << "error " << i;
+		EXPECT_EQ(errors[i].hash_level, loaded[i].hash_level) << "error " << i;
+		EXPECT_EQ(errors[i].sector, loaded[i].sector) << "error " << i;
+		EXPECT_EQ(errors[i].kb, loaded[i].kb) << "error " << i;
+		EXPECT_EQ(errors[i].err_type, loaded[i].err_type) << "error " << i;
+		EXPECT_EQ(errors[i].is_zero, loaded[i].is_zero) << "error " << i;
+	}
+
+	// Overwrite with no errors.
+	ASSERT_EQ(0, cache.save(key, vector<VerifyCache::Error>()));
+	ASSERT_TRUE(cache.load(key, loaded));
+	EXPECT_TRUE(loaded.empty());
+}
+
+/**
+ * Keys that haven't been saved aren't found.
+ */
+TEST_F(VerifyCacheTest, missingKey)
+{
+	VerifyCache cache(CACHE_DIR);
+	uint8_t key[VerifyCache::KEY_SIZE];
+	makeKey(key, 2);
+
+	vector<VerifyCache::Error> loaded;
+	loaded.push_back(makeError(0, 0, 0, 0, 1, false));
+	EXPECT_FALSE(cache.load(key, loaded));
+	EXPECT_TRUE(loaded.empty());
+}
+
+/**
+ * Invalid cache files are rejected.
+ */
+TEST_F(VerifyCacheTest, invalidFile)
+{
+	VerifyCache cache(CACHE_DIR);
+	uint8_t key[VerifyCache::KEY_SIZE];
+	makeKey(key, 3);
+
+	// Save a valid file first so the directory exists.
+	vector<VerifyCache::Error> errors;
+	errors.push_back(makeError(0, 1, 0, 1, 1, false));
+	ASSERT_EQ(0, cache.save(key, errors));
+
+	// Find the filename.
+	std::tstring filename(cache.dir());
+#ifdef _WIN32
+	filename += _T('\\');
+#else /* !_WIN32 */
+	filename += _T('/');
+#endif /* _WIN32 */
+	static const TCHAR hex_digits[] = _T("0123456789abcdef");
+	for (unsigned int i = 0; i < VerifyCache::KEY_SIZE; i++) {
+		filename += hex_digits[key[i] >> 4];
+		filename += hex_digits[key[i] & 0x0F];
+	}
+	filename += _T(".verify");
+
+	static const char *const bad_files[] = {
+		// Wrong version
+		"rvthtool-verify 2\nerrors 0\n",
+		// Truncated error list
+		"rvthtool-verify 1\nerrors 2\n0 1 0 1 1 1 0\n",
+		// Hash level out of range (H4 isn't cached)
+		"rvthtool-verify 1\nerrors 1\n0 1 4 0 0 1 0\n",
+		// Sector out of range
+		"rvthtool-verify 1\nerrors 1\n0 1 0 64 1 1 0\n",
+	};
+	for (const char *bad_file : bad_files) {
+		FILE *f = _tfopen(filename.c_str(), _T("w"));
+		ASSERT_TRUE(f != nullptr);
+		fputs(bad_file, f);
+		fclose(f);
+
+		vector<VerifyCache::Error> loaded;
+		EXPECT_FALSE(cache.load(key, loaded)) << bad_file;
+		EXPECT_TRUE(loaded.empty()) << bad_file;
+	}
+}
+
+} }
+
+#ifdef _MSC_VER
+# define RVTH_CDECL __cdecl
+#else
+# define RVTH_CDECL
+#endif
+
+/**
+ * Test suite main function.
+ */
+int RVTH_CDECL main(int argc, char *argv[])
+{
+	fprintf(stderr, "librvth test suite: Verification cache tests.\n\n");
+	fflush(nullptr);
+
+	// coverity[fun_call_w_exception]: uncaught exceptions cause nonzero exit anyway, so don't warn.
+	::testing::InitGoogleTest(&argc, argv);
+	return RUN_ALL_TESTS();
+}
@@ -2,7 +2,7 @@
  * RVT-H Tool (librvth)                                                    *
  * verify.cpp: RVT-H verification functions.                               *
  *                                                                         *
- * Copyright (c) 2018-2025 by David Korth.                                 *
+ * Copyright (c) 2018-2026 by David Korth.                                 *
  * SPDX-License-Identifier: GPL-2.0-or-later                               *
  ***************************************************************************/
 
@@ -11,6 +11,7 @@
 #include "rvth_error.h"
 
 #include "ptbl.h"
+#include "verify_group.hpp"
 
 // For LBA_TO_BYTES()
 #include "nhcd_structs.h"
@@ -18,13 +19,21 @@
 // Reader class
 #include "reader/Reader.hpp"
 
+// Thread-safe queue
+#include "BlockingQueue.hpp"
+
+// Read-ahead pipeline
+#include "ReadAhead.hpp"
+
+// Verification cache
+#include "VerifyCache.hpp"
+
 // libwiicrypto
 #include "libwiicrypto/gcn_structs.h"
 #include "libwiicrypto/wii_structs.h"
 #include "libwiicrypto/cert_store.h"
 #include "libwiicrypto/sig_tools.h"
 #include "libwiicrypto/wii_sector.h"
-#include "libwiicrypto/title_key.h"
 
 // Encryption and hashing
 #include "aesw.h"
@@ -42,10 +51,15 @@
 #include <cstring>
 
 // C++ includes
-#include <array>
+#include <algorithm>
+#include <condition_variable>
 #include <memory>
-using std::array;
+#include <mutex>
+#include <thread>
+#include <vector>
+using std::thread;
 using std::unique_ptr;
+using std::vector;
 
 // Sector buffer. (1 LBA)
 typedef union _sbuf1_t {
@@ -68,72 +82,340 @@ typedef union _sbuf2_t {
 } sbuf2_t;
 
 /**
- * Is a block of data all zero bytes?
- * @param pData Data block
- * @param size Size of data block, in bytes
- * @return True if the data is all zero; false if not.
+ * Group verification job.
  */
-static bool is_block_zero(const uint8_t *pData, size_t size)
+struct VerifyJob {
+	VerifyJob()
+		: gdata_enc(nullptr)
+		, gdata(new Wii_Disc_Sector_t[64])
+		, H3_entry(nullptr)
+		, part_idx(0)
+		, group(0)
+		, seq(0)
+		, max_sector(64)
+		, err(0)
+	{ }
+
+	// NOTE: Retaining the encrypted version in order to do zero checks.
+	// NOTE: gdata_enc points into chunk, which is owned by the ReadAhead.
+	ReadAhead::Chunk chunk;				// Encrypted group from the ReadAhead
+	const Wii_Disc_Sector_t *gdata_enc;		// 2 MB, one group (chunk.buf)
+	unique_ptr<Wii_Disc_Sector_t[]> gdata;		// 2 MB, one group
+
+	vector<VerifyError> errors;	// Errors found in this group
+	const uint8_t *H3_entry;	// H3 hash for this group
+	unsigned int part_idx;		// Partition index (multi-threaded only)
+	unsigned int group;		// Group number
+	unsigned int seq;		// Sequence number (multi-threaded only)
+	unsigned int max_sector;	// Number of sectors to check
+	int err;			// Read error (negative POSIX error code)
+};
+
+/**
+ * Get the next group from the ReadAhead.
+ * @param readAhead	[in] ReadAhead
+ * @param is_last_group	[in] True if this is the last group in the partition.
+ * @param job		[in,out] Group verification job (max_sector may be adjusted)
+ * @return 0 on success; negative POSIX error code on error.
+ */
+static int read_group(ReadAhead &readAhead, bool is_last_group, VerifyJob *job)
 {
-	// Vectorize to uintptr_t.
-	// TODO: Handle unaligned architectures?
-	const uintptr_t *pData32 = reinterpret_cast<const uintptr_t*>(pData);
-	for (; size > sizeof(uintptr_t)-1; size -= sizeof(uintptr_t), pData32++) {
-		if (*pData32 != 0) {
-			// Not zero.
-			return false;
-		}
-	}
-	if (unlikely(size > 0)) {
-		pData = reinterpret_cast<const uint8_t*>(pData32);
-		for (; size > 0; size--, pData++) {
-			if (*pData != 0) {
-				// Not zero.
-				return false;
-			}
+	if (!readAhead.next(job->chunk)) {
+		// Group is missing.
+		job->gdata_enc = nullptr;
+		return -EIO;
+	}
+	job->gdata_enc = reinterpret_cast<const Wii_Disc_Sector_t*>(job->chunk.buf);
+	if (job->chunk.err != 0) {
+		// Read error.
+		return -job->chunk.err;
+	}
+
+	if (unlikely(job->chunk.lba_len < LBAS_PER_GROUP)) {
+		// Incomplete group. I'm not sure how this would work
+		// on real hardware, but some SDK update images have
+		// incomplete groups.
+		if (!is_last_group) {
+			// Partition is truncated.
+			return -EIO;
+		}
+		const unsigned int tmp_max_sector = job->chunk.lba_len / 64;
+		if (tmp_max_sector < job->max_sector) {
+			job->max_sector = tmp_max_sector;
 		}
 	}
 
-	// It's all zero.
-	return true;
+	return 0;
 }
 
 /**
- * Verify partitions in a Wii disc image.
- *
- * NOTE: This function only supports encrypted Wii disc images,
- * either retail or debug encryption.
- *
- * This will check all five levels of hashes:
- * - H4: Hash of H3 table (stored in the TMD)
- * - H3: Hash of all H2 tables (H2 table = 2 MB group)
- * - H2: Hash of all H1 tables (H1 table = 256 KB subgroup)
- * - H1: Hash of all H0 tables (H0 table = 32 KB block)
- * - H0: Hash of a single KB   (H0 = 1 KB)
- *
- * NOTE: Assuming the TMD signature is valid, which means
- * the H4 hash is correct.
- *
- * @param bank		[in] Bank number (0-7)
- * @param errorCount	[out] Error counts for all 5 hash tables
- * @param callback	[in,opt] Progress callback
- * @param userdata	[in,opt] User data for progress callback
- * @return Error code. (If negative, POSIX error; otherwise, see RvtH_Errors.)
+ * Decrypt and verify a group.
+ * Errors are added to job->errors in the order they're found.
+ * @param aesw	[in] AES context, with the title key set
+ * @param job	[in,out] Group verification job
  */
-int RvtH::verifyWiiPartitions(unsigned int bank,
-	WiiErrorCount_t *errorCount,
-	RvtH_Verify_Progress_Callback callback,
-	void *userdata)
+static inline void verify_group(AesCtx *aesw, VerifyJob *job)
 {
-	int ret = 0;	// errno or RvtH_Errors
-	if (errorCount) {
-		for (size_t i = 0; i < ARRAY_SIZE(errorCount->errs); i++) {
-			errorCount->errs[i] = 0;
+	rvth_verify_group(aesw, job->gdata_enc, job->gdata.get(),
+		job->H3_entry, job->max_sector, job->errors);
+}
+
+/**
+ * Verification result reporter.
+ * Updates the error counts and runs the progress callback for one bank.
+ * This must only be used from the thread that started the verification.
+ */
+class VerifyReporter
+{
+public:
+	VerifyReporter(const RvtH *rvth, unsigned int bank, unsigned int pt_total,
+		RvtH::WiiErrorCount_t *errorCount,
+		RvtH_Verify_Progress_Callback callback, void *userdata)
+		: errorCount(errorCount)
+		, callback(callback)
+		, userdata(userdata)
+		, record(nullptr)
+	{
+		// Initialize the callback state.
+		state.rvth = rvth;
+		state.bank = bank;
+
+		state.pt_type = 0;	// will be updated later
+		state.pt_current = 0;
+		state.pt_total = pt_total;
+
+		state.group_cur = 0;
+		state.group_total = 0;
+
+		state.type = RVTH_VERIFY_STATUS;
+		state.hash_level = 0;
+		state.sector = 0;
+		state.kb = 0;
+		state.err_type = RVTH_VERIFY_ERROR_UNKNOWN;
+		state.is_zero = false;
+		state.is_cached = false;
+	}
+
+	/**
+	 * Mark the bank's results as cached.
+	 */
+	void setCached(void)
+	{
+		state.is_cached = true;
+	}
+
+	/**
+	 * Record reported errors so they can be saved in the verification cache.
+	 * @param errors Error list (must be valid until verification is finished)
+	 */
+	void setRecord(vector<VerifyCache::Error> *errors)
+	{
+		record = errors;
+	}
+
+	/**
+	 * Report the start of a partition.
+	 * The group count is estimated from the partition size.
+	 * @param part Partition
+	 */
+	void partitionStart(const VerifyPartition *part)
+	{
+		// Starting the next partition.
+		state.pt_type = part->pte->type;
+		state.pt_current = part->pt_idx;
+
+		if (callback) {
+			// NOTE: Determining number of groups by searching for the first
+			// all-zero hash in the H3 table, not by using the data size.
+			// TODO: Compare the two?
+			state.group_cur = 0;
+			state.group_total = part->group_est;
+
+			state.type = RVTH_VERIFY_STATUS;
+			callback(&state, userdata);
+		}
+	}
+
+	/**
+	 * Report the partition header and the H4 hash.
+	 * @param part Partition
+	 */
+	void partitionLoaded(const VerifyPartition *part)
+	{
+		if (callback && part->group_hdr != 0) {
+			// Group count from the partition header.
+			state.group_total = part->group_hdr;
+			state.type = RVTH_VERIFY_STATUS;
+			callback(&state, userdata);
+
+			// Group count from the H3 table.
+			state.group_total = part->group_count;
+			callback(&state, userdata);
+		}
+
+		if (part->h4_error) {
+			if (errorCount) {
+				errorCount->h4++;
+			}
+			if (callback) {
+				state.is_zero = part->h4_is_zero;
+				state.type = RVTH_VERIFY_ERROR_REPORT;
+				state.hash_level = 4;
+				state.sector = 0;	// irrelevant for H4
+				state.err_type = RVTH_VERIFY_ERROR_BAD_HASH;
+				callback(&state, userdata);
+			}
 		}
 	}
 
+	/**
+	 * Report the start of a group.
+	 * @param group Group number
+	 */
+	void groupStart(unsigned int group)
+	{
+		// Update the status.
+		if (callback) {
+			state.group_cur = group;
+			state.type = RVTH_VERIFY_STATUS;
+			callback(&state, userdata);
+		}
+	}
+
+	/**
+	 * Report errors from a verified group.
+	 * @param job Group verification job
+	 */
+	void groupDone(const VerifyJob *job)
+	{
+		for (const VerifyError &error : job->errors) {
+			if (record) {
+				VerifyCache::Error cached;
+				cached.pt_idx = state.pt_current;
+				cached.hash_level = error.hash_level;
+				cached.sector = error.sector;
+				cached.kb = error.kb;
+				cached.err_type = error.err_type;
+				cached.is_zero = error.is_zero;
+				cached.group = job->group;
+				record->push_back(cached);
+			}
+			reportError(error.hash_level, error.sector, error.kb, error.err_type, error.is_zero);
+		}
+	}
+
+	/**
+	 * Report a partition's groups from the verification cache.
+	 * @param part		Partition
+	 * @param errors	Cached errors for the bank
+	 */
+	void groupsCached(const VerifyPartition *part, const vector<VerifyCache::Error> &errors)
+	{
+		unsigned int group_cur = ~0U;
+		for (const VerifyCache::Error &error : errors) {
+			if (error.pt_idx != part->pt_idx) {
+				continue;
+			}
+			if (error.group != group_cur) {
+				group_cur = error.group;
+				groupStart(group_cur);
+			}
+			reportError(error.hash_level, error.sector, error.kb, error.err_type, error.is_zero);
+		}
+	}
+
+	/**
+	 * Report the end of a partition.
+	 * If this is the last partition, the end of the bank is reported, too.
+	 * @param part Partition
+	 */
+	void partitionDone(const VerifyPartition *part)
+	{
+		if (!callback) {
+			return;
+		}
+
+		// Update the status.
+		state.group_cur = part->group_count;
+		state.type = RVTH_VERIFY_STATUS;
+		callback(&state, userdata);
+
+		if (part->pt_idx + 1 >= state.pt_total) {
+			// Finished verifying the disc.
+			state.pt_current = state.pt_total;
+			callback(&state, userdata);
+		}
+	}
+
+private:
+	/**
+	 * Report an error.
+	 * @param hash_level	Hash level
+	 * @param sector	Sector number
+	 * @param kb		KB number (H0 only)
+	 * @param err_type	Error type
+	 * @param is_zero	True if the encrypted data is all zeroes.
+	 */
+	void reportError(uint8_t hash_level, uint8_t sector, uint8_t kb, uint8_t err_type, bool is_zero)
+	{
+		if (errorCount) {
+			errorCount->errs[hash_level]++;
+		}
+		if (callback) {
+			state.is_zero = is_zero;
+			state.type = RVTH_VERIFY_ERROR_REPORT;
+			state.hash_level = hash_level;
+			state.sector = sector;
+			if (hash_level == 0) {
+				state.kb = kb;
+			}
+			state.err_type = err_type;
+			callback(&state, userdata);
+		}
+	}
+
+private:
+	RvtH::WiiErrorCount_t *const errorCount;
+	const RvtH_Verify_Progress_Callback callback;
+	void *const userdata;
+	RvtH_Verify_Progress_State state;
+	vector<VerifyCache::Error> *record;
+};
+
+/**
+ * Bank to verify.
+ */
+struct VerifyBank {
+	VerifyBank()
+		: entry(nullptr)
+		, err(0)
+		, cacheable(false)
+		, cached(false)
+		, save(false)
+	{
+		memset(cache_key, 0, sizeof(cache_key));
+	}
+
+	RvtH_BankEntry *entry;			// Bank entry
+	unique_ptr<VerifyReporter> reporter;	// Result reporter
+	int err;				// Error code (negative POSIX error or RvtH_Errors)
+
+	// Verification cache
+	bool cacheable;				// If true, the bank can be cached.
+	bool cached;				// If true, cached results are reported.
+	bool save;				// If true, results will be saved to the cache.
+	uint8_t cache_key[VerifyCache::KEY_SIZE];
+	vector<VerifyCache::Error> cache_errors;	// Cached or recorded errors
+};
+
+/**
+ * Make sure a bank can be verified, and load its partition table.
+ * @param entry	[in] Bank entry
+ * @return 0 on success; negative POSIX error code or RvtH_Errors on error.
+ */
+static int check_bank(RvtH_BankEntry *entry)
+{
 	// Make sure this is a Wii disc.
-	RvtH_BankEntry *const entry = &d_ptr->entries[bank];
 	switch (entry->type) {
 		case RVTH_BankType_Wii_SL:
 		case RVTH_BankType_Wii_DL:
@@ -168,41 +450,133 @@ int RvtH::verifyWiiPartitions(unsigned int bank,
 	}
 
 	// Make sure the partition table is loaded.
-	ret = rvth_ptbl_load(entry);
+	int ret = rvth_ptbl_load(entry);
 	if (ret != 0 || entry->pt_count == 0 || !entry->ptbl) {
 		// Unable to load the partition table.
 		errno = -ret;
 		return ret;
 	}
+	return 0;
+}
 
-	// Callback state.
-	RvtH_Verify_Progress_State state;
+/**
+ * Load the partitions in a bank.
+ * Loading stops at the first partition that can't be loaded,
+ * since the rest of the bank won't be verified.
+ * @param entry		[in] Bank entry
+ * @param bank_idx	[in] Index into the list of banks being verified
+ * @param parts		[in,out] List of partitions
+ */
+static void load_bank(RvtH_BankEntry *entry, unsigned int bank_idx,
+	vector<unique_ptr<VerifyPartition> > &parts)
+{
+	unique_ptr<RVL_PartitionHeader> pt_hdr(new RVL_PartitionHeader);
+	for (unsigned int pt_idx = 0; pt_idx < entry->pt_count; pt_idx++) {
+		VerifyPartition *const part = new VerifyPartition;
+		parts.emplace_back(part);
+		part->reader = entry->reader;
+		part->pte = &entry->ptbl[pt_idx];
+		part->pt_idx = pt_idx;
+		part->bank_idx = bank_idx;
+		part->err = rvth_verify_load_partition(pt_hdr.get(), part);
+		if (part->err != 0) {
+			break;
+		}
+	}
+}
 
-	if (callback) {
-		// Initialize the callback state.
-		state.rvth = this;
-		state.bank = bank;
+/**
+ * Start reporting a partition.
+ * @param vb	[in,out] Bank
+ * @param part	[in] Partition
+ * @return True if the partition's groups should be verified; false if not.
+ */
+static bool begin_partition(VerifyBank &vb, const VerifyPartition *part)
+{
+	if (vb.err != 0) {
+		// A previous partition failed.
+		return false;
+	}
 
-		state.pt_type = 0;	// will be updated later
-		state.pt_current = 0;
-		state.pt_total = entry->pt_count;
+	vb.reporter->partitionStart(part);
+	if (part->err != 0) {
+		// Unable to load the partition.
+		vb.err = part->err;
+		return false;
+	}
+	vb.reporter->partitionLoaded(part);
 
-		state.type = RVTH_VERIFY_STATUS;
-		state.hash_level = 0;
-		state.sector = 0;
-		state.kb = 0;
-		state.err_type = RVTH_VERIFY_ERROR_UNKNOWN;
-		state.is_zero = false;
+	if (vb.cached) {
+		// Report the cached results instead of verifying the groups.
+		vb.reporter->groupsCached(part, vb.cache_errors);
+		vb.reporter->partitionDone(part);
+		return false;
 	}
+	return true;
+}
 
-	struct sha1_ctx sha1;
-	array<uint8_t, SHA1_DIGEST_SIZE> digest;
-	unique_ptr<RVL_PartitionHeader> pt_hdr(new RVL_PartitionHeader);
-	unique_ptr<Wii_Disc_H3_t> H3_tbl(new Wii_Disc_H3_t);
-	// NOTE: Retaining the encrypted version in order to do zero checks.
-	unique_ptr<Wii_Disc_Sector_t[]> gdata_enc(new Wii_Disc_Sector_t[64]);	// 2 MB, one group
-	unique_ptr<Wii_Disc_Sector_t[]> gdata(new Wii_Disc_Sector_t[64]);	// 2 MB, one group
+/**
+ * Finish reporting a partition.
+ * @param vb	[in,out] Bank
+ * @param part	[in] Partition
+ * @param ret	[in] Result of verifying the partition's groups
+ */
+static void end_partition(VerifyBank &vb, const VerifyPartition *part, int ret)
+{
+	if (ret != 0) {
+		// Read error.
+		vb.err = ret;
+		return;
+	}
+	vb.reporter->partitionDone(part);
+}
+
+/**
+ * Verify the groups in a partition using a single thread.
+ * @param part		[in] Partition
+ * @param aesw		[in] AES context, with the title key set
+ * @param reporter	[in] Verification result reporter
+ * @return 0 on success; negative POSIX error code on error.
+ */
+static int verify_groups_st(const VerifyPartition *part, AesCtx *aesw, VerifyReporter &reporter)
+{
+	// Read the groups ahead of verification.
+	const unsigned int group_count = part->group_count;
+	ReadAhead readAhead(part->reader, part->lba_data,
+		rvth_verify_groups_lba_len(part->pte, part->lba_data, group_count), GROUP_SIZE_ENC);
 
+	VerifyJob job;
+	job.H3_entry = part->H3_tbl->h3[0];
+	for (unsigned int g = 0; g < group_count; g++, job.H3_entry += SHA1_DIGEST_SIZE) {
+		const bool is_last_group = (g == (group_count - 1));
+		job.group = g;
+		job.max_sector = 64;
+		if (part->last_group_sectors != 0 && is_last_group) {
+			job.max_sector = part->last_group_sectors;
+		}
+
+		reporter.groupStart(g);
+		int ret = read_group(readAhead, is_last_group, &job);
+		if (ret != 0) {
+			return ret;
+		}
+		verify_group(aesw, &job);
+		reporter.groupDone(&job);
+		readAhead.release(job.chunk);
+	}
+
+	return 0;
+}
+
+/**
+ * Verify partitions using a single thread.
+ * @param banks	[in,out] Banks
+ * @param parts	[in] Partitions, in LBA order
+ * @return 0 on success; negative POSIX error code on error.
+ */
+static int verify_partitions_st(vector<VerifyBank> &banks,
+	const vector<unique_ptr<VerifyPartition> > &parts)
+{
 	// Initialize the AES context.
 	errno = 0;
 	AesCtx *const aesw = aesw_new();
@@ -214,401 +588,538 @@ int RvtH::verifyWiiPartitions(unsigned int bank,
 		return ret;
 	}
 
-	// Zero IV for decrypting hashes.
-	uint8_t zero_iv[16];
-	memset(zero_iv, 0, sizeof(zero_iv));
-
-	// Verify partitions.
-	Reader *const reader = entry->reader;
-	for (unsigned int pt_idx = 0; pt_idx < entry->pt_count; pt_idx++) {
-		const pt_entry_t *const pte = &entry->ptbl[pt_idx];
-
-		// Initial group count will be calculated based on data size.
-		// NOTE: LBA length is in 512-byte (2^9) blocks. Groups are 2 MB (2^21).
-		// To convert from 512-byte blocks to 2 MB blocks, shift
-		// right by 12.
-		// NOTE 2: Last group is usually incomplete, so we shouldn't check past
-		// the last sector.
-		unsigned int group_count = pte->lba_len >> 12;
-		unsigned int last_group_sectors = 0;
-		if (pte->lba_len & 0xFFF) {
-			group_count++;
-			last_group_sectors = (pte->lba_len & 0xFFF) / 64;
+	for (const auto &part : parts) {
+		VerifyBank &vb = banks[part->bank_idx];
+		if (!begin_partition(vb, part.get())) {
+			continue;
 		}
 
-		if (callback) {
-			// Starting the next partition.
-			state.pt_type = pte->type;
-			state.pt_current = pt_idx;
-
-			// NOTE: Determining number of groups by searching for the first
-			// all-zero hash in the H3 table, not by using the data size.
-			// TODO: Compare the two?
-			state.group_cur = 0;
-			state.group_total = group_count;
+		aesw_set_key(aesw, part->title_key, sizeof(part->title_key));
+		const int ret = verify_groups_st(part.get(), aesw, *vb.reporter);
+		end_partition(vb, part.get(), ret);
+	}
 
-			state.type = RVTH_VERIFY_STATUS;
-			callback(&state, userdata);
-		}
+	aesw_free(aesw);
+	return 0;
+}
 
-		// Read the partition header.
-		size_t lba_size = reader->read(pt_hdr.get(), pte->lba_start, BYTES_TO_LBA(sizeof(RVL_PartitionHeader)));
-		if (lba_size != BYTES_TO_LBA(sizeof(RVL_PartitionHeader))) {
-			// Read error.
-			int err = errno;
-			if (err == 0) {
-				err = EIO;
-				errno = EIO;
-			}
-			aesw_free(aesw);
-			return -err;
-		}
-
-		// Use the data length in the partition header to determine
-		// the total number of groups and the last group sector count.
-		// This is usually accurate except for unencrypted partitions,
-		// in which case, this function won't work anyway!
-		if (pt_hdr->data_size != 0) {
-			const uint64_t data_size = static_cast<uint64_t>(be32_to_cpu(pt_hdr->data_size)) << 2;
-			if (data_size > 9ULL*1024*1024*1024) {
-				// Cannot be more than 9 GiB!
-				// H3 table is limited to 9,830.4 MiB,
-				// but dual-layer discs are limited to ~8 GiB.
-				aesw_free(aesw);
-				errno = EIO;
-				return -EIO;
-			}
-			group_count = static_cast<uint32_t>(data_size / GROUP_SIZE_ENC);
-			if (data_size % GROUP_SIZE_ENC != 0) {
-				group_count++;
-				last_group_sectors = static_cast<uint32_t>((data_size % GROUP_SIZE_ENC) / 32768);
+/**
+ * Verify partitions using multiple threads.
+ *
+ * One thread reads groups from all of the partitions in LBA order,
+ * and the worker threads decrypt and verify them. Workers aren't
+ * idled at partition or bank boundaries. Results are reported by
+ * the calling thread in the same order, so the callback sequence
+ * and error counts are identical to verify_partitions_st().
+ *
+ * If a group can't be read, the rest of its bank is skipped.
+ *
+ * @param banks		[in,out] Banks
+ * @param parts		[in] Partitions, in LBA order
+ * @param threads	[in] Number of worker threads (must be at least 2)
+ * @return 0 on success; negative POSIX error code on error.
+ */
+static int verify_partitions_mt(vector<VerifyBank> &banks,
+	const vector<unique_ptr<VerifyPartition> > &parts, unsigned int threads)
+{
+	// Each worker thread needs its own AES context.
+	vector<AesCtx*> aesw_workers;
+	aesw_workers.reserve(threads);
+	for (unsigned int i = 0; i < threads; i++) {
+		errno = 0;
+		AesCtx *const aesw = aesw_new();
+		if (!aesw) {
+			int ret = -errno;
+			if (ret == 0) {
+				ret = -EIO;
 			}
-			if (callback) {
-				state.group_total = group_count;
-				state.type = RVTH_VERIFY_STATUS;
-				callback(&state, userdata);
+			for (AesCtx *p : aesw_workers) {
+				aesw_free(p);
 			}
+			return ret;
 		}
+		aesw_workers.push_back(aesw);
+	}
 
-		// TMD must be located within the partition header.
-		const unsigned int tmd_offset = be32_to_cpu(pt_hdr->tmd_offset) << 2;
-		const unsigned int tmd_size = be32_to_cpu(pt_hdr->tmd_size);
-		if (tmd_offset == 0 || tmd_offset > sizeof(RVL_PartitionHeader) ||
-		    tmd_size < (sizeof(RVL_TMD_Header) + sizeof(RVL_Content_Entry)))
-		{
-			// TMD offset and/or size is invalid.
-			// TODO: More specific error?
-			aesw_free(aesw);
-			errno = EIO;
-			return -EIO;
-		}
-		const RVL_TMD_Header *const pTmd = reinterpret_cast<const RVL_TMD_Header*>(
-			reinterpret_cast<const uint8_t*>(pt_hdr.get()) + tmd_offset);
-		if (pTmd->nbr_cont != cpu_to_be16(1)) {
-			// Disc partitions should only have one content in the TMD!
-			// TODO: More specific error?
-			aesw_free(aesw);
-			errno = EIO;
-			return -EIO;
-		}
-		const RVL_Content_Entry *const pContentEntry = reinterpret_cast<const RVL_Content_Entry*>(
-			reinterpret_cast<const uint8_t*>(pt_hdr.get()) + tmd_offset + sizeof(RVL_TMD_Header));
+	// Job slots. This limits the number of groups in flight,
+	// so each in-flight group has a unique (seq % slot_count) index.
+	const unsigned int slot_count = threads + 2;
 
-		// Decrypt the title key.
-		uint8_t title_key[16];
-		uint8_t crypto_type;	// not used yet?
-		ret = decrypt_title_key(&pt_hdr->ticket, title_key, &crypto_type);
-		if (ret != 0) {
-			// Error decrypting title key.
-			// TODO: Indicate the error.
-			return ret;
-		}
-		aesw_set_key(aesw, title_key, sizeof(title_key));
-
-		// Get the H3 table offset. (usually 0x8000)
-		// NOTE: It's shifted right by 2, so un-shift, then convert to LBA.
-		// May cause overflow if it's too high, but it's usually 0x8000.
-		const uint32_t h3_tbl_lba = BYTES_TO_LBA(be32_to_cpu(pt_hdr->h3_table_offset) << 2);
-		if (h3_tbl_lba == 0) {
-			// Invalid H3 table LBA.
-			// TODO: Return a better error code.
-			aesw_free(aesw);
-			errno = EIO;
-			return -EIO;
-		}
+	// Read-ahead pipelines, indexed by partition.
+	// A partition's ReadAhead is freed once it has been read
+	// and all of its chunks have been released.
+	// NOTE: Only the reader thread uses the ReadAheads, but they
+	// must outlive the worker threads.
+	vector<unique_ptr<ReadAhead> > readAheads(parts.size());
+	vector<unsigned int> chunks_out(parts.size(), 0);
 
-		// Read the H3 table.
-		lba_size = reader->read(H3_tbl.get(), pte->lba_start + h3_tbl_lba, BYTES_TO_LBA(sizeof(Wii_Disc_H3_t)));
-		if (lba_size != BYTES_TO_LBA(sizeof(Wii_Disc_H3_t))) {
-			// Read error.
-			aesw_free(aesw);
-			int err = errno;
-			if (err == 0) {
-				err = EIO;
-				errno = EIO;
-			}
-			return -err;
+	vector<unique_ptr<VerifyJob> > jobs;
+	jobs.reserve(slot_count);
+	BlockingQueue<VerifyJob*> freeQueue;
+	BlockingQueue<VerifyJob*> workQueue;
+	for (unsigned int i = 0; i < slot_count; i++) {
+		jobs.emplace_back(new VerifyJob);
+		freeQueue.push(jobs.back().get());
+	}
+
+	// Completed jobs, indexed by (seq % slot_count).
+	std::mutex done_mutex;
+	std::condition_variable done_cond;
+	vector<VerifyJob*> done(slot_count, nullptr);
+	auto mark_done = [&](VerifyJob *job) {
+		{
+			std::lock_guard<std::mutex> lock(done_mutex);
+			done[job->seq % slot_count] = job;
 		}
+		done_cond.notify_all();
+	};
 
-		// Unlikely: Partition header's data size is 0.
-		// If so, fall back to checking the H3 table.
-		if (unlikely(pt_hdr->data_size != 0)) {
-			// Find the first 00 hash. This will indicate the group count.
-			// TODO: Partial final group?
-			const uint8_t *H3_entry = H3_tbl->h3[0];
-			for (group_count = 0; group_count < ARRAY_SIZE(H3_tbl->h3);
-				group_count++, H3_entry += ARRAY_SIZE(H3_tbl->h3[0]))
+	// Reader thread.
+	thread reader_thread([&]() {
+		vector<bool> bank_failed(banks.size(), false);
+		unsigned int seq = 0;
+		const unsigned int part_count = static_cast<unsigned int>(parts.size());
+		for (unsigned int p = 0; p < part_count; p++) {
+			const VerifyPartition *const part = parts[p].get();
+			if (bank_failed[part->bank_idx] || part->err != 0 ||
+			    banks[part->bank_idx].cached)
 			{
-				if (H3_entry[0] != 0)
-					continue;
+				// Partition won't be verified.
+				continue;
+			}
+
+			// Read the groups ahead of verification.
+			// Each job holds at most one chunk, so one buffer per job is enough.
+			const unsigned int group_count = part->group_count;
+			readAheads[p].reset(new ReadAhead(part->reader, part->lba_data,
+				rvth_verify_groups_lba_len(part->pte, part->lba_data, group_count),
+				GROUP_SIZE_ENC, slot_count));
+
+			bool aborted = false;
+			for (unsigned int g = 0; g < group_count; g++) {
+				VerifyJob *job;
+				if (!freeQueue.pop(job)) {
+					// Verification was aborted.
+					aborted = true;
+					break;
+				}
+				if (job->gdata_enc) {
+					// Return the previous group's buffer to its ReadAhead.
+					const unsigned int prev = job->part_idx;
+					readAheads[prev]->release(job->chunk);
+					job->gdata_enc = nullptr;
+					if (--chunks_out[prev] == 0 && prev != p) {
+						readAheads[prev].reset();
+					}
+				}
 
-				// Found an H3 entry that starts with 0.
-				// Check the rest of the entry.
-				if (is_block_zero(H3_entry, sizeof(H3_tbl->h3[0]))) {
-					// Found an all-zero entry.
+				const bool is_last_group = (g == (group_count - 1));
+				job->part_idx = p;
+				job->group = g;
+				job->seq = seq++;
+				job->H3_entry = part->H3_tbl->h3[g];
+				job->max_sector = 64;
+				if (part->last_group_sectors != 0 && is_last_group) {
+					job->max_sector = part->last_group_sectors;
+				}
+
+				job->err = read_group(*readAheads[p], is_last_group, job);
+				if (job->gdata_enc) {
+					chunks_out[p]++;
+				}
+				if (job->err != 0) {
+					// Read error. Report it in order,
+					// and skip the rest of the bank.
+					bank_failed[part->bank_idx] = true;
+					mark_done(job);
+					break;
+				}
+				if (!workQueue.push(job)) {
+					// Verification was aborted.
+					aborted = true;
 					break;
 				}
 			}
-			if (callback) {
-				state.group_total = group_count;
-				callback(&state, userdata);
+
+			if (chunks_out[p] == 0) {
+				readAheads[p].reset();
+			}
+			if (aborted) {
+				break;
 			}
 		}
+		workQueue.close();
+	});
 
-		// Verify the H4 hash. (H3 table)
-		sha1_init(&sha1);
-		sha1_update(&sha1, sizeof(Wii_Disc_H3_t), reinterpret_cast<const uint8_t*>(H3_tbl.get()));
-		sha1_digest(&sha1, digest.size(), digest.data());
-		if (memcmp(pContentEntry->sha1_hash, digest.data(), SHA1_DIGEST_SIZE) != 0) {
-			state.is_zero = is_block_zero((const uint8_t*)H3_tbl.get(), 512);	// only check one LBA
-			if (errorCount) {
-				errorCount->h4++;
-			}
-			if (callback) {
-				state.type = RVTH_VERIFY_ERROR_REPORT;
-				state.hash_level = 4;
-				state.sector = 0;	// irrelevant for H4
-				state.err_type = RVTH_VERIFY_ERROR_BAD_HASH;
-				callback(&state, userdata);
+	// Worker threads.
+	vector<thread> workers;
+	workers.reserve(threads);
+	for (unsigned int i = 0; i < threads; i++) {
+		AesCtx *const aesw = aesw_workers[i];
+		workers.emplace_back([&, aesw]() {
+			unsigned int key_part_idx = ~0U;
+			VerifyJob *job;
+			while (workQueue.pop(job)) {
+				if (job->part_idx != key_part_idx) {
+					// Switch to this partition's title key.
+					key_part_idx = job->part_idx;
+					aesw_set_key(aesw, parts[key_part_idx]->title_key, 16);
+				}
+				verify_group(aesw, job);
+				mark_done(job);
 			}
+		});
+	}
+
+	// Report the results in order.
+	unsigned int seq = 0;
+	const unsigned int part_count = static_cast<unsigned int>(parts.size());
+	for (unsigned int p = 0; p < part_count; p++) {
+		const VerifyPartition *const part = parts[p].get();
+		VerifyBank &vb = banks[part->bank_idx];
+		if (!begin_partition(vb, part)) {
+			continue;
 		}
 
-		// Process the 2 MB blocks.
-		// FIXME: Check for an incomplete final block.
-#define LBAS_PER_GROUP BYTES_TO_LBA(GROUP_SIZE_ENC)
-		const uint8_t *H3_entry = H3_tbl->h3[0];
-		uint32_t lba = pte->lba_start + BYTES_TO_LBA(static_cast<uint64_t>(be32_to_cpu(pt_hdr->data_offset)) << 2);
-		for (unsigned int g = 0; g < group_count; g++, lba += LBAS_PER_GROUP) {
-			const bool is_last_group = (g == (group_count - 1));
+		int ret = 0;
+		for (unsigned int g = 0; g < part->group_count; g++) {
+			vb.reporter->groupStart(g);
 
-			unsigned int max_sector = 64;
-			if (last_group_sectors != 0 && is_last_group) {
-				max_sector = last_group_sectors;
+			VerifyJob *job;
+			{
+				std::unique_lock<std::mutex> lock(done_mutex);
+				VerifyJob *&slot = done[seq % slot_count];
+				done_cond.wait(lock, [&slot]() { return slot != nullptr; });
+				job = slot;
+				slot = nullptr;
 			}
+			assert(job->seq == seq);
+			assert(job->part_idx == p);
+			assert(job->group == g);
+			seq++;
 
-			// Update the status.
-			if (callback) {
-				state.group_cur = g;
-				state.type = RVTH_VERIFY_STATUS;
-				callback(&state, userdata);
+			if (job->err != 0) {
+				// Read error.
+				ret = job->err;
+				freeQueue.push(job);
+				break;
 			}
 
-			if (unlikely(lba + LBAS_PER_GROUP > pte->lba_start + pte->lba_len)) {
-				// Incomplete group. Attempting to read it will
-				// result in an assertion. I'm not sure how this
-				// would work on real hardware, but some SDK update
-				// images have incomplete groups.
-				if (!is_last_group) {
-					// Should not happen if this isn't the last group!
-					assert(!"Group is truncated, but it isn't the last group.");
-					aesw_free(aesw);
-					errno = EIO;
-					return -EIO;
-				}
-				const uint32_t lba_remain = pte->lba_len - lba;
-				lba_size = reader->read(gdata_enc.get(), lba, lba_remain);
-				if (lba_size != lba_remain) {
-					// Read error.
-					aesw_free(aesw);
-					errno = EIO;
-					return -EIO;
-				}
+			vb.reporter->groupDone(job);
+			freeQueue.push(job);
+		}
+		end_partition(vb, part, ret);
+	}
 
-				const unsigned int tmp_max_sector = lba_remain / 64;
-				if (tmp_max_sector < max_sector) {
-					max_sector = tmp_max_sector;
-				}
-			} else {
-				// Read a full group;
-				lba_size = reader->read(gdata_enc.get(), lba, LBAS_PER_GROUP);
-				if (lba_size != LBAS_PER_GROUP) {
-					// Read error.
-					aesw_free(aesw);
-					errno = EIO;
-					return -EIO;
-				}
-			}
+	// Shut down the pipeline.
+	freeQueue.close();
+	workQueue.close();
+	reader_thread.join();
+	for (thread &worker : workers) {
+		worker.join();
+	}
+	for (AesCtx *aesw : aesw_workers) {
+		aesw_free(aesw);
+	}
 
-			// Decrypt the blocks.
-			// User data IV is stored within the encrypted H2 table,
-			// so decrypt the user data first, *then* the hashes.
-			memcpy(gdata.get(), gdata_enc.get(), GROUP_SIZE_ENC);
-			for (unsigned int i = 0; i < max_sector; i++) {
-				// Decrypt user data.
-				aesw_set_iv(aesw, &gdata[i].hashes.H2[7][4], 16);
-				aesw_decrypt(aesw, gdata[i].data, sizeof(gdata[i].data));
-
-				// Decrypt hashes. (IV == 0)
-				aesw_set_iv(aesw, zero_iv, sizeof(zero_iv));
-				aesw_decrypt(aesw, (uint8_t*)&gdata[i].hashes, sizeof(gdata[i].hashes));
-			}
+	return 0;
+}
 
-			// Verify the H3 hash. (hash of H2 table in sector 0)
-			sha1_init(&sha1);
-			sha1_update(&sha1, sizeof(gdata[0].hashes.H2), gdata[0].hashes.H2[0]);
-			sha1_digest(&sha1, digest.size(), digest.data());
-			if (memcmp(H3_entry, digest.data(), digest.size()) != 0) {
-				state.is_zero = is_block_zero((const uint8_t*)&gdata_enc[0], sizeof(gdata_enc[0]));
-				if (errorCount) {
-					errorCount->h3++;
-				}
-				if (callback) {
-					state.type = RVTH_VERIFY_ERROR_REPORT;
-					state.hash_level = 3;
-					state.sector = 0;
-					state.err_type = RVTH_VERIFY_ERROR_BAD_HASH;
-					callback(&state, userdata);
-				}
+/**
+ * Get a bank's verification cache key.
+ * @param entry	[in] Bank entry
+ * @param parts	[in] Bank's partitions, in partition table order
+ * @param key	[out] Cache key
+ */
+static void get_cache_key(const RvtH_BankEntry *entry,
+	const vector<const VerifyPartition*> &parts, uint8_t key[VerifyCache::KEY_SIZE])
+{
+	struct sha1_ctx sha1;
+	sha1_init(&sha1);
+
+	// NHCD timestamp and LBA range
+	const int64_t timestamp = static_cast<int64_t>(entry->timestamp);
+	const uint32_t bank_info[4] = {
+		cpu_to_be32(static_cast<uint32_t>(static_cast<uint64_t>(timestamp) >> 32)),
+		cpu_to_be32(static_cast<uint32_t>(timestamp)),
+		cpu_to_be32(entry->lba_start),
+		cpu_to_be32(entry->lba_len),
+	};
+	sha1_update(&sha1, sizeof(bank_info), reinterpret_cast<const uint8_t*>(bank_info));
+
+	// Disc header
+	sha1_update(&sha1, sizeof(entry->discHeader), reinterpret_cast<const uint8_t*>(&entry->discHeader));
+
+	// Partition table and H3 tables
+	for (const VerifyPartition *part : parts) {
+		const uint32_t pt_info[3] = {
+			cpu_to_be32(part->pte->lba_start),
+			cpu_to_be32(part->pte->lba_len),
+			cpu_to_be32(part->pte->type),
+		};
+		sha1_update(&sha1, sizeof(pt_info), reinterpret_cast<const uint8_t*>(pt_info));
+		sha1_update(&sha1, sizeof(part->H3_sha1), part->H3_sha1);
+	}
+
+	sha1_digest(&sha1, VerifyCache::KEY_SIZE, key);
+}
+
+/**
+ * Look up banks in the verification cache.
+ * Banks that aren't found will have their results recorded.
+ * @param cache	[in] Verification cache
+ * @param mode	[in] Verification cache mode
+ * @param banks	[in,out] Banks
+ * @param parts	[in] Partitions
+ */
+static void lookup_cache(const VerifyCache &cache, RvtH_Verify_Cache_Mode mode,
+	vector<VerifyBank> &banks, const vector<unique_ptr<VerifyPartition> > &parts)
+{
+	const unsigned int bank_count = static_cast<unsigned int>(banks.size());
+	for (unsigned int i = 0; i < bank_count; i++) {
+		VerifyBank &vb = banks[i];
+		if (!vb.cacheable) {
+			continue;
+		}
+
+		// All partitions must be loaded.
+		vector<const VerifyPartition*> bank_parts;
+		bool ok = true;
+		for (const auto &part : parts) {
+			if (part->bank_idx != i) {
+				continue;
+			}
+			if (part->err != 0) {
+				ok = false;
+				break;
 			}
-			H3_entry += digest.size();
+			bank_parts.push_back(part.get());
+		}
+		if (!ok || bank_parts.size() != vb.entry->pt_count) {
+			continue;
+		}
+		get_cache_key(vb.entry, bank_parts, vb.cache_key);
 
-			// Make sure sectors 1-63 have the same H2 table as sector 0.
-			for (unsigned int sector = 1; sector < max_sector; sector++) {
-				if (memcmp(gdata[0].hashes.H2,
-					   gdata[sector].hashes.H2,
-				           sizeof(gdata[0].hashes.H2)) != 0)
+		if (mode == RVTH_VERIFY_CACHE_ON && cache.load(vb.cache_key, vb.cache_errors)) {
+			// Make sure the cached errors are in range.
+			for (const VerifyCache::Error &error : vb.cache_errors) {
+				if (error.pt_idx >= bank_parts.size() ||
+				    error.group >= bank_parts[error.pt_idx]->group_count)
 				{
-					state.is_zero = is_block_zero((const uint8_t*)&gdata_enc[sector], sizeof(gdata_enc[sector]));
-					if (errorCount) {
-						errorCount->h2++;
-					}
-					if (callback) {
-						state.type = RVTH_VERIFY_ERROR_REPORT;
-						state.hash_level = 2;
-						state.sector = sector;
-						state.err_type = RVTH_VERIFY_ERROR_TABLE_COPY;
-						callback(&state, userdata);
-					}
+					ok = false;
+					break;
 				}
 			}
-
-			// Verify the H2 hashes. (hash of H1 tables in each subgroup of 8 sectors)
-			for (unsigned int sector = 0; sector < max_sector; sector += 8) {
-				const unsigned int sg = sector / 8;
-				sha1_init(&sha1);
-				sha1_update(&sha1, sizeof(gdata[sector].hashes.H1), gdata[sector].hashes.H1[0]);
-				sha1_digest(&sha1, digest.size(), digest.data());
-				if (memcmp(gdata[0].hashes.H2[sg], digest.data(), digest.size()) != 0) {
-					state.is_zero = is_block_zero((const uint8_t*)&gdata_enc[sector], sizeof(gdata_enc[sector]));
-					if (errorCount) {
-						errorCount->h2++;
-					}
-					if (callback) {
-						state.type = RVTH_VERIFY_ERROR_REPORT;
-						state.hash_level = 2;
-						state.sector = sector;
-						state.err_type = RVTH_VERIFY_ERROR_BAD_HASH;
-						callback(&state, userdata);
-					}
-				}
+			if (ok) {
+				vb.cached = true;
+				vb.reporter->setCached();
+				continue;
 			}
+			vb.cache_errors.clear();
+		}
 
-			// Make sure sectors in each subgroup have the same H1 table as
-			// sectors 0, 8, 16, 24, 32, 40, 48, 56.
-			for (unsigned int sector_start = 0; sector_start < max_sector; sector_start += 8) {
-				unsigned int sector_end = sector_start + 8;
-				if (sector_end > max_sector) {
-					sector_end = max_sector;
-				}
-				for (unsigned int sector = sector_start; sector < sector_end; sector++) {
-					if (memcmp(gdata[sector_start].hashes.H1,
-					           gdata[sector].hashes.H1,
-					           sizeof(gdata[0].hashes.H1)) != 0)
-					{
-						state.is_zero = is_block_zero((const uint8_t*)&gdata_enc[sector], sizeof(gdata_enc[sector]));
-						if (errorCount) {
-							errorCount->h1++;
-						}
-						if (callback) {
-							state.type = RVTH_VERIFY_ERROR_REPORT;
-							state.hash_level = 1;
-							state.sector = sector;
-							state.err_type = RVTH_VERIFY_ERROR_TABLE_COPY;
-							callback(&state, userdata);
-						}
-					}
-				}
-			}
+		// Record the results so they can be cached.
+		vb.save = true;
+		vb.reporter->setRecord(&vb.cache_errors);
+	}
+}
 
-			// Verify the H1 hashes. (hash of H0 tables in each block of 31 KB)
-			for (unsigned int sector = 0; sector < max_sector; sector++) {
-				sha1_init(&sha1);
-				sha1_update(&sha1, sizeof(gdata[sector].hashes.H0), gdata[sector].hashes.H0[0]);
-				sha1_digest(&sha1, digest.size(), digest.data());
-				if (memcmp(gdata[sector].hashes.H1[sector % 8], digest.data(), digest.size()) != 0) {
-					state.is_zero = is_block_zero((const uint8_t*)&gdata_enc[sector], sizeof(gdata_enc[sector]));
-					if (errorCount) {
-						errorCount->h1++;
-					}
-					if (callback) {
-						state.type = RVTH_VERIFY_ERROR_REPORT;
-						state.hash_level = 1;
-						state.sector = sector;
-						state.err_type = RVTH_VERIFY_ERROR_BAD_HASH;
-						callback(&state, userdata);
-					}
-				}
-			}
+/**
+ * Verify partitions in one or more banks.
+ * @param banks		[in,out] Banks, in LBA order
+ * @param threads	[in] Number of worker threads (0 for auto; 1 to disable threading)
+ * @param cacheMode	[in] Verification cache mode
+ * @return 0 on success; negative POSIX error code on error. (Bank errors are stored in banks.)
+ */
+static int verify_banks(vector<VerifyBank> &banks, unsigned int threads,
+	RvtH_Verify_Cache_Mode cacheMode)
+{
+	// Load all of the partition headers and H3 tables first,
+	// so the group data can be read sequentially.
+	vector<unique_ptr<VerifyPartition> > parts;
+	const unsigned int bank_count = static_cast<unsigned int>(banks.size());
+	for (unsigned int i = 0; i < bank_count; i++) {
+		load_bank(banks[i].entry, i, parts);
+	}
 
-			// H0 tables are unique per block.
-			// Verify the H0 hashes. (Now we're actually checking the data!)
-			for (unsigned int sector = 0; sector < max_sector; sector++) {
-				const uint8_t *pData = gdata[sector].data;
-				for (unsigned int kb = 0; kb < 31; kb++, pData += 1024) {
-					sha1_init(&sha1);
-					sha1_update(&sha1, 1024, pData);
-					sha1_digest(&sha1, digest.size(), digest.data());
-					if (memcmp(gdata[sector].hashes.H0[kb], digest.data(), digest.size()) != 0) {
-						state.is_zero = is_block_zero(&gdata_enc[sector].data[kb * 1024], 1024);
-						if (errorCount) {
-							errorCount->h0++;
-						}
-						if (callback) {
-							state.type = RVTH_VERIFY_ERROR_REPORT;
-							state.hash_level = 0;
-							state.sector = sector;
-							state.kb = kb+1;
-							state.err_type = RVTH_VERIFY_ERROR_BAD_HASH;
-							callback(&state, userdata);
-						}
-					}
-				}
-			}
+	// Check the verification cache.
+	unique_ptr<VerifyCache> cache;
+	if (cacheMode != RVTH_VERIFY_CACHE_OFF) {
+		cache.reset(new VerifyCache());
+		if (cache->isValid()) {
+			lookup_cache(*cache, cacheMode, banks, parts);
 		}
+	}
 
-		// Update the status.
-		if (callback) {
-			state.group_cur = group_count;
-			state.type = RVTH_VERIFY_STATUS;
-			callback(&state, userdata);
+	if (threads == 0) {
+		// Use one worker thread per CPU.
+		threads = thread::hardware_concurrency();
+	}
+
+	int ret;
+	if (threads > 1) {
+		ret = verify_partitions_mt(banks, parts, threads);
+	} else {
+		ret = verify_partitions_st(banks, parts);
+	}
+	if (ret != 0) {
+		return ret;
+	}
+
+	// Save the new results.
+	// NOTE: Errors saving to the cache are ignored.
+	for (const VerifyBank &vb : banks) {
+		if (vb.save && vb.err == 0) {
+			cache->save(vb.cache_key, vb.cache_errors);
 		}
 	}
+	return 0;
+}
 
-	// Finished verifying the disc.
-	if (callback) {
-		state.pt_current = entry->pt_count;
-		callback(&state, userdata);
+/**
+ * Verify partitions in a Wii disc image.
+ *
+ * NOTE: This function only supports encrypted Wii disc images,
+ * either retail or debug encryption.
+ *
+ * This will check all five levels of hashes:
+ * - H4: Hash of H3 table (stored in the TMD)
+ * - H3: Hash of all H2 tables (H2 table = 2 MB group)
+ * - H2: Hash of all H1 tables (H1 table = 256 KB subgroup)
+ * - H1: Hash of all H0 tables (H0 table = 32 KB block)
+ * - H0: Hash of a single KB   (H0 = 1 KB)
+ *
+ * NOTE: Assuming the TMD signature is valid, which means
+ * the H4 hash is correct.
+ *
+ * Groups are decrypted and hashed by a pool of worker threads.
+ * Errors are still reported through the callback in group order,
+ * and the callback is always run on the calling thread.
+ *
+ * If the verification cache is enabled (see setVerifyCacheMode()),
+ * an unchanged RVT-H bank's results are reported from the cache.
+ *
+ * @param bank		[in] Bank number (0-7)
+ * @param errorCount	[out] Error counts for all 5 hash tables
+ * @param callback	[in,opt] Progress callback
+ * @param userdata	[in,opt] User data for progress callback
+ * @param threads	[in,opt] Number of worker threads (0 for auto; 1 to disable threading)
+ * @return Error code. (If negative, POSIX error; otherwise, see RvtH_Errors.)
+ */
+int RvtH::verifyWiiPartitions(unsigned int bank,
+	WiiErrorCount_t *errorCount,
+	RvtH_Verify_Progress_Callback callback,
+	void *userdata,
+	unsigned int threads)
+{
+	if (errorCount) {
+		for (size_t i = 0; i < ARRAY_SIZE(errorCount->errs); i++) {
+			errorCount->errs[i] = 0;
+		}
 	}
 
+	if (bank >= d_ptr->bankCount()) {
+		errno = ERANGE;
+		return -ERANGE;
+	}
+
+	RvtH_BankEntry *const entry = d_ptr->bankEntry(bank);
+	int ret = check_bank(entry);
+	if (ret != 0) {
+		return ret;
+	}
+
+	vector<VerifyBank> banks(1);
+	banks[0].entry = entry;
+	banks[0].reporter.reset(new VerifyReporter(this, bank, entry->pt_count,
+		errorCount, callback, userdata));
+	banks[0].cacheable = d_ptr->isHDD();
+
+	ret = verify_banks(banks, threads, d_ptr->verifyCacheMode);
+	if (ret == 0) {
+		ret = banks[0].err;
+	}
+	if (ret < 0) {
+		errno = -ret;
+	}
 	return ret;
 }
+
+/**
+ * Verify partitions in all Wii banks.
+ *
+ * This is equivalent to calling verifyWiiPartitions() for each bank,
+ * but the banks share a single pool of worker threads. Group data is
+ * read in LBA order across all banks, so an HDD still sees mostly
+ * sequential access.
+ *
+ * Progress is reported one bank at a time, in LBA order.
+ * state->bank indicates which bank is being reported.
+ *
+ * Banks that can't be verified, e.g. empty banks or GameCube banks,
+ * are skipped, and their error codes are stored in bankErrs.
+ *
+ * If the verification cache is enabled (see setVerifyCacheMode()),
+ * unchanged banks' results are reported from the cache.
+ *
+ * @param errorCounts	[out,opt] Array of bankCount() error counts
+ * @param bankErrs	[out,opt] Array of bankCount() error codes (If negative, POSIX error; otherwise, see RvtH_Errors.)
+ * @param callback	[in,opt] Progress callback
+ * @param userdata	[in,opt] User data for progress callback
+ * @param threads	[in,opt] Number of worker threads (0 for auto; 1 to disable threading)
+ * @return 0 on success; negative POSIX error code on error. (Bank errors are stored in bankErrs.)
+ */
+int RvtH::verifyAllWiiPartitions(WiiErrorCount_t *errorCounts,
+	int *bankErrs,
+	RvtH_Verify_Progress_Callback callback,
+	void *userdata,
+	unsigned int threads)
+{
+	const unsigned int bank_count = d_ptr->bankCount();
+	vector<VerifyBank> banks;
+	banks.reserve(bank_count);
+	for (unsigned int bank = 0; bank < bank_count; bank++) {
+		WiiErrorCount_t *const errorCount = (errorCounts ? &errorCounts[bank] : nullptr);
+		if (errorCount) {
+			for (size_t i = 0; i < ARRAY_SIZE(errorCount->errs); i++) {
+				errorCount->errs[i] = 0;
+			}
+		}
+
+		RvtH_BankEntry *const entry = d_ptr->bankEntry(bank);
+		const int ret = check_bank(entry);
+		if (bankErrs) {
+			bankErrs[bank] = ret;
+		}
+		if (ret != 0) {
+			// Bank can't be verified.
+			continue;
+		}
+
+		banks.resize(banks.size() + 1);
+		VerifyBank &vb = banks.back();
+		vb.entry = entry;
+		vb.reporter.reset(new VerifyReporter(this, bank, entry->pt_count,
+			errorCount, callback, userdata));
+		vb.cacheable = d_ptr->isHDD();
+	}
+
+	// Verify the banks in LBA order.
+	std::stable_sort(banks.begin(), banks.end(),
+		[](const VerifyBank &a, const VerifyBank &b) {
+			return a.entry->lba_start < b.entry->lba_start;
+		});
+
+	int ret = verify_banks(banks, threads, d_ptr->verifyCacheMode);
+	if (ret != 0) {
+		errno = -ret;
+		return ret;
+	}
+
+	if (bankErrs) {
+		for (const VerifyBank &vb : banks) {
+			bankErrs[vb.entry - d_ptr->entries.data()] = vb.err;
+		}
+	}
+	return 0;
+}
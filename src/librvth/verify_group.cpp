@@ -0,0 +1,354 @@
+/***************************************************************************
+ * RVT-H Tool (librvth)                                                    *
+ * verify_group.cpp: Wii partition hash verification kernel.               *
+ *                                                                         *
+ * Copyright (c) 2018-2026 by David Korth.                                 *
+ * SPDX-License-Identifier: GPL-2.0-or-later                               *
+ ***************************************************************************/
+
+#include "verify_group.hpp"
+#include "rvth_p.hpp"
+#include "rvth_enums.h"
+
+// Reader class
+#include "reader/Reader.hpp"
+
+// libwiicrypto
+#include "libwiicrypto/title_key.h"
+
+// Encryption and hashing
+#include "aesw.h"
+#include "sha1w.h"
+#include <nettle/sha1.h>
+
+#include "byteswap.h"
+
+// C includes (C++ namespace)
+#include <cerrno>
+#include <cstring>
+
+// C++ includes
+#include <array>
+using std::array;
+using std::vector;
+
+VerifyPartition::VerifyPartition()
+	: reader(nullptr)
+	, pte(nullptr)
+	, pt_idx(0)
+	, bank_idx(0)
+	, lba_data(0)
+	, group_est(0)
+	, group_hdr(0)
+	, group_count(0)
+	, last_group_sectors(0)
+	, h4_error(false)
+	, h4_is_zero(false)
+	, err(0)
+	, H3_tbl(new Wii_Disc_H3_t)
+{
+	memset(title_key, 0, sizeof(title_key));
+	memset(H3_sha1, 0, sizeof(H3_sha1));
+}
+
+/**
+ * Add an error to a group's error list.
+ * @param errors	[in,out] Error list
+ * @param hash_level	[in] Hash level
+ * @param sector	[in] Sector number
+ * @param err_type	[in] Error type
+ * @param is_zero	[in] True if the encrypted data is all zeroes.
+ * @param kb		[in,opt] KB number (H0 only)
+ */
+static inline void add_error(vector<VerifyError> &errors, unsigned int hash_level, unsigned int sector,
+	RvtH_Verify_Error_Type err_type, bool is_zero, unsigned int kb = 0)
+{
+	VerifyError error;
+	error.hash_level = static_cast<uint8_t>(hash_level);
+	error.sector = static_cast<uint8_t>(sector);
+	error.kb = static_cast<uint8_t>(kb);
+	error.err_type = static_cast<uint8_t>(err_type);
+	error.is_zero = is_zero;
+	errors.push_back(error);
+}
+
+/**
+ * Get the number of LBAs to read for a partition's groups.
+ * Some SDK update images have an incomplete last group,
+ * so this may be less than group_count * LBAS_PER_GROUP.
+ * @param pte		[in] Partition table entry
+ * @param lba_data	[in] Starting LBA of the partition data
+ * @param group_count	[in] Number of groups
+ * @return Number of LBAs.
+ */
+uint32_t rvth_verify_groups_lba_len(const pt_entry_t *pte, uint32_t lba_data, unsigned int group_count)
+{
+	const uint32_t lba_end = pte->lba_start + pte->lba_len;
+	if (lba_data >= lba_end) {
+		return 0;
+	}
+	const uint64_t lba_len = static_cast<uint64_t>(group_count) * LBAS_PER_GROUP;
+	return (lba_len < lba_end - lba_data) ? static_cast<uint32_t>(lba_len) : (lba_end - lba_data);
+}
+
+/**
+ * Decrypt and verify a group.
+ * @param aesw		[in] AES context, with the title key set
+ * @param gdata_enc	[in] Encrypted group (2 MB)
+ * @param gdata		[out] Buffer for the decrypted group (2 MB)
+ * @param H3_entry	[in] H3 hash for this group
+ * @param max_sector	[in] Number of sectors to check (1-64)
+ * @param errors	[out] Error list (cleared before verifying)
+ */
+void rvth_verify_group(AesCtx *aesw, const Wii_Disc_Sector_t *gdata_enc, Wii_Disc_Sector_t *gdata,
+	const uint8_t *H3_entry, unsigned int max_sector, vector<VerifyError> &errors)
+{
+	// Calculated hashes.
+	uint8_t H3_digest[SHA1_DIGEST_SIZE];		// H2 table in sector 0
+	uint8_t H2_digests[8][SHA1_DIGEST_SIZE];	// H1 tables in each subgroup
+	uint8_t H1_digests[64][SHA1_DIGEST_SIZE];	// H0 tables in each sector
+	uint8_t H0_digests[31][SHA1_DIGEST_SIZE];	// User data in one sector
+
+	// Zero IV for decrypting hashes.
+	static const uint8_t zero_iv[16] = {0};
+
+	errors.clear();
+
+	// Decrypt the blocks.
+	// User data IV is stored within the encrypted H2 table,
+	// so take it from the encrypted copy of the group.
+	memcpy(gdata, gdata_enc, GROUP_SIZE_ENC);
+	array<AesBatchEntry, 64*2> batch;
+	for (unsigned int i = 0; i < max_sector; i++) {
+		// User data
+		batch[i*2].iv = &gdata_enc[i].hashes.H2[7][4];
+		batch[i*2].data = gdata[i].data;
+		batch[i*2].size = sizeof(gdata[i].data);
+
+		// Hashes (IV == 0)
+		batch[i*2+1].iv = zero_iv;
+		batch[i*2+1].data = reinterpret_cast<uint8_t*>(&gdata[i].hashes);
+		batch[i*2+1].size = sizeof(gdata[i].hashes);
+	}
+	if (max_sector > 0) {
+		aesw_decrypt_batch(aesw, batch.data(), max_sector * 2);
+	}
+
+	// Verify the H3 hash. (hash of H2 table in sector 0)
+	sha1w_hash_blocks(H3_digest, gdata[0].hashes.H2[0],
+		sizeof(gdata[0].hashes.H2), sizeof(gdata[0].hashes.H2), 1);
+	if (memcmp(H3_entry, H3_digest, sizeof(H3_digest)) != 0) {
+		add_error(errors, 3, 0, RVTH_VERIFY_ERROR_BAD_HASH,
+			RvtHPrivate::isBlockEmpty((const uint8_t*)&gdata_enc[0], sizeof(gdata_enc[0])));
+	}
+
+	// Make sure sectors 1-63 have the same H2 table as sector 0.
+	for (unsigned int sector = 1; sector < max_sector; sector++) {
+		if (memcmp(gdata[0].hashes.H2,
+			   gdata[sector].hashes.H2,
+		           sizeof(gdata[0].hashes.H2)) != 0)
+		{
+			add_error(errors, 2, sector, RVTH_VERIFY_ERROR_TABLE_COPY,
+				RvtHPrivate::isBlockEmpty((const uint8_t*)&gdata_enc[sector], sizeof(gdata_enc[sector])));
+		}
+	}
+
+	// Verify the H2 hashes. (hash of H1 tables in each subgroup of 8 sectors)
+	// The H1 tables are taken from the first sector in each subgroup.
+	sha1w_hash_blocks(H2_digests[0], gdata[0].hashes.H1[0],
+		sizeof(gdata[0].hashes.H1), sizeof(gdata[0]) * 8, (max_sector + 7) / 8);
+	for (unsigned int sector = 0; sector < max_sector; sector += 8) {
+		const unsigned int sg = sector / 8;
+		if (memcmp(gdata[0].hashes.H2[sg], H2_digests[sg], SHA1_DIGEST_SIZE) != 0) {
+			add_error(errors, 2, sector, RVTH_VERIFY_ERROR_BAD_HASH,
+				RvtHPrivate::isBlockEmpty((const uint8_t*)&gdata_enc[sector], sizeof(gdata_enc[sector])));
+		}
+	}
+
+	// Make sure sectors in each subgroup have the same H1 table as
+	// sectors 0, 8, 16, 24, 32, 40, 48, 56.
+	for (unsigned int sector_start = 0; sector_start < max_sector; sector_start += 8) {
+		unsigned int sector_end = sector_start + 8;
+		if (sector_end > max_sector) {
+			sector_end = max_sector;
+		}
+		for (unsigned int sector = sector_start; sector < sector_end; sector++) {
+			if (memcmp(gdata[sector_start].hashes.H1,
+			           gdata[sector].hashes.H1,
+			           sizeof(gdata[0].hashes.H1)) != 0)
+			{
+				add_error(errors, 1, sector, RVTH_VERIFY_ERROR_TABLE_COPY,
+					RvtHPrivate::isBlockEmpty((const uint8_t*)&gdata_enc[sector], sizeof(gdata_enc[sector])));
+			}
+		}
+	}
+
+	// Verify the H1 hashes. (hash of H0 tables in each block of 31 KB)
+	sha1w_hash_blocks(H1_digests[0], gdata[0].hashes.H0[0],
+		sizeof(gdata[0].hashes.H0), sizeof(gdata[0]), max_sector);
+	for (unsigned int sector = 0; sector < max_sector; sector++) {
+		if (memcmp(gdata[sector].hashes.H1[sector % 8], H1_digests[sector], SHA1_DIGEST_SIZE) != 0) {
+			add_error(errors, 1, sector, RVTH_VERIFY_ERROR_BAD_HASH,
+				RvtHPrivate::isBlockEmpty((const uint8_t*)&gdata_enc[sector], sizeof(gdata_enc[sector])));
+		}
+	}
+
+	// H0 tables are unique per block.
+	// Verify the H0 hashes. (Now we're actually checking the data!)
+	for (unsigned int sector = 0; sector < max_sector; sector++) {
+		sha1w_hash_blocks(H0_digests[0], gdata[sector].data, 1024, 1024, ARRAY_SIZE(H0_digests));
+		for (unsigned int kb = 0; kb < 31; kb++) {
+			if (memcmp(gdata[sector].hashes.H0[kb], H0_digests[kb], SHA1_DIGEST_SIZE) != 0) {
+				add_error(errors, 0, sector, RVTH_VERIFY_ERROR_BAD_HASH,
+					RvtHPrivate::isBlockEmpty(&gdata_enc[sector].data[kb * 1024], 1024), kb+1);
+			}
+		}
+	}
+}
+
+/**
+ * Load a partition's header and H3 table, decrypt the title key,
+ * and check the H4 hash.
+ * @param pt_hdr	[out] Buffer for the partition header
+ * @param part		[in,out] Partition (reader and pte must be set)
+ * @return 0 on success; negative POSIX error code or RvtH_Errors on error.
+ */
+int rvth_verify_load_partition(RVL_PartitionHeader *pt_hdr, VerifyPartition *part)
+{
+	Reader *const reader = part->reader;
+	const pt_entry_t *const pte = part->pte;
+
+	// Initial group count will be calculated based on data size.
+	// NOTE: LBA length is in 512-byte (2^9) blocks. Groups are 2 MB (2^21).
+	// To convert from 512-byte blocks to 2 MB blocks, shift
+	// right by 12.
+	// NOTE 2: Last group is usually incomplete, so we shouldn't check past
+	// the last sector.
+	unsigned int group_count = pte->lba_len >> 12;
+	unsigned int last_group_sectors = 0;
+	if (pte->lba_len & 0xFFF) {
+		group_count++;
+		last_group_sectors = (pte->lba_len & 0xFFF) / 64;
+	}
+	part->group_est = group_count;
+
+	// Read the partition header.
+	size_t lba_size = reader->read(pt_hdr, pte->lba_start, BYTES_TO_LBA(sizeof(RVL_PartitionHeader)));
+	if (lba_size != BYTES_TO_LBA(sizeof(RVL_PartitionHeader))) {
+		// Read error.
+		int err = errno;
+		if (err == 0) {
+			err = EIO;
+		}
+		return -err;
+	}
+
+	// Use the data length in the partition header to determine
+	// the total number of groups and the last group sector count.
+	// This is usually accurate except for unencrypted partitions,
+	// in which case, this function won't work anyway!
+	if (pt_hdr->data_size != 0) {
+		const uint64_t data_size = static_cast<uint64_t>(be32_to_cpu(pt_hdr->data_size)) << 2;
+		if (data_size > 9ULL*1024*1024*1024) {
+			// Cannot be more than 9 GiB!
+			// H3 table is limited to 9,830.4 MiB,
+			// but dual-layer discs are limited to ~8 GiB.
+			return -EIO;
+		}
+		group_count = static_cast<uint32_t>(data_size / GROUP_SIZE_ENC);
+		last_group_sectors = 0;
+		if (data_size % GROUP_SIZE_ENC != 0) {
+			group_count++;
+			last_group_sectors = static_cast<uint32_t>((data_size % GROUP_SIZE_ENC) / 32768);
+		}
+		part->group_hdr = group_count;
+	}
+
+	// TMD must be located within the partition header.
+	const unsigned int tmd_offset = be32_to_cpu(pt_hdr->tmd_offset) << 2;
+	const unsigned int tmd_size = be32_to_cpu(pt_hdr->tmd_size);
+	if (tmd_offset == 0 || tmd_offset > sizeof(RVL_PartitionHeader) ||
+	    tmd_size < (sizeof(RVL_TMD_Header) + sizeof(RVL_Content_Entry)))
+	{
+		// TMD offset and/or size is invalid.
+		// TODO: More specific error?
+		return -EIO;
+	}
+	const RVL_TMD_Header *const pTmd = reinterpret_cast<const RVL_TMD_Header*>(
+		reinterpret_cast<const uint8_t*>(pt_hdr) + tmd_offset);
+	if (pTmd->nbr_cont != cpu_to_be16(1)) {
+		// Disc partitions should only have one content in the TMD!
+		// TODO: More specific error?
+		return -EIO;
+	}
+	const RVL_Content_Entry *const pContentEntry = reinterpret_cast<const RVL_Content_Entry*>(
+		reinterpret_cast<const uint8_t*>(pt_hdr) + tmd_offset + sizeof(RVL_TMD_Header));
+
+	// Decrypt the title key.
+	uint8_t crypto_type;	// not used yet?
+	int ret = decrypt_title_key(&pt_hdr->ticket, part->title_key, &crypto_type);
+	if (ret != 0) {
+		// Error decrypting title key.
+		// TODO: Indicate the error.
+		return ret;
+	}
+
+	// Get the H3 table offset. (usually 0x8000)
+	// NOTE: It's shifted right by 2, so un-shift, then convert to LBA.
+	// May cause overflow if it's too high, but it's usually 0x8000.
+	const uint32_t h3_tbl_lba = BYTES_TO_LBA(be32_to_cpu(pt_hdr->h3_table_offset) << 2);
+	if (h3_tbl_lba == 0) {
+		// Invalid H3 table LBA.
+		// TODO: Return a better error code.
+		return -EIO;
+	}
+
+	// Read the H3 table.
+	Wii_Disc_H3_t *const H3_tbl = part->H3_tbl.get();
+	lba_size = reader->read(H3_tbl, pte->lba_start + h3_tbl_lba, BYTES_TO_LBA(sizeof(Wii_Disc_H3_t)));
+	if (lba_size != BYTES_TO_LBA(sizeof(Wii_Disc_H3_t))) {
+		// Read error.
+		int err = errno;
+		if (err == 0) {
+			err = EIO;
+		}
+		return -err;
+	}
+
+	// Unlikely: Partition header's data size is 0.
+	// If so, fall back to checking the H3 table.
+	if (unlikely(pt_hdr->data_size != 0)) {
+		// Find the first 00 hash. This will indicate the group count.
+		// TODO: Partial final group?
+		const uint8_t *H3_entry = H3_tbl->h3[0];
+		for (group_count = 0; group_count < ARRAY_SIZE(H3_tbl->h3);
+			group_count++, H3_entry += ARRAY_SIZE(H3_tbl->h3[0]))
+		{
+			if (H3_entry[0] != 0)
+				continue;
+
+			// Found an H3 entry that starts with 0.
+			// Check the rest of the entry.
+			if (RvtHPrivate::isBlockEmpty(H3_entry, sizeof(H3_tbl->h3[0]))) {
+				// Found an all-zero entry.
+				break;
+			}
+		}
+	}
+	part->group_count = group_count;
+	part->last_group_sectors = last_group_sectors;
+
+	// Verify the H4 hash. (H3 table)
+	struct sha1_ctx sha1;
+	sha1_init(&sha1);
+	sha1_update(&sha1, sizeof(Wii_Disc_H3_t), reinterpret_cast<const uint8_t*>(H3_tbl));
+	sha1_digest(&sha1, sizeof(part->H3_sha1), part->H3_sha1);
+	if (memcmp(pContentEntry->sha1_hash, part->H3_sha1, SHA1_DIGEST_SIZE) != 0) {
+		part->h4_error = true;
+		part->h4_is_zero = RvtHPrivate::isBlockEmpty((const uint8_t*)H3_tbl, 512);	// only check one LBA
+	}
+
+	// Get the starting LBA of the partition data.
+	part->lba_data = pte->lba_start + BYTES_TO_LBA(static_cast<uint64_t>(be32_to_cpu(pt_hdr->data_offset)) << 2);
+	return 0;
+}
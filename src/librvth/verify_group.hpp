@@ -0,0 +1,121 @@
+/***************************************************************************
+ * RVT-H Tool (librvth)                                                    *
+ * verify_group.hpp: Wii partition hash verification kernel.               *
+ *                                                                         *
+ * Copyright (c) 2018-2026 by David Korth.                                 *
+ * SPDX-License-Identifier: GPL-2.0-or-later                               *
+ ***************************************************************************/
+
+#pragma once
+
+#include "libwiicrypto/common.h"
+#include "libwiicrypto/wii_structs.h"
+#include "libwiicrypto/wii_sector.h"
+#include "ptbl.h"
+
+// For BYTES_TO_LBA()
+#include "nhcd_structs.h"
+
+// C includes
+#include <stdint.h>
+
+// C++ includes
+#include <memory>
+#include <vector>
+
+class Reader;
+typedef struct _AesCtx AesCtx;
+
+#define LBAS_PER_GROUP BYTES_TO_LBA(GROUP_SIZE_ENC)
+
+/**
+ * Hash verification error.
+ * Errors are collected per group so they can be reported in
+ * group order, regardless of which thread verified the group.
+ */
+struct VerifyError {
+	uint8_t hash_level;	// Hash level (0-4)
+	uint8_t sector;		// Sector number (0-63)
+	uint8_t kb;		// KB number (1-31; H0 only)
+	uint8_t err_type;	// Error type (see RvtH_Verify_Error_Type)
+	bool is_zero;		// If true, the encrypted sector is all zeroes.
+};
+
+/**
+ * Partition to verify.
+ * The partition header and H3 table are loaded before
+ * any groups are read.
+ */
+struct VerifyPartition {
+	VerifyPartition();
+
+	Reader *reader;			// Reader
+	const pt_entry_t *pte;		// Partition table entry
+	unsigned int pt_idx;		// Partition index
+	unsigned int bank_idx;		// Index into the list of banks being verified
+	uint32_t lba_data;		// Starting LBA of the partition data
+
+	unsigned int group_est;		// Group count, estimated from the partition size
+	unsigned int group_hdr;		// Group count from the partition header (0 if not set)
+	unsigned int group_count;	// Group count
+	unsigned int last_group_sectors;	// Number of sectors in the last group (0 for 64)
+
+	bool h4_error;			// If true, the H4 hash is invalid.
+	bool h4_is_zero;		// If true, the H3 table is zeroed.
+	int err;			// Error loading the partition (negative POSIX error or RvtH_Errors)
+
+	std::unique_ptr<Wii_Disc_H3_t> H3_tbl;	// H3 table
+	uint8_t H3_sha1[RVL_SHA1_DIGEST_SIZE];	// SHA-1 of the H3 table
+	uint8_t title_key[16];			// Decrypted title key
+
+	/**
+	 * Get the number of sectors to check in a group.
+	 * @param group	[in] Group number
+	 * @return Number of sectors. (1-64)
+	 */
+	inline unsigned int groupSectors(unsigned int group) const
+	{
+		return (last_group_sectors != 0 && group == group_count - 1)
+			? last_group_sectors : 64;
+	}
+};
+
+/**
+ * Load a partition's header and H3 table, decrypt the title key,
+ * and check the H4 hash.
+ * @param pt_hdr	[out] Buffer for the partition header
+ * @param part		[in,out] Partition (reader and pte must be set)
+ * @return 0 on success; negative POSIX error code or RvtH_Errors on error.
+ */
+int rvth_verify_load_partition(RVL_PartitionHeader *pt_hdr, VerifyPartition *part);
+
+/**
+ * Get the number of LBAs to read for a partition's groups.
+ * Some SDK update images have an incomplete last group,
+ * so this may be less than group_count * LBAS_PER_GROUP.
+ * @param pte		[in] Partition table entry
+ * @param lba_data	[in] Starting LBA of the partition data
+ * @param group_count	[in] Number of groups
+ * @return Number of LBAs.
+ */
+uint32_t rvth_verify_groups_lba_len(const pt_entry_t *pte, uint32_t lba_data, unsigned int group_count);
+
+/**
+ * Decrypt and verify a group.
+ *
+ * This is the hash verification kernel shared by standalone
+ * verification and import verification. It doesn't do any I/O,
+ * so it can be run on any thread as long as each thread has
+ * its own AES context and buffers.
+ *
+ * Errors are added to the list in the order they're found.
+ *
+ * @param aesw		[in] AES context, with the title key set
+ * @param gdata_enc	[in] Encrypted group (2 MB)
+ * @param gdata		[out] Buffer for the decrypted group (2 MB)
+ * @param H3_entry	[in] H3 hash for this group
+ * @param max_sector	[in] Number of sectors to check (1-64)
+ * @param errors	[out] Error list (cleared before verifying)
+ */
+void rvth_verify_group(AesCtx *aesw, const Wii_Disc_Sector_t *gdata_enc, Wii_Disc_Sector_t *gdata,
+	const uint8_t *H3_entry, unsigned int max_sector, std::vector<VerifyError> &errors);
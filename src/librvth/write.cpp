@@ -2,7 +2,7 @@
  * RVT-H Tool (librvth)                                                    *
  * write.cpp: RVT-H write functions.                                       *
  *                                                                         *
- * Copyright (c) 2018-2025 by David Korth.                                 *
+ * Copyright (c) 2018-2026 by David Korth.                                 *
  * SPDX-License-Identifier: GPL-2.0-or-later                               *
  ***************************************************************************/
 
@@ -13,8 +13,10 @@
 #include "byteswap.h"
 #include "nhcd_structs.h"
 
-// Disc image reader
+// Disc image readers
 #include "reader/Reader.hpp"
+#include "reader/CisoReader.hpp"
+#include "reader/WbfsReader.hpp"
 
 // C includes
 #include <stdlib.h>
@@ -36,6 +38,21 @@
  * @param pErr		[out,opt] Error code. (If negative, POSIX error; otherwise, see RvtH_Errors.)
  */
 RvtH::RvtH(const TCHAR *filename, uint32_t lba_len, int *pErr)
+	: RvtH(filename, lba_len, RVTH_ImageFormat_GCM, pErr)
+{}
+
+/**
+ * Create a writable RVT-H disc image object using the specified format.
+ *
+ * Check isOpen() after constructing the object to determine
+ * if the file was opened successfully.
+ *
+ * @param filename	[in] Filename.
+ * @param lba_len	[in] LBA length. (Will NOT be allocated initially.)
+ * @param format	[in] Disc image format.
+ * @param pErr		[out,opt] Error code. (If negative, POSIX error; otherwise, see RvtH_Errors.)
+ */
+RvtH::RvtH(const TCHAR *filename, uint32_t lba_len, RvtH_ImageFormat_e format, int *pErr)
 	: d_ptr(new RvtHPrivate(this))
 {
 	RvtH_BankEntry *entry;
@@ -68,7 +85,7 @@ RvtH::RvtH(const TCHAR *filename, uint32_t lba_len, int *pErr)
 
 	// Initialize the bank entry.
 	// NOTE: Not using rvth_init_BankEntry() here.
-	entry = &d_ptr->entries[0];
+	entry = d_ptr->bankEntry(0);
 	entry->lba_start = 0;
 	entry->lba_len = lba_len;
 	entry->type = RVTH_BankType_Empty;
@@ -79,7 +96,18 @@ RvtH::RvtH(const TCHAR *filename, uint32_t lba_len, int *pErr)
 	entry->timestamp = time(nullptr);
 
 	// Initialize the disc image reader.
-	entry->reader = Reader::open(d_ptr->file, entry->lba_start, entry->lba_len);
+	switch (format) {
+		case RVTH_ImageFormat_GCM:
+		default:
+			entry->reader = Reader::open(d_ptr->file, entry->lba_start, entry->lba_len);
+			break;
+		case RVTH_ImageFormat_CISO:
+			entry->reader = CisoReader::create(d_ptr->file, entry->lba_start, entry->lba_len);
+			break;
+		case RVTH_ImageFormat_WBFS:
+			entry->reader = WbfsReader::create(d_ptr->file, entry->lba_start, entry->lba_len);
+			break;
+	}
 	if (!entry->reader) {
 		// Error creating the disc image reader.
 		err = errno;
@@ -127,7 +155,7 @@ int RvtH::deleteBank(unsigned int bank)
 	}
 
 	// Is the bank deleted?
-	RvtH_BankEntry *const rvth_entry = &d_ptr->entries[bank];
+	RvtH_BankEntry *const rvth_entry = d_ptr->bankEntry(bank);
 	if (rvth_entry->is_deleted) {
 		// Bank is already deleted.
 		return RVTH_ERROR_BANK_IS_DELETED;
@@ -193,7 +221,7 @@ int RvtH::undeleteBank(unsigned int bank)
 	}
 
 	// Is the bank deleted?
-	RvtH_BankEntry *const rvth_entry = &d_ptr->entries[bank];
+	RvtH_BankEntry *const rvth_entry = d_ptr->bankEntry(bank);
 	if (!rvth_entry->is_deleted) {
 		// Bank is not deleted.
 		return RVTH_ERROR_BANK_NOT_DELETED;
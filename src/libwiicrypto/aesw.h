@@ -68,6 +68,57 @@ size_t aesw_encrypt(AesCtx *aesw, uint8_t *pData, size_t size);
  */
 size_t aesw_decrypt(AesCtx *aesw, uint8_t *pData, size_t size);
 
+/**
+ * AES batch entry.
+ * Used for encrypting or decrypting many blocks with the same key.
+ */
+typedef struct _AesBatchEntry {
+	const uint8_t *iv;	// IV (16 bytes)
+	uint8_t *data;		// Data block (in/out)
+	size_t size;		// Length of data block. (Must be a multiple of 16.)
+} AesBatchEntry;
+
+/**
+ * Encrypt a batch of data blocks, each with its own IV.
+ *
+ * Entries are processed in order, and each entry's IV is read
+ * immediately before that entry is encrypted, so an IV may point
+ * into data that was encrypted by an earlier entry.
+ *
+ * The IV set with aesw_set_iv() is neither used nor modified.
+ *
+ * @param aesw		[in] AES context.
+ * @param entries	[in] Batch entries.
+ * @param count		[in] Number of entries.
+ * @return Number of entries encrypted on success; 0 on error.
+ */
+size_t aesw_encrypt_batch(AesCtx *aesw, const AesBatchEntry *entries, size_t count);
+
+/**
+ * Decrypt a batch of data blocks, each with its own IV.
+ *
+ * Entries are processed in order, and each entry's IV is read
+ * immediately before that entry is decrypted, so an IV may point
+ * into ciphertext that will be decrypted by a later entry.
+ *
+ * The IV set with aesw_set_iv() is neither used nor modified.
+ *
+ * @param aesw		[in] AES context.
+ * @param entries	[in] Batch entries.
+ * @param count		[in] Number of entries.
+ * @return Number of entries decrypted on success; 0 on error.
+ */
+size_t aesw_decrypt_batch(AesCtx *aesw, const AesBatchEntry *entries, size_t count);
+
+/**
+ * Enable or disable hardware acceleration for an AES context.
+ * Hardware acceleration is enabled by default if the CPU supports it.
+ * @param aesw		[in] AES context.
+ * @param enable	[in] Non-zero to enable; zero to disable.
+ * @return 0 on success; negative POSIX error code on error. (-ENOTSUP if not available)
+ */
+int aesw_set_hw_accel(AesCtx *aesw, int enable);
+
 #ifdef __cplusplus
 }
 #endif
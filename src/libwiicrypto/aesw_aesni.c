@@ -0,0 +1,217 @@
+/***************************************************************************
+ * RVT-H Tool (libwiicrypto)                                               *
+ * aesw_aesni.c: AES wrapper functions. (AES-NI version)                   *
+ *                                                                         *
+ * Copyright (c) 2026 by David Korth.                                      *
+ * SPDX-License-Identifier: GPL-2.0-or-later                               *
+ ***************************************************************************/
+
+#include "aesw_hw.h"
+
+// AES-NI intrinsics
+#include <emmintrin.h>
+#include <wmmintrin.h>
+
+#include "cpuflags_x86.h"
+
+/**
+ * Does the CPU support the hardware AES backend?
+ * @return True if supported; false if not.
+ */
+bool aesw_hw_is_supported(void)
+{
+	return cpuflags_x86_has(CPUFLAG_X86_AESNI);
+}
+
+/**
+ * AES-128 key expansion step.
+ * @param key Previous round key
+ * @param keygened Result of _mm_aeskeygenassist_si128()
+ * @return Next round key
+ */
+static inline __m128i aes128_key_exp(__m128i key, __m128i keygened)
+{
+	keygened = _mm_shuffle_epi32(keygened, _MM_SHUFFLE(3,3,3,3));
+	key = _mm_xor_si128(key, _mm_slli_si128(key, 4));
+	key = _mm_xor_si128(key, _mm_slli_si128(key, 4));
+	key = _mm_xor_si128(key, _mm_slli_si128(key, 4));
+	return _mm_xor_si128(key, keygened);
+}
+
+// NOTE: _mm_aeskeygenassist_si128() requires an immediate value for rcon.
+#define AES128_KEY_EXP(k, rcon) aes128_key_exp(k, _mm_aeskeygenassist_si128(k, rcon))
+
+/**
+ * Expand an AES-128 key.
+ * @param hw	[out] Expanded round keys.
+ * @param pKey	[in] Key data. (16 bytes)
+ */
+void aesw_hw_set_key(AesHwKeys *hw, const uint8_t *pKey)
+{
+	__m128i rk[11];
+	unsigned int i;
+
+	rk[0]  = _mm_loadu_si128((const __m128i*)pKey);
+	rk[1]  = AES128_KEY_EXP(rk[0], 0x01);
+	rk[2]  = AES128_KEY_EXP(rk[1], 0x02);
+	rk[3]  = AES128_KEY_EXP(rk[2], 0x04);
+	rk[4]  = AES128_KEY_EXP(rk[3], 0x08);
+	rk[5]  = AES128_KEY_EXP(rk[4], 0x10);
+	rk[6]  = AES128_KEY_EXP(rk[5], 0x20);
+	rk[7]  = AES128_KEY_EXP(rk[6], 0x40);
+	rk[8]  = AES128_KEY_EXP(rk[7], 0x80);
+	rk[9]  = AES128_KEY_EXP(rk[8], 0x1B);
+	rk[10] = AES128_KEY_EXP(rk[9], 0x36);
+
+	// Decryption keys are in reverse order, with InvMixColumns
+	// applied to all but the first and last round keys.
+	for (i = 0; i < 11; i++) {
+		_mm_storeu_si128((__m128i*)hw->enc[i], rk[i]);
+	}
+	_mm_storeu_si128((__m128i*)hw->dec[0], rk[10]);
+	for (i = 1; i < 10; i++) {
+		_mm_storeu_si128((__m128i*)hw->dec[i], _mm_aesimc_si128(rk[10-i]));
+	}
+	_mm_storeu_si128((__m128i*)hw->dec[10], rk[0]);
+}
+
+/**
+ * Load round keys.
+ * @param rk	[out] Round keys.
+ * @param src	[in] Round keys from AesHwKeys.
+ */
+static inline void load_round_keys(__m128i rk[11], const uint8_t src[11][16])
+{
+	unsigned int i;
+	for (i = 0; i < 11; i++) {
+		rk[i] = _mm_loadu_si128((const __m128i*)src[i]);
+	}
+}
+
+/**
+ * Encrypt a block of data using AES-128-CBC.
+ * @param hw	[in] Expanded round keys.
+ * @param iv	[in/out] IV. (Updated for chaining.)
+ * @param pData	[in/out] Data block.
+ * @param size	[in] Length of data block. (Must be a multiple of 16.)
+ */
+void aesw_hw_cbc_encrypt(const AesHwKeys *hw, uint8_t *iv, uint8_t *pData, size_t size)
+{
+	__m128i rk[11];
+	__m128i fb;
+	unsigned int r;
+
+	load_round_keys(rk, hw->enc);
+	fb = _mm_loadu_si128((const __m128i*)iv);
+	for (; size >= 16; size -= 16, pData += 16) {
+		__m128i b = _mm_xor_si128(_mm_loadu_si128((const __m128i*)pData), fb);
+		b = _mm_xor_si128(b, rk[0]);
+		for (r = 1; r < 10; r++) {
+			b = _mm_aesenc_si128(b, rk[r]);
+		}
+		fb = _mm_aesenclast_si128(b, rk[10]);
+		_mm_storeu_si128((__m128i*)pData, fb);
+	}
+	_mm_storeu_si128((__m128i*)iv, fb);
+}
+
+/**
+ * Encrypt AESW_HW_LANES independent data blocks using AES-128-CBC.
+ * The blocks are encrypted in lockstep to hide instruction latency.
+ *
+ * All blocks must be the same size, and no entry's IV may
+ * overlap another entry's data.
+ *
+ * @param hw		[in] Expanded round keys.
+ * @param entries	[in] AESW_HW_LANES batch entries.
+ */
+void aesw_hw_cbc_encrypt_multi(const AesHwKeys *hw, const AesBatchEntry *entries)
+{
+	__m128i rk[11];
+	__m128i fb[AESW_HW_LANES];
+	uint8_t *pData[AESW_HW_LANES];
+	size_t size = entries[0].size;
+	unsigned int l, r;
+
+	load_round_keys(rk, hw->enc);
+	for (l = 0; l < AESW_HW_LANES; l++) {
+		fb[l] = _mm_loadu_si128((const __m128i*)entries[l].iv);
+		pData[l] = entries[l].data;
+	}
+
+	for (; size >= 16; size -= 16) {
+		__m128i b[AESW_HW_LANES];
+		for (l = 0; l < AESW_HW_LANES; l++) {
+			b[l] = _mm_xor_si128(_mm_loadu_si128((const __m128i*)pData[l]), fb[l]);
+			b[l] = _mm_xor_si128(b[l], rk[0]);
+		}
+		for (r = 1; r < 10; r++) {
+			for (l = 0; l < AESW_HW_LANES; l++) {
+				b[l] = _mm_aesenc_si128(b[l], rk[r]);
+			}
+		}
+		for (l = 0; l < AESW_HW_LANES; l++) {
+			fb[l] = _mm_aesenclast_si128(b[l], rk[10]);
+			_mm_storeu_si128((__m128i*)pData[l], fb[l]);
+			pData[l] += 16;
+		}
+	}
+}
+
+/**
+ * Decrypt a block of data using AES-128-CBC.
+ * @param hw	[in] Expanded round keys.
+ * @param iv	[in/out] IV. (Updated for chaining.)
+ * @param pData	[in/out] Data block.
+ * @param size	[in] Length of data block. (Must be a multiple of 16.)
+ */
+void aesw_hw_cbc_decrypt(const AesHwKeys *hw, uint8_t *iv, uint8_t *pData, size_t size)
+{
+	__m128i rk[11];
+	__m128i prev;
+	unsigned int i, r;
+
+	load_round_keys(rk, hw->dec);
+	prev = _mm_loadu_si128((const __m128i*)iv);
+
+	// CBC decryption doesn't depend on the previous block's output,
+	// so decrypt 8 blocks at a time to keep the AES unit busy.
+	for (; size >= 16*8; size -= 16*8, pData += 16*8) {
+		__m128i c[8], b[8];
+		for (i = 0; i < 8; i++) {
+			c[i] = _mm_loadu_si128((const __m128i*)&pData[i*16]);
+			b[i] = _mm_xor_si128(c[i], rk[0]);
+		}
+		for (r = 1; r < 10; r++) {
+			for (i = 0; i < 8; i++) {
+				b[i] = _mm_aesdec_si128(b[i], rk[r]);
+			}
+		}
+		for (i = 0; i < 8; i++) {
+			b[i] = _mm_aesdeclast_si128(b[i], rk[10]);
+		}
+
+		b[0] = _mm_xor_si128(b[0], prev);
+		for (i = 1; i < 8; i++) {
+			b[i] = _mm_xor_si128(b[i], c[i-1]);
+		}
+		for (i = 0; i < 8; i++) {
+			_mm_storeu_si128((__m128i*)&pData[i*16], b[i]);
+		}
+		prev = c[7];
+	}
+
+	// Remaining blocks.
+	for (; size >= 16; size -= 16, pData += 16) {
+		const __m128i c = _mm_loadu_si128((const __m128i*)pData);
+		__m128i b = _mm_xor_si128(c, rk[0]);
+		for (r = 1; r < 10; r++) {
+			b = _mm_aesdec_si128(b, rk[r]);
+		}
+		b = _mm_aesdeclast_si128(b, rk[10]);
+		_mm_storeu_si128((__m128i*)pData, _mm_xor_si128(b, prev));
+		prev = c;
+	}
+
+	_mm_storeu_si128((__m128i*)iv, prev);
+}
@@ -0,0 +1,256 @@
+/***************************************************************************
+ * RVT-H Tool (libwiicrypto)                                               *
+ * aesw_armce.c: AES wrapper functions. (ARMv8 Crypto Extensions version)  *
+ *                                                                         *
+ * Copyright (c) 2026 by David Korth.                                      *
+ * SPDX-License-Identifier: GPL-2.0-or-later                               *
+ ***************************************************************************/
+
+#include "aesw_hw.h"
+
+// ARMv8 Crypto Extensions intrinsics
+#include <arm_neon.h>
+
+// CPU feature detection
+#if defined(__linux__)
+#  include <sys/auxv.h>
+#  ifndef HWCAP_AES
+#    include <asm/hwcap.h>
+#  endif
+#elif defined(_WIN32)
+#  include <windows.h>
+#endif
+
+/**
+ * Does the CPU support the hardware AES backend?
+ * @return True if supported; false if not.
+ */
+bool aesw_hw_is_supported(void)
+{
+#if defined(__APPLE__)
+	// All Apple ARM64 CPUs support the Crypto Extensions.
+	return true;
+#elif defined(__linux__) && defined(HWCAP_AES)
+	return !!(getauxval(AT_HWCAP) & HWCAP_AES);
+#elif defined(_WIN32)
+	return !!IsProcessorFeaturePresent(PF_ARM_V8_CRYPTO_INSTRUCTIONS_AVAILABLE);
+#else
+	// TODO: Detection for other operating systems.
+	return false;
+#endif
+}
+
+/**
+ * AES SubWord() using the AESE instruction.
+ * With all four columns set to the same word, ShiftRows has no
+ * effect, so AESE with a zero round key is just SubBytes.
+ * @param w Word
+ * @return SubWord(w)
+ */
+static inline uint32_t aes_sub_word(uint32_t w)
+{
+	const uint8x16_t v = vaeseq_u8(vreinterpretq_u8_u32(vdupq_n_u32(w)), vdupq_n_u8(0));
+	return vgetq_lane_u32(vreinterpretq_u32_u8(v), 0);
+}
+
+/**
+ * Expand an AES-128 key.
+ * @param hw	[out] Expanded round keys.
+ * @param pKey	[in] Key data. (16 bytes)
+ */
+void aesw_hw_set_key(AesHwKeys *hw, const uint8_t *pKey)
+{
+	static const uint8_t rcon[10] = {
+		0x01, 0x02, 0x04, 0x08, 0x10, 0x20, 0x40, 0x80, 0x1B, 0x36
+	};
+	uint32_t w[44];
+	unsigned int i;
+
+	// NOTE: Words are stored in little-endian order, so RotWord()
+	// is a right rotation and rcon goes into the low byte.
+	for (i = 0; i < 4; i++) {
+		w[i] = (uint32_t)pKey[i*4] |
+		       ((uint32_t)pKey[i*4+1] << 8) |
+		       ((uint32_t)pKey[i*4+2] << 16) |
+		       ((uint32_t)pKey[i*4+3] << 24);
+	}
+	for (i = 4; i < 44; i++) {
+		uint32_t t = w[i-1];
+		if (i % 4 == 0) {
+			t = aes_sub_word((t >> 8) | (t << 24)) ^ rcon[i/4 - 1];
+		}
+		w[i] = w[i-4] ^ t;
+	}
+	for (i = 0; i < 11; i++) {
+		vst1q_u8(hw->enc[i], vreinterpretq_u8_u32(vld1q_u32(&w[i*4])));
+	}
+
+	// Decryption keys are in reverse order, with InvMixColumns
+	// applied to all but the first and last round keys.
+	vst1q_u8(hw->dec[0], vld1q_u8(hw->enc[10]));
+	for (i = 1; i < 10; i++) {
+		vst1q_u8(hw->dec[i], vaesimcq_u8(vld1q_u8(hw->enc[10-i])));
+	}
+	vst1q_u8(hw->dec[10], vld1q_u8(hw->enc[0]));
+}
+
+/**
+ * Load round keys.
+ * @param rk	[out] Round keys.
+ * @param src	[in] Round keys from AesHwKeys.
+ */
+static inline void load_round_keys(uint8x16_t rk[11], const uint8_t src[11][16])
+{
+	unsigned int i;
+	for (i = 0; i < 11; i++) {
+		rk[i] = vld1q_u8(src[i]);
+	}
+}
+
+/**
+ * Encrypt a single block.
+ * @param b Block
+ * @param rk Encryption round keys
+ * @return Encrypted block
+ */
+static inline uint8x16_t aes_encrypt_block(uint8x16_t b, const uint8x16_t rk[11])
+{
+	unsigned int r;
+	for (r = 0; r < 9; r++) {
+		b = vaesmcq_u8(vaeseq_u8(b, rk[r]));
+	}
+	b = vaeseq_u8(b, rk[9]);
+	return veorq_u8(b, rk[10]);
+}
+
+/**
+ * Decrypt a single block.
+ * @param b Block
+ * @param rk Decryption round keys
+ * @return Decrypted block
+ */
+static inline uint8x16_t aes_decrypt_block(uint8x16_t b, const uint8x16_t rk[11])
+{
+	unsigned int r;
+	for (r = 0; r < 9; r++) {
+		b = vaesimcq_u8(vaesdq_u8(b, rk[r]));
+	}
+	b = vaesdq_u8(b, rk[9]);
+	return veorq_u8(b, rk[10]);
+}
+
+/**
+ * Encrypt a block of data using AES-128-CBC.
+ * @param hw	[in] Expanded round keys.
+ * @param iv	[in/out] IV. (Updated for chaining.)
+ * @param pData	[in/out] Data block.
+ * @param size	[in] Length of data block. (Must be a multiple of 16.)
+ */
+void aesw_hw_cbc_encrypt(const AesHwKeys *hw, uint8_t *iv, uint8_t *pData, size_t size)
+{
+	uint8x16_t rk[11];
+	uint8x16_t fb;
+
+	load_round_keys(rk, hw->enc);
+	fb = vld1q_u8(iv);
+	for (; size >= 16; size -= 16, pData += 16) {
+		fb = aes_encrypt_block(veorq_u8(vld1q_u8(pData), fb), rk);
+		vst1q_u8(pData, fb);
+	}
+	vst1q_u8(iv, fb);
+}
+
+/**
+ * Encrypt AESW_HW_LANES independent data blocks using AES-128-CBC.
+ * The blocks are encrypted in lockstep to hide instruction latency.
+ *
+ * All blocks must be the same size, and no entry's IV may
+ * overlap another entry's data.
+ *
+ * @param hw		[in] Expanded round keys.
+ * @param entries	[in] AESW_HW_LANES batch entries.
+ */
+void aesw_hw_cbc_encrypt_multi(const AesHwKeys *hw, const AesBatchEntry *entries)
+{
+	uint8x16_t rk[11];
+	uint8x16_t fb[AESW_HW_LANES];
+	uint8_t *pData[AESW_HW_LANES];
+	size_t size = entries[0].size;
+	unsigned int l, r;
+
+	load_round_keys(rk, hw->enc);
+	for (l = 0; l < AESW_HW_LANES; l++) {
+		fb[l] = vld1q_u8(entries[l].iv);
+		pData[l] = entries[l].data;
+	}
+
+	for (; size >= 16; size -= 16) {
+		uint8x16_t b[AESW_HW_LANES];
+		for (l = 0; l < AESW_HW_LANES; l++) {
+			b[l] = veorq_u8(vld1q_u8(pData[l]), fb[l]);
+		}
+		for (r = 0; r < 9; r++) {
+			for (l = 0; l < AESW_HW_LANES; l++) {
+				b[l] = vaesmcq_u8(vaeseq_u8(b[l], rk[r]));
+			}
+		}
+		for (l = 0; l < AESW_HW_LANES; l++) {
+			fb[l] = veorq_u8(vaeseq_u8(b[l], rk[9]), rk[10]);
+			vst1q_u8(pData[l], fb[l]);
+			pData[l] += 16;
+		}
+	}
+}
+
+/**
+ * Decrypt a block of data using AES-128-CBC.
+ * @param hw	[in] Expanded round keys.
+ * @param iv	[in/out] IV. (Updated for chaining.)
+ * @param pData	[in/out] Data block.
+ * @param size	[in] Length of data block. (Must be a multiple of 16.)
+ */
+void aesw_hw_cbc_decrypt(const AesHwKeys *hw, uint8_t *iv, uint8_t *pData, size_t size)
+{
+	uint8x16_t rk[11];
+	uint8x16_t prev;
+	unsigned int i, r;
+
+	load_round_keys(rk, hw->dec);
+	prev = vld1q_u8(iv);
+
+	// CBC decryption doesn't depend on the previous block's output,
+	// so decrypt 8 blocks at a time to keep the AES unit busy.
+	for (; size >= 16*8; size -= 16*8, pData += 16*8) {
+		uint8x16_t c[8], b[8];
+		for (i = 0; i < 8; i++) {
+			c[i] = vld1q_u8(&pData[i*16]);
+			b[i] = c[i];
+		}
+		for (r = 0; r < 9; r++) {
+			for (i = 0; i < 8; i++) {
+				b[i] = vaesimcq_u8(vaesdq_u8(b[i], rk[r]));
+			}
+		}
+		for (i = 0; i < 8; i++) {
+			b[i] = veorq_u8(vaesdq_u8(b[i], rk[9]), rk[10]);
+		}
+
+		b[0] = veorq_u8(b[0], prev);
+		for (i = 1; i < 8; i++) {
+			b[i] = veorq_u8(b[i], c[i-1]);
+		}
+		for (i = 0; i < 8; i++) {
+			vst1q_u8(&pData[i*16], b[i]);
+		}
+		prev = c[7];
+	}
+
+	// Remaining blocks.
+	for (; size >= 16; size -= 16, pData += 16) {
+		const uint8x16_t c = vld1q_u8(pData);
+		vst1q_u8(pData, veorq_u8(aes_decrypt_block(c, rk), prev));
+		prev = c;
+	}
+
+	vst1q_u8(iv, prev);
+}
@@ -0,0 +1,87 @@
+/***************************************************************************
+ * RVT-H Tool (libwiicrypto)                                               *
+ * aesw_hw.h: AES wrapper functions. (hardware acceleration)               *
+ *                                                                         *
+ * Copyright (c) 2026 by David Korth.                                      *
+ * SPDX-License-Identifier: GPL-2.0-or-later                               *
+ ***************************************************************************/
+
+// NOTE: This is an internal header used by aesw_nettle.c.
+// It should not be used by anything outside of libwiicrypto.
+
+#pragma once
+
+#include "config.libwiicrypto.h"
+#include "aesw.h"
+#include "stdboolx.h"
+
+#if defined(HAVE_AESW_AESNI) || defined(HAVE_AESW_ARMCE)
+#  define HAVE_AESW_HW 1
+#endif
+
+#ifdef HAVE_AESW_HW
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Number of independent CBC streams that aesw_hw_cbc_encrypt_multi()
+// processes at once.
+#define AESW_HW_LANES 4
+
+/**
+ * Expanded AES-128 round keys for the hardware backend.
+ */
+typedef struct _AesHwKeys {
+	uint8_t enc[11][16];	// Encryption round keys
+	uint8_t dec[11][16];	// Decryption round keys (inverse cipher)
+} AesHwKeys;
+
+/**
+ * Does the CPU support the hardware AES backend?
+ * @return True if supported; false if not.
+ */
+bool aesw_hw_is_supported(void);
+
+/**
+ * Expand an AES-128 key.
+ * @param hw	[out] Expanded round keys.
+ * @param pKey	[in] Key data. (16 bytes)
+ */
+void aesw_hw_set_key(AesHwKeys *hw, const uint8_t *pKey);
+
+/**
+ * Encrypt a block of data using AES-128-CBC.
+ * @param hw	[in] Expanded round keys.
+ * @param iv	[in/out] IV. (Updated for chaining.)
+ * @param pData	[in/out] Data block.
+ * @param size	[in] Length of data block. (Must be a multiple of 16.)
+ */
+void aesw_hw_cbc_encrypt(const AesHwKeys *hw, uint8_t *iv, uint8_t *pData, size_t size);
+
+/**
+ * Encrypt AESW_HW_LANES independent data blocks using AES-128-CBC.
+ * The blocks are encrypted in lockstep to hide instruction latency.
+ *
+ * All blocks must be the same size, and no entry's IV may
+ * overlap another entry's data.
+ *
+ * @param hw		[in] Expanded round keys.
+ * @param entries	[in] AESW_HW_LANES batch entries.
+ */
+void aesw_hw_cbc_encrypt_multi(const AesHwKeys *hw, const AesBatchEntry *entries);
+
+/**
+ * Decrypt a block of data using AES-128-CBC.
+ * @param hw	[in] Expanded round keys.
+ * @param iv	[in/out] IV. (Updated for chaining.)
+ * @param pData	[in/out] Data block.
+ * @param size	[in] Length of data block. (Must be a multiple of 16.)
+ */
+void aesw_hw_cbc_decrypt(const AesHwKeys *hw, uint8_t *iv, uint8_t *pData, size_t size);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* HAVE_AESW_HW */
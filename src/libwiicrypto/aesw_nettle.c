@@ -2,13 +2,15 @@
  * RVT-H Tool (libwiicrypto)                                               *
  * aesw_nettle.c: AES wrapper functions. (nettle version)                  *
  *                                                                         *
- * Copyright (c) 2018 by David Korth.                                      *
+ * Copyright (c) 2018-2026 by David Korth.                                 *
  * SPDX-License-Identifier: GPL-2.0-or-later                               *
  ***************************************************************************/
 
 #include "config.nettle.h"
 
 #include "aesw.h"
+#include "aesw_hw.h"
+#include "stdboolx.h"
 
 #include <assert.h>
 #include <errno.h>
@@ -20,19 +22,104 @@
 #include <nettle/cbc.h>
 
 // AES context. (GNU Nettle version.)
+// NOTE: Both key schedules are expanded when the key is set,
+// since callers usually encrypt or decrypt many small blocks
+// with the same key.
 struct _AesCtx {
 #ifdef HAVE_NETTLE_3
-	struct aes128_ctx ctx;
+	struct aes128_ctx enc_ctx;	// Encryption key schedule
+	struct aes128_ctx dec_ctx;	// Decryption key schedule
 #else /* !HAVE_NETTLE_3 */
-	struct aes_ctx ctx;
+	struct aes_ctx enc_ctx;		// Encryption key schedule
+	struct aes_ctx dec_ctx;		// Decryption key schedule
 #endif /* HAVE_NETTLE_3 */
 
+#ifdef HAVE_AESW_HW
+	// Hardware-accelerated backend.
+	AesHwKeys hw;		// Expanded round keys
+	bool hw_supported;	// CPU supports the hardware backend
+	bool use_hw;		// Use the hardware backend
+#endif /* HAVE_AESW_HW */
+
 	// Encryption key.
 	uint8_t key[16];
 	// Initialization vector.
 	uint8_t iv[16];
 };
 
+#ifdef HAVE_NETTLE_3
+#  define AESW_CBC_ENCRYPT(aesw, iv, size, pData) \
+	cbc_encrypt(&(aesw)->enc_ctx, (nettle_cipher_func*)aes128_encrypt, \
+		AES_BLOCK_SIZE, (iv), (size), (pData), (pData))
+#  define AESW_CBC_DECRYPT(aesw, iv, size, pData) \
+	cbc_decrypt(&(aesw)->dec_ctx, (nettle_cipher_func*)aes128_decrypt, \
+		AES_BLOCK_SIZE, (iv), (size), (pData), (pData))
+#else /* !HAVE_NETTLE_3 */
+#  define AESW_CBC_ENCRYPT(aesw, iv, size, pData) \
+	cbc_encrypt(&(aesw)->enc_ctx, (nettle_crypt_func*)aes_encrypt, \
+		AES_BLOCK_SIZE, (iv), (size), (pData), (pData))
+#  define AESW_CBC_DECRYPT(aesw, iv, size, pData) \
+	cbc_decrypt(&(aesw)->dec_ctx, (nettle_crypt_func*)aes_decrypt, \
+		AES_BLOCK_SIZE, (iv), (size), (pData), (pData))
+#endif /* HAVE_NETTLE_3 */
+
+/**
+ * Expand the encryption and decryption key schedules.
+ * @param aesw AES context.
+ */
+static void aesw_expand_key(AesCtx *aesw)
+{
+#ifdef HAVE_NETTLE_3
+	aes128_set_encrypt_key(&aesw->enc_ctx, aesw->key);
+	aes128_set_decrypt_key(&aesw->dec_ctx, aesw->key);
+#else /* !HAVE_NETTLE_3 */
+	aes_set_encrypt_key(&aesw->enc_ctx, sizeof(aesw->key), aesw->key);
+	aes_set_decrypt_key(&aesw->dec_ctx, sizeof(aesw->key), aesw->key);
+#endif /* HAVE_NETTLE_3 */
+
+#ifdef HAVE_AESW_HW
+	if (aesw->hw_supported) {
+		aesw_hw_set_key(&aesw->hw, aesw->key);
+	}
+#endif /* HAVE_AESW_HW */
+}
+
+/**
+ * Encrypt a block of data using AES-128-CBC.
+ * @param aesw	[in] AES context.
+ * @param iv	[in/out] IV. (Updated for chaining.)
+ * @param pData	[in/out] Data block.
+ * @param size	[in] Length of data block. (Must be a multiple of 16.)
+ */
+static inline void aesw_cbc_encrypt(AesCtx *aesw, uint8_t *iv, uint8_t *pData, size_t size)
+{
+#ifdef HAVE_AESW_HW
+	if (aesw->use_hw) {
+		aesw_hw_cbc_encrypt(&aesw->hw, iv, pData, size);
+		return;
+	}
+#endif /* HAVE_AESW_HW */
+	AESW_CBC_ENCRYPT(aesw, iv, size, pData);
+}
+
+/**
+ * Decrypt a block of data using AES-128-CBC.
+ * @param aesw	[in] AES context.
+ * @param iv	[in/out] IV. (Updated for chaining.)
+ * @param pData	[in/out] Data block.
+ * @param size	[in] Length of data block. (Must be a multiple of 16.)
+ */
+static inline void aesw_cbc_decrypt(AesCtx *aesw, uint8_t *iv, uint8_t *pData, size_t size)
+{
+#ifdef HAVE_AESW_HW
+	if (aesw->use_hw) {
+		aesw_hw_cbc_decrypt(&aesw->hw, iv, pData, size);
+		return;
+	}
+#endif /* HAVE_AESW_HW */
+	AESW_CBC_DECRYPT(aesw, iv, size, pData);
+}
+
 /**
  * Create an AES context.
  * @return AES context, or NULL on error.
@@ -47,6 +134,15 @@ AesCtx *aesw_new(void)
 		return NULL;
 	}
 
+#ifdef HAVE_AESW_HW
+	// Use the hardware backend if the CPU supports it.
+	aesw->hw_supported = aesw_hw_is_supported();
+	aesw->use_hw = aesw->hw_supported;
+#endif /* HAVE_AESW_HW */
+
+	// Expand the default (all-zero) key.
+	aesw_expand_key(aesw);
+
 	// AES context has been initialized.
 	return aesw;
 }
@@ -73,7 +169,11 @@ int aesw_set_key(AesCtx *aesw, const uint8_t *pKey, size_t size)
 		return -EINVAL;
 	}
 
-	memcpy(aesw->key, pKey, size);
+	if (memcmp(aesw->key, pKey, size) != 0) {
+		// Key has changed. Expand the new key schedules.
+		memcpy(aesw->key, pKey, size);
+		aesw_expand_key(aesw);
+	}
 	return 0;
 }
 
@@ -109,17 +209,7 @@ size_t aesw_encrypt(AesCtx *aesw, uint8_t *pData, size_t size)
 		return 0;
 	}
 
-	// TODO: Only set encrypt key if switching modes?
-#ifdef HAVE_NETTLE_3
-	aes128_set_encrypt_key(&aesw->ctx, aesw->key);
-	cbc_encrypt(&aesw->ctx, (nettle_cipher_func*)aes128_encrypt,
-		AES_BLOCK_SIZE, aesw->iv, size, pData, pData);
-#else /* !HAVE_NETTLE_3 */
-	aes_set_encrypt_key(&aesw->ctx, sizeof(aesw->key), aesw->key);
-	cbc_encrypt(&aesw->ctx, (nettle_crypt_func*)aes_encrypt,
-		AES_BLOCK_SIZE, aesw->iv, size, pData, pData);
-#endif /* HAVE_NETTLE_3 */
-
+	aesw_cbc_encrypt(aesw, aesw->iv, pData, size);
 	return size;
 }
 
@@ -138,16 +228,152 @@ size_t aesw_decrypt(AesCtx *aesw, uint8_t *pData, size_t size)
 		return 0;
 	}
 
-	// TODO: Only set decrypt key if switching modes?
-#ifdef HAVE_NETTLE_3
-	aes128_set_decrypt_key(&aesw->ctx, aesw->key);
-	cbc_decrypt(&aesw->ctx, (nettle_cipher_func*)aes128_decrypt,
-		AES_BLOCK_SIZE, aesw->iv, size, pData, pData);
-#else /* !HAVE_NETTLE_3 */
-	aes_set_decrypt_key(&aesw->ctx, sizeof(aesw->key), aesw->key);
-	cbc_decrypt(&aesw->ctx, (nettle_crypt_func*)aes_decrypt,
-		AES_BLOCK_SIZE, aesw->iv, size, pData, pData);
-#endif /* HAVE_NETTLE_3 */
-
+	aesw_cbc_decrypt(aesw, aesw->iv, pData, size);
 	return size;
 }
+
+/**
+ * Validate a batch of AES blocks.
+ * @param entries	[in] Batch entries.
+ * @param count		[in] Number of entries.
+ * @return True if valid; false if not.
+ */
+static bool aesw_batch_is_valid(const AesBatchEntry *entries, size_t count)
+{
+	size_t i;
+	for (i = 0; i < count; i++) {
+		if (!entries[i].iv || !entries[i].data || (entries[i].size % 16 != 0))
+			return false;
+	}
+	return true;
+}
+
+#ifdef HAVE_AESW_HW
+/**
+ * Can a set of batch entries be encrypted in lockstep?
+ * All entries must be the same size, and no entry's IV or
+ * data may overlap another entry's data.
+ * @param entries	[in] Batch entries.
+ * @param count		[in] Number of entries.
+ * @return True if the entries can be interleaved; false if not.
+ */
+static bool aesw_batch_can_interleave(const AesBatchEntry *entries, size_t count)
+{
+	size_t i, j;
+	for (i = 0; i < count; i++) {
+		if (entries[i].size != entries[0].size)
+			return false;
+		for (j = 0; j < count; j++) {
+			const uint8_t *const data = entries[j].data;
+			const uint8_t *const data_end = data + entries[j].size;
+			if (i == j)
+				continue;
+			if (entries[i].iv + 16 > data && entries[i].iv < data_end)
+				return false;
+			if (entries[i].data + entries[i].size > data && entries[i].data < data_end)
+				return false;
+		}
+	}
+	return true;
+}
+#endif /* HAVE_AESW_HW */
+
+/**
+ * Encrypt a batch of data blocks, each with its own IV.
+ *
+ * Entries are processed in order, and each entry's IV is read
+ * immediately before that entry is encrypted, so an IV may point
+ * into data that was encrypted by an earlier entry.
+ *
+ * The IV set with aesw_set_iv() is neither used nor modified.
+ *
+ * @param aesw		[in] AES context.
+ * @param entries	[in] Batch entries.
+ * @param count		[in] Number of entries.
+ * @return Number of entries encrypted on success; 0 on error.
+ */
+size_t aesw_encrypt_batch(AesCtx *aesw, const AesBatchEntry *entries, size_t count)
+{
+	size_t i;
+	uint8_t iv[16];
+
+	if (!aesw || !entries || !aesw_batch_is_valid(entries, count)) {
+		// Invalid parameters.
+		errno = EINVAL;
+		return 0;
+	}
+
+	for (i = 0; i < count; ) {
+#ifdef HAVE_AESW_HW
+		if (aesw->use_hw && count - i >= AESW_HW_LANES &&
+		    aesw_batch_can_interleave(&entries[i], AESW_HW_LANES))
+		{
+			// Encrypt multiple entries at once.
+			aesw_hw_cbc_encrypt_multi(&aesw->hw, &entries[i]);
+			i += AESW_HW_LANES;
+			continue;
+		}
+#endif /* HAVE_AESW_HW */
+
+		memcpy(iv, entries[i].iv, sizeof(iv));
+		aesw_cbc_encrypt(aesw, iv, entries[i].data, entries[i].size);
+		i++;
+	}
+	return count;
+}
+
+/**
+ * Decrypt a batch of data blocks, each with its own IV.
+ *
+ * Entries are processed in order, and each entry's IV is read
+ * immediately before that entry is decrypted, so an IV may point
+ * into ciphertext that will be decrypted by a later entry.
+ *
+ * The IV set with aesw_set_iv() is neither used nor modified.
+ *
+ * @param aesw		[in] AES context.
+ * @param entries	[in] Batch entries.
+ * @param count		[in] Number of entries.
+ * @return Number of entries decrypted on success; 0 on error.
+ */
+size_t aesw_decrypt_batch(AesCtx *aesw, const AesBatchEntry *entries, size_t count)
+{
+	size_t i;
+	uint8_t iv[16];
+
+	if (!aesw || !entries || !aesw_batch_is_valid(entries, count)) {
+		// Invalid parameters.
+		errno = EINVAL;
+		return 0;
+	}
+
+	for (i = 0; i < count; i++) {
+		memcpy(iv, entries[i].iv, sizeof(iv));
+		aesw_cbc_decrypt(aesw, iv, entries[i].data, entries[i].size);
+	}
+	return count;
+}
+
+/**
+ * Enable or disable hardware acceleration for an AES context.
+ * Hardware acceleration is enabled by default if the CPU supports it.
+ * @param aesw		[in] AES context.
+ * @param enable	[in] Non-zero to enable; zero to disable.
+ * @return 0 on success; negative POSIX error code on error. (-ENOTSUP if not available)
+ */
+int aesw_set_hw_accel(AesCtx *aesw, int enable)
+{
+	if (!aesw) {
+		return -EINVAL;
+	}
+
+#ifdef HAVE_AESW_HW
+	if (enable && !aesw->hw_supported) {
+		return -ENOTSUP;
+	}
+	aesw->use_hw = !!enable;
+	return 0;
+#else /* !HAVE_AESW_HW */
+	return (enable ? -ENOTSUP : 0);
+#endif /* HAVE_AESW_HW */
+}
@@ -0,0 +1,81 @@
+/***************************************************************************
+ * RVT-H Tool (libwiicrypto)                                               *
+ * atomic_once.h: One-time initialization and relaxed atomic integers.     *
+ *                                                                         *
+ * Copyright (c) 2026 by David Korth.                                      *
+ * SPDX-License-Identifier: GPL-2.0-or-later                               *
+ ***************************************************************************/
+
+#pragma once
+
+#ifdef _WIN32
+#  include <windows.h>
+#else /* !_WIN32 */
+#  include <pthread.h>
+#endif /* _WIN32 */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** One-time initialization **/
+
+#ifdef _WIN32
+// InitOnceExecuteOnce() requires Windows Vista, so use a
+// once-flag built on the Interlocked functions, which are
+// full memory barriers.
+// States: 0 == not started; 1 == running; 2 == done
+typedef volatile LONG wii_once_t;
+#  define WII_ONCE_INIT 0
+
+/**
+ * Run an initialization function exactly once.
+ * Other callers wait until the function has returned,
+ * and see everything it wrote.
+ * @param once		[in,out] Once-flag (initialize to WII_ONCE_INIT)
+ * @param init_fn	[in] Initialization function
+ */
+static inline void wii_once(wii_once_t *once, void (*init_fn)(void))
+{
+	if (InterlockedCompareExchange(once, 2, 2) == 2) {
+		// Already initialized.
+		return;
+	}
+
+	if (InterlockedCompareExchange(once, 1, 0) == 0) {
+		init_fn();
+		InterlockedExchange(once, 2);
+		return;
+	}
+
+	// Another thread is running the initialization function.
+	while (InterlockedCompareExchange(once, 2, 2) != 2) {
+		Sleep(0);
+	}
+}
+#else /* !_WIN32 */
+typedef pthread_once_t wii_once_t;
+#  define WII_ONCE_INIT PTHREAD_ONCE_INIT
+#  define wii_once(once, init_fn) pthread_once((once), (init_fn))
+#endif /* _WIN32 */
+
+/** Relaxed atomic integers **/
+
+// These only guarantee that a load sees a whole value written by
+// a store. They don't order any other memory accesses, so they're
+// only suitable for values that don't publish other data.
+#if defined(__GNUC__) || defined(__clang__)
+#  define wii_atomic_load_relaxed(p)		__atomic_load_n((p), __ATOMIC_RELAXED)
+#  define wii_atomic_store_relaxed(p, v)	__atomic_store_n((p), (v), __ATOMIC_RELAXED)
+#elif defined(_MSC_VER)
+// MSVC: Aligned volatile 32-bit accesses are single-copy atomic
+// on all supported architectures.
+#  define wii_atomic_load_relaxed(p)		(*(volatile const int*)(p))
+#  define wii_atomic_store_relaxed(p, v)	(*(volatile int*)(p) = (v))
+#else
+#  error Relaxed atomics are not implemented for this compiler.
+#endif
+
+#ifdef __cplusplus
+}
+#endif
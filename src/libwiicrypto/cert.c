@@ -2,7 +2,7 @@
  * RVT-H Tool (libwiicrypto)                                               *
  * cert.c: Certificate management.                                         *
  *                                                                         *
- * Copyright (c) 2018-2025 by David Korth.                                 *
+ * Copyright (c) 2018-2026 by David Korth.                                 *
  * SPDX-License-Identifier: GPL-2.0-or-later                               *
  ***************************************************************************/
 
@@ -15,9 +15,20 @@
 
 #include <assert.h>
 #include <errno.h>
+#include <stdint.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 
+// Threads for fakesigning
+#ifdef _WIN32
+#  include <windows.h>
+#  include <process.h>
+#else /* !_WIN32 */
+#  include <pthread.h>
+#  include <unistd.h>
+#endif /* _WIN32 */
+
 // RSA and hash functions
 #include "rsaw.h"
 #include <nettle/sha1.h>
@@ -397,6 +408,276 @@ int cert_verify(const uint8_t *data, size_t size)
 	return ret;
 }
 
+/** Fakesigning **/
+
+// Fakesigning brute-forces a 32-bit word in the ticket or TMD until
+// the first byte of the SHA-1 hash is 0. Only the bytes starting at
+// the 64-byte block containing that word change between tries, so
+// the SHA-1 state for the blocks before it is calculated once, and
+// each try only hashes the rest of the data.
+
+// Minimum size of the changing part of the data for automatic
+// multithreading. Tickets and disc partition TMDs are smaller
+// than this, so starting threads would take longer than hashing.
+#define FAKESIGN_MT_MIN_TAIL_SIZE (16U*1024U)
+
+// Maximum number of threads for fakesigning.
+#define FAKESIGN_MAX_THREADS 64U
+
+// Number of tries between checks for a result from another thread.
+#define FAKESIGN_CHECK_INTERVAL 64U
+
+#ifdef _WIN32
+typedef CRITICAL_SECTION fakesign_mutex_t;
+#  define fakesign_mutex_init(m)	InitializeCriticalSection(m)
+#  define fakesign_mutex_destroy(m)	DeleteCriticalSection(m)
+#  define fakesign_mutex_lock(m)	EnterCriticalSection(m)
+#  define fakesign_mutex_unlock(m)	LeaveCriticalSection(m)
+#else /* !_WIN32 */
+typedef pthread_mutex_t fakesign_mutex_t;
+#  define fakesign_mutex_init(m)	pthread_mutex_init((m), NULL)
+#  define fakesign_mutex_destroy(m)	pthread_mutex_destroy(m)
+#  define fakesign_mutex_lock(m)	pthread_mutex_lock(m)
+#  define fakesign_mutex_unlock(m)	pthread_mutex_unlock(m)
+#endif /* _WIN32 */
+
+/**
+ * Fakesigning search state.
+ */
+typedef struct _fakesign_search_t {
+	// Input (read-only; shared between threads)
+	const struct sha1_ctx *midstate;	// SHA-1 state after the unchanging blocks
+	const uint8_t *tail;			// Remaining data
+	size_t tail_size;			// Size of the remaining data
+	size_t fake_pos;			// Offset of the fake word in `tail`
+
+	// Nonces to try: start, start+step, start+2*step, ...
+	uint32_t start;
+	uint32_t step;
+
+	// Result (shared between threads; protected by mutex)
+	fakesign_mutex_t *mutex;
+	uint32_t *pBest;			// Lowest nonce found
+	bool *pFound;				// True if a nonce was found
+} fakesign_search_t;
+
+/**
+ * Search for a fakesigning nonce.
+ *
+ * If a nonce is found, and it's lower than the current result,
+ * the result is updated. The search stops once all of this
+ * search's nonces are higher than the current result.
+ *
+ * @param search Search state.
+ * @return 0 on success; negative POSIX error code on error.
+ */
+static int cert_fakesign_search(fakesign_search_t *search)
+{
+	struct sha1_ctx sha1;
+	uint8_t digest[SHA1_DIGEST_SIZE];
+	uint32_t nonce = search->start;
+	uint32_t best = UINT32_MAX;
+	bool found = false;
+	unsigned int check = 0;
+
+	// The fake word is changed in a local copy of the data,
+	// since other threads are using the original data.
+	uint8_t *const tail = malloc(search->tail_size);
+	if (!tail) {
+		errno = ENOMEM;
+		return -ENOMEM;
+	}
+	memcpy(tail, search->tail, search->tail_size);
+
+	for (;;) {
+		if (++check == FAKESIGN_CHECK_INTERVAL) {
+			// Check if another thread found a lower nonce.
+			check = 0;
+			fakesign_mutex_lock(search->mutex);
+			found = *search->pFound;
+			best = *search->pBest;
+			fakesign_mutex_unlock(search->mutex);
+		}
+		if (found && nonce > best) {
+			// A lower nonce was already found.
+			break;
+		}
+
+		// Calculate the SHA-1 of the remaining data.
+		// If the first byte is 0, we're done.
+		memcpy(&tail[search->fake_pos], &nonce, sizeof(nonce));
+		sha1 = *search->midstate;
+		sha1_update(&sha1, search->tail_size, tail);
+		sha1_digest(&sha1, sizeof(digest), digest);
+		if (digest[0] == 0) {
+			// Found a nonce.
+			fakesign_mutex_lock(search->mutex);
+			if (!*search->pFound || nonce < *search->pBest) {
+				*search->pBest = nonce;
+				*search->pFound = true;
+			}
+			fakesign_mutex_unlock(search->mutex);
+			break;
+		}
+
+		if (nonce > UINT32_MAX - search->step) {
+			// No more nonces.
+			break;
+		}
+		nonce += search->step;
+	}
+
+	free(tail);
+	return 0;
+}
+
+#ifdef _WIN32
+static unsigned int __stdcall cert_fakesign_thread(void *param)
+{
+	return (unsigned int)cert_fakesign_search((fakesign_search_t*)param);
+}
+#else /* !_WIN32 */
+static void *cert_fakesign_thread(void *param)
+{
+	return (void*)(intptr_t)cert_fakesign_search((fakesign_search_t*)param);
+}
+#endif /* _WIN32 */
+
+/**
+ * Get the number of CPUs for automatic multithreading.
+ * @return Number of CPUs.
+ */
+static unsigned int cert_fakesign_cpu_count(void)
+{
+#ifdef _WIN32
+	SYSTEM_INFO sysinfo;
+	GetSystemInfo(&sysinfo);
+	return (sysinfo.dwNumberOfProcessors > 0 ? (unsigned int)sysinfo.dwNumberOfProcessors : 1);
+#elif defined(_SC_NPROCESSORS_ONLN)
+	const long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+	return (cpus > 0 ? (unsigned int)cpus : 1);
+#else
+	return 1;
+#endif
+}
+
+/**
+ * Fakesign a ticket or TMD. (internal function)
+ *
+ * The hash covers everything from the issuer to the end of the data.
+ * The signature must be zeroed before calling this function.
+ *
+ * @param data		[in/out] Ticket or TMD to fakesign.
+ * @param size		[in] Size of ticket or TMD.
+ * @param fake_offset	[in] Offset of the 32-bit word to brute-force.
+ * @param threads	[in] Number of threads (0 for auto; 1 to disable threading)
+ * @return 0 on success; negative POSIX error code on error.
+ */
+static int cert_fakesign_int(uint8_t *data, size_t size, size_t fake_offset, unsigned int threads)
+{
+	static const size_t signing_offset = offsetof(RVL_Sig_RSA2048, issuer);
+	struct sha1_ctx midstate;
+	fakesign_search_t searches[FAKESIGN_MAX_THREADS];
+	fakesign_mutex_t mutex;
+	uint32_t best = 0;
+	bool found = false;
+	size_t prefix_size;
+	unsigned int i;
+	int ret = 0;
+
+	assert(fake_offset >= signing_offset);
+	assert(fake_offset + sizeof(uint32_t) <= size);
+
+	// Hash the complete SHA-1 blocks before the fake word.
+	prefix_size = (fake_offset - signing_offset) & ~(size_t)(SHA1_DATA_SIZE - 1);
+	sha1_init(&midstate);
+	sha1_update(&midstate, prefix_size, &data[signing_offset]);
+
+	if (threads == 0) {
+		// Only use multiple threads if the data is large enough.
+		threads = (size - signing_offset - prefix_size >= FAKESIGN_MT_MIN_TAIL_SIZE)
+			? cert_fakesign_cpu_count() : 1;
+	}
+	if (threads > FAKESIGN_MAX_THREADS) {
+		threads = FAKESIGN_MAX_THREADS;
+	}
+
+	fakesign_mutex_init(&mutex);
+	for (i = 0; i < threads; i++) {
+		fakesign_search_t *const search = &searches[i];
+		search->midstate = &midstate;
+		search->tail = &data[signing_offset + prefix_size];
+		search->tail_size = size - signing_offset - prefix_size;
+		search->fake_pos = fake_offset - signing_offset - prefix_size;
+		search->start = i;
+		search->step = threads;
+		search->mutex = &mutex;
+		search->pBest = &best;
+		search->pFound = &found;
+	}
+
+	if (threads == 1) {
+		ret = cert_fakesign_search(&searches[0]);
+	} else {
+		// Split the nonces between the threads.
+		// Each thread tries every Nth nonce.
+		// NOTE: If a thread can't be started, the calling
+		// thread does its search after the others finish.
+#ifdef _WIN32
+		HANDLE hThreads[FAKESIGN_MAX_THREADS];
+#else /* !_WIN32 */
+		pthread_t tids[FAKESIGN_MAX_THREADS];
+#endif /* _WIN32 */
+		bool started[FAKESIGN_MAX_THREADS];
+
+		for (i = 0; i < threads; i++) {
+#ifdef _WIN32
+			hThreads[i] = (HANDLE)_beginthreadex(NULL, 0, cert_fakesign_thread, &searches[i], 0, NULL);
+			started[i] = (hThreads[i] != NULL);
+#else /* !_WIN32 */
+			started[i] = (pthread_create(&tids[i], NULL, cert_fakesign_thread, &searches[i]) == 0);
+#endif /* _WIN32 */
+		}
+
+		for (i = 0; i < threads; i++) {
+			int tret;
+			if (started[i]) {
+#ifdef _WIN32
+				DWORD dwExitCode = 0;
+				WaitForSingleObject(hThreads[i], INFINITE);
+				GetExitCodeThread(hThreads[i], &dwExitCode);
+				CloseHandle(hThreads[i]);
+				tret = (int)dwExitCode;
+#else /* !_WIN32 */
+				void *retval = NULL;
+				pthread_join(tids[i], &retval);
+				tret = (int)(intptr_t)retval;
+#endif /* _WIN32 */
+			} else {
+				tret = cert_fakesign_search(&searches[i]);
+			}
+			if (tret != 0 && ret == 0) {
+				ret = tret;
+			}
+		}
+	}
+	fakesign_mutex_destroy(&mutex);
+
+	if (ret != 0) {
+		errno = -ret;
+		return ret;
+	}
+
+	// The lowest nonce is used, so the result doesn't depend
+	// on the number of threads.
+	// TODO: If no nonce was found, failed.
+	if (!found) {
+		best = 0;
+	}
+	memcpy(&data[fake_offset], &best, sizeof(best));
+	return 0;
+}
+
 /**
  * Fakesign a ticket.
  *
@@ -409,12 +690,32 @@ int cert_verify(const uint8_t *data, size_t size)
  */
 int cert_fakesign_ticket(uint8_t *ticket_u8, size_t size)
 {
-	struct sha1_ctx sha1;
-	uint8_t digest[SHA1_DIGEST_SIZE];
-	uint32_t *fake;
+	return cert_fakesign_ticket_mt(ticket_u8, size, 1);
+}
+
+/**
+ * Fakesign a ticket.
+ *
+ * NOTE: If changing the encryption type, the issuer and title key
+ * must be updated *before* calling this function.
+ *
+ * @param ticket_u8	[in/out] Ticket to fakesign.
+ * @param size		[in] Size of ticket.
+ * @param threads	[in] Number of threads (0 for auto; 1 to disable threading)
+ * @return 0 on success; negative POSIX error code on error.
+ */
+int cert_fakesign_ticket_mt(uint8_t *ticket_u8, size_t size, unsigned int threads)
+{
 	RVL_Ticket *const ticket = (RVL_Ticket*)ticket_u8;
 
-	if (!ticket) {
+	// Using 0x25C for brute-forcing the SHA-1 hash.
+	// This area is part of the content access permissions.
+	// Disc partitions only have one content, so the rest is unused.
+	// (Wiimm's ISO Tools uses 0x24C.)
+	// NOTE: Brute-forcing is done using HOST-endian.
+	static const size_t fake_offset = offsetof(RVL_Ticket, content_access_perm) + 0x3A;
+
+	if (!ticket || size < fake_offset + sizeof(uint32_t)) {
 		errno = EINVAL;
 		return -EINVAL;
 	}
@@ -429,24 +730,7 @@ int cert_fakesign_ticket(uint8_t *ticket_u8, size_t size)
 	memset(ticket->signature, 0, sizeof(ticket->signature));
 	memset(ticket->padding_sig, 0, sizeof(ticket->padding_sig));
 
-	// Using 0x25C for brute-forcing the SHA-1 hash.
-	// This area is part of the content access permissions.
-	// Disc partitions only have one content, so the rest is unused.
-	// (Wiimm's ISO Tools uses 0x24C.)
-	// NOTE: Brute-forcing is done using HOST-endian.
-	fake = (uint32_t*)&ticket->content_access_perm[0x3A];
-	*fake = 0;
-	sha1_init(&sha1);
-	do {
-		// Calculate the SHA-1 of the ticket.
-		// If the first byte is 0, we're done.
-		static const size_t signing_offset = offsetof(RVL_Ticket, issuer);
-		sha1_update(&sha1, size - signing_offset, (const uint8_t*)(&ticket_u8[signing_offset]));
-		sha1_digest(&sha1, sizeof(digest), digest);
-	} while (digest[0] != 0 && ++(*fake) != 0);
-
-	// TODO: If the first byte of the hash is not 0, failed.
-	return 0;
+	return cert_fakesign_int(ticket_u8, size, fake_offset, threads);
 }
 
 /**
@@ -461,10 +745,29 @@ int cert_fakesign_ticket(uint8_t *ticket_u8, size_t size)
  */
 int cert_fakesign_tmd(uint8_t *tmd, size_t size)
 {
-	struct sha1_ctx sha1;
-	uint8_t digest[SHA1_DIGEST_SIZE];
+	return cert_fakesign_tmd_mt(tmd, size, 1);
+}
+
+/**
+ * Fakesign a TMD.
+ *
+ * NOTE: If changing the encryption type, the issuer must be
+ * updated *before* calling this function.
+ *
+ * @param tmd		[in/out] TMD to fakesign.
+ * @param size		[in] Size of TMD.
+ * @param threads	[in] Number of threads (0 for auto; 1 to disable threading)
+ * @return 0 on success; negative POSIX error code on error.
+ */
+int cert_fakesign_tmd_mt(uint8_t *tmd, size_t size, unsigned int threads)
+{
 	RVL_TMD_Header *const tmdHeader = (RVL_TMD_Header*)tmd;
-	uint32_t *fake;
+
+	// Using 0x19C for brute-forcing the SHA-1 hash.
+	// This area is "reserved" and is otherwise unused.
+	// (Wiimm's ISO Tools uses 0x19A.)
+	// NOTE: Brute-forcing is done using HOST-endian.
+	static const size_t fake_offset = offsetof(RVL_TMD_Header, reserved) + 2;
 
 	if (!tmd || size < sizeof(RVL_TMD_Header)) {
 		errno = EINVAL;
@@ -481,23 +784,7 @@ int cert_fakesign_tmd(uint8_t *tmd, size_t size)
 	memset(tmdHeader->signature, 0, sizeof(tmdHeader->signature));
 	memset(tmdHeader->padding_sig, 0, sizeof(tmdHeader->padding_sig));
 
-	// Using 0x19C for brute-forcing the SHA-1 hash.
-	// This area is "reserved" and is otherwise unused.
-	// (Wiimm's ISO Tools uses 0x19A.)
-	// NOTE: Brute-forcing is done using HOST-endian.
-	fake = (uint32_t*)&tmdHeader->reserved[2];
-	*fake = 0;
-	sha1_init(&sha1);
-	do {
-		// Calculate the SHA-1 of the TMD.
-		// If the first byte is 0, we're done.
-		sha1_update(&sha1, size - offsetof(RVL_TMD_Header, issuer),
-			&tmd[offsetof(RVL_TMD_Header, issuer)]);
-		sha1_digest(&sha1, sizeof(digest), digest);
-	} while (digest[0] != 0 && ++(*fake) != 0);
-
-	// TODO: If the first byte of the hash is not 0, failed.
-	return 0;
+	return cert_fakesign_int(tmd, size, fake_offset, threads);
 }
 
 /**
@@ -2,7 +2,7 @@
  * RVT-H Tool (libwiicrypto)                                               *
  * cert.h: Certificate management.                                         *
  *                                                                         *
- * Copyright (c) 2018-2025 by David Korth.                                 *
+ * Copyright (c) 2018-2026 by David Korth.                                 *
  * SPDX-License-Identifier: GPL-2.0-or-later                               *
  ***************************************************************************/
 
@@ -94,6 +94,19 @@ int cert_verify(const uint8_t *data, size_t size);
  */
 int cert_fakesign_ticket(uint8_t *ticket_u8, size_t size);
 
+/**
+ * Fakesign a ticket.
+ *
+ * NOTE: If changing the encryption type, the issuer and title key
+ * must be updated *before* calling this function.
+ *
+ * @param ticket_u8	[in/out] Ticket to fakesign.
+ * @param size		[in] Size of ticket.
+ * @param threads	[in] Number of threads (0 for auto; 1 to disable threading)
+ * @return 0 on success; negative POSIX error code on error.
+ */
+int cert_fakesign_ticket_mt(uint8_t *ticket_u8, size_t size, unsigned int threads);
+
 /**
  * Fakesign a TMD.
  *
@@ -106,6 +119,22 @@ int cert_fakesign_ticket(uint8_t *ticket_u8, size_t size);
  */
 int cert_fakesign_tmd(uint8_t *tmd, size_t size);
 
+/**
+ * Fakesign a TMD.
+ *
+ * With threads == 0, multiple threads are only used if the TMD
+ * has enough content entries to benefit from them.
+ *
+ * NOTE: If changing the encryption type, the issuer must be
+ * updated *before* calling this function.
+ *
+ * @param tmd		[in/out] TMD to fakesign.
+ * @param size		[in] Size of TMD.
+ * @param threads	[in] Number of threads (0 for auto; 1 to disable threading)
+ * @return 0 on success; negative POSIX error code on error.
+ */
+int cert_fakesign_tmd_mt(uint8_t *tmd, size_t size, unsigned int threads);
+
 /**
  * Sign a ticket or TMD with real encryption keys.
  *
@@ -0,0 +1,105 @@
+/***************************************************************************
+ * RVT-H Tool (libwiicrypto)                                               *
+ * cpuflags_x86.c: x86 CPU feature detection.                              *
+ *                                                                         *
+ * Copyright (c) 2026 by David Korth.                                      *
+ * SPDX-License-Identifier: GPL-2.0-or-later                               *
+ ***************************************************************************/
+
+#include "cpuflags_x86.h"
+#include "atomic_once.h"
+
+#ifdef _MSC_VER
+#  include <intrin.h>
+#else /* !_MSC_VER */
+#  include <cpuid.h>
+#endif /* _MSC_VER */
+
+// Cached CPU flags.
+static uint32_t cpu_flags = 0;
+static wii_once_t cpu_flags_once = WII_ONCE_INIT;
+
+/**
+ * Run CPUID.
+ * @param leaf		[in] Leaf
+ * @param subleaf	[in] Subleaf
+ * @param regs		[out] EAX, EBX, ECX, EDX
+ */
+static void do_cpuid(unsigned int leaf, unsigned int subleaf, unsigned int regs[4])
+{
+#ifdef _MSC_VER
+	__cpuidex((int*)regs, (int)leaf, (int)subleaf);
+#else /* !_MSC_VER */
+	__cpuid_count(leaf, subleaf, regs[0], regs[1], regs[2], regs[3]);
+#endif /* _MSC_VER */
+}
+
+/**
+ * Read the XCR0 register.
+ * NOTE: Only call this if CPUID reports OSXSAVE.
+ * @return XCR0 (low 32 bits)
+ */
+static uint32_t read_xcr0(void)
+{
+#ifdef _MSC_VER
+	return (uint32_t)_xgetbv(0);
+#else /* !_MSC_VER */
+	uint32_t eax, edx;
+	__asm__ __volatile__ ("xgetbv" : "=a" (eax), "=d" (edx) : "c" (0));
+	return eax;
+#endif /* _MSC_VER */
+}
+
+/**
+ * Detect the x86 CPU feature flags.
+ * Called once by cpuflags_x86().
+ */
+static void cpuflags_x86_detect(void)
+{
+	unsigned int regs[4];
+	unsigned int max_leaf;
+	uint32_t flags = 0;
+
+	do_cpuid(0, 0, regs);
+	max_leaf = regs[0];
+	if (max_leaf >= 1) {
+		do_cpuid(1, 0, regs);
+		if (regs[3] & (1U << 26))
+			flags |= CPUFLAG_X86_SSE2;
+		if (regs[2] & (1U << 9))
+			flags |= CPUFLAG_X86_SSSE3;
+		if (regs[2] & (1U << 19))
+			flags |= CPUFLAG_X86_SSE41;
+		if (regs[2] & (1U << 25))
+			flags |= CPUFLAG_X86_AESNI;
+
+		// AVX2 requires OS support for saving the YMM registers.
+		if ((regs[2] & (1U << 27)) && (regs[2] & (1U << 28)) &&	// OSXSAVE, AVX
+		    (read_xcr0() & 6) == 6 &&				// XMM and YMM state
+		    max_leaf >= 7)
+		{
+			unsigned int regs7[4];
+			do_cpuid(7, 0, regs7);
+			if (regs7[1] & (1U << 5))
+				flags |= CPUFLAG_X86_AVX2;
+		}
+	}
+	if (max_leaf >= 7) {
+		do_cpuid(7, 0, regs);
+		if (regs[1] & (1U << 29))
+			flags |= CPUFLAG_X86_SHA;
+	}
+
+	cpu_flags = flags;
+}
+
+/**
+ * Get the x86 CPU feature flags.
+ * The flags are detected on the first call and cached.
+ * @return CPU feature flags. (See CPUFLAG_X86_*)
+ */
+uint32_t cpuflags_x86(void)
+{
+	wii_once(&cpu_flags_once, cpuflags_x86_detect);
+	return cpu_flags;
+}
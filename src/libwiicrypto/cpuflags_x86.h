@@ -0,0 +1,45 @@
+/***************************************************************************
+ * RVT-H Tool (libwiicrypto)                                               *
+ * cpuflags_x86.h: x86 CPU feature detection.                              *
+ *                                                                         *
+ * Copyright (c) 2026 by David Korth.                                      *
+ * SPDX-License-Identifier: GPL-2.0-or-later                               *
+ ***************************************************************************/
+
+#pragma once
+
+#include <stdint.h>
+#include "stdboolx.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// x86 CPU feature flags.
+#define CPUFLAG_X86_SSE2	(1U << 0)
+#define CPUFLAG_X86_SSSE3	(1U << 1)
+#define CPUFLAG_X86_SSE41	(1U << 2)
+#define CPUFLAG_X86_AVX2	(1U << 3)	// includes OS support for YMM registers
+#define CPUFLAG_X86_AESNI	(1U << 4)
+#define CPUFLAG_X86_SHA		(1U << 5)
+
+/**
+ * Get the x86 CPU feature flags.
+ * The flags are detected on the first call and cached.
+ * @return CPU feature flags. (See CPUFLAG_X86_*)
+ */
+uint32_t cpuflags_x86(void);
+
+/**
+ * Check if the CPU supports all of the specified features.
+ * @param flags CPU feature flags. (See CPUFLAG_X86_*)
+ * @return True if all features are supported; false if not.
+ */
+static inline bool cpuflags_x86_has(uint32_t flags)
+{
+	return (cpuflags_x86() & flags) == flags;
+}
+
+#ifdef __cplusplus
+}
+#endif
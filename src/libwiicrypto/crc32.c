@@ -0,0 +1,93 @@
+/***************************************************************************
+ * RVT-H Tool (libwiicrypto)                                               *
+ * crc32.c: CRC-32 checksum function.                                      *
+ *                                                                         *
+ * Copyright (c) 2026 by David Korth.                                      *
+ * SPDX-License-Identifier: GPL-2.0-or-later                               *
+ ***************************************************************************/
+
+#include "crc32.h"
+#include "byteswap.h"
+#include "atomic_once.h"
+
+#include <string.h>
+
+// Reflected CRC-32 polynomial.
+#define CRC32_POLY 0xEDB88320U
+
+// Slicing-by-8 lookup tables.
+// Table 0 is the standard byte-at-a-time table. Table n is the CRC
+// of a byte followed by n zero bytes, so 8 bytes can be processed
+// with 8 independent lookups.
+static uint32_t crc32_tbl[8][256];
+static wii_once_t crc32_tbl_once = WII_ONCE_INIT;
+
+/**
+ * Initialize the lookup tables.
+ */
+static void crc32_init_tables(void)
+{
+	unsigned int i, n;
+
+	for (i = 0; i < 256; i++) {
+		uint32_t crc = i;
+		for (n = 0; n < 8; n++) {
+			crc = (crc >> 1) ^ ((crc & 1) ? CRC32_POLY : 0);
+		}
+		crc32_tbl[0][i] = crc;
+	}
+	for (i = 0; i < 256; i++) {
+		uint32_t crc = crc32_tbl[0][i];
+		for (n = 1; n < 8; n++) {
+			crc = (crc >> 8) ^ crc32_tbl[0][crc & 0xFF];
+			crc32_tbl[n][i] = crc;
+		}
+	}
+}
+
+/**
+ * Update a CRC-32 checksum.
+ *
+ * The initial value is 0. The return value can be passed
+ * back in to continue the checksum with more data.
+ *
+ * @param crc	[in] Previous CRC-32. (0 for the first call)
+ * @param pData	[in] Data.
+ * @param size	[in] Size of the data, in bytes.
+ * @return Updated CRC-32.
+ */
+uint32_t crc32_update(uint32_t crc, const uint8_t *pData, size_t size)
+{
+	wii_once(&crc32_tbl_once, crc32_init_tables);
+
+	crc = ~crc;
+
+	// Process single bytes until the data is 4-byte aligned.
+	for (; size > 0 && ((uintptr_t)pData & 3) != 0; size--, pData++) {
+		crc = (crc >> 8) ^ crc32_tbl[0][(crc ^ *pData) & 0xFF];
+	}
+
+	// Process 8 bytes at a time.
+	for (; size >= 8; size -= 8, pData += 8) {
+		uint32_t lo, hi;
+		memcpy(&lo, pData, sizeof(lo));
+		memcpy(&hi, pData + 4, sizeof(hi));
+		lo = le32_to_cpu(lo) ^ crc;
+		hi = le32_to_cpu(hi);
+		crc = crc32_tbl[7][ lo        & 0xFF] ^
+		      crc32_tbl[6][(lo >>  8) & 0xFF] ^
+		      crc32_tbl[5][(lo >> 16) & 0xFF] ^
+		      crc32_tbl[4][ lo >> 24        ] ^
+		      crc32_tbl[3][ hi        & 0xFF] ^
+		      crc32_tbl[2][(hi >>  8) & 0xFF] ^
+		      crc32_tbl[1][(hi >> 16) & 0xFF] ^
+		      crc32_tbl[0][ hi >> 24        ];
+	}
+
+	// Process the remaining bytes.
+	for (; size > 0; size--, pData++) {
+		crc = (crc >> 8) ^ crc32_tbl[0][(crc ^ *pData) & 0xFF];
+	}
+
+	return ~crc;
+}
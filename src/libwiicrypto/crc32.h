@@ -0,0 +1,37 @@
+/***************************************************************************
+ * RVT-H Tool (libwiicrypto)                                               *
+ * crc32.h: CRC-32 checksum function.                                      *
+ *                                                                         *
+ * Copyright (c) 2026 by David Korth.                                      *
+ * SPDX-License-Identifier: GPL-2.0-or-later                               *
+ ***************************************************************************/
+
+// Disc image catalogs (e.g. Redump) list the CRC-32 of each image
+// along with its MD5 and SHA-1. This is the same CRC-32 as zlib's
+// crc32(): reflected polynomial 0xEDB88320, inverted in and out.
+
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Update a CRC-32 checksum.
+ *
+ * The initial value is 0. The return value can be passed
+ * back in to continue the checksum with more data.
+ *
+ * @param crc	[in] Previous CRC-32. (0 for the first call)
+ * @param pData	[in] Data.
+ * @param size	[in] Size of the data, in bytes.
+ * @return Updated CRC-32.
+ */
+uint32_t crc32_update(uint32_t crc, const uint8_t *pData, size_t size);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,218 @@
+/***************************************************************************
+ * RVT-H Tool (libwiicrypto)                                               *
+ * sha1w.c: SHA-1 batch hashing functions.                                 *
+ *                                                                         *
+ * Copyright (c) 2026 by David Korth.                                      *
+ * SPDX-License-Identifier: GPL-2.0-or-later                               *
+ ***************************************************************************/
+
+#include "sha1w.h"
+#include "sha1w_x86.h"
+#include "stdboolx.h"
+#include "atomic_once.h"
+
+#ifdef HAVE_SHA1W_X86
+#  include "cpuflags_x86.h"
+#endif /* HAVE_SHA1W_X86 */
+
+#include <errno.h>
+#include <string.h>
+
+// Nettle SHA-1 functions.
+#include <nettle/sha1.h>
+
+// Maximum number of lanes used by the multi-buffer implementations.
+#define SHA1W_MAX_LANES 8
+
+// Selected implementation.
+// SHA1W_Impl, stored as an int for wii_atomic_*_relaxed().
+static int sha1w_impl = SHA1W_IMPL_AUTO;
+
+/**
+ * Is the specified SHA-1 implementation supported on this CPU?
+ * @param impl SHA-1 implementation.
+ * @return True if supported; false if not.
+ */
+static bool sha1w_is_supported(SHA1W_Impl impl)
+{
+	switch (impl) {
+		case SHA1W_IMPL_GENERIC:
+			return true;
+#ifdef HAVE_SHA1W_X86
+		case SHA1W_IMPL_SSE2:
+			return cpuflags_x86_has(CPUFLAG_X86_SSE2);
+		case SHA1W_IMPL_AVX2:
+			return cpuflags_x86_has(CPUFLAG_X86_AVX2);
+		case SHA1W_IMPL_SHANI:
+			return cpuflags_x86_has(CPUFLAG_X86_SHA | CPUFLAG_X86_SSSE3 | CPUFLAG_X86_SSE41);
+#endif /* HAVE_SHA1W_X86 */
+		default:
+			break;
+	}
+	return false;
+}
+
+/**
+ * Select the SHA-1 implementation used by sha1w_hash_blocks().
+ *
+ * This is intended for testing and benchmarking, and must not be
+ * called while another thread is hashing.
+ *
+ * @param impl SHA-1 implementation.
+ * @return 0 on success; -ENOTSUP if the implementation isn't available.
+ */
+int sha1w_set_impl(SHA1W_Impl impl)
+{
+	if (impl == SHA1W_IMPL_AUTO) {
+		wii_atomic_store_relaxed(&sha1w_impl, SHA1W_IMPL_AUTO);
+		return 0;
+	} else if (!sha1w_is_supported(impl)) {
+		return -ENOTSUP;
+	}
+
+	wii_atomic_store_relaxed(&sha1w_impl, (int)impl);
+	return 0;
+}
+
+/**
+ * Get the SHA-1 implementation used by sha1w_hash_blocks().
+ * @return SHA-1 implementation. (never SHA1W_IMPL_AUTO)
+ */
+SHA1W_Impl sha1w_get_impl(void)
+{
+	// Order of preference. SHA-NI is a single-buffer implementation,
+	// but it's still faster than 8-lane AVX2.
+	static const SHA1W_Impl impls[] = {
+		SHA1W_IMPL_SHANI,
+		SHA1W_IMPL_AVX2,
+		SHA1W_IMPL_SSE2,
+	};
+	SHA1W_Impl impl = (SHA1W_Impl)wii_atomic_load_relaxed(&sha1w_impl);
+	unsigned int i;
+
+	if (impl != SHA1W_IMPL_AUTO) {
+		return impl;
+	}
+
+	impl = SHA1W_IMPL_GENERIC;
+	for (i = 0; i < sizeof(impls)/sizeof(impls[0]); i++) {
+		if (sha1w_is_supported(impls[i])) {
+			impl = impls[i];
+			break;
+		}
+	}
+	wii_atomic_store_relaxed(&sha1w_impl, (int)impl);
+	return impl;
+}
+
+/**
+ * Hash a single block using nettle.
+ * @param pDigest	[out] Digest. (20 bytes)
+ * @param pData		[in] Data block.
+ * @param size		[in] Length of the data block, in bytes.
+ */
+static void sha1w_generic(uint8_t *pDigest, const uint8_t *pData, size_t size)
+{
+	struct sha1_ctx sha1;
+	sha1_init(&sha1);
+	sha1_update(&sha1, size, pData);
+	sha1_digest(&sha1, SHA1_DIGEST_SIZE, pDigest);
+}
+
+#ifdef HAVE_SHA1W_X86
+/**
+ * Multi-buffer hash function.
+ * @param pDigests	[out] Digests. (lanes * 20 bytes)
+ * @param pData		[in] Data blocks. (lanes)
+ * @param size		[in] Length of each data block, in bytes.
+ */
+typedef void (*sha1w_mb_fn)(uint8_t *pDigests, const uint8_t *const *pData, size_t size);
+
+/**
+ * Hash blocks using a multi-buffer implementation.
+ *
+ * Full sets of lanes are always hashed. If more than half of the lanes
+ * are needed for the remaining blocks, the unused lanes are filled with
+ * duplicates of the last block and hashed as well.
+ *
+ * @param fn		[in] Multi-buffer hash function.
+ * @param lanes		[in] Number of lanes.
+ * @param pDigests	[out] Digests.
+ * @param pData		[in] First data block.
+ * @param size		[in] Length of each data block, in bytes.
+ * @param stride	[in] Distance between the start of each data block, in bytes.
+ * @param count		[in] Number of data blocks.
+ * @return Number of blocks hashed.
+ */
+static size_t sha1w_hash_mb(sha1w_mb_fn fn, unsigned int lanes,
+	uint8_t *pDigests, const uint8_t *pData, size_t size, size_t stride, size_t count)
+{
+	const uint8_t *ptrs[SHA1W_MAX_LANES];
+	uint8_t digests[SHA1W_MAX_LANES * SHA1_DIGEST_SIZE];
+	size_t done, rem;
+	unsigned int l;
+
+	for (done = 0; count - done >= lanes; done += lanes) {
+		for (l = 0; l < lanes; l++) {
+			ptrs[l] = pData + ((done + l) * stride);
+		}
+		fn(&pDigests[done * SHA1_DIGEST_SIZE], ptrs, size);
+	}
+
+	rem = count - done;
+	if (rem > lanes / 2) {
+		for (l = 0; l < lanes; l++) {
+			ptrs[l] = pData + ((done + (l < rem ? l : rem - 1)) * stride);
+		}
+		fn(digests, ptrs, size);
+		memcpy(&pDigests[done * SHA1_DIGEST_SIZE], digests, rem * SHA1_DIGEST_SIZE);
+		done = count;
+	}
+
+	return done;
+}
+#endif /* HAVE_SHA1W_X86 */
+
+/**
+ * Hash multiple equal-length blocks using SHA-1.
+ *
+ * Block i starts at pData + (i * stride). Digest i is written to
+ * pDigests + (i * 20). The digests must not overlap the data.
+ *
+ * @param pDigests	[out] Digests. (count * 20 bytes)
+ * @param pData		[in] First data block.
+ * @param size		[in] Length of each data block, in bytes.
+ * @param stride	[in] Distance between the start of each data block, in bytes.
+ * @param count		[in] Number of data blocks.
+ */
+void sha1w_hash_blocks(uint8_t *pDigests, const uint8_t *pData, size_t size, size_t stride, size_t count)
+{
+	size_t done = 0;
+
+	switch (sha1w_get_impl()) {
+#ifdef HAVE_SHA1W_X86
+		case SHA1W_IMPL_SHANI:
+			for (; done < count; done++) {
+				sha1w_shani(&pDigests[done * SHA1_DIGEST_SIZE], pData + (done * stride), size);
+			}
+			return;
+
+		case SHA1W_IMPL_AVX2:
+			done = sha1w_hash_mb(sha1w_avx2_x8, 8, pDigests, pData, size, stride, count);
+			// fall-through
+		case SHA1W_IMPL_SSE2:
+			done += sha1w_hash_mb(sha1w_sse2_x4, 4,
+				&pDigests[done * SHA1_DIGEST_SIZE], pData + (done * stride),
+				size, stride, count - done);
+			break;
+#endif /* HAVE_SHA1W_X86 */
+
+		default:
+			break;
+	}
+
+	// Remaining blocks.
+	for (; done < count; done++) {
+		sha1w_generic(&pDigests[done * SHA1_DIGEST_SIZE], pData + (done * stride), size);
+	}
+}
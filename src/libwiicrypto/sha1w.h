@@ -0,0 +1,69 @@
+/***************************************************************************
+ * RVT-H Tool (libwiicrypto)                                               *
+ * sha1w.h: SHA-1 batch hashing functions.                                 *
+ *                                                                         *
+ * Copyright (c) 2026 by David Korth.                                      *
+ * SPDX-License-Identifier: GPL-2.0-or-later                               *
+ ***************************************************************************/
+
+// Wii disc hash trees consist of many SHA-1 hashes of equal-length
+// blocks: 31 user data blocks per sector (H0), 64 H0 tables per
+// group (H1), and so on. Hashing the blocks as a batch allows the
+// use of SHA-NI or multi-buffer SIMD implementations.
+
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * SHA-1 implementations.
+ */
+typedef enum {
+	SHA1W_IMPL_AUTO		= 0,	// Select the best available implementation.
+	SHA1W_IMPL_GENERIC	= 1,	// nettle (one block at a time)
+	SHA1W_IMPL_SSE2		= 2,	// 4-lane multi-buffer SSE2
+	SHA1W_IMPL_AVX2		= 3,	// 8-lane multi-buffer AVX2
+	SHA1W_IMPL_SHANI	= 4,	// Intel SHA extensions
+
+	SHA1W_IMPL_MAX
+} SHA1W_Impl;
+
+/**
+ * Select the SHA-1 implementation used by sha1w_hash_blocks().
+ *
+ * This is intended for testing and benchmarking, and must not be
+ * called while another thread is hashing.
+ *
+ * @param impl SHA-1 implementation.
+ * @return 0 on success; -ENOTSUP if the implementation isn't available.
+ */
+int sha1w_set_impl(SHA1W_Impl impl);
+
+/**
+ * Get the SHA-1 implementation used by sha1w_hash_blocks().
+ * @return SHA-1 implementation. (never SHA1W_IMPL_AUTO)
+ */
+SHA1W_Impl sha1w_get_impl(void);
+
+/**
+ * Hash multiple equal-length blocks using SHA-1.
+ *
+ * Block i starts at pData + (i * stride). Digest i is written to
+ * pDigests + (i * 20). The digests must not overlap the data.
+ *
+ * @param pDigests	[out] Digests. (count * 20 bytes)
+ * @param pData		[in] First data block.
+ * @param size		[in] Length of each data block, in bytes.
+ * @param stride	[in] Distance between the start of each data block, in bytes.
+ * @param count		[in] Number of data blocks.
+ */
+void sha1w_hash_blocks(uint8_t *pDigests, const uint8_t *pData, size_t size, size_t stride, size_t count);
+
+#ifdef __cplusplus
+}
+#endif
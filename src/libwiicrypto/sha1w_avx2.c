@@ -0,0 +1,27 @@
+/***************************************************************************
+ * RVT-H Tool (libwiicrypto)                                               *
+ * sha1w_avx2.c: SHA-1 batch hashing functions. (AVX2 multi-buffer)        *
+ *                                                                         *
+ * Copyright (c) 2026 by David Korth.                                      *
+ * SPDX-License-Identifier: GPL-2.0-or-later                               *
+ ***************************************************************************/
+
+#include "sha1w_x86.h"
+
+// AVX2 intrinsics
+#include <immintrin.h>
+
+typedef __m256i vec_t;
+#define V_ADD(a,b)	_mm256_add_epi32(a, b)
+#define V_XOR(a,b)	_mm256_xor_si256(a, b)
+#define V_AND(a,b)	_mm256_and_si256(a, b)
+#define V_OR(a,b)	_mm256_or_si256(a, b)
+#define V_SLLI(a,n)	_mm256_slli_epi32(a, n)
+#define V_SRLI(a,n)	_mm256_srli_epi32(a, n)
+#define V_SET1(x)	_mm256_set1_epi32((int)(x))
+#define V_LOAD(p)	_mm256_loadu_si256((const __m256i*)(p))
+#define V_STORE(p,v)	_mm256_storeu_si256((__m256i*)(p), v)
+
+#define SHA1W_MB_FUNC	sha1w_avx2_x8
+#define SHA1W_MB_LANES	8
+#include "sha1w_mb.h"
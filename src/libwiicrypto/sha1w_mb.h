@@ -0,0 +1,185 @@
+/***************************************************************************
+ * RVT-H Tool (libwiicrypto)                                               *
+ * sha1w_mb.h: SHA-1 batch hashing functions. (multi-buffer template)      *
+ *                                                                         *
+ * Copyright (c) 2026 by David Korth.                                      *
+ * SPDX-License-Identifier: GPL-2.0-or-later                               *
+ ***************************************************************************/
+
+// NOTE: This is an internal template used by sha1w_sse2.c and sha1w_avx2.c.
+// Each lane of a SIMD vector holds the state of a separate message,
+// so all messages must be the same length.
+//
+// Define the following before including this file:
+// - SHA1W_MB_FUNC:	Function name.
+// - SHA1W_MB_LANES:	Number of 32-bit lanes in vec_t.
+// - vec_t:		SIMD vector type.
+// - V_ADD(a,b), V_XOR(a,b), V_AND(a,b), V_OR(a,b): 32-bit lane operations
+// - V_SLLI(a,n), V_SRLI(a,n): 32-bit lane shifts
+// - V_SET1(x):		Broadcast a 32-bit value.
+// - V_LOAD(p):		Load a vector from uint32_t[SHA1W_MB_LANES].
+// - V_STORE(p,v):	Store a vector to uint32_t[SHA1W_MB_LANES].
+
+// C includes
+#include <string.h>
+
+#define V_ROL(a,n) V_OR(V_SLLI(a,n), V_SRLI(a,32-(n)))
+
+// SHA-1 round functions
+#define F1(b,c,d) V_XOR(d, V_AND(b, V_XOR(c, d)))
+#define F2(b,c,d) V_XOR(V_XOR(b, c), d)
+#define F3(b,c,d) V_OR(V_AND(b, c), V_AND(d, V_OR(b, c)))
+
+/**
+ * Load a big-endian 32-bit word.
+ * @param p Pointer
+ * @return Word
+ */
+static inline uint32_t load_be32(const uint8_t *p)
+{
+	return ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) |
+	       ((uint32_t)p[2] << 8) | (uint32_t)p[3];
+}
+
+/**
+ * Store a big-endian 32-bit word.
+ * @param p Pointer
+ * @param w Word
+ */
+static inline void store_be32(uint8_t *p, uint32_t w)
+{
+	p[0] = (uint8_t)(w >> 24);
+	p[1] = (uint8_t)(w >> 16);
+	p[2] = (uint8_t)(w >> 8);
+	p[3] = (uint8_t)w;
+}
+
+/**
+ * Get message schedule word t, expanding it if necessary.
+ * @param W Message schedule (ring buffer)
+ * @param t Round number
+ * @return W[t]
+ */
+static inline vec_t sched(vec_t W[16], unsigned int t)
+{
+	if (t >= 16) {
+		W[t & 15] = V_ROL(V_XOR(V_XOR(W[(t-3) & 15], W[(t-8) & 15]),
+		                        V_XOR(W[(t-14) & 15], W[t & 15])), 1);
+	}
+	return W[t & 15];
+}
+
+// Rounds rotate the variables instead of moving them.
+#define ROUND(a,b,c,d,e,F,k,t) do { \
+	e = V_ADD(e, V_ADD(V_ADD(V_ROL(a, 5), F(b, c, d)), V_ADD(k, sched(W, t)))); \
+	b = V_ROL(b, 30); \
+} while (0)
+
+#define ROUND5(F,k,t) do { \
+	ROUND(a,b,c,d,e,F,k,(t)+0); \
+	ROUND(e,a,b,c,d,F,k,(t)+1); \
+	ROUND(d,e,a,b,c,F,k,(t)+2); \
+	ROUND(c,d,e,a,b,F,k,(t)+3); \
+	ROUND(b,c,d,e,a,F,k,(t)+4); \
+} while (0)
+
+/**
+ * Process one 64-byte block from each lane.
+ * @param state	[in/out] Hash state
+ * @param p	[in] 64-byte blocks
+ */
+static void sha1w_mb_block(vec_t state[5], const uint8_t *const p[SHA1W_MB_LANES])
+{
+	vec_t W[16];
+	vec_t a, b, c, d, e, k;
+	unsigned int t, l;
+
+	for (t = 0; t < 16; t++) {
+		uint32_t w[SHA1W_MB_LANES];
+		for (l = 0; l < SHA1W_MB_LANES; l++) {
+			w[l] = load_be32(&p[l][t*4]);
+		}
+		W[t] = V_LOAD(w);
+	}
+
+	a = state[0]; b = state[1]; c = state[2]; d = state[3]; e = state[4];
+
+	k = V_SET1(0x5A827999);
+	for (t = 0; t < 20; t += 5)
+		ROUND5(F1, k, t);
+	k = V_SET1(0x6ED9EBA1);
+	for (; t < 40; t += 5)
+		ROUND5(F2, k, t);
+	k = V_SET1(0x8F1BBCDC);
+	for (; t < 60; t += 5)
+		ROUND5(F3, k, t);
+	k = V_SET1(0xCA62C1D6);
+	for (; t < 80; t += 5)
+		ROUND5(F2, k, t);
+
+	state[0] = V_ADD(state[0], a);
+	state[1] = V_ADD(state[1], b);
+	state[2] = V_ADD(state[2], c);
+	state[3] = V_ADD(state[3], d);
+	state[4] = V_ADD(state[4], e);
+}
+
+/**
+ * Hash SHA1W_MB_LANES equal-length blocks.
+ * @param pDigests	[out] Digests. (SHA1W_MB_LANES * 20 bytes)
+ * @param pData		[in] Data blocks.
+ * @param size		[in] Length of each data block, in bytes.
+ */
+void SHA1W_MB_FUNC(uint8_t *pDigests, const uint8_t *const pData[SHA1W_MB_LANES], size_t size)
+{
+	vec_t state[5];
+	const uint8_t *p[SHA1W_MB_LANES];
+	uint8_t tail[SHA1W_MB_LANES][128];
+	const uint64_t bits = (uint64_t)size * 8;
+	const size_t rem = size % 64;
+	const size_t tail_size = (rem < 56 ? 64 : 128);
+	size_t blocks;
+	unsigned int i, l;
+
+	state[0] = V_SET1(0x67452301);
+	state[1] = V_SET1(0xEFCDAB89);
+	state[2] = V_SET1(0x98BADCFE);
+	state[3] = V_SET1(0x10325476);
+	state[4] = V_SET1(0xC3D2E1F0);
+
+	for (l = 0; l < SHA1W_MB_LANES; l++) {
+		p[l] = pData[l];
+	}
+	for (blocks = size / 64; blocks > 0; blocks--) {
+		sha1w_mb_block(state, p);
+		for (l = 0; l < SHA1W_MB_LANES; l++) {
+			p[l] += 64;
+		}
+	}
+
+	// Final block(s): Remaining data, 0x80, zero padding,
+	// and the message length in bits.
+	for (l = 0; l < SHA1W_MB_LANES; l++) {
+		memcpy(tail[l], p[l], rem);
+		tail[l][rem] = 0x80;
+		memset(&tail[l][rem+1], 0, tail_size - rem - 1 - 8);
+		store_be32(&tail[l][tail_size-8], (uint32_t)(bits >> 32));
+		store_be32(&tail[l][tail_size-4], (uint32_t)bits);
+		p[l] = tail[l];
+	}
+	sha1w_mb_block(state, p);
+	if (tail_size > 64) {
+		for (l = 0; l < SHA1W_MB_LANES; l++) {
+			p[l] += 64;
+		}
+		sha1w_mb_block(state, p);
+	}
+
+	for (i = 0; i < 5; i++) {
+		uint32_t w[SHA1W_MB_LANES];
+		V_STORE(w, state[i]);
+		for (l = 0; l < SHA1W_MB_LANES; l++) {
+			store_be32(&pDigests[l*20 + i*4], w[l]);
+		}
+	}
+}
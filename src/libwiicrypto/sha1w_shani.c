@@ -0,0 +1,156 @@
+/***************************************************************************
+ * RVT-H Tool (libwiicrypto)                                               *
+ * sha1w_shani.c: SHA-1 batch hashing functions. (Intel SHA extensions)    *
+ *                                                                         *
+ * Copyright (c) 2026 by David Korth.                                      *
+ * SPDX-License-Identifier: GPL-2.0-or-later                               *
+ ***************************************************************************/
+
+#include "sha1w_x86.h"
+
+// SHA intrinsics
+#include <immintrin.h>
+
+// C includes
+#include <string.h>
+
+// Four rounds of SHA-1, without any message schedule updates.
+// ea/eb alternate between steps; func is the round function. (0-3)
+#define SHANI_ROUNDS(ea, eb, m, func) do { \
+	ea = _mm_sha1nexte_epu32(ea, m); \
+	eb = abcd; \
+	abcd = _mm_sha1rnds4_epu32(abcd, ea, func); \
+} while (0)
+
+// Four rounds of SHA-1, plus message schedule updates for later rounds:
+// sha1msg2 finishes m1, sha1msg1 starts m3, and the xor adds m0 to m2.
+#define SHANI_ROUNDS_SCHED(ea, eb, m0, m1, m2, m3, func) do { \
+	ea = _mm_sha1nexte_epu32(ea, m0); \
+	eb = abcd; \
+	m1 = _mm_sha1msg2_epu32(m1, m0); \
+	abcd = _mm_sha1rnds4_epu32(abcd, ea, func); \
+	m3 = _mm_sha1msg1_epu32(m3, m0); \
+	m2 = _mm_xor_si128(m2, m0); \
+} while (0)
+
+/**
+ * Process 64-byte blocks.
+ * @param pAbcd	[in/out] State: A, B, C, D (A in the highest lane)
+ * @param pE	[in/out] State: E (in the highest lane)
+ * @param p	[in] Data
+ * @param blocks	[in] Number of 64-byte blocks
+ */
+static void sha1w_shani_blocks(__m128i *pAbcd, __m128i *pE, const uint8_t *p, size_t blocks)
+{
+	const __m128i mask = _mm_set_epi64x(0x0001020304050607ULL, 0x08090A0B0C0D0E0FULL);
+	__m128i abcd = *pAbcd, e0 = *pE, e1;
+	__m128i m0, m1, m2, m3;
+
+	for (; blocks > 0; blocks--, p += 64) {
+		const __m128i abcd_save = abcd;
+		const __m128i e_save = e0;
+
+		// Rounds 0-3
+		m0 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)&p[0]), mask);
+		e0 = _mm_add_epi32(e0, m0);
+		e1 = abcd;
+		abcd = _mm_sha1rnds4_epu32(abcd, e0, 0);
+
+		// Rounds 4-7
+		m1 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)&p[16]), mask);
+		SHANI_ROUNDS(e1, e0, m1, 0);
+		m0 = _mm_sha1msg1_epu32(m0, m1);
+
+		// Rounds 8-11
+		m2 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)&p[32]), mask);
+		SHANI_ROUNDS(e0, e1, m2, 0);
+		m1 = _mm_sha1msg1_epu32(m1, m2);
+		m0 = _mm_xor_si128(m0, m2);
+
+		// Rounds 12-15
+		m3 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)&p[48]), mask);
+		e1 = _mm_sha1nexte_epu32(e1, m3);
+		e0 = abcd;
+		m0 = _mm_sha1msg2_epu32(m0, m3);
+		abcd = _mm_sha1rnds4_epu32(abcd, e1, 0);
+		m2 = _mm_sha1msg1_epu32(m2, m3);
+		m1 = _mm_xor_si128(m1, m3);
+
+		// Rounds 16-67
+		SHANI_ROUNDS_SCHED(e0, e1, m0, m1, m2, m3, 0);	// 16-19
+		SHANI_ROUNDS_SCHED(e1, e0, m1, m2, m3, m0, 1);	// 20-23
+		SHANI_ROUNDS_SCHED(e0, e1, m2, m3, m0, m1, 1);	// 24-27
+		SHANI_ROUNDS_SCHED(e1, e0, m3, m0, m1, m2, 1);	// 28-31
+		SHANI_ROUNDS_SCHED(e0, e1, m0, m1, m2, m3, 1);	// 32-35
+		SHANI_ROUNDS_SCHED(e1, e0, m1, m2, m3, m0, 1);	// 36-39
+		SHANI_ROUNDS_SCHED(e0, e1, m2, m3, m0, m1, 2);	// 40-43
+		SHANI_ROUNDS_SCHED(e1, e0, m3, m0, m1, m2, 2);	// 44-47
+		SHANI_ROUNDS_SCHED(e0, e1, m0, m1, m2, m3, 2);	// 48-51
+		SHANI_ROUNDS_SCHED(e1, e0, m1, m2, m3, m0, 2);	// 52-55
+		SHANI_ROUNDS_SCHED(e0, e1, m2, m3, m0, m1, 2);	// 56-59
+		SHANI_ROUNDS_SCHED(e1, e0, m3, m0, m1, m2, 3);	// 60-63
+		SHANI_ROUNDS_SCHED(e0, e1, m0, m1, m2, m3, 3);	// 64-67
+
+		// Rounds 68-71
+		e1 = _mm_sha1nexte_epu32(e1, m1);
+		e0 = abcd;
+		m2 = _mm_sha1msg2_epu32(m2, m1);
+		abcd = _mm_sha1rnds4_epu32(abcd, e1, 3);
+		m3 = _mm_xor_si128(m3, m1);
+
+		// Rounds 72-75
+		e0 = _mm_sha1nexte_epu32(e0, m2);
+		e1 = abcd;
+		m3 = _mm_sha1msg2_epu32(m3, m2);
+		abcd = _mm_sha1rnds4_epu32(abcd, e0, 3);
+
+		// Rounds 76-79
+		SHANI_ROUNDS(e1, e0, m3, 3);
+
+		// Add this block's hash to the state.
+		e0 = _mm_sha1nexte_epu32(e0, e_save);
+		abcd = _mm_add_epi32(abcd, abcd_save);
+	}
+
+	*pAbcd = abcd;
+	*pE = e0;
+}
+
+/**
+ * Hash a single block using the Intel SHA extensions.
+ * @param pDigest	[out] Digest. (20 bytes)
+ * @param pData		[in] Data block.
+ * @param size		[in] Length of the data block, in bytes.
+ */
+void sha1w_shani(uint8_t *pDigest, const uint8_t *pData, size_t size)
+{
+	const __m128i mask = _mm_set_epi64x(0x0001020304050607ULL, 0x08090A0B0C0D0E0FULL);
+	__m128i abcd = _mm_set_epi32(0x67452301, (int)0xEFCDAB89, (int)0x98BADCFE, 0x10325476);
+	__m128i e = _mm_set_epi32((int)0xC3D2E1F0, 0, 0, 0);
+	uint8_t tail[128];
+	const uint64_t bits = (uint64_t)size * 8;
+	const size_t rem = size % 64;
+	const size_t tail_size = (rem < 56 ? 64 : 128);
+	uint32_t w;
+	unsigned int i;
+
+	sha1w_shani_blocks(&abcd, &e, pData, size / 64);
+
+	// Final block(s): Remaining data, 0x80, zero padding,
+	// and the message length in bits.
+	memcpy(tail, &pData[size - rem], rem);
+	tail[rem] = 0x80;
+	memset(&tail[rem+1], 0, tail_size - rem - 1);
+	for (i = 0; i < 8; i++) {
+		tail[tail_size - 1 - i] = (uint8_t)(bits >> (i * 8));
+	}
+	sha1w_shani_blocks(&abcd, &e, tail, tail_size / 64);
+
+	// Reversing all 16 bytes puts A first, in big-endian order.
+	_mm_storeu_si128((__m128i*)pDigest, _mm_shuffle_epi8(abcd, mask));
+	w = (uint32_t)_mm_extract_epi32(e, 3);
+	pDigest[16] = (uint8_t)(w >> 24);
+	pDigest[17] = (uint8_t)(w >> 16);
+	pDigest[18] = (uint8_t)(w >> 8);
+	pDigest[19] = (uint8_t)w;
+}
@@ -0,0 +1,27 @@
+/***************************************************************************
+ * RVT-H Tool (libwiicrypto)                                               *
+ * sha1w_sse2.c: SHA-1 batch hashing functions. (SSE2 multi-buffer)        *
+ *                                                                         *
+ * Copyright (c) 2026 by David Korth.                                      *
+ * SPDX-License-Identifier: GPL-2.0-or-later                               *
+ ***************************************************************************/
+
+#include "sha1w_x86.h"
+
+// SSE2 intrinsics
+#include <emmintrin.h>
+
+typedef __m128i vec_t;
+#define V_ADD(a,b)	_mm_add_epi32(a, b)
+#define V_XOR(a,b)	_mm_xor_si128(a, b)
+#define V_AND(a,b)	_mm_and_si128(a, b)
+#define V_OR(a,b)	_mm_or_si128(a, b)
+#define V_SLLI(a,n)	_mm_slli_epi32(a, n)
+#define V_SRLI(a,n)	_mm_srli_epi32(a, n)
+#define V_SET1(x)	_mm_set1_epi32((int)(x))
+#define V_LOAD(p)	_mm_loadu_si128((const __m128i*)(p))
+#define V_STORE(p,v)	_mm_storeu_si128((__m128i*)(p), v)
+
+#define SHA1W_MB_FUNC	sha1w_sse2_x4
+#define SHA1W_MB_LANES	4
+#include "sha1w_mb.h"
@@ -0,0 +1,53 @@
+/***************************************************************************
+ * RVT-H Tool (libwiicrypto)                                               *
+ * sha1w_x86.h: SHA-1 batch hashing functions. (x86 implementations)       *
+ *                                                                         *
+ * Copyright (c) 2026 by David Korth.                                      *
+ * SPDX-License-Identifier: GPL-2.0-or-later                               *
+ ***************************************************************************/
+
+// NOTE: This is an internal header used by sha1w.c.
+// It should not be used by anything outside of libwiicrypto.
+
+#pragma once
+
+#include "config.libwiicrypto.h"
+
+#include <stdint.h>
+#include <stddef.h>
+
+#ifdef HAVE_SHA1W_X86
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Hash 4 equal-length blocks using 4-lane multi-buffer SSE2.
+ * @param pDigests	[out] Digests. (4 * 20 bytes)
+ * @param pData		[in] Data blocks.
+ * @param size		[in] Length of each data block, in bytes.
+ */
+void sha1w_sse2_x4(uint8_t *pDigests, const uint8_t *const pData[4], size_t size);
+
+/**
+ * Hash 8 equal-length blocks using 8-lane multi-buffer AVX2.
+ * @param pDigests	[out] Digests. (8 * 20 bytes)
+ * @param pData		[in] Data blocks.
+ * @param size		[in] Length of each data block, in bytes.
+ */
+void sha1w_avx2_x8(uint8_t *pDigests, const uint8_t *const pData[8], size_t size);
+
+/**
+ * Hash a single block using the Intel SHA extensions.
+ * @param pDigest	[out] Digest. (20 bytes)
+ * @param pData		[in] Data block.
+ * @param size		[in] Length of the data block, in bytes.
+ */
+void sha1w_shani(uint8_t *pDigest, const uint8_t *pData, size_t size);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* HAVE_SHA1W_X86 */
@@ -0,0 +1,251 @@
+/***************************************************************************
+ * RVT-H Tool (libwiicrypto/tests)                                         *
+ * AesBackendTest.cpp: AES backend comparison test.                        *
+ *                                                                         *
+ * Copyright (c) 2026 by David Korth.                                      *
+ * SPDX-License-Identifier: GPL-2.0-or-later                               *
+ ***************************************************************************/
+
+// Google Test
+#include "gtest/gtest.h"
+
+#include "libwiicrypto/aesw.h"
+#include "libwiicrypto/wii_sector.h"
+
+// C includes. (C++ namespace)
+#include <cerrno>
+#include <cstring>
+
+// C++ includes.
+#include <memory>
+#include <random>
+#include <vector>
+using std::unique_ptr;
+using std::vector;
+
+namespace LibWiiCrypto { namespace Tests {
+
+/**
+ * Compares the hardware-accelerated AES backend against nettle.
+ * Test parameter: Data size, in bytes.
+ */
+class AesBackendTest : public ::testing::TestWithParam<size_t>
+{
+protected:
+	AesBackendTest()
+		: aesw_sw(nullptr)
+		, aesw_hw(nullptr)
+		, rng(0x52565448)	// 'RVTH'
+	{ }
+
+	void SetUp(void) final
+	{
+		aesw_sw = aesw_new();
+		aesw_hw = aesw_new();
+		ASSERT_TRUE(aesw_sw != nullptr);
+		ASSERT_TRUE(aesw_hw != nullptr);
+
+		ASSERT_EQ(0, aesw_set_hw_accel(aesw_sw, 0));
+		if (aesw_set_hw_accel(aesw_hw, 1) != 0) {
+			GTEST_SKIP() << "Hardware-accelerated AES is not available on this CPU.";
+		}
+
+		uint8_t key[16];
+		fill(key, sizeof(key));
+		ASSERT_EQ(0, aesw_set_key(aesw_sw, key, sizeof(key)));
+		ASSERT_EQ(0, aesw_set_key(aesw_hw, key, sizeof(key)));
+	}
+
+	void TearDown(void) final
+	{
+		aesw_free(aesw_sw);
+		aesw_free(aesw_hw);
+	}
+
+	/**
+	 * Fill a buffer with pseudo-random data.
+	 * @param buf Buffer
+	 * @param size Size
+	 */
+	void fill(uint8_t *buf, size_t size)
+	{
+		for (size_t i = 0; i < size; i++) {
+			buf[i] = static_cast<uint8_t>(rng());
+		}
+	}
+
+public:
+	AesCtx *aesw_sw;	// nettle
+	AesCtx *aesw_hw;	// hardware-accelerated
+	std::mt19937 rng;
+};
+
+/**
+ * CBC encryption, including IV chaining across two calls.
+ */
+TEST_P(AesBackendTest, encrypt)
+{
+	const size_t size = GetParam();
+	vector<uint8_t> buf_sw(size), buf_hw;
+	uint8_t iv[16];
+	fill(buf_sw.data(), size);
+	fill(iv, sizeof(iv));
+	buf_hw = buf_sw;
+
+	ASSERT_EQ(0, aesw_set_iv(aesw_sw, iv, sizeof(iv)));
+	ASSERT_EQ(0, aesw_set_iv(aesw_hw, iv, sizeof(iv)));
+	for (int i = 0; i < 2; i++) {
+		ASSERT_EQ(size, aesw_encrypt(aesw_sw, buf_sw.data(), size));
+		ASSERT_EQ(size, aesw_encrypt(aesw_hw, buf_hw.data(), size));
+		EXPECT_EQ(0, memcmp(buf_sw.data(), buf_hw.data(), size));
+	}
+}
+
+/**
+ * CBC decryption, including IV chaining across two calls.
+ */
+TEST_P(AesBackendTest, decrypt)
+{
+	const size_t size = GetParam();
+	vector<uint8_t> buf_sw(size), buf_hw;
+	uint8_t iv[16];
+	fill(buf_sw.data(), size);
+	fill(iv, sizeof(iv));
+	buf_hw = buf_sw;
+
+	ASSERT_EQ(0, aesw_set_iv(aesw_sw, iv, sizeof(iv)));
+	ASSERT_EQ(0, aesw_set_iv(aesw_hw, iv, sizeof(iv)));
+	for (int i = 0; i < 2; i++) {
+		ASSERT_EQ(size, aesw_decrypt(aesw_sw, buf_sw.data(), size));
+		ASSERT_EQ(size, aesw_decrypt(aesw_hw, buf_hw.data(), size));
+		EXPECT_EQ(0, memcmp(buf_sw.data(), buf_hw.data(), size));
+	}
+}
+
+/**
+ * Batch encryption and decryption with independent IVs.
+ * Uses 9 entries so the interleaved path and the single-entry
+ * path are both exercised.
+ */
+TEST_P(AesBackendTest, batch)
+{
+	static const size_t count = 9;
+	const size_t size = GetParam();
+	vector<uint8_t> buf_sw(size * count), buf_hw;
+	vector<uint8_t> ivs(16 * count);
+	fill(buf_sw.data(), buf_sw.size());
+	fill(ivs.data(), ivs.size());
+	buf_hw = buf_sw;
+
+	vector<AesBatchEntry> batch_sw(count), batch_hw(count);
+	for (size_t i = 0; i < count; i++) {
+		batch_sw[i].iv = batch_hw[i].iv = &ivs[i * 16];
+		batch_sw[i].data = &buf_sw[i * size];
+		batch_hw[i].data = &buf_hw[i * size];
+		batch_sw[i].size = batch_hw[i].size = size;
+	}
+
+	ASSERT_EQ(count, aesw_encrypt_batch(aesw_sw, batch_sw.data(), count));
+	ASSERT_EQ(count, aesw_encrypt_batch(aesw_hw, batch_hw.data(), count));
+	EXPECT_EQ(0, memcmp(buf_sw.data(), buf_hw.data(), buf_sw.size()));
+
+	ASSERT_EQ(count, aesw_decrypt_batch(aesw_sw, batch_sw.data(), count));
+	ASSERT_EQ(count, aesw_decrypt_batch(aesw_hw, batch_hw.data(), count));
+	EXPECT_EQ(0, memcmp(buf_sw.data(), buf_hw.data(), buf_sw.size()));
+}
+
+INSTANTIATE_TEST_CASE_P(sizes, AesBackendTest,
+	::testing::Values(16U, 112U, 128U, 144U, 1024U, 31744U, 32768U));
+
+/**
+ * Encrypt and decrypt a full Wii disc group the same way
+ * extract_crypt.cpp and verify.cpp do. The user data IVs are
+ * taken from the encrypted hash blocks, so batch entries
+ * depend on earlier entries.
+ */
+TEST(AesBackendGroupTest, wiiGroup)
+{
+	AesCtx *const aesw_sw = aesw_new();
+	AesCtx *const aesw_hw = aesw_new();
+	ASSERT_TRUE(aesw_sw != nullptr);
+	ASSERT_TRUE(aesw_hw != nullptr);
+	ASSERT_EQ(0, aesw_set_hw_accel(aesw_sw, 0));
+	if (aesw_set_hw_accel(aesw_hw, 1) != 0) {
+		aesw_free(aesw_sw);
+		aesw_free(aesw_hw);
+		GTEST_SKIP() << "Hardware-accelerated AES is not available on this CPU.";
+	}
+
+	std::mt19937 rng(64);
+	uint8_t key[16];
+	for (uint8_t &b : key) {
+		b = static_cast<uint8_t>(rng());
+	}
+	aesw_set_key(aesw_sw, key, sizeof(key));
+	aesw_set_key(aesw_hw, key, sizeof(key));
+
+	unique_ptr<Wii_Disc_Sector_t[]> orig(new Wii_Disc_Sector_t[64]);
+	unique_ptr<Wii_Disc_Sector_t[]> gdata_sw(new Wii_Disc_Sector_t[64]);
+	unique_ptr<Wii_Disc_Sector_t[]> gdata_hw(new Wii_Disc_Sector_t[64]);
+	uint8_t *const p = reinterpret_cast<uint8_t*>(orig.get());
+	for (size_t i = 0; i < GROUP_SIZE_ENC; i++) {
+		p[i] = static_cast<uint8_t>(rng());
+	}
+	memcpy(gdata_sw.get(), orig.get(), GROUP_SIZE_ENC);
+	memcpy(gdata_hw.get(), orig.get(), GROUP_SIZE_ENC);
+
+	// Encrypt: hashes first, then user data.
+	static const uint8_t zero_iv[16] = {0};
+	AesBatchEntry batch_sw[64*2], batch_hw[64*2];
+	for (unsigned int i = 0; i < 64; i++) {
+		batch_sw[i].iv = batch_hw[i].iv = zero_iv;
+		batch_sw[i].data = reinterpret_cast<uint8_t*>(&gdata_sw[i].hashes);
+		batch_hw[i].data = reinterpret_cast<uint8_t*>(&gdata_hw[i].hashes);
+		batch_sw[i].size = batch_hw[i].size = sizeof(gdata_sw[i].hashes);
+
+		batch_sw[64+i].iv = &gdata_sw[i].hashes.H2[7][4];
+		batch_hw[64+i].iv = &gdata_hw[i].hashes.H2[7][4];
+		batch_sw[64+i].data = gdata_sw[i].data;
+		batch_hw[64+i].data = gdata_hw[i].data;
+		batch_sw[64+i].size = batch_hw[64+i].size = sizeof(gdata_sw[i].data);
+	}
+	ASSERT_EQ(ARRAY_SIZE(batch_sw), aesw_encrypt_batch(aesw_sw, batch_sw, ARRAY_SIZE(batch_sw)));
+	ASSERT_EQ(ARRAY_SIZE(batch_hw), aesw_encrypt_batch(aesw_hw, batch_hw, ARRAY_SIZE(batch_hw)));
+	EXPECT_EQ(0, memcmp(gdata_sw.get(), gdata_hw.get(), GROUP_SIZE_ENC));
+
+	// Decrypt: user data first, then hashes.
+	for (unsigned int i = 0; i < 64; i++) {
+		batch_hw[i*2].iv = &gdata_hw[i].hashes.H2[7][4];
+		batch_hw[i*2].data = gdata_hw[i].data;
+		batch_hw[i*2].size = sizeof(gdata_hw[i].data);
+		batch_hw[i*2+1].iv = zero_iv;
+		batch_hw[i*2+1].data = reinterpret_cast<uint8_t*>(&gdata_hw[i].hashes);
+		batch_hw[i*2+1].size = sizeof(gdata_hw[i].hashes);
+	}
+	ASSERT_EQ(ARRAY_SIZE(batch_hw), aesw_decrypt_batch(aesw_hw, batch_hw, ARRAY_SIZE(batch_hw)));
+	EXPECT_EQ(0, memcmp(orig.get(), gdata_hw.get(), GROUP_SIZE_ENC));
+
+	aesw_free(aesw_sw);
+	aesw_free(aesw_hw);
+}
+
+} }
+
+#ifdef _MSC_VER
+# define RVTH_CDECL __cdecl
+#else
+# define RVTH_CDECL
+#endif
+
+/**
+ * Test suite main function.
+ */
+int RVTH_CDECL main(int argc, char *argv[])
+{
+	fprintf(stderr, "libwiicrypto test suite: AES backend tests.\n\n");
+	fflush(nullptr);
+
+	// coverity[fun_call_w_exception]: uncaught exceptions cause nonzero exit anyway, so don't warn.
+	::testing::InitGoogleTest(&argc, argv);
+	return RUN_ALL_TESTS();
+}
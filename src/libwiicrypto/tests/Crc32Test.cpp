@@ -0,0 +1,105 @@
+/***************************************************************************
+ * RVT-H Tool (libwiicrypto/tests)                                         *
+ * Crc32Test.cpp: CRC-32 checksum test.                                    *
+ *                                                                         *
+ * Copyright (c) 2026 by David Korth.                                      *
+ * SPDX-License-Identifier: GPL-2.0-or-later                               *
+ ***************************************************************************/
+
+// Google Test
+#include "gtest/gtest.h"
+
+#include "libwiicrypto/crc32.h"
+
+// C includes. (C++ namespace)
+#include <cstdio>
+#include <cstring>
+
+// C++ includes.
+#include <vector>
+using std::vector;
+
+namespace LibWiiCrypto { namespace Tests {
+
+/**
+ * Reference CRC-32, one bit at a time.
+ * @param pData Data
+ * @param size Size
+ * @return CRC-32
+ */
+static uint32_t crc32_ref(const uint8_t *pData, size_t size)
+{
+	uint32_t crc = ~0U;
+	for (size_t i = 0; i < size; i++) {
+		crc ^= pData[i];
+		for (unsigned int n = 0; n < 8; n++) {
+			crc = (crc >> 1) ^ ((crc & 1) ? 0xEDB88320U : 0);
+		}
+	}
+	return ~crc;
+}
+
+/**
+ * Known test vectors.
+ */
+TEST(Crc32Test, knownValues)
+{
+	EXPECT_EQ(0U, crc32_update(0, nullptr, 0));
+
+	static const char check[] = "123456789";
+	EXPECT_EQ(0xCBF43926U, crc32_update(0, reinterpret_cast<const uint8_t*>(check), 9));
+
+	static const char fox[] = "The quick brown fox jumps over the lazy dog";
+	EXPECT_EQ(0x414FA339U, crc32_update(0, reinterpret_cast<const uint8_t*>(fox), sizeof(fox)-1));
+}
+
+/**
+ * Buffers of various sizes and alignments, hashed all at once
+ * and in pieces, match the reference implementation.
+ */
+TEST(Crc32Test, sizesAndAlignments)
+{
+	vector<uint8_t> buf(1024 + 16);
+	uint32_t seed = 0x52565448;	// 'RVTH'
+	for (uint8_t &b : buf) {
+		seed = seed * 1103515245U + 12345U;
+		b = static_cast<uint8_t>(seed >> 16);
+	}
+
+	static const size_t sizes[] = {1, 3, 7, 8, 9, 15, 16, 17, 63, 64, 65, 1000, 1024};
+	for (size_t align = 0; align < 8; align++) {
+		const uint8_t *const p = &buf[align];
+		for (size_t size : sizes) {
+			const uint32_t expected = crc32_ref(p, size);
+			EXPECT_EQ(expected, crc32_update(0, p, size)) << "align " << align << ", size " << size;
+
+			// Split at every position.
+			for (size_t split = 0; split <= size; split += 5) {
+				uint32_t crc = crc32_update(0, p, split);
+				crc = crc32_update(crc, p + split, size - split);
+				EXPECT_EQ(expected, crc) << "align " << align << ", size " << size << ", split " << split;
+			}
+		}
+	}
+}
+
+} }
+
+#ifdef _MSC_VER
+# define RVTH_CDECL __cdecl
+#else
+# define RVTH_CDECL
+#endif
+
+/**
+ * Test suite main function.
+ */
+int RVTH_CDECL main(int argc, char *argv[])
+{
+	fprintf(stderr, "libwiicrypto test suite: CRC-32 tests.\n\n");
+	fflush(nullptr);
+
+	// coverity[fun_call_w_exception]: uncaught exceptions cause nonzero exit anyway, so don't warn.
+	::testing::InitGoogleTest(&argc, argv);
+	return RUN_ALL_TESTS();
+}
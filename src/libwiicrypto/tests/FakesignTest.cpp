@@ -0,0 +1,151 @@
+/***************************************************************************
+ * RVT-H Tool (libwiicrypto/tests)                                         *
+ * FakesignTest.cpp: Ticket and TMD fakesigning test.                      *
+ *                                                                         *
+ * Copyright (c) 2026 by David Korth.                                      *
+ * SPDX-License-Identifier: GPL-2.0-or-later                               *
+ ***************************************************************************/
+
+// Google Test
+#include "gtest/gtest.h"
+
+#include "libwiicrypto/cert.h"
+#include "libwiicrypto/cert_store.h"
+#include "libwiicrypto/sha1w.h"
+#include "libwiicrypto/wii_structs.h"
+#include "libwiicrypto/byteswap.h"
+
+// C includes. (C++ namespace)
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+
+// C++ includes.
+#include <random>
+#include <vector>
+using std::vector;
+
+namespace LibWiiCrypto { namespace Tests {
+
+// Fake word offsets.
+static const size_t TICKET_FAKE_OFFSET = 0x25C;
+static const size_t TMD_FAKE_OFFSET = 0x19C;
+
+// Size of a TMD content entry.
+static const size_t TMD_CONTENT_SIZE = 36;
+
+/**
+ * Test parameters: is TMD, number of TMD contents, number of threads
+ */
+typedef std::tuple<bool, unsigned int, unsigned int> FakesignTest_params;
+
+/**
+ * Compares fakesigning against a simple search that hashes
+ * the entire ticket or TMD on every try.
+ */
+class FakesignTest : public ::testing::TestWithParam<FakesignTest_params>
+{
+protected:
+	/**
+	 * Calculate the SHA-1 hash of a ticket or TMD, starting at the issuer.
+	 * @param digest	[out] SHA-1 digest
+	 * @param data		[in] Ticket or TMD
+	 */
+	static void hash(uint8_t digest[20], const vector<uint8_t> &data)
+	{
+		static const size_t signing_offset = offsetof(RVL_Sig_RSA2048, issuer);
+		const size_t size = data.size() - signing_offset;
+		sha1w_hash_blocks(digest, &data[signing_offset], size, size, 1);
+	}
+};
+
+/**
+ * Fakesign a ticket or TMD and make sure the lowest
+ * nonce was found, regardless of the number of threads.
+ */
+TEST_P(FakesignTest, fakesign)
+{
+	const bool isTMD = std::get<0>(GetParam());
+	const unsigned int contents = std::get<1>(GetParam());
+	const unsigned int threads = std::get<2>(GetParam());
+	const size_t size = isTMD
+		? sizeof(RVL_TMD_Header) + (contents * TMD_CONTENT_SIZE)
+		: sizeof(RVL_Ticket);
+	const size_t fake_offset = isTMD ? TMD_FAKE_OFFSET : TICKET_FAKE_OFFSET;
+
+	// Random data with an RSA-2048 SHA-1 signature type.
+	vector<uint8_t> data(size);
+	std::mt19937 rng(static_cast<unsigned int>(size));
+	for (uint8_t &b : data) {
+		b = static_cast<uint8_t>(rng());
+	}
+	const uint32_t sigtype = cpu_to_be32(RVL_CERT_SIGTYPE_RSA2048_SHA1);
+	memcpy(&data[0], &sigtype, sizeof(sigtype));
+
+	// Fakesign the data.
+	vector<uint8_t> actual(data);
+	if (isTMD) {
+		ASSERT_EQ(0, cert_fakesign_tmd_mt(actual.data(), actual.size(), threads));
+	} else {
+		ASSERT_EQ(0, cert_fakesign_ticket_mt(actual.data(), actual.size(), threads));
+	}
+
+	// Signature and padding must be zeroed.
+	const size_t signing_offset = offsetof(RVL_Sig_RSA2048, issuer);
+	for (size_t i = sizeof(sigtype); i < signing_offset; i++) {
+		ASSERT_EQ(0, actual[i]) << "i == " << i;
+	}
+
+	// Only the fake word should be changed after the signature.
+	memset(&data[sizeof(sigtype)], 0, signing_offset - sizeof(sigtype));
+	vector<uint8_t> expected(data);
+	memcpy(&expected[fake_offset], &actual[fake_offset], sizeof(uint32_t));
+	EXPECT_EQ(expected, actual);
+
+	uint8_t digest[20];
+	hash(digest, actual);
+	EXPECT_EQ(0, digest[0]);
+
+	// Make sure there isn't a lower nonce.
+	uint32_t nonce;
+	memcpy(&nonce, &actual[fake_offset], sizeof(nonce));
+	for (uint32_t i = 0; i < nonce; i++) {
+		memcpy(&expected[fake_offset], &i, sizeof(i));
+		hash(digest, expected);
+		ASSERT_NE(0, digest[0]) << "Lower nonce found: " << i << " < " << nonce;
+	}
+}
+
+INSTANTIATE_TEST_CASE_P(ticket, FakesignTest,
+	::testing::Combine(
+		::testing::Values(false),
+		::testing::Values(0U),
+		::testing::Values(0U, 1U, 4U)));
+
+INSTANTIATE_TEST_CASE_P(tmd, FakesignTest,
+	::testing::Combine(
+		::testing::Values(true),
+		// Contents: Disc partition, and a large WAD.
+		::testing::Values(1U, 1000U),
+		::testing::Values(0U, 1U, 4U)));
+
+} }
+
+#ifdef _MSC_VER
+# define RVTH_CDECL __cdecl
+#else
+# define RVTH_CDECL
+#endif
+
+/**
+ * Test suite main function.
+ */
+int RVTH_CDECL main(int argc, char *argv[])
+{
+	fprintf(stderr, "libwiicrypto test suite: Fakesigning tests.\n\n");
+	fflush(nullptr);
+
+	// coverity[fun_call_w_exception]: uncaught exceptions cause nonzero exit anyway, so don't warn.
+	::testing::InitGoogleTest(&argc, argv);
+	return RUN_ALL_TESTS();
+}
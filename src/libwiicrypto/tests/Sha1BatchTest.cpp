@@ -0,0 +1,127 @@
+/***************************************************************************
+ * RVT-H Tool (libwiicrypto/tests)                                         *
+ * Sha1BatchTest.cpp: SHA-1 batch hashing test.                            *
+ *                                                                         *
+ * Copyright (c) 2026 by David Korth.                                      *
+ * SPDX-License-Identifier: GPL-2.0-or-later                               *
+ ***************************************************************************/
+
+// Google Test
+#include "gtest/gtest.h"
+
+#include "libwiicrypto/sha1w.h"
+
+// C includes. (C++ namespace)
+#include <cstdio>
+#include <cstring>
+
+// C++ includes.
+#include <random>
+#include <vector>
+using std::vector;
+
+namespace LibWiiCrypto { namespace Tests {
+
+/**
+ * Test parameters: SHA-1 implementation, block size, block count
+ */
+typedef std::tuple<SHA1W_Impl, size_t, size_t> Sha1BatchTest_params;
+
+/**
+ * Compares each SHA-1 implementation against the generic implementation.
+ */
+class Sha1BatchTest : public ::testing::TestWithParam<Sha1BatchTest_params>
+{
+protected:
+	void TearDown(void) final
+	{
+		sha1w_set_impl(SHA1W_IMPL_AUTO);
+	}
+};
+
+/**
+ * Hash blocks with a stride larger than the block size,
+ * and compare against the generic implementation.
+ */
+TEST_P(Sha1BatchTest, hashBlocks)
+{
+	const SHA1W_Impl impl = std::get<0>(GetParam());
+	const size_t size = std::get<1>(GetParam());
+	const size_t count = std::get<2>(GetParam());
+	const size_t stride = size + 13;
+
+	vector<uint8_t> data(stride * count + 1);
+	std::mt19937 rng(static_cast<unsigned int>(size * 1000 + count));
+	for (uint8_t &b : data) {
+		b = static_cast<uint8_t>(rng());
+	}
+
+	vector<uint8_t> expected(count * 20), actual(count * 20);
+	ASSERT_EQ(0, sha1w_set_impl(SHA1W_IMPL_GENERIC));
+	sha1w_hash_blocks(expected.data(), data.data(), size, stride, count);
+
+	if (sha1w_set_impl(impl) != 0) {
+		GTEST_SKIP() << "SHA-1 implementation " << static_cast<int>(impl) << " is not available on this CPU.";
+	}
+	ASSERT_EQ(impl, sha1w_get_impl());
+	sha1w_hash_blocks(actual.data(), data.data(), size, stride, count);
+	EXPECT_EQ(0, memcmp(expected.data(), actual.data(), expected.size()));
+}
+
+INSTANTIATE_TEST_CASE_P(impls, Sha1BatchTest,
+	::testing::Combine(
+		::testing::Values(SHA1W_IMPL_SSE2, SHA1W_IMPL_AVX2, SHA1W_IMPL_SHANI),
+		// Sizes: Padding edge cases, plus the H0-H2 sizes used by Wii discs.
+		::testing::Values(0U, 1U, 55U, 56U, 63U, 64U, 119U, 160U, 620U, 1024U),
+		::testing::Values(1U, 3U, 5U, 8U, 31U)));
+
+/**
+ * Known-answer tests for all implementations.
+ * FIPS 180-2 test vectors: "abc", and the 56-byte two-block message.
+ */
+TEST(Sha1KnownAnswerTest, fips180)
+{
+	static const char msg_abc[] = "abc";
+	static const uint8_t sha1_abc[20] = {
+		0xA9,0x99,0x3E,0x36,0x47,0x06,0x81,0x6A,0xBA,0x3E,
+		0x25,0x71,0x78,0x50,0xC2,0x6C,0x9C,0xD0,0xD8,0x9D,
+	};
+	static const char msg_56[] = "abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq";
+	static const uint8_t sha1_56[20] = {
+		0x84,0x98,0x3E,0x44,0x1C,0x3B,0xD2,0x6E,0xBA,0xAE,
+		0x4A,0xA1,0xF9,0x51,0x29,0xE5,0xE5,0x46,0x70,0xF1,
+	};
+
+	for (int impl = SHA1W_IMPL_GENERIC; impl < SHA1W_IMPL_MAX; impl++) {
+		if (sha1w_set_impl(static_cast<SHA1W_Impl>(impl)) != 0)
+			continue;
+
+		uint8_t digest[20];
+		sha1w_hash_blocks(digest, reinterpret_cast<const uint8_t*>(msg_abc), 3, 3, 1);
+		EXPECT_EQ(0, memcmp(sha1_abc, digest, sizeof(digest))) << "impl == " << impl;
+		sha1w_hash_blocks(digest, reinterpret_cast<const uint8_t*>(msg_56), 56, 56, 1);
+		EXPECT_EQ(0, memcmp(sha1_56, digest, sizeof(digest))) << "impl == " << impl;
+	}
+	sha1w_set_impl(SHA1W_IMPL_AUTO);
+}
+
+} }
+
+#ifdef _MSC_VER
+# define RVTH_CDECL __cdecl
+#else
+# define RVTH_CDECL
+#endif
+
+/**
+ * Test suite main function.
+ */
+int RVTH_CDECL main(int argc, char *argv[])
+{
+	fprintf(stderr, "libwiicrypto test suite: SHA-1 batch hashing tests.\n\n");
+	fflush(nullptr);
+
+	// coverity[fun_call_w_exception]: uncaught exceptions cause nonzero exit anyway, so don't warn.
+	::testing::InitGoogleTest(&argc, argv);
+	return RUN_ALL_TESTS();
+}
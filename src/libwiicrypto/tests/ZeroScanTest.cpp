@@ -0,0 +1,129 @@
+/***************************************************************************
+ * RVT-H Tool (libwiicrypto/tests)                                         *
+ * ZeroScanTest.cpp: Zero-byte scanning test and micro-benchmark.          *
+ *                                                                         *
+ * Copyright (c) 2026 by David Korth.                                      *
+ * SPDX-License-Identifier: GPL-2.0-or-later                               *
+ ***************************************************************************/
+
+// Google Test
+#include "gtest/gtest.h"
+
+#include "libwiicrypto/zero_scan.h"
+
+// C includes. (C++ namespace)
+#include <cstdio>
+#include <cstring>
+
+// C++ includes.
+#include <chrono>
+#include <vector>
+using std::vector;
+
+namespace LibWiiCrypto { namespace Tests {
+
+static const char *const impl_names[ZERO_SCAN_IMPL_MAX] = {
+	"Auto", "Generic", "SSE2", "AVX2", "NEON",
+};
+
+/**
+ * Test parameters: zero-scan implementation
+ */
+class ZeroScanTest : public ::testing::TestWithParam<ZERO_SCAN_Impl>
+{
+protected:
+	void SetUp(void) override
+	{
+		const ZERO_SCAN_Impl impl = GetParam();
+		if (zero_scan_set_impl(impl) != 0) {
+			GTEST_SKIP() << "Zero-scan implementation " << impl_names[impl] << " is not available on this CPU.";
+		}
+		ASSERT_EQ(impl, zero_scan_get_impl());
+	}
+
+	void TearDown(void) final
+	{
+		zero_scan_set_impl(ZERO_SCAN_IMPL_AUTO);
+	}
+};
+
+/**
+ * Place a single non-zero byte at every position in buffers
+ * of various sizes and alignments.
+ */
+TEST_P(ZeroScanTest, nonZeroByte)
+{
+	static const size_t sizes[] = {0, 1, 7, 8, 63, 64, 65, 127, 128, 129, 300, 4096};
+	vector<uint8_t> buf(4096 + 16);
+
+	for (size_t align = 0; align < 16; align += 3) {
+		uint8_t *const p = &buf[align];
+		for (size_t size : sizes) {
+			memset(buf.data(), 0, buf.size());
+			EXPECT_EQ(size, zero_scan(p, size)) << "align == " << align << ", size == " << size;
+			EXPECT_TRUE(zero_scan_is_zero(p, size));
+
+			for (size_t pos = 0; pos < size; pos++) {
+				p[pos] = 0x80;
+				ASSERT_EQ(pos, zero_scan(p, size))
+					<< "align == " << align << ", size == " << size << ", pos == " << pos;
+				ASSERT_FALSE(zero_scan_is_zero(p, size));
+				p[pos] = 0;
+			}
+
+			// Non-zero bytes past the end of the buffer must be ignored.
+			p[size] = 0xFF;
+			EXPECT_EQ(size, zero_scan(p, size)) << "align == " << align << ", size == " << size;
+		}
+	}
+}
+
+/**
+ * Micro-benchmark: Scan a 64 MB all-zero buffer, which is
+ * the worst case when extracting a mostly-empty disc image.
+ */
+TEST_P(ZeroScanTest, benchmark)
+{
+	static const size_t size = 64U*1024U*1024U;
+	static const unsigned int passes = 8;
+
+	vector<uint8_t> buf(size);
+	size_t total = 0;
+	auto start = std::chrono::steady_clock::now();
+	for (unsigned int pass = 0; pass < passes; pass++) {
+		total += zero_scan(buf.data(), buf.size());
+	}
+	auto end = std::chrono::steady_clock::now();
+	EXPECT_EQ(size * passes, total);
+
+	const double secs = std::chrono::duration<double>(end - start).count();
+	const double mib = (double)size * passes / (1024.0*1024.0);
+	printf("%-7s zero scan: %.0f MiB in %.3f s (%.1f MiB/s)\n",
+		impl_names[GetParam()], mib, secs, (secs > 0 ? mib / secs : 0.0));
+	fflush(stdout);
+}
+
+INSTANTIATE_TEST_CASE_P(impls, ZeroScanTest,
+	::testing::Values(ZERO_SCAN_IMPL_GENERIC, ZERO_SCAN_IMPL_SSE2,
+		ZERO_SCAN_IMPL_AVX2, ZERO_SCAN_IMPL_NEON));
+
+} }
+
+#ifdef _MSC_VER
+# define RVTH_CDECL __cdecl
+#else
+# define RVTH_CDECL
+#endif
+
+/**
+ * Test suite main function.
+ */
+int RVTH_CDECL main(int argc, char *argv[])
+{
+	fprintf(stderr, "libwiicrypto test suite: Zero-byte scanning tests.\n\n");
+	fflush(nullptr);
+
+	// coverity[fun_call_w_exception]: uncaught exceptions cause nonzero exit anyway, so don't warn.
+	::testing::InitGoogleTest(&argc, argv);
+	return RUN_ALL_TESTS();
+}
@@ -0,0 +1,158 @@
+/***************************************************************************
+ * RVT-H Tool (libwiicrypto)                                               *
+ * zero_scan.c: Zero-byte scanning functions.                              *
+ *                                                                         *
+ * Copyright (c) 2026 by David Korth.                                      *
+ * SPDX-License-Identifier: GPL-2.0-or-later                               *
+ ***************************************************************************/
+
+#include "zero_scan.h"
+#include "zero_scan_simd.h"
+#include "atomic_once.h"
+
+#ifdef HAVE_ZERO_SCAN_X86
+#  include "cpuflags_x86.h"
+#endif /* HAVE_ZERO_SCAN_X86 */
+
+#include <errno.h>
+#include <string.h>
+
+// Selected implementation.
+// ZERO_SCAN_Impl, stored as an int for wii_atomic_*_relaxed().
+static int zero_scan_impl = ZERO_SCAN_IMPL_AUTO;
+
+/**
+ * Is the specified implementation supported on this CPU?
+ * @param impl Zero-scan implementation.
+ * @return True if supported; false if not.
+ */
+static bool zero_scan_is_supported(ZERO_SCAN_Impl impl)
+{
+	switch (impl) {
+		case ZERO_SCAN_IMPL_GENERIC:
+			return true;
+#ifdef HAVE_ZERO_SCAN_X86
+		case ZERO_SCAN_IMPL_SSE2:
+			return cpuflags_x86_has(CPUFLAG_X86_SSE2);
+		case ZERO_SCAN_IMPL_AVX2:
+			return cpuflags_x86_has(CPUFLAG_X86_AVX2);
+#endif /* HAVE_ZERO_SCAN_X86 */
+#ifdef HAVE_ZERO_SCAN_NEON
+		case ZERO_SCAN_IMPL_NEON:
+			// NEON is always available on arm64.
+			return true;
+#endif /* HAVE_ZERO_SCAN_NEON */
+		default:
+			break;
+	}
+	return false;
+}
+
+/**
+ * Select the implementation used by zero_scan().
+ *
+ * This is intended for testing and benchmarking, and must not be
+ * called while another thread is scanning.
+ *
+ * @param impl Zero-scan implementation.
+ * @return 0 on success; -ENOTSUP if the implementation isn't available.
+ */
+int zero_scan_set_impl(ZERO_SCAN_Impl impl)
+{
+	if (impl == ZERO_SCAN_IMPL_AUTO) {
+		wii_atomic_store_relaxed(&zero_scan_impl, ZERO_SCAN_IMPL_AUTO);
+		return 0;
+	} else if (!zero_scan_is_supported(impl)) {
+		return -ENOTSUP;
+	}
+
+	wii_atomic_store_relaxed(&zero_scan_impl, (int)impl);
+	return 0;
+}
+
+/**
+ * Get the implementation used by zero_scan().
+ * @return Zero-scan implementation. (never ZERO_SCAN_IMPL_AUTO)
+ */
+ZERO_SCAN_Impl zero_scan_get_impl(void)
+{
+	// Order of preference.
+	static const ZERO_SCAN_Impl impls[] = {
+		ZERO_SCAN_IMPL_AVX2,
+		ZERO_SCAN_IMPL_SSE2,
+		ZERO_SCAN_IMPL_NEON,
+	};
+	ZERO_SCAN_Impl impl = (ZERO_SCAN_Impl)wii_atomic_load_relaxed(&zero_scan_impl);
+	unsigned int i;
+
+	if (impl != ZERO_SCAN_IMPL_AUTO) {
+		return impl;
+	}
+
+	impl = ZERO_SCAN_IMPL_GENERIC;
+	for (i = 0; i < sizeof(impls)/sizeof(impls[0]); i++) {
+		if (zero_scan_is_supported(impls[i])) {
+			impl = impls[i];
+			break;
+		}
+	}
+	wii_atomic_store_relaxed(&zero_scan_impl, (int)impl);
+	return impl;
+}
+
+/**
+ * Get the length of the run of zero bytes at the start of a buffer.
+ * (Generic implementation)
+ * @param pData	[in] Data.
+ * @param size	[in] Size of the data, in bytes.
+ * @return Number of zero bytes before the first non-zero byte. (size if all zero)
+ */
+size_t zero_scan_generic(const uint8_t *pData, size_t size)
+{
+	size_t pos = 0;
+
+	// Check 64-bit words.
+	// NOTE: memcpy() is used for unaligned loads.
+	for (; size - pos >= sizeof(uint64_t); pos += sizeof(uint64_t)) {
+		uint64_t x;
+		memcpy(&x, &pData[pos], sizeof(x));
+		if (x != 0) {
+			// Found a non-zero word.
+			break;
+		}
+	}
+
+	// Find the non-zero byte.
+	for (; pos < size; pos++) {
+		if (pData[pos] != 0) {
+			break;
+		}
+	}
+	return pos;
+}
+
+/**
+ * Get the length of the run of zero bytes at the start of a buffer.
+ * @param pData	[in] Data.
+ * @param size	[in] Size of the data, in bytes.
+ * @return Number of zero bytes before the first non-zero byte. (size if all zero)
+ */
+size_t zero_scan(const uint8_t *pData, size_t size)
+{
+	switch (zero_scan_get_impl()) {
+#ifdef HAVE_ZERO_SCAN_X86
+		case ZERO_SCAN_IMPL_AVX2:
+			return zero_scan_avx2(pData, size);
+		case ZERO_SCAN_IMPL_SSE2:
+			return zero_scan_sse2(pData, size);
+#endif /* HAVE_ZERO_SCAN_X86 */
+#ifdef HAVE_ZERO_SCAN_NEON
+		case ZERO_SCAN_IMPL_NEON:
+			return zero_scan_neon(pData, size);
+#endif /* HAVE_ZERO_SCAN_NEON */
+		default:
+			break;
+	}
+
+	return zero_scan_generic(pData, size);
+}
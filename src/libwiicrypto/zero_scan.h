@@ -0,0 +1,75 @@
+/***************************************************************************
+ * RVT-H Tool (libwiicrypto)                                               *
+ * zero_scan.h: Zero-byte scanning functions.                              *
+ *                                                                         *
+ * Copyright (c) 2026 by David Korth.                                      *
+ * SPDX-License-Identifier: GPL-2.0-or-later                               *
+ ***************************************************************************/
+
+// Disc images have large areas of zero bytes, which are skipped when
+// writing sparse files, and partially-zeroed sectors are checked when
+// reporting hash errors. zero_scan() finds the length of a run of zero
+// bytes, so callers can skip an entire zero area in a single call.
+
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include "stdboolx.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Zero-scan implementations.
+ */
+typedef enum {
+	ZERO_SCAN_IMPL_AUTO	= 0,	// Select the best available implementation.
+	ZERO_SCAN_IMPL_GENERIC	= 1,	// 64-bit words
+	ZERO_SCAN_IMPL_SSE2	= 2,	// SSE2
+	ZERO_SCAN_IMPL_AVX2	= 3,	// AVX2
+	ZERO_SCAN_IMPL_NEON	= 4,	// ARM NEON
+
+	ZERO_SCAN_IMPL_MAX
+} ZERO_SCAN_Impl;
+
+/**
+ * Select the implementation used by zero_scan().
+ *
+ * This is intended for testing and benchmarking, and must not be
+ * called while another thread is scanning.
+ *
+ * @param impl Zero-scan implementation.
+ * @return 0 on success; -ENOTSUP if the implementation isn't available.
+ */
+int zero_scan_set_impl(ZERO_SCAN_Impl impl);
+
+/**
+ * Get the implementation used by zero_scan().
+ * @return Zero-scan implementation. (never ZERO_SCAN_IMPL_AUTO)
+ */
+ZERO_SCAN_Impl zero_scan_get_impl(void);
+
+/**
+ * Get the length of the run of zero bytes at the start of a buffer.
+ * @param pData	[in] Data.
+ * @param size	[in] Size of the data, in bytes.
+ * @return Number of zero bytes before the first non-zero byte. (size if all zero)
+ */
+size_t zero_scan(const uint8_t *pData, size_t size);
+
+/**
+ * Is a buffer all zero bytes?
+ * @param pData	[in] Data.
+ * @param size	[in] Size of the data, in bytes.
+ * @return True if the data is all zero; false if not.
+ */
+static inline bool zero_scan_is_zero(const uint8_t *pData, size_t size)
+{
+	return (zero_scan(pData, size) == size);
+}
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,39 @@
+/***************************************************************************
+ * RVT-H Tool (libwiicrypto)                                               *
+ * zero_scan_avx2.c: Zero-byte scanning functions. (AVX2 version)          *
+ *                                                                         *
+ * Copyright (c) 2026 by David Korth.                                      *
+ * SPDX-License-Identifier: GPL-2.0-or-later                               *
+ ***************************************************************************/
+
+#include "zero_scan_simd.h"
+
+// AVX2 intrinsics
+#include <immintrin.h>
+
+/**
+ * Get the length of the run of zero bytes at the start of a buffer.
+ * (AVX2 version)
+ * @param pData	[in] Data.
+ * @param size	[in] Size of the data, in bytes.
+ * @return Number of zero bytes before the first non-zero byte. (size if all zero)
+ */
+size_t zero_scan_avx2(const uint8_t *pData, size_t size)
+{
+	size_t pos = 0;
+
+	// Check 128 bytes at a time.
+	for (; size - pos >= 128; pos += 128) {
+		const __m256i *const p = (const __m256i*)&pData[pos];
+		__m256i x = _mm256_or_si256(
+			_mm256_or_si256(_mm256_loadu_si256(&p[0]), _mm256_loadu_si256(&p[1])),
+			_mm256_or_si256(_mm256_loadu_si256(&p[2]), _mm256_loadu_si256(&p[3])));
+		if (!_mm256_testz_si256(x, x)) {
+			// Found a non-zero byte.
+			return pos + zero_scan_generic(&pData[pos], 128);
+		}
+	}
+
+	// Remaining bytes.
+	return pos + zero_scan_generic(&pData[pos], size - pos);
+}
@@ -0,0 +1,39 @@
+/***************************************************************************
+ * RVT-H Tool (libwiicrypto)                                               *
+ * zero_scan_neon.c: Zero-byte scanning functions. (ARM NEON version)      *
+ *                                                                         *
+ * Copyright (c) 2026 by David Korth.                                      *
+ * SPDX-License-Identifier: GPL-2.0-or-later                               *
+ ***************************************************************************/
+
+#include "zero_scan_simd.h"
+
+// NEON intrinsics
+#include <arm_neon.h>
+
+/**
+ * Get the length of the run of zero bytes at the start of a buffer.
+ * (ARM NEON version)
+ * @param pData	[in] Data.
+ * @param size	[in] Size of the data, in bytes.
+ * @return Number of zero bytes before the first non-zero byte. (size if all zero)
+ */
+size_t zero_scan_neon(const uint8_t *pData, size_t size)
+{
+	size_t pos = 0;
+
+	// Check 64 bytes at a time.
+	for (; size - pos >= 64; pos += 64) {
+		const uint8_t *const p = &pData[pos];
+		const uint8x16_t x = vorrq_u8(
+			vorrq_u8(vld1q_u8(&p[0]), vld1q_u8(&p[16])),
+			vorrq_u8(vld1q_u8(&p[32]), vld1q_u8(&p[48])));
+		if (vmaxvq_u8(x) != 0) {
+			// Found a non-zero byte.
+			return pos + zero_scan_generic(&pData[pos], 64);
+		}
+	}
+
+	// Remaining bytes.
+	return pos + zero_scan_generic(&pData[pos], size - pos);
+}
@@ -0,0 +1,44 @@
+/***************************************************************************
+ * RVT-H Tool (libwiicrypto)                                               *
+ * zero_scan_simd.h: Zero-byte scanning functions. (SIMD implementations)  *
+ *                                                                         *
+ * Copyright (c) 2026 by David Korth.                                      *
+ * SPDX-License-Identifier: GPL-2.0-or-later                               *
+ ***************************************************************************/
+
+// NOTE: This is an internal header used by zero_scan.c.
+// It should not be used by anything outside of libwiicrypto.
+
+#pragma once
+
+#include "config.libwiicrypto.h"
+
+#include <stdint.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Get the length of the run of zero bytes at the start of a buffer.
+ * (Generic implementation; also used by the SIMD implementations
+ * to find the exact position of a non-zero byte.)
+ * @param pData	[in] Data.
+ * @param size	[in] Size of the data, in bytes.
+ * @return Number of zero bytes before the first non-zero byte. (size if all zero)
+ */
+size_t zero_scan_generic(const uint8_t *pData, size_t size);
+
+#ifdef HAVE_ZERO_SCAN_X86
+size_t zero_scan_sse2(const uint8_t *pData, size_t size);
+size_t zero_scan_avx2(const uint8_t *pData, size_t size);
+#endif /* HAVE_ZERO_SCAN_X86 */
+
+#ifdef HAVE_ZERO_SCAN_NEON
+size_t zero_scan_neon(const uint8_t *pData, size_t size);
+#endif /* HAVE_ZERO_SCAN_NEON */
+
+#ifdef __cplusplus
+}
+#endif
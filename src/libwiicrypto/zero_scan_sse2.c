@@ -0,0 +1,40 @@
+/***************************************************************************
+ * RVT-H Tool (libwiicrypto)                                               *
+ * zero_scan_sse2.c: Zero-byte scanning functions. (SSE2 version)          *
+ *                                                                         *
+ * Copyright (c) 2026 by David Korth.                                      *
+ * SPDX-License-Identifier: GPL-2.0-or-later                               *
+ ***************************************************************************/
+
+#include "zero_scan_simd.h"
+
+// SSE2 intrinsics
+#include <emmintrin.h>
+
+/**
+ * Get the length of the run of zero bytes at the start of a buffer.
+ * (SSE2 version)
+ * @param pData	[in] Data.
+ * @param size	[in] Size of the data, in bytes.
+ * @return Number of zero bytes before the first non-zero byte. (size if all zero)
+ */
+size_t zero_scan_sse2(const uint8_t *pData, size_t size)
+{
+	const __m128i zero = _mm_setzero_si128();
+	size_t pos = 0;
+
+	// Check 64 bytes at a time.
+	for (; size - pos >= 64; pos += 64) {
+		const __m128i *const p = (const __m128i*)&pData[pos];
+		__m128i x = _mm_or_si128(
+			_mm_or_si128(_mm_loadu_si128(&p[0]), _mm_loadu_si128(&p[1])),
+			_mm_or_si128(_mm_loadu_si128(&p[2]), _mm_loadu_si128(&p[3])));
+		if (_mm_movemask_epi8(_mm_cmpeq_epi8(x, zero)) != 0xFFFF) {
+			// Found a non-zero byte.
+			return pos + zero_scan_generic(&pData[pos], 64);
+		}
+	}
+
+	// Remaining bytes.
+	return pos + zero_scan_generic(&pData[pos], size - pos);
+}
@@ -2,7 +2,7 @@
  * RVT-H Tool (qrvthtool)                                                  *
  * QRvtHToolWindow.cpp: Main window.                                       *
  *                                                                         *
- * Copyright (c) 2018-2025 by David Korth.                                 *
+ * Copyright (c) 2018-2026 by David Korth.                                 *
  * SPDX-License-Identifier: GPL-2.0-or-later                               *
  ***************************************************************************/
 
@@ -820,6 +820,9 @@ void QRvtHToolWindow::openRvtH(const QString &filename, bool isDevice)
 		return;
 	}
 
+	// The model shows all bank entries, so start loading them now.
+	rvth_tmp->prefetchBankEntries();
+
 	d->rvth = rvth_tmp;
 	d->filename = filename;
 	d->model->setRvtH(d->rvth);
@@ -2,7 +2,7 @@
  * RVT-H Tool                                                              *
  * extract.cpp: Extract/import a bank from/to an RVT-H disk image.         *
  *                                                                         *
- * Copyright (c) 2018-2019 by David Korth.                                 *
+ * Copyright (c) 2018-2026 by David Korth.                                 *
  * SPDX-License-Identifier: GPL-2.0-or-later                               *
  ***************************************************************************/
 
@@ -16,8 +16,12 @@
 // C includes. (C++ namespace)
 #include <cassert>
 #include <cerrno>
+#include <cinttypes>
 #include <cstdlib>
 
+// C++ includes
+#include <numeric>
+
 /**
  * RVT-H progress callback.
  * @param state		[in] Current progress.
@@ -40,6 +44,11 @@ static bool progress_callback(const RvtH_Progress_State *state, void *userdata)
 				state->lba_processed / MEGABYTE,
 				state->lba_total / MEGABYTE);
 			break;
+		case RVTH_PROGRESS_HASH:
+			printf("\rHashing: %4u MiB / %4u MiB processed...",
+				state->lba_processed / MEGABYTE,
+				state->lba_total / MEGABYTE);
+			break;
 		case RVTH_PROGRESS_RECRYPT:
 			if (state->lba_total <= 1) {
 				// TODO: Encryption types?
@@ -67,6 +76,25 @@ static bool progress_callback(const RvtH_Progress_State *state, void *userdata)
 	return true;
 }
 
+/**
+ * Print disc image digests.
+ * @param digests	[in] Digests
+ */
+static void print_digests(const RvtH_Digests *digests)
+{
+	printf("Size:  %" PRIu64 " bytes\n", digests->size);
+	printf("CRC32: %08x\n", digests->crc32);
+	fputs("MD5:   ", stdout);
+	for (unsigned int i = 0; i < sizeof(digests->md5); i++) {
+		printf("%02x", digests->md5[i]);
+	}
+	fputs("\nSHA-1: ", stdout);
+	for (unsigned int i = 0; i < sizeof(digests->sha1); i++) {
+		printf("%02x", digests->sha1[i]);
+	}
+	putchar('\n');
+}
+
 /**
  * 'extract' command.
  * @param rvth_filename	[in] RVT-H device or disk image filename.
@@ -74,9 +102,12 @@ static bool progress_callback(const RvtH_Progress_State *state, void *userdata)
  * @param gcm_filename	[in] Filename for the extracted GCM image.
  * @param recrypt_key	[in] Key for recryption. (-1 for default)
  * @param flags		[in] Flags. (See RvtH_Extract_Flags.)
+ * @param threads	[in] Number of worker threads for encryption. (0 for auto)
+ * @param hash		[in] If true, print the digests of the extracted image.
+ * @param direct_io	[in] If true, use direct I/O for the RVT-H device.
  * @return 0 on success; non-zero on error.
  */
-int extract(const TCHAR *rvth_filename, const TCHAR *s_bank, const TCHAR *gcm_filename, int recrypt_key, unsigned int flags)
+int extract(const TCHAR *rvth_filename, const TCHAR *s_bank, const TCHAR *gcm_filename, int recrypt_key, unsigned int flags, unsigned int threads, bool hash, bool direct_io)
 {
 	// Open the RVT-H device or disk image.
 	int ret;
@@ -89,6 +120,15 @@ int extract(const TCHAR *rvth_filename, const TCHAR *s_bank, const TCHAR *gcm_fi
 		return ret;
 	}
 
+	if (direct_io) {
+		// Enable direct I/O for bank data.
+		// If this fails, continue using buffered I/O.
+		ret = rvth->setDirectIO(true);
+		if (ret != 0) {
+			fprintf(stderr, "*** WARNING: Unable to enable direct I/O: %s\n", rvth_error(ret));
+		}
+	}
+
 	unsigned int bank;
 	if (s_bank) {
 		// Validate the bank number.
@@ -118,9 +158,15 @@ int extract(const TCHAR *rvth_filename, const TCHAR *s_bank, const TCHAR *gcm_fi
 	putchar('\n');
 
 	_tprintf(_T("Extracting Bank %u into '%s'...\n"), bank+1, gcm_filename);
-	ret = rvth->extract(bank, gcm_filename, recrypt_key, flags, progress_callback);
+	RvtH_Digests digests;
+	ret = rvth->extract(bank, gcm_filename, recrypt_key, flags, progress_callback, nullptr, threads,
+		(hash ? &digests : nullptr));
 	if (ret == 0) {
-		_tprintf(_T("Bank %u extracted to '%s' successfully.\n\n"), bank+1, gcm_filename);
+		_tprintf(_T("Bank %u extracted to '%s' successfully.\n"), bank+1, gcm_filename);
+		if (hash) {
+			print_digests(&digests);
+		}
+		putchar('\n');
 	} else {
 		// TODO: Delete the gcm file?
 		fprintf(stderr, "*** ERROR: rvth_extract() failed: %s\n", rvth_error(ret));
@@ -136,9 +182,12 @@ int extract(const TCHAR *rvth_filename, const TCHAR *s_bank, const TCHAR *gcm_fi
  * @param s_bank	Bank number (as a string).
  * @param gcm_filename	Filename of the GCM image to import.
  * @param ios_force	IOS version to force. (-1 to use the existing IOS)
+ * @param flags		Flags. (See RvtH_Import_Flags.)
+ * @param hash		If true, print the digests of the imported image.
+ * @param direct_io	If true, use direct I/O for the RVT-H device.
  * @return 0 on success; non-zero on error.
  */
-int import(const TCHAR *rvth_filename, const TCHAR *s_bank, const TCHAR *gcm_filename, int ios_force)
+int import(const TCHAR *rvth_filename, const TCHAR *s_bank, const TCHAR *gcm_filename, int ios_force, unsigned int flags, bool hash, bool direct_io)
 {
 	// TODO: Verification for overwriting images.
 
@@ -153,6 +202,15 @@ int import(const TCHAR *rvth_filename, const TCHAR *s_bank, const TCHAR *gcm_fil
 		return ret;
 	}
 
+	if (direct_io) {
+		// Enable direct I/O for bank data.
+		// If this fails, continue using buffered I/O.
+		ret = rvth->setDirectIO(true);
+		if (ret != 0) {
+			fprintf(stderr, "*** WARNING: Unable to enable direct I/O: %s\n", rvth_error(ret));
+		}
+	}
+
 	// Validate the bank number.
 	TCHAR *endptr;
 	unsigned int bank = (unsigned int)_tcstoul(s_bank, &endptr, 10) - 1;
@@ -199,9 +257,44 @@ int import(const TCHAR *rvth_filename, const TCHAR *s_bank, const TCHAR *gcm_fil
 	delete rvth_src_tmp;
 
 	_tprintf(_T("Importing '%s' into Bank %u...\n"), gcm_filename, bank+1);
-	ret = rvth->import(bank, gcm_filename, progress_callback, nullptr, ios_force);
+	RvtH_Import_Stats stats;
+	RvtH_Digests digests;
+	ret = rvth->import(bank, gcm_filename, progress_callback, nullptr, ios_force, flags, &stats,
+		(hash ? &digests : nullptr));
 	if (ret == 0) {
+		if (stats.incremental) {
+			static constexpr uint64_t MEGABYTE = 1048576U;
+			printf("Incremental import: %u MiB written, %u MiB unchanged (%u MiB compared).\n",
+				(unsigned int)(stats.bytes_written / MEGABYTE),
+				(unsigned int)(stats.bytes_skipped / MEGABYTE),
+				(unsigned int)(stats.bytes_read / MEGABYTE));
+		} else if (flags & RVTH_IMPORT_INCREMENTAL) {
+			_tprintf(_T("Bank %u doesn't have the same title, or the image was recrypted;\n")
+				_T("the full image was written.\n"), bank+1);
+		}
 		_tprintf(_T("'%s' imported to Bank %u successfully.\n"), gcm_filename, bank+1);
+		if (stats.verified) {
+			// NOTE: The hashes are checked on the source data.
+			const unsigned int total_errs = std::accumulate(stats.verify_errs,
+				stats.verify_errs + ARRAY_SIZE(stats.verify_errs), 0U);
+			printf("Disc image verified with %u error%s.\n", total_errs, (total_errs != 1) ? "s" : "");
+			if (total_errs != 0) {
+				printf("- H0: %u, H1: %u, H2: %u, H3: %u, H4: %u\n",
+					stats.verify_errs[0], stats.verify_errs[1], stats.verify_errs[2],
+					stats.verify_errs[3], stats.verify_errs[4]);
+			}
+			if (stats.reread) {
+				printf("Re-read %u group%s that didn't match the disc image.\n",
+					stats.reread_errs, (stats.reread_errs != 1) ? "s" : "");
+			} else if (flags & RVTH_IMPORT_VERIFY_REREAD) {
+				printf("Groups were not re-read, since the OS page cache can't be bypassed. (Try --direct-io.)\n");
+			}
+		}
+		if (hash) {
+			// NOTE: These are the digests of the image as it was
+			// copied, before recryption for the RVT-H.
+			print_digests(&digests);
+		}
 	} else {
 		// TODO: Delete the gcm file?
 		fprintf(stderr, "*** ERROR: rvth_import() failed: %s\n", rvth_error(ret));
@@ -2,13 +2,14 @@
  * RVT-H Tool                                                              *
  * extract.h: Extract a bank from an RVT-H disk image.                     *
  *                                                                         *
- * Copyright (c) 2018-2025 by David Korth.                                 *
+ * Copyright (c) 2018-2026 by David Korth.                                 *
  * SPDX-License-Identifier: GPL-2.0-or-later                               *
  ***************************************************************************/
 
 #pragma once
 
 #include "tcharx.h"
+#include "stdboolx.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -21,9 +22,12 @@ extern "C" {
  * @param gcm_filename	Filename for the extracted GCM image.
  * @param recrypt_key	[in] Key for recryption. (-1 for default)
  * @param flags		[in] Flags. (See RvtH_Extract_Flags.)
+ * @param threads	[in] Number of worker threads for encryption. (0 for auto)
+ * @param hash		[in] If true, print the digests of the extracted image.
+ * @param direct_io	[in] If true, use direct I/O for the RVT-H device.
  * @return 0 on success; non-zero on error.
  */
-int extract(const TCHAR *rvth_filename, const TCHAR *s_bank, const TCHAR *gcm_filename, int recrypt_key, unsigned int flags);
+int extract(const TCHAR *rvth_filename, const TCHAR *s_bank, const TCHAR *gcm_filename, int recrypt_key, unsigned int flags, unsigned int threads, bool hash, bool direct_io);
 
 /**
  * 'import' command.
@@ -31,9 +35,12 @@ int extract(const TCHAR *rvth_filename, const TCHAR *s_bank, const TCHAR *gcm_fi
  * @param s_bank	Bank number (as a string).
  * @param gcm_filename	Filename of the GCM image to import.
  * @param ios_force	IOS version to force. (-1 to use the existing IOS)
+ * @param flags		Flags. (See RvtH_Import_Flags.)
+ * @param hash		If true, print the digests of the imported image.
+ * @param direct_io	If true, use direct I/O for the RVT-H device.
  * @return 0 on success; non-zero on error.
  */
-int import(const TCHAR *rvth_filename, const TCHAR *s_bank, const TCHAR *gcm_filename, int ios_force);
+int import(const TCHAR *rvth_filename, const TCHAR *s_bank, const TCHAR *gcm_filename, int ios_force, unsigned int flags, bool hash, bool direct_io);
 
 #ifdef __cplusplus
 }
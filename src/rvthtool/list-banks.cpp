@@ -2,7 +2,7 @@
  * RVT-H Tool                                                              *
  * list-banks.cpp: List banks in an RVT-H disk image.                      *
  *                                                                         *
- * Copyright (c) 2018-2022 by David Korth.                                 *
+ * Copyright (c) 2018-2026 by David Korth.                                 *
  * SPDX-License-Identifier: GPL-2.0-or-later                               *
  ***************************************************************************/
 
@@ -301,6 +301,9 @@ int list_banks(const TCHAR *rvth_filename)
 		return ret;
 	}
 
+	// All bank entries will be printed, so start loading them now.
+	rvth->prefetchBankEntries();
+
 	_tprintf(_T("File: %s\n"), rvth_filename);
 
 	// Check if this is an HDD image.
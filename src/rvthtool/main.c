@@ -2,7 +2,7 @@
  * RVT-H Tool                                                              *
  * main.c: Main program file.                                              *
  *                                                                         *
- * Copyright (c) 2018-2025 by David Korth.                                 *
+ * Copyright (c) 2018-2026 by David Korth.                                 *
  * SPDX-License-Identifier: GPL-2.0-or-later                               *
  ***************************************************************************/
 
@@ -17,6 +17,7 @@
 #include <getopt.h>
 
 #include "librvth/config.librvth.h"
+#include "config.rvthtool.h"
 #include "librvth/rvth.hpp"
 #include "libwiicrypto/cert.h"
 #include "libwiicrypto/sig_tools.h"
@@ -31,6 +32,7 @@
 #include "undelete.h"
 #include "verify.h"
 #include "query.h"
+#include "mount.h"
 
 #ifdef _MSC_VER
 #  define RVTH_CDECL __cdecl
@@ -38,6 +40,16 @@
 #  define RVTH_CDECL
 #endif
 
+// Long-only options.
+#define OPT_DIRECT_IO 0x100
+#define OPT_NO_CACHE 0x101
+#define OPT_REBUILD_CACHE 0x102
+#define OPT_INCREMENTAL 0x103
+#define OPT_HASH 0x104
+#define OPT_VERIFY 0x105
+#define OPT_REREAD 0x106
+#define OPT_FS 0x107
+
 #ifdef _WIN32
 #  define DEVICE_NAME_EXAMPLE "\\\\.\\PhysicalDriveN"
 #else
@@ -109,8 +121,9 @@ static void print_help(const TCHAR *argv0)
 		_T("- Undelete the specified bank number from the specified RVT-H device.\n")
 		_T("  [This command only works with RVT-H Readers, not disk images.]\n")
 		_T("\n")
-		_T("verify ") _T(DEVICE_NAME_EXAMPLE) _T(" bank#\n")
+		_T("verify ") _T(DEVICE_NAME_EXAMPLE) _T(" bank#|all\n")
 		_T("- Verify all hashes on an encrypted Wii or RVT-R bank or disc image.\n")
+		_T("  Specify 'all' to verify all Wii banks using a shared thread pool.\n")
 		_T("\n")
 		_T("show-table rvth.img\n")
 		_T("- Print out the raw NHCD Bank Table information for debugging.\n")
@@ -120,6 +133,14 @@ static void print_help(const TCHAR *argv0)
 #ifndef HAVE_QUERY
 		_T("  [NOTE: Not available on this system.]\n")
 #endif /* HAVE_QUERY */
+		_T("\n")
+		_T("mount rvth.img mountpoint\n")
+		_T("- Mount each bank of rvth.img as a read-only disc image, bankN.iso.\n")
+		_T("  With --fs, the game partition of each Wii bank is also mounted\n")
+		_T("  as a directory, bankN/. Unmount with 'fusermount3 -u mountpoint'.\n")
+#ifndef HAVE_FUSE
+		_T("  [NOTE: Not available on this system.]\n")
+#endif /* HAVE_FUSE */
 		_T("\n")
 		_T("help\n")
 		_T("- Display this help and exit.\n")
@@ -132,6 +153,29 @@ static void print_help(const TCHAR *argv0)
 		_T("                            Importing to RVT-H will always use debug keys.\n")
 		_T("  -N, --ndev                Prepend extracted images with a 32 KB header\n")
 		_T("                            required by official SDK tools.\n")
+		_T("  -f, --format=FMT          Format for extracted images: gcm, ciso, wbfs\n")
+		_T("                            CISO and WBFS images only store used blocks.\n")
+		_T("                            Can't be combined with --ndev.\n")
+		_T("  -j, --threads=N           Use N worker threads when verifying, or when\n")
+		_T("                            extracting an unencrypted image with -k.\n")
+		_T("                            Default is one per CPU; 1 disables threading.\n")
+		_T("      --direct-io           Bypass the OS page cache when transferring bank\n")
+		_T("                            data to or from an RVT-H Reader.\n")
+		_T("      --no-cache            Don't use cached results when verifying\n")
+		_T("                            an RVT-H bank, and don't save new results.\n")
+		_T("      --rebuild-cache       Verify RVT-H banks even if cached results are\n")
+		_T("                            available, and save the new results.\n")
+		_T("      --incremental         When importing into a bank that already has the\n")
+		_T("                            same title, only write the parts that changed.\n")
+		_T("                            Not used if the image needs to be recrypted.\n")
+		_T("      --hash                Print the CRC32, MD5, and SHA-1 of the disc image\n")
+		_T("                            when extracting or importing.\n")
+		_T("      --verify              Verify all hashes on an encrypted Wii image\n")
+		_T("                            while importing it.\n")
+		_T("      --reread              With --verify, read each group back from the\n")
+		_T("                            bank after writing it and compare it.\n")
+		_T("      --fs                  When mounting, also expose the game partition\n")
+		_T("                            filesystem of each Wii bank.\n")
 #ifdef SHOW_HIDDEN_OPTIONS
 		_T("  -I, --ios=xx              Force IOSxx when importing a disc image to\n")
 		_T("                            an RVT-H Reader.")
@@ -145,6 +189,7 @@ int RVTH_CDECL _tmain(int argc, TCHAR *argv[])
 {
 	int ret;
 	unsigned int flags = 0;
+	unsigned int import_flags = 0;
 
 	// Key to use for recryption.
 	// -1 == default; no recryption, except when importing retail to RVT-H.
@@ -155,6 +200,22 @@ int RVTH_CDECL _tmain(int argc, TCHAR *argv[])
 	// Default is -1, or "use existing IOS".
 	int ios_force = -1;
 
+	// Number of worker threads for verification and encryption.
+	// Default is 0, or "one per CPU".
+	unsigned int threads = 0;
+
+	// Use direct I/O for bank data on RVT-H Readers.
+	bool direct_io = false;
+
+	// Print the disc image digests when extracting or importing.
+	bool hash = false;
+
+	// Expose the game partition filesystems when mounting.
+	bool with_fs = false;
+
+	// Verification cache mode for RVT-H banks.
+	RvtH_Verify_Cache_Mode cache_mode = RVTH_VERIFY_CACHE_ON;
+
 #ifdef _WIN32
 	// Set Win32 security options.
 	secoptions_init();
@@ -182,13 +243,23 @@ int RVTH_CDECL _tmain(int argc, TCHAR *argv[])
 		static const struct option long_options[] = {
 			{_T("recrypt"),	required_argument,	0, _T('k')},
 			{_T("ndev"),	no_argument,		0, _T('N')},
+			{_T("format"),	required_argument,	0, _T('f')},
 			{_T("ios"),	required_argument,	0, _T('I')},
+			{_T("threads"),	required_argument,	0, _T('j')},
+			{_T("direct-io"), no_argument,		0, OPT_DIRECT_IO},
+			{_T("no-cache"), no_argument,		0, OPT_NO_CACHE},
+			{_T("rebuild-cache"), no_argument,	0, OPT_REBUILD_CACHE},
+			{_T("incremental"), no_argument,	0, OPT_INCREMENTAL},
+			{_T("hash"), no_argument,		0, OPT_HASH},
+			{_T("verify"), no_argument,		0, OPT_VERIFY},
+			{_T("reread"), no_argument,		0, OPT_REREAD},
+			{_T("fs"), no_argument,			0, OPT_FS},
 			{_T("help"),	no_argument,		0, _T('h')},
 
 			{NULL, 0, 0, 0}
 		};
 
-		int c = getopt_long(argc, argv, _T("k:NI:h"), long_options, NULL);
+		int c = getopt_long(argc, argv, _T("k:Nf:I:j:h"), long_options, NULL);
 		if (c == -1)
 			break;
 
@@ -228,6 +299,21 @@ int RVTH_CDECL _tmain(int argc, TCHAR *argv[])
 				flags |= RVTH_EXTRACT_PREPEND_SDK_HEADER;
 				break;
 
+			case _T('f'):
+				// Extracted image format.
+				flags &= ~(RVTH_EXTRACT_FORMAT_CISO | RVTH_EXTRACT_FORMAT_WBFS);
+				if (!_tcsicmp(optarg, _T("gcm"))) {
+					// Plain disc image. (default)
+				} else if (!_tcsicmp(optarg, _T("ciso"))) {
+					flags |= RVTH_EXTRACT_FORMAT_CISO;
+				} else if (!_tcsicmp(optarg, _T("wbfs"))) {
+					flags |= RVTH_EXTRACT_FORMAT_WBFS;
+				} else {
+					print_error(argv[0], _T("unknown image format '%s'"), optarg);
+					return EXIT_FAILURE;
+				}
+				break;
+
 			case _T('I'): {
 				// Force an IOS version.
 				TCHAR *endptr;
@@ -243,6 +329,61 @@ int RVTH_CDECL _tmain(int argc, TCHAR *argv[])
 				break;
 			}
 
+			case _T('j'): {
+				// Number of worker threads.
+				TCHAR *endptr;
+				long threads_tmp = _tcstol(optarg, &endptr, 0);
+				if (*endptr != '\0') {
+					print_error(argv[0], _T("unable to parse '%s' as a thread count"), optarg);
+					return EXIT_FAILURE;
+				} else if (threads_tmp < 0 || threads_tmp > 256) {
+					print_error(argv[0], _T("%ld is not a valid thread count"), threads_tmp);
+					return EXIT_FAILURE;
+				}
+				threads = (unsigned int)threads_tmp;
+				break;
+			}
+
+			case OPT_DIRECT_IO:
+				// Use direct I/O.
+				direct_io = true;
+				break;
+
+			case OPT_NO_CACHE:
+				// Don't use the verification cache.
+				cache_mode = RVTH_VERIFY_CACHE_OFF;
+				break;
+
+			case OPT_REBUILD_CACHE:
+				// Rebuild the verification cache.
+				cache_mode = RVTH_VERIFY_CACHE_REBUILD;
+				break;
+
+			case OPT_INCREMENTAL:
+				// Incremental import.
+				import_flags |= RVTH_IMPORT_INCREMENTAL;
+				break;
+
+			case OPT_HASH:
+				// Print the disc image digests.
+				hash = true;
+				break;
+
+			case OPT_VERIFY:
+				// Verify the hashes while importing.
+				import_flags |= RVTH_IMPORT_VERIFY;
+				break;
+
+			case OPT_REREAD:
+				// Re-read the written groups.
+				import_flags |= RVTH_IMPORT_VERIFY_REREAD;
+				break;
+
+			case OPT_FS:
+				// Expose the game partition filesystems.
+				with_fs = true;
+				break;
+
 			case _T('h'):
 				print_help(argv[0]);
 				return EXIT_SUCCESS;
@@ -254,6 +395,13 @@ int RVTH_CDECL _tmain(int argc, TCHAR *argv[])
 		}
 	}
 
+	if ((flags & RVTH_EXTRACT_PREPEND_SDK_HEADER) &&
+	    (flags & (RVTH_EXTRACT_FORMAT_CISO | RVTH_EXTRACT_FORMAT_WBFS)))
+	{
+		print_error(argv[0], _T("--ndev can't be used with CISO or WBFS images"));
+		return EXIT_FAILURE;
+	}
+
 	// First argument after getopt-parsed arguments is set in optind.
 	if (optind >= argc) {
 		print_error(argv[0], _T("no parameters specified"));
@@ -283,10 +431,10 @@ int RVTH_CDECL _tmain(int argc, TCHAR *argv[])
 			// Pass NULL as the bank number, which will be
 			// interpreted as bank 1 for single-disc images
 			// and an error for HDD images.
-			ret = extract(argv[optind+1], NULL, argv[optind+2], recrypt_key, flags);
+			ret = extract(argv[optind+1], NULL, argv[optind+2], recrypt_key, flags, threads, hash, direct_io);
 		} else {
 			// Three or more parameters specified.
-			ret = extract(argv[optind+1], argv[optind+2], argv[optind+3], recrypt_key, flags);
+			ret = extract(argv[optind+1], argv[optind+2], argv[optind+3], recrypt_key, flags, threads, hash, direct_io);
 		}
 	} else if (!_tcscmp(argv[optind], _T("import"))) {
 		// Import a bank.
@@ -294,7 +442,7 @@ int RVTH_CDECL _tmain(int argc, TCHAR *argv[])
 			print_error(argv[0], _T("missing parameters for 'import'"));
 			return EXIT_FAILURE;
 		}
-		ret = import(argv[optind+1], argv[optind+2], argv[optind+3], ios_force);
+		ret = import(argv[optind+1], argv[optind+2], argv[optind+3], ios_force, import_flags, hash, direct_io);
 	} else if (!_tcscmp(argv[optind], _T("delete"))) {
 		// Delete a bank.
 		if (argc < 3) {
@@ -319,10 +467,10 @@ int RVTH_CDECL _tmain(int argc, TCHAR *argv[])
 			// Pass NULL as the bank number, which will be
 			// interpreted as bank 1 for single-disc images
 			// and an error for HDD images.
-			ret = verify(argv[optind+1], NULL);
+			ret = verify(argv[optind+1], NULL, threads, direct_io, cache_mode);
 		} else {
 			// Two or more parameters specified.
-			ret = verify(argv[optind+1], argv[optind+2]);
+			ret = verify(argv[optind+1], argv[optind+2], threads, direct_io, cache_mode);
 		}
 	} else if (!_tcscmp(argv[optind], _T("show-table"))) {
 		// Print raw table information.
@@ -336,6 +484,13 @@ int RVTH_CDECL _tmain(int argc, TCHAR *argv[])
 		// NOTE: Not checking HAVE_QUERY. If querying isn't available,
 		// an error message will be displayed.
 		ret = query();
+	} else if (!_tcscmp(argv[optind], _T("mount"))) {
+		// Mount an RVT-H device or disk image.
+		if (argc < optind+3) {
+			print_error(argv[0], _T("missing parameters for 'mount'"));
+			return EXIT_FAILURE;
+		}
+		ret = mount_rvth(argv[optind+1], argv[optind+2], with_fs);
 	} else {
 		// If the "command" contains a slash or dot (or backslash on Windows),
 		// assume it's a filename and handle it as 'list'.
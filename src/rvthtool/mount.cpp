@@ -0,0 +1,548 @@
+/***************************************************************************
+ * RVT-H Tool                                                              *
+ * mount.cpp: Mount an RVT-H disk image using FUSE.                        *
+ *                                                                         *
+ * Copyright (c) 2026 by David Korth.                                      *
+ * SPDX-License-Identifier: GPL-2.0-or-later                               *
+ ***************************************************************************/
+
+#include "mount.h"
+#include "config.rvthtool.h"
+
+#ifdef HAVE_FUSE
+
+#define FUSE_USE_VERSION 31
+#include <fuse.h>
+
+#include "librvth/rvth.hpp"
+#include "librvth/rvth_error.h"
+#include "librvth/nhcd_structs.h"
+#include "librvth/DiscFs.hpp"
+#include "librvth/reader/Reader.hpp"
+#include "librvth/reader/PartitionReader.hpp"
+#include "libwiicrypto/byteswap.h"
+#include "libwiicrypto/wii_sector.h"
+
+// C includes
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// C includes (C++ namespace)
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+// C++ includes
+#include <memory>
+#include <mutex>
+#include <vector>
+using std::unique_ptr;
+using std::vector;
+
+// A mounted bank.
+struct MountBank {
+	unsigned int bank;		// Bank number (0-7)
+	const RvtH_BankEntry *entry;	// Bank entry
+	uint64_t size;			// Size of bankN.iso, in bytes
+
+	// If true, the disc header in LBA 0 was zeroed by the RVT-H's
+	// "Flush" function, so it's restored from the bank table entry.
+	bool restoreHeader;
+
+	// Game partition filesystem (with --fs only)
+	unique_ptr<PartitionReader> ptReader;
+	unique_ptr<DiscFs> fs;
+};
+
+// Mount state.
+struct MountState {
+	unique_ptr<RvtH> rvth;
+	vector<MountBank> banks;
+
+	// Reader and PartitionReader aren't thread-safe, and all banks
+	// of an HDD image share the same file, so reads are serialized.
+	std::mutex mutex;
+};
+
+// Node types.
+enum NodeType {
+	NODE_NONE,
+	NODE_ROOT,	// Root directory
+	NODE_ISO,	// bankN.iso
+	NODE_FS,	// Entry in bankN/
+};
+
+// File handles: high 32 bits are the index into MountState::banks;
+// low 32 bits are the DiscFs entry index plus 1, or 0 for bankN.iso.
+static inline uint64_t make_fh(unsigned int bank_idx, int fs_idx)
+{
+	return (static_cast<uint64_t>(bank_idx) << 32) | static_cast<uint32_t>(fs_idx + 1);
+}
+
+/**
+ * Get the mount state.
+ * @return MountState
+ */
+static inline MountState *get_state(void)
+{
+	return static_cast<MountState*>(fuse_get_context()->private_data);
+}
+
+/**
+ * Look up a path.
+ * @param state		[in] MountState
+ * @param path		[in] Path
+ * @param pBankIdx	[out] Index into MountState::banks
+ * @param pFsIdx	[out] DiscFs entry index (NODE_FS only)
+ * @return Node type
+ */
+static NodeType lookup(const MountState *state, const char *path, unsigned int *pBankIdx, int *pFsIdx)
+{
+	if (!strcmp(path, "/")) {
+		return NODE_ROOT;
+	} else if (strncmp(path, "/bank", 5) != 0) {
+		return NODE_NONE;
+	}
+
+	// Bank numbers are 1-based, as in the other commands.
+	char *endptr;
+	const unsigned long bank = strtoul(&path[5], &endptr, 10);
+	if (endptr == &path[5] || bank == 0) {
+		return NODE_NONE;
+	}
+
+	for (unsigned int i = 0; i < state->banks.size(); i++) {
+		const MountBank &mb = state->banks[i];
+		if (mb.bank + 1 != bank)
+			continue;
+
+		*pBankIdx = i;
+		if (!strcmp(endptr, ".iso")) {
+			return NODE_ISO;
+		} else if (mb.fs && (*endptr == '\0' || *endptr == '/')) {
+			*pFsIdx = mb.fs->lookup(endptr);
+			return (*pFsIdx >= 0 ? NODE_FS : NODE_NONE);
+		}
+		break;
+	}
+
+	return NODE_NONE;
+}
+
+/**
+ * Initialize the filesystem.
+ * @param conn	[in,out] Connection information
+ * @param cfg	[in,out] Configuration
+ * @return Private data
+ */
+static void *rvth_fuse_init(struct fuse_conn_info *conn, struct fuse_config *cfg)
+{
+	// NOTE: conn->max_readahead can only be lowered from the value
+	// offered by the kernel, which is the read_ahead_kb setting of
+	// the mount's backing device. (usually 128 KB) See README.md
+	// for raising it after mounting.
+	((void)conn);
+
+	// Everything is read-only, so the kernel can keep file data
+	// and attributes cached for as long as it's mounted.
+	cfg->kernel_cache = 1;
+	cfg->entry_timeout = 3600;
+	cfg->attr_timeout = 3600;
+	cfg->negative_timeout = 3600;
+	return get_state();
+}
+
+/**
+ * Get file attributes.
+ * @param path	[in] Path
+ * @param st	[out] stat buffer
+ * @param fi	[in] File information (may be NULL)
+ * @return 0 on success; negative POSIX error code on error.
+ */
+static int rvth_fuse_getattr(const char *path, struct stat *st, struct fuse_file_info *fi)
+{
+	((void)fi);
+	MountState *const state = get_state();
+	unsigned int bank_idx = 0;
+	int fs_idx = -1;
+	const NodeType type = lookup(state, path, &bank_idx, &fs_idx);
+	if (type == NODE_NONE) {
+		return -ENOENT;
+	}
+
+	memset(st, 0, sizeof(*st));
+	st->st_uid = getuid();
+	st->st_gid = getgid();
+	st->st_blksize = GROUP_SIZE_ENC;
+	if (type == NODE_ROOT) {
+		st->st_mode = S_IFDIR | 0555;
+		st->st_nlink = 2;
+		return 0;
+	}
+
+	const MountBank &mb = state->banks[bank_idx];
+	if (mb.entry->timestamp != -1) {
+		st->st_mtime = mb.entry->timestamp;
+	}
+
+	if (type == NODE_ISO) {
+		st->st_mode = S_IFREG | 0444;
+		st->st_nlink = 1;
+		st->st_size = static_cast<off_t>(mb.size);
+	} else {
+		const DiscFs::Entry &fsEntry = mb.fs->entry(fs_idx);
+		if (fsEntry.is_dir) {
+			st->st_mode = S_IFDIR | 0555;
+			st->st_nlink = 2;
+		} else {
+			st->st_mode = S_IFREG | 0444;
+			st->st_nlink = 1;
+			st->st_size = static_cast<off_t>(fsEntry.size);
+		}
+	}
+	st->st_blocks = (st->st_size + 511) / 512;
+	return 0;
+}
+
+/**
+ * Read a directory.
+ * @param path	[in] Path
+ * @param buf	[in] Buffer for filler
+ * @param filler	[in] Directory filler function
+ * @param offset	[in] Offset (unused)
+ * @param fi	[in] File information
+ * @param flags	[in] Flags
+ * @return 0 on success; negative POSIX error code on error.
+ */
+static int rvth_fuse_readdir(const char *path, void *buf, fuse_fill_dir_t filler,
+	off_t offset, struct fuse_file_info *fi, enum fuse_readdir_flags flags)
+{
+	((void)offset);
+	((void)fi);
+	((void)flags);
+	static const enum fuse_fill_dir_flags fill_flags = static_cast<enum fuse_fill_dir_flags>(0);
+
+	MountState *const state = get_state();
+	unsigned int bank_idx = 0;
+	int fs_idx = -1;
+	const NodeType type = lookup(state, path, &bank_idx, &fs_idx);
+
+	if (type == NODE_ROOT) {
+		filler(buf, ".", nullptr, 0, fill_flags);
+		filler(buf, "..", nullptr, 0, fill_flags);
+		for (const MountBank &mb : state->banks) {
+			char name[32];
+			snprintf(name, sizeof(name), "bank%u.iso", mb.bank + 1);
+			filler(buf, name, nullptr, 0, fill_flags);
+			if (mb.fs) {
+				snprintf(name, sizeof(name), "bank%u", mb.bank + 1);
+				filler(buf, name, nullptr, 0, fill_flags);
+			}
+		}
+		return 0;
+	} else if (type != NODE_FS) {
+		return (type == NODE_NONE ? -ENOENT : -ENOTDIR);
+	}
+
+	const DiscFs::Entry &dir = state->banks[bank_idx].fs->entry(fs_idx);
+	if (!dir.is_dir) {
+		return -ENOTDIR;
+	}
+	filler(buf, ".", nullptr, 0, fill_flags);
+	filler(buf, "..", nullptr, 0, fill_flags);
+	for (const auto &child : dir.children) {
+		filler(buf, child.first.c_str(), nullptr, 0, fill_flags);
+	}
+	return 0;
+}
+
+/**
+ * Open a file.
+ * @param path	[in] Path
+ * @param fi	[in,out] File information
+ * @return 0 on success; negative POSIX error code on error.
+ */
+static int rvth_fuse_open(const char *path, struct fuse_file_info *fi)
+{
+	if ((fi->flags & O_ACCMODE) != O_RDONLY) {
+		return -EROFS;
+	}
+
+	MountState *const state = get_state();
+	unsigned int bank_idx = 0;
+	int fs_idx = -1;
+	const NodeType type = lookup(state, path, &bank_idx, &fs_idx);
+	switch (type) {
+		case NODE_ISO:
+			fi->fh = make_fh(bank_idx, -1);
+			break;
+		case NODE_FS:
+			if (state->banks[bank_idx].fs->entry(fs_idx).is_dir) {
+				return -EISDIR;
+			}
+			fi->fh = make_fh(bank_idx, fs_idx);
+			break;
+		case NODE_ROOT:
+			return -EISDIR;
+		default:
+			return -ENOENT;
+	}
+
+	// The contents never change.
+	fi->keep_cache = 1;
+	return 0;
+}
+
+/**
+ * Read from bankN.iso.
+ *
+ * LBA-aligned spans are read directly into the FUSE buffer;
+ * only a partial LBA at the start or end uses a bounce buffer.
+ *
+ * @param mb	[in] MountBank
+ * @param buf	[out] Output buffer
+ * @param size	[in] Number of bytes to read
+ * @param pos	[in] Starting position (must be less than mb.size)
+ * @return Number of bytes read, or negative POSIX error code on error.
+ */
+static int read_iso(const MountBank &mb, char *buf, size_t size, uint64_t pos)
+{
+	Reader *const reader = mb.entry->reader;
+	const uint64_t start = pos;
+	size_t done = 0;
+	while (done < size) {
+		const uint32_t lba = BYTES_TO_LBA(pos);
+		const unsigned int lba_offset = static_cast<unsigned int>(pos % LBA_SIZE);
+		if (lba_offset == 0 && size - done >= LBA_SIZE) {
+			// Aligned: Read directly into the output buffer.
+			const uint32_t lba_len = BYTES_TO_LBA(size - done);
+			const uint32_t lba_read = reader->read(&buf[done], lba, lba_len);
+			if (lba_read == 0) {
+				break;
+			}
+			done += static_cast<size_t>(LBA_TO_BYTES(lba_read));
+			pos += LBA_TO_BYTES(lba_read);
+			if (lba_read != lba_len) {
+				break;
+			}
+		} else {
+			// Partial LBA: Use a bounce buffer.
+			uint8_t sbuf[LBA_SIZE];
+			if (reader->read(sbuf, lba, 1) != 1) {
+				break;
+			}
+			size_t len = LBA_SIZE - lba_offset;
+			if (len > size - done) {
+				len = size - done;
+			}
+			memcpy(&buf[done], &sbuf[lba_offset], len);
+			done += len;
+			pos += len;
+		}
+	}
+
+	if (done == 0 && size > 0) {
+		return -EIO;
+	}
+
+	if (mb.restoreHeader && start < sizeof(mb.entry->discHeader)) {
+		// Restore the disc header.
+		size_t len = sizeof(mb.entry->discHeader) - static_cast<size_t>(start);
+		if (len > done) {
+			len = done;
+		}
+		memcpy(buf, reinterpret_cast<const uint8_t*>(&mb.entry->discHeader) + start, len);
+	}
+	return static_cast<int>(done);
+}
+
+/**
+ * Read from a file.
+ * @param path	[in] Path (unused; the file handle is used instead)
+ * @param buf	[out] Output buffer
+ * @param size	[in] Number of bytes to read
+ * @param offset	[in] Starting offset
+ * @param fi	[in] File information
+ * @return Number of bytes read, or negative POSIX error code on error.
+ */
+static int rvth_fuse_read(const char *path, char *buf, size_t size, off_t offset,
+	struct fuse_file_info *fi)
+{
+	((void)path);
+	MountState *const state = get_state();
+	const unsigned int bank_idx = static_cast<unsigned int>(fi->fh >> 32);
+	const int fs_idx = static_cast<int>(static_cast<uint32_t>(fi->fh)) - 1;
+	const MountBank &mb = state->banks[bank_idx];
+	if (offset < 0) {
+		return -EINVAL;
+	}
+
+	// Get the file's location.
+	uint64_t file_offset = 0;
+	uint64_t file_size = mb.size;
+	if (fs_idx >= 0) {
+		const DiscFs::Entry &fsEntry = mb.fs->entry(fs_idx);
+		file_offset = fsEntry.offset;
+		file_size = fsEntry.size;
+	}
+
+	const uint64_t pos = static_cast<uint64_t>(offset);
+	if (pos >= file_size) {
+		return 0;
+	} else if (size > file_size - pos) {
+		size = static_cast<size_t>(file_size - pos);
+	}
+
+	std::lock_guard<std::mutex> lock(state->mutex);
+	if (fs_idx < 0) {
+		return read_iso(mb, buf, size, pos);
+	}
+
+	errno = 0;
+	const size_t ret = mb.ptReader->read(buf, file_offset + pos, size);
+	if (ret == 0 && size > 0) {
+		return (errno != 0 ? -errno : -EIO);
+	}
+	return static_cast<int>(ret);
+}
+
+/**
+ * Check if a bank's disc header needs to be restored.
+ * @param entry	[in] Bank entry
+ * @return True if LBA 0 has neither the Wii nor the GameCube magic number.
+ */
+static bool needs_header_restore(const RvtH_BankEntry *entry)
+{
+	uint8_t sbuf[LBA_SIZE];
+	if (entry->reader->read(sbuf, 0, 1) != 1) {
+		return false;
+	}
+
+	const GCN_DiscHeader *const hdr = reinterpret_cast<const GCN_DiscHeader*>(sbuf);
+	return (hdr->magic_wii != be32_to_cpu(WII_MAGIC) &&
+	        hdr->magic_gcn != be32_to_cpu(GCN_MAGIC));
+}
+
+/**
+ * 'mount' command.
+ * @param rvth_filename	RVT-H device or disk image filename.
+ * @param mountpoint	Mount point.
+ * @param with_fs	If true, also expose the game partition filesystem of each Wii bank.
+ * @return 0 on success; non-zero on error.
+ */
+int mount_rvth(const TCHAR *rvth_filename, const TCHAR *mountpoint, bool with_fs)
+{
+	// Open the RVT-H device or disk image.
+	int ret;
+	MountState state;
+	state.rvth.reset(new RvtH(rvth_filename, &ret));
+	if (ret != 0 || !state.rvth->isOpen()) {
+		_ftprintf(stderr, _T("*** ERROR opening RVT-H device '%s': "), rvth_filename);
+		fputs(rvth_error(ret), stderr);
+		_fputtc(_T('\n'), stderr);
+		return ret;
+	}
+
+	RvtH *const rvth = state.rvth.get();
+	const unsigned int bankCount = rvth->bankCount();
+	for (unsigned int bank = 0; bank < bankCount; bank++) {
+		const RvtH_BankEntry *const entry = rvth->bankEntry(bank);
+		if (!entry || !entry->reader) {
+			continue;
+		}
+		switch (entry->type) {
+			case RVTH_BankType_GCN:
+			case RVTH_BankType_Wii_SL:
+			case RVTH_BankType_Wii_DL:
+				break;
+			default:
+				// Empty, unknown, or the second bank of a
+				// dual-layer image. Nothing to mount.
+				continue;
+		}
+
+		state.banks.resize(state.banks.size() + 1);
+		MountBank &mb = state.banks.back();
+		mb.bank = bank;
+		mb.entry = entry;
+		mb.size = LBA_TO_BYTES(entry->lba_len);
+		mb.restoreHeader = needs_header_restore(entry);
+
+		if (with_fs && entry->type != RVTH_BankType_GCN) {
+			int err = 0;
+			mb.ptReader.reset(rvth->openGamePartition(bank, &err));
+			if (mb.ptReader) {
+				mb.fs.reset(new DiscFs());
+				err = mb.fs->load(mb.ptReader.get());
+			}
+			if (err != 0) {
+				fprintf(stderr, "*** WARNING: Bank %u: Unable to load the game partition filesystem: %s\n",
+					bank + 1, rvth_error(err));
+				mb.fs.reset();
+				mb.ptReader.reset();
+			}
+		}
+	}
+
+	if (state.banks.empty()) {
+		fputs("*** ERROR: No banks to mount.\n", stderr);
+		return RVTH_ERROR_BANK_EMPTY;
+	}
+
+	static const struct fuse_operations ops = []() {
+		struct fuse_operations ops;
+		memset(&ops, 0, sizeof(ops));
+		ops.init = rvth_fuse_init;
+		ops.getattr = rvth_fuse_getattr;
+		ops.readdir = rvth_fuse_readdir;
+		ops.open = rvth_fuse_open;
+		ops.read = rvth_fuse_read;
+		return ops;
+	}();
+
+	// Run in the foreground so the RvtH object stays valid,
+	// and the mount can be stopped with Ctrl-C.
+	char argv0[] = "rvthtool";
+	char opt_f[] = "-f";
+	char opt_o[] = "-o";
+	char opt_ro[] = "ro,default_permissions,fsname=rvthtool,subtype=rvth";
+	char *const s_mountpoint = strdup(mountpoint);
+	char *fuse_argv[] = {argv0, opt_f, opt_o, opt_ro, s_mountpoint, nullptr};
+	const int fuse_argc = static_cast<int>(ARRAY_SIZE(fuse_argv)) - 1;
+
+	printf("Mounting %u bank(s) on %s. Press Ctrl-C or run 'fusermount3 -u' to unmount.\n",
+		static_cast<unsigned int>(state.banks.size()), mountpoint);
+	fflush(stdout);
+	ret = fuse_main(fuse_argc, fuse_argv, &ops, &state);
+	free(s_mountpoint);
+
+	// Close the PartitionReaders before the RvtH object.
+	state.banks.clear();
+	return ret;
+}
+
+#else /* !HAVE_FUSE */
+
+// C includes (C++ namespace)
+#include <cerrno>
+#include <cstdio>
+
+/**
+ * 'mount' command.
+ * @param rvth_filename	RVT-H device or disk image filename.
+ * @param mountpoint	Mount point.
+ * @param with_fs	If true, also expose the game partition filesystem of each Wii bank.
+ * @return 0 on success; non-zero on error.
+ */
+int mount_rvth(const TCHAR *rvth_filename, const TCHAR *mountpoint, bool with_fs)
+{
+	((void)rvth_filename);
+	((void)mountpoint);
+	((void)with_fs);
+	_fputts(_T("*** ERROR: Mounting is not available on this system.\n"), stderr);
+	return -ENOSYS;
+}
+
+#endif /* HAVE_FUSE */
@@ -0,0 +1,29 @@
+/***************************************************************************
+ * RVT-H Tool                                                              *
+ * mount.h: Mount an RVT-H disk image using FUSE.                          *
+ *                                                                         *
+ * Copyright (c) 2026 by David Korth.                                      *
+ * SPDX-License-Identifier: GPL-2.0-or-later                               *
+ ***************************************************************************/
+
+#pragma once
+
+#include "tcharx.h"
+#include "stdboolx.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * 'mount' command.
+ * @param rvth_filename	RVT-H device or disk image filename.
+ * @param mountpoint	Mount point.
+ * @param with_fs	If true, also expose the game partition filesystem of each Wii bank.
+ * @return 0 on success; non-zero on error.
+ */
+int mount_rvth(const TCHAR *rvth_filename, const TCHAR *mountpoint, bool with_fs);
+
+#ifdef __cplusplus
+}
+#endif
@@ -2,7 +2,7 @@
  * RVT-H Tool                                                              *
  * verify.cpp: Verify a bank in an RVT-H disk image.                       *
  *                                                                         *
- * Copyright (c) 2018-2022 by David Korth.                                 *
+ * Copyright (c) 2018-2026 by David Korth.                                 *
  * SPDX-License-Identifier: GPL-2.0-or-later                               *
  ***************************************************************************/
 
@@ -17,10 +17,27 @@
 #include <cassert>
 #include <cerrno>
 #include <cstdlib>
+#include <cstring>
 
 // C++ includes
+#include <memory>
 #include <numeric>
 
+// Progress callback state.
+struct VerifyProgress {
+	VerifyProgress(bool all_banks)
+		: prev_bank(-1)
+		, prev_pt(-1)
+		, cached_bank(-1)
+		, all_banks(all_banks)
+	{ }
+
+	int prev_bank;		// Previous bank number
+	int prev_pt;		// Previous partition number
+	int cached_bank;	// Last bank reported from the cache
+	bool all_banks;		// If true, verifying all banks.
+};
+
 /**
  * RVT-H verify progress callback.
  * @param state		[in] Current progress.
@@ -29,16 +46,39 @@
  */
 static bool progress_callback(const RvtH_Verify_Progress_State *state, void *userdata)
 {
-	UNUSED(userdata);
-	static int prev_pt = -1;	// TODO: Userdata struct.
+	VerifyProgress *const progress = static_cast<VerifyProgress*>(userdata);
 	int pt_current = state->pt_current;
 	if (pt_current < state->pt_total) {
 		pt_current++;
 	}
-	if (prev_pt != -1 && prev_pt != pt_current) {
+
+	if (progress->all_banks && progress->prev_bank != static_cast<int>(state->bank)) {
+		// Starting the next bank.
+		if (progress->prev_pt != -1) {
+			putchar('\n');
+		}
+		progress->prev_bank = static_cast<int>(state->bank);
+		progress->prev_pt = -1;
+
+		// Print the bank information.
+		print_bank(state->rvth, state->bank);
+		_tprintf(_T("\nVerifying Bank %u...\n"), state->bank+1);
+	}
+
+	if (state->is_cached && progress->cached_bank != static_cast<int>(state->bank)) {
+		// Results are from the verification cache.
+		progress->cached_bank = static_cast<int>(state->bank);
+		if (progress->prev_pt != -1) {
+			putchar('\n');
+			progress->prev_pt = -1;
+		}
+		fputs("Using cached results. (Specify --rebuild-cache to verify again.)\n", stdout);
+	}
+
+	if (progress->prev_pt != -1 && progress->prev_pt != pt_current) {
 		putchar('\n');
 	}
-	prev_pt = pt_current;
+	progress->prev_pt = pt_current;
 
 	const char *ps_pt_type = nullptr;
 	char s_pt_type[8];
@@ -76,6 +116,10 @@ static bool progress_callback(const RvtH_Verify_Progress_State *state, void *use
 			if (state->pt_current == state->pt_total) {
 				// Finished processing.
 				putchar('\n');
+				if (progress->all_banks) {
+					// Bank is finished.
+					progress->prev_pt = -1;
+				}
 			}
 			break;
 		}
@@ -117,13 +161,80 @@ static bool progress_callback(const RvtH_Verify_Progress_State *state, void *use
 	return true;
 }
 
+/**
+ * Verify all banks.
+ * @param rvth		[in] RVT-H disk image.
+ * @param threads	[in] Number of worker threads. (0 for auto)
+ * @return 0 on success; non-zero on error.
+ */
+static int verify_all(RvtH *rvth, unsigned int threads)
+{
+	const unsigned int bank_count = rvth->bankCount();
+	std::unique_ptr<RvtH::WiiErrorCount_t[]> errorCounts(new RvtH::WiiErrorCount_t[bank_count]);
+	std::unique_ptr<int[]> bankErrs(new int[bank_count]);
+
+	VerifyProgress progress(true);
+	int ret = rvth->verifyAllWiiPartitions(errorCounts.get(), bankErrs.get(),
+		progress_callback, &progress, threads);
+	if (ret != 0) {
+		fprintf(stderr, "*** ERROR: rvth->verifyAllWiiPartitions() failed: %s\n", rvth_error(ret));
+		return ret;
+	}
+
+	// Print the results.
+	putchar('\n');
+	unsigned int bank_verified = 0;
+	for (unsigned int bank = 0; bank < bank_count; bank++) {
+		const int err = bankErrs[bank];
+		switch (err) {
+			case 0: {
+				// Add up the errors.
+				const RvtH::WiiErrorCount_t &errorCount = errorCounts[bank];
+				unsigned int total_errs = std::accumulate(errorCount.errs, errorCount.errs + ARRAY_SIZE(errorCount.errs), 0);
+				_tprintf(_T("Bank %u verified with %u error%s.\n"), bank+1, total_errs, (total_errs != 1) ? _T("s") : _T(""));
+				bank_verified++;
+				break;
+			}
+
+			case RVTH_ERROR_BANK_EMPTY:
+			case RVTH_ERROR_BANK_DL_2:
+				// Nothing to verify.
+				break;
+
+			case RVTH_ERROR_NOT_WII_IMAGE:
+			case RVTH_ERROR_IS_UNENCRYPTED:
+				// Bank can't be verified.
+				printf("Bank %u skipped: %s\n", bank+1, rvth_error(err));
+				break;
+
+			default:
+				// Error verifying the bank.
+				printf("*** ERROR: Bank %u: %s\n", bank+1, rvth_error(err));
+				if (ret == 0) {
+					ret = err;
+				}
+				break;
+		}
+	}
+
+	if (bank_verified == 0 && ret == 0) {
+		_fputts(_T("*** ERROR: No banks could be verified.\n"), stderr);
+		ret = RVTH_ERROR_NOT_WII_IMAGE;
+	}
+	return ret;
+}
+
 /**
  * 'verify' command.
  * @param rvth_filename	[in] RVT-H device or disk image filename.
- * @param s_bank	[in] Bank number (as a string). (If NULL, assumes bank 1.)
+ * @param s_bank	[in] Bank number (as a string), or "all". (If NULL, assumes bank 1.)
+ * @param threads	[in] Number of worker threads. (0 for auto)
+ * @param direct_io	[in] If true, use direct I/O for the RVT-H device.
+ * @param cache_mode	[in] Verification cache mode for RVT-H banks.
  * @return 0 on success; non-zero on error.
  */
-int verify(const TCHAR *rvth_filename, const TCHAR *s_bank)
+int verify(const TCHAR *rvth_filename, const TCHAR *s_bank, unsigned int threads, bool direct_io,
+	RvtH_Verify_Cache_Mode cache_mode)
 {
 	// Open the RVT-H device or disk image.
 	int ret;
@@ -136,6 +247,23 @@ int verify(const TCHAR *rvth_filename, const TCHAR *s_bank)
 		return ret;
 	}
 
+	if (direct_io) {
+		// Enable direct I/O for bank data.
+		// If this fails, continue using buffered I/O.
+		ret = rvth->setDirectIO(true);
+		if (ret != 0) {
+			fprintf(stderr, "*** WARNING: Unable to enable direct I/O: %s\n", rvth_error(ret));
+		}
+	}
+	rvth->setVerifyCacheMode(cache_mode);
+
+	if (s_bank && !_tcsicmp(s_bank, _T("all"))) {
+		// Verify all banks.
+		ret = verify_all(rvth, threads);
+		delete rvth;
+		return ret;
+	}
+
 	unsigned int bank;
 	if (s_bank) {
 		// Validate the bank number.
@@ -176,7 +304,8 @@ int verify(const TCHAR *rvth_filename, const TCHAR *s_bank)
 		_fputts(_T("Verifying disc image...\n"), stdout);
 	}
 	fflush(stdout);
-	ret = rvth->verifyWiiPartitions(bank, &errorCount, progress_callback);
+	VerifyProgress progress(false);
+	ret = rvth->verifyWiiPartitions(bank, &errorCount, progress_callback, &progress, threads);
 	if (ret == 0) {
 		// Add up the errors.
 		unsigned int total_errs = std::accumulate(errorCount.errs, errorCount.errs + ARRAY_SIZE(errorCount.errs), 0);
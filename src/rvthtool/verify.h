@@ -2,13 +2,16 @@
  * RVT-H Tool                                                              *
  * verify.h: Verify a bank in an RVT-H disk image.                         *
  *                                                                         *
- * Copyright (c) 2018-2025 by David Korth.                                 *
+ * Copyright (c) 2018-2026 by David Korth.                                 *
  * SPDX-License-Identifier: GPL-2.0-or-later                               *
  ***************************************************************************/
 
 #pragma once
 
 #include "tcharx.h"
+#include "stdboolx.h"
+
+#include "librvth/rvth.hpp"
 
 #ifdef __cplusplus
 extern "C" {
@@ -17,10 +20,14 @@ extern "C" {
 /**
  * 'verify' command.
  * @param rvth_filename	RVT-H device or disk image filename.
- * @param s_bank	Bank number (as a string). (If NULL, assumes bank 1.)
+ * @param s_bank	Bank number (as a string), or "all". (If NULL, assumes bank 1.)
+ * @param threads	Number of worker threads. (0 for auto)
+ * @param direct_io	If true, use direct I/O for the RVT-H device.
+ * @param cache_mode	Verification cache mode for RVT-H banks.
  * @return 0 on success; non-zero on error.
  */
-int verify(const TCHAR *rvth_filename, const TCHAR *s_bank);
+int verify(const TCHAR *rvth_filename, const TCHAR *s_bank, unsigned int threads, bool direct_io,
+	RvtH_Verify_Cache_Mode cache_mode);
 
 #ifdef __cplusplus
 }
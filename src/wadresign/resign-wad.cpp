@@ -2,7 +2,7 @@
  * RVT-H Tool: WAD Resigner                                                *
  * resign-wad.c: Re-sign a WAD file.                                       *
  *                                                                         *
- * Copyright (c) 2018-2024 by David Korth.                                 *
+ * Copyright (c) 2018-2026 by David Korth.                                 *
  * SPDX-License-Identifier: GPL-2.0-or-later                               *
  ***************************************************************************/
 
@@ -687,7 +687,9 @@ int resign_wad(const TCHAR *src_wad, const TCHAR *dest_wad, int recrypt_key, int
 	if (likely(toKey != RVL_KEY_DEBUG)) {
 		// Retail: Fakesign the TMD.
 		// Dolphin and cIOSes ignore the signature anyway.
-		cert_fakesign_tmd(tmd_buf.get(), wadInfo.tmd_size);
+		// WADs can have many contents, so large TMDs are fakesigned
+		// using multiple threads.
+		cert_fakesign_tmd_mt(tmd_buf.get(), wadInfo.tmd_size, 0);
 	} else {
 		// Debug: Use the real signing keys.
 		// Debug IOS requires a valid signature.